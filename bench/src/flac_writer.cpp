@@ -0,0 +1,196 @@
+#include "flac_writer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace bench {
+
+static constexpr std::uint32_t BLOCK_SIZE = 4096;
+
+class BitWriter
+{
+public:
+
+	auto write(std::uint64_t value, int num_bits) -> void
+	{
+		for (int i = num_bits - 1; i >= 0; i--)
+		{
+			byte_ = std::uint8_t((byte_ << 1) | ((value >> i) & 1));
+
+			if (++num_bits_in_byte_ == 8)
+			{
+				bytes_.push_back(byte_);
+				byte_ = 0;
+				num_bits_in_byte_ = 0;
+			}
+		}
+	}
+
+	auto align() -> void
+	{
+		if (num_bits_in_byte_ > 0)
+		{
+			write(0, 8 - num_bits_in_byte_);
+		}
+	}
+
+	auto bytes() -> std::vector<std::uint8_t>& { return bytes_; }
+
+private:
+
+	std::vector<std::uint8_t> bytes_;
+	std::uint8_t byte_{0};
+	int num_bits_in_byte_{0};
+};
+
+[[nodiscard]] static
+auto crc8(const std::uint8_t* data, std::size_t size) -> std::uint8_t
+{
+	std::uint8_t crc{0};
+
+	for (std::size_t i = 0; i < size; i++)
+	{
+		crc ^= data[i];
+
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = std::uint8_t((crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1));
+		}
+	}
+
+	return crc;
+}
+
+[[nodiscard]] static
+auto crc16(const std::uint8_t* data, std::size_t size) -> std::uint16_t
+{
+	std::uint16_t crc{0};
+
+	for (std::size_t i = 0; i < size; i++)
+	{
+		crc ^= std::uint16_t(data[i] << 8);
+
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = std::uint16_t((crc & 0x8000) ? (crc << 1) ^ 0x8005 : (crc << 1));
+		}
+	}
+
+	return crc;
+}
+
+// Frame numbers are coded the same way as UTF-8
+static
+auto write_utf8(BitWriter* writer, std::uint32_t value) -> void
+{
+	if (value < 0x80)
+	{
+		writer->write(value, 8);
+		return;
+	}
+
+	int num_continuation_bytes{1};
+
+	while (value >= (std::uint32_t(1) << (6 + (5 * num_continuation_bytes))))
+	{
+		num_continuation_bytes++;
+	}
+
+	const auto lead_mask{std::uint32_t(0xFF00) >> (num_continuation_bytes + 1)};
+
+	writer->write((lead_mask & 0xFF) | (value >> (6 * num_continuation_bytes)), 8);
+
+	for (int i = num_continuation_bytes - 1; i >= 0; i--)
+	{
+		writer->write(0x80 | ((value >> (6 * i)) & 0x3F), 8);
+	}
+}
+
+[[nodiscard]] static
+auto get_sample_size_code(int bit_depth) -> std::uint32_t
+{
+	switch (bit_depth)
+	{
+		case 8: return 1;
+		case 12: return 2;
+		case 16: return 4;
+		case 20: return 5;
+		case 24: default: return 6;
+	}
+}
+
+auto write_verbatim_flac(const float* frames, std::uint64_t num_frames, int num_channels, int sample_rate, int bit_depth) -> std::vector<char>
+{
+	BitWriter writer;
+
+	writer.write('f', 8);
+	writer.write('L', 8);
+	writer.write('a', 8);
+	writer.write('C', 8);
+
+	// STREAMINFO, the last (and only) metadata block
+	writer.write(1, 1);
+	writer.write(0, 7);
+	writer.write(34, 24);
+	writer.write(BLOCK_SIZE, 16);
+	writer.write(BLOCK_SIZE, 16);
+	writer.write(0, 24); // Frame sizes aren't known
+	writer.write(0, 24);
+	writer.write(std::uint32_t(sample_rate), 20);
+	writer.write(std::uint32_t(num_channels - 1), 3);
+	writer.write(std::uint32_t(bit_depth - 1), 5);
+	writer.write(num_frames, 36);
+
+	for (int i = 0; i < 16; i++)
+	{
+		writer.write(0, 8); // No MD5
+	}
+
+	const auto scale{double(std::int64_t(1) << (bit_depth - 1))};
+
+	std::uint32_t frame_number{0};
+
+	for (std::uint64_t frame = 0; frame < num_frames; frame += BLOCK_SIZE, frame_number++)
+	{
+		const auto block_size{std::uint32_t(std::min<std::uint64_t>(BLOCK_SIZE, num_frames - frame))};
+		const auto frame_start{writer.bytes().size()};
+
+		writer.write(0x3FFE, 14); // Sync code
+		writer.write(0, 1);
+		writer.write(0, 1); // Fixed block size
+		writer.write(block_size == BLOCK_SIZE ? 12 : 7, 4); // 12 means 4096, 7 means it follows the frame number
+		writer.write(0, 4); // Sample rate from STREAMINFO
+		writer.write(std::uint32_t(num_channels - 1), 4); // Independent channels
+		writer.write(get_sample_size_code(bit_depth), 3);
+		writer.write(0, 1);
+
+		write_utf8(&writer, frame_number);
+
+		if (block_size != BLOCK_SIZE)
+		{
+			writer.write(block_size - 1, 16);
+		}
+
+		writer.write(crc8(writer.bytes().data() + frame_start, writer.bytes().size() - frame_start), 8);
+
+		for (int c = 0; c < num_channels; c++)
+		{
+			writer.write(0, 1);
+			writer.write(1, 6); // Verbatim
+			writer.write(0, 1); // No wasted bits
+
+			for (std::uint32_t i = 0; i < block_size; i++)
+			{
+				const auto value{std::clamp(std::nearbyint(double(frames[((frame + i) * num_channels) + c]) * scale), -scale, scale - 1.0)};
+
+				writer.write(std::uint64_t(std::int64_t(value)), bit_depth);
+			}
+		}
+
+		writer.align();
+		writer.write(crc16(writer.bytes().data() + frame_start, writer.bytes().size() - frame_start), 16);
+	}
+
+	return { writer.bytes().begin(), writer.bytes().end() };
+}
+
+} // bench
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace bench {
+
+// blahdio can't write FLAC, so the FLAC inputs are written here with
+// every subframe stored verbatim. dr_flac still has to parse every
+// frame and unpack every sample, but there is no prediction to undo,
+// so decoding is faster than for a real encoder's output.
+[[nodiscard]] extern auto write_verbatim_flac(const float* frames, std::uint64_t num_frames, int num_channels, int sample_rate, int bit_depth) -> std::vector<char>;
+
+} // bench
@@ -0,0 +1,202 @@
+#include "inputs.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <blahdio/audio_writer.h>
+#include "flac_writer.h"
+
+namespace bench {
+
+auto to_string(blahdio::AudioType type) -> const char*
+{
+	switch (type)
+	{
+		case blahdio::AudioType::flac: return "flac";
+		case blahdio::AudioType::mp3: return "mp3";
+		case blahdio::AudioType::wav: return "wav";
+		case blahdio::AudioType::wavpack: return "wavpack";
+		default: return "none";
+	}
+}
+
+auto generate_signal(std::uint64_t num_frames, int num_channels, int sample_rate) -> std::vector<float>
+{
+	static constexpr double PI = 3.14159265358979;
+	static constexpr double FREQUENCIES[] = { 110.0, 277.0, 659.0, 1760.0 };
+
+	std::vector<float> out(num_frames * num_channels);
+
+	std::mt19937 rng{1234};
+	std::uniform_real_distribution<float> noise{-0.01f, 0.01f};
+
+	for (std::uint64_t i = 0; i < num_frames; i++)
+	{
+		const auto t{double(i) / sample_rate};
+
+		for (int c = 0; c < num_channels; c++)
+		{
+			double value{0.0};
+
+			for (int k = 0; k < 4; k++)
+			{
+				const auto level{0.1 + (0.05 * std::sin(2.0 * PI * (0.25 + (0.1 * (k + c))) * t))};
+
+				value += level * std::sin((2.0 * PI * FREQUENCIES[k] * t) + c);
+			}
+
+			out[(i * num_channels) + c] = float(value) + noise(rng);
+		}
+	}
+
+	return out;
+}
+
+[[nodiscard]] static
+auto load_file(const std::filesystem::path& path) -> std::vector<char>
+{
+	std::ifstream file(path, std::ios::binary);
+
+	return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+static
+auto save_file(const std::filesystem::path& path, const std::vector<char>& bytes) -> void
+{
+	std::ofstream file(path, std::ios::binary);
+
+	file.write(bytes.data(), std::streamsize(bytes.size()));
+}
+
+static
+auto write_with_blahdio(const std::filesystem::path& path, blahdio::AudioType type, const InputOptions& options, const std::vector<float>& signal, int bit_depth, blahdio::AudioDataFormat::StorageType storage_type) -> void
+{
+	blahdio::AudioDataFormat format;
+
+	format.num_frames = options.num_frames;
+	format.num_channels = options.num_channels;
+	format.sample_rate = options.sample_rate;
+	format.bit_depth = bit_depth;
+	format.storage_type = storage_type;
+
+	blahdio::AudioWriter writer(path.string(), type, format);
+
+	blahdio::AudioWriter::Callbacks callbacks;
+
+	callbacks.should_abort = []() { return false; };
+	callbacks.get_next_chunk = [&](float* buffer, std::uint64_t frame, std::uint32_t num_frames)
+	{
+		const auto first{signal.begin() + std::ptrdiff_t(frame * options.num_channels)};
+
+		std::copy(first, first + std::ptrdiff_t(std::size_t(num_frames) * options.num_channels), buffer);
+	};
+
+	writer.write_frames(callbacks, 4096);
+}
+
+[[nodiscard]] static
+auto get_type_for_extension(std::string extension) -> blahdio::AudioType
+{
+	for (auto& c : extension) c = char(std::tolower((unsigned char)(c)));
+
+	if (extension == ".wav") return blahdio::AudioType::wav;
+	if (extension == ".flac") return blahdio::AudioType::flac;
+	if (extension == ".mp3") return blahdio::AudioType::mp3;
+	if (extension == ".wv") return blahdio::AudioType::wavpack;
+
+	return blahdio::AudioType::none;
+}
+
+auto make_inputs(const InputOptions& options, const std::vector<float>& signal, std::vector<std::string>* skipped) -> std::vector<Input>
+{
+	using StorageType = blahdio::AudioDataFormat::StorageType;
+
+	struct Generated
+	{
+		const char* name;
+		blahdio::AudioType type;
+		int bit_depth;
+		StorageType storage_type;
+	};
+
+	static constexpr Generated GENERATED[] =
+	{
+		{ "wav_s16", blahdio::AudioType::wav, 16, StorageType::Int },
+		{ "wav_s24", blahdio::AudioType::wav, 24, StorageType::Int },
+		{ "wav_f32", blahdio::AudioType::wav, 32, StorageType::Float },
+		{ "wavpack_s16", blahdio::AudioType::wavpack, 16, StorageType::Int },
+		{ "wavpack_s24", blahdio::AudioType::wavpack, 24, StorageType::Int },
+		{ "flac_s16", blahdio::AudioType::flac, 16, StorageType::Int },
+		{ "flac_s24", blahdio::AudioType::flac, 24, StorageType::Int },
+	};
+
+	std::filesystem::create_directories(options.dir);
+
+	std::vector<Input> out;
+
+	for (const auto& generated : GENERATED)
+	{
+		Input input;
+
+		input.name = generated.name;
+		input.type = generated.type;
+		input.path = options.dir / (std::string(generated.name) + (generated.type == blahdio::AudioType::wavpack ? ".wv" : generated.type == blahdio::AudioType::flac ? ".flac" : ".wav"));
+
+		if (generated.type == blahdio::AudioType::flac)
+		{
+			save_file(input.path, write_verbatim_flac(signal.data(), options.num_frames, options.num_channels, options.sample_rate, generated.bit_depth));
+		}
+		else
+		{
+			try
+			{
+				write_with_blahdio(input.path, generated.type, options, signal, generated.bit_depth, generated.storage_type);
+			}
+			catch (const std::exception& err)
+			{
+				skipped->push_back(input.name + ": " + err.what());
+				continue;
+			}
+		}
+
+		input.bytes = load_file(input.path);
+		out.push_back(std::move(input));
+	}
+
+	if (!options.extra_dir.empty())
+	{
+		std::vector<std::filesystem::path> paths;
+
+		for (const auto& entry : std::filesystem::directory_iterator(options.extra_dir))
+		{
+			if (entry.is_regular_file()) paths.push_back(entry.path());
+		}
+
+		// Directory order isn't defined, and the results should line up
+		// from one run to the next
+		std::sort(paths.begin(), paths.end());
+
+		for (const auto& path : paths)
+		{
+			const auto type{get_type_for_extension(path.extension().string())};
+
+			if (type == blahdio::AudioType::none) continue;
+
+			Input input;
+
+			input.name = "extra:" + path.filename().string();
+			input.type = type;
+			input.path = path;
+			input.bytes = load_file(input.path);
+
+			out.push_back(std::move(input));
+		}
+	}
+
+	return out;
+}
+
+} // bench
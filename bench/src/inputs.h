@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <blahdio/audio_type.h>
+
+namespace bench {
+
+struct Input
+{
+	// Identifies the input in the results, e.g. "wav_s16"
+	std::string name;
+	blahdio::AudioType type;
+	std::filesystem::path path;
+
+	// The whole file, for the memory and stream sources
+	std::vector<char> bytes;
+};
+
+struct InputOptions
+{
+	// Where the generated files are written
+	std::filesystem::path dir;
+
+	std::uint64_t num_frames{};
+	int num_channels{};
+	int sample_rate{};
+
+	// Optional. Any WAV, FLAC, MP3 or WavPack files in here are used as
+	// well. This is the only way to benchmark MP3, which can't be
+	// generated.
+	std::filesystem::path extra_dir;
+};
+
+// Music-like test signal: a few sines with slowly changing levels plus
+// a little noise, so the lossless formats have something to compress.
+// Always the same for the same arguments.
+[[nodiscard]] extern auto generate_signal(std::uint64_t num_frames, int num_channels, int sample_rate) -> std::vector<float>;
+
+// Writes the signal as WAV, WavPack and FLAC at a few bit depths and
+// loads them, along with the extra files. Formats which this build of
+// the library can't write are left out and their names added to
+// skipped.
+[[nodiscard]] extern auto make_inputs(const InputOptions& options, const std::vector<float>& signal, std::vector<std::string>* skipped) -> std::vector<Input>;
+
+[[nodiscard]] extern auto to_string(blahdio::AudioType type) -> const char*;
+
+} // bench
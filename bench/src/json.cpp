@@ -0,0 +1,131 @@
+#include "json.h"
+#include <cmath>
+#include <cstdio>
+
+namespace bench {
+
+auto JsonWriter::begin_value(std::string_view key) -> void
+{
+	if (!not_empty_.empty())
+	{
+		if (not_empty_.back()) *out_ << ",";
+
+		not_empty_.back() = true;
+
+		*out_ << "\n" << std::string(not_empty_.size(), '\t');
+	}
+
+	if (!key.empty())
+	{
+		write_string(key);
+		*out_ << ": ";
+	}
+}
+
+auto JsonWriter::write_string(std::string_view string) -> void
+{
+	*out_ << '"';
+
+	for (const auto c : string)
+	{
+		switch (c)
+		{
+			case '"': *out_ << "\\\""; break;
+			case '\\': *out_ << "\\\\"; break;
+			case '\n': *out_ << "\\n"; break;
+			case '\t': *out_ << "\\t"; break;
+
+			default:
+			{
+				if ((unsigned char)(c) < 0x20)
+				{
+					char escaped[8];
+
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", unsigned(c));
+					*out_ << escaped;
+				}
+				else
+				{
+					*out_ << c;
+				}
+			}
+		}
+	}
+
+	*out_ << '"';
+}
+
+auto JsonWriter::begin_object(std::string_view key) -> void
+{
+	begin_value(key);
+	*out_ << "{";
+	not_empty_.push_back(false);
+}
+
+auto JsonWriter::end_object() -> void
+{
+	const auto had_values{not_empty_.back()};
+
+	not_empty_.pop_back();
+
+	if (had_values) *out_ << "\n" << std::string(not_empty_.size(), '\t');
+
+	*out_ << "}";
+
+	if (not_empty_.empty()) *out_ << "\n";
+}
+
+auto JsonWriter::begin_array(std::string_view key) -> void
+{
+	begin_value(key);
+	*out_ << "[";
+	not_empty_.push_back(false);
+}
+
+auto JsonWriter::end_array() -> void
+{
+	const auto had_values{not_empty_.back()};
+
+	not_empty_.pop_back();
+
+	if (had_values) *out_ << "\n" << std::string(not_empty_.size(), '\t');
+
+	*out_ << "]";
+}
+
+auto JsonWriter::value(std::string_view key, std::string_view value) -> void
+{
+	begin_value(key);
+	write_string(value);
+}
+
+auto JsonWriter::value(std::string_view key, double value) -> void
+{
+	begin_value(key);
+
+	// JSON has no infinity or NaN
+	if (!std::isfinite(value))
+	{
+		*out_ << "null";
+		return;
+	}
+
+	char buffer[32];
+
+	std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+	*out_ << buffer;
+}
+
+auto JsonWriter::value(std::string_view key, std::int64_t value) -> void
+{
+	begin_value(key);
+	*out_ << value;
+}
+
+auto JsonWriter::value(std::string_view key, bool value) -> void
+{
+	begin_value(key);
+	*out_ << (value ? "true" : "false");
+}
+
+} // bench
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+
+// Just enough JSON for the results. Keys are written in the order they
+// are added so two runs can be diffed line by line.
+class JsonWriter
+{
+public:
+
+	explicit JsonWriter(std::ostream* out) : out_{out} {}
+
+	auto begin_object(std::string_view key = {}) -> void;
+	auto end_object() -> void;
+	auto begin_array(std::string_view key) -> void;
+	auto end_array() -> void;
+
+	auto value(std::string_view key, std::string_view value) -> void;
+	auto value(std::string_view key, const char* value) -> void { this->value(key, std::string_view{value}); }
+	auto value(std::string_view key, double value) -> void;
+	auto value(std::string_view key, std::int64_t value) -> void;
+	auto value(std::string_view key, int value) -> void { this->value(key, std::int64_t(value)); }
+	auto value(std::string_view key, std::uint32_t value) -> void { this->value(key, std::int64_t(value)); }
+	auto value(std::string_view key, std::uint64_t value) -> void { this->value(key, std::int64_t(value)); }
+	auto value(std::string_view key, bool value) -> void;
+
+private:
+
+	auto begin_value(std::string_view key) -> void;
+	auto write_string(std::string_view string) -> void;
+
+	std::ostream* out_;
+
+	// Whether anything has been written yet at each level
+	std::vector<bool> not_empty_;
+};
+
+} // bench
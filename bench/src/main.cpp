@@ -0,0 +1,686 @@
+// Measures decode, encode, header probe and seek performance on inputs
+// generated at startup, and prints the results as JSON. See --help.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <blahdio/audio_writer.h>
+#include "inputs.h"
+#include "json.h"
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+	double seconds{30.0};
+	int num_channels{2};
+	int sample_rate{44100};
+	int repeat{5};
+	int probe_iterations{200};
+	int num_seeks{200};
+	std::vector<std::uint32_t> chunk_sizes{256, 4096, 65536};
+	std::filesystem::path work_dir{"bench_files"};
+	std::filesystem::path extra_dir;
+	std::filesystem::path out_path;
+};
+
+enum class Source { file, memory, stream };
+
+static constexpr Source SOURCES[] = { Source::file, Source::memory, Source::stream };
+
+static constexpr blahdio::AudioTypeHint HINTS[] =
+{
+	blahdio::AudioTypeHint::try_flac_first,
+	blahdio::AudioTypeHint::try_mp3_first,
+	blahdio::AudioTypeHint::try_wav_first,
+	blahdio::AudioTypeHint::try_wavpack_first,
+	blahdio::AudioTypeHint::try_flac_only,
+	blahdio::AudioTypeHint::try_mp3_only,
+	blahdio::AudioTypeHint::try_wav_only,
+	blahdio::AudioTypeHint::try_wavpack_only,
+};
+
+[[nodiscard]] static
+auto to_string(Source source) -> const char*
+{
+	switch (source)
+	{
+		case Source::file: return "file";
+		case Source::memory: return "memory";
+		case Source::stream: default: return "stream";
+	}
+}
+
+[[nodiscard]] static
+auto to_string(blahdio::AudioTypeHint hint) -> const char*
+{
+	switch (hint)
+	{
+		case blahdio::AudioTypeHint::try_flac_first: return "try_flac_first";
+		case blahdio::AudioTypeHint::try_mp3_first: return "try_mp3_first";
+		case blahdio::AudioTypeHint::try_wav_first: return "try_wav_first";
+		case blahdio::AudioTypeHint::try_wavpack_first: return "try_wavpack_first";
+		case blahdio::AudioTypeHint::try_flac_only: return "try_flac_only";
+		case blahdio::AudioTypeHint::try_mp3_only: return "try_mp3_only";
+		case blahdio::AudioTypeHint::try_wav_only: return "try_wav_only";
+		case blahdio::AudioTypeHint::try_wavpack_only: default: return "try_wavpack_only";
+	}
+}
+
+[[nodiscard]] static
+auto get_hint(blahdio::AudioType type) -> blahdio::AudioTypeHint
+{
+	switch (type)
+	{
+		case blahdio::AudioType::flac: return blahdio::AudioTypeHint::try_flac_only;
+		case blahdio::AudioType::mp3: return blahdio::AudioTypeHint::try_mp3_only;
+		case blahdio::AudioType::wavpack: return blahdio::AudioTypeHint::try_wavpack_only;
+		case blahdio::AudioType::wav: default: return blahdio::AudioTypeHint::try_wav_only;
+	}
+}
+
+[[nodiscard]] static
+auto seconds_since(Clock::time_point start) -> double
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Sorts the samples
+[[nodiscard]] static
+auto percentile(std::vector<double>* samples, double p) -> double
+{
+	if (samples->empty()) return 0.0;
+
+	std::sort(samples->begin(), samples->end());
+
+	return (*samples)[std::min(samples->size() - 1, std::size_t(p * double(samples->size())))];
+}
+
+// A read stream over a block of memory, for the stream source
+class MemoryStream
+{
+public:
+
+	explicit MemoryStream(const std::vector<char>& bytes) : bytes_{&bytes} {}
+
+	[[nodiscard]] auto stream() -> blahdio::AudioReader::Stream
+	{
+		blahdio::AudioReader::Stream out;
+
+		out.read_bytes = [this](void* buffer, std::uint32_t bytes_to_read)
+		{
+			const auto size{std::uint32_t(std::min<std::uint64_t>(bytes_to_read, bytes_->size() - position_))};
+
+			std::memcpy(buffer, bytes_->data() + position_, size);
+			position_ += size;
+
+			return size;
+		};
+
+		out.seek = [this](blahdio::AudioReader::Stream::SeekOrigin origin, std::int64_t offset)
+		{
+			const auto base{origin == blahdio::AudioReader::Stream::SeekOrigin::Start ? 0 : std::int64_t(position_)};
+			const auto position{base + offset};
+
+			if (position < 0 || std::uint64_t(position) > bytes_->size()) return false;
+
+			position_ = std::uint64_t(position);
+
+			return true;
+		};
+
+		out.get_size = [this]() { return std::uint64_t(bytes_->size()); };
+
+		return out;
+	}
+
+private:
+
+	const std::vector<char>* bytes_;
+	std::uint64_t position_{0};
+};
+
+// Keeps whatever the reader's source needs alive for as long as the
+// reader
+struct OpenReader
+{
+	std::optional<MemoryStream> memory_stream;
+	std::optional<blahdio::AudioReader> reader;
+};
+
+static
+auto open_reader(const Input& input, Source source, blahdio::AudioTypeHint hint, OpenReader* out) -> void
+{
+	switch (source)
+	{
+		case Source::file:
+		{
+			out->reader.emplace(input.path.string(), hint);
+			break;
+		}
+
+		case Source::memory:
+		{
+			out->reader.emplace((const void*)(input.bytes.data()), input.bytes.size(), hint);
+			break;
+		}
+
+		case Source::stream:
+		{
+			out->memory_stream.emplace(input.bytes);
+			out->reader.emplace(out->memory_stream->stream(), hint);
+			break;
+		}
+	}
+}
+
+static
+auto run_decode(const Options& options, const std::vector<Input>& inputs, JsonWriter* json) -> void
+{
+	json->begin_array("decode");
+
+	for (const auto& input : inputs)
+	{
+		for (const auto source : SOURCES)
+		{
+			for (const auto chunk_size : options.chunk_sizes)
+			{
+				std::vector<double> times;
+				std::uint64_t frames_read{0};
+				int num_channels{0};
+				std::string error;
+
+				for (int i = 0; i < options.repeat && error.empty(); i++)
+				{
+					frames_read = 0;
+
+					const auto start{Clock::now()};
+
+					OpenReader open;
+
+					open_reader(input, source, get_hint(input.type), &open);
+
+					blahdio::AudioReader::Callbacks callbacks;
+
+					callbacks.should_abort = []() { return false; };
+					callbacks.return_chunk = [&](const void*, std::uint64_t, std::uint32_t num_frames)
+					{
+						frames_read += num_frames;
+					};
+
+					const auto result{open.reader->read_frames(callbacks, chunk_size)};
+
+					times.push_back(seconds_since(start));
+
+					if (!result)
+					{
+						error = result.error();
+						break;
+					}
+
+					num_channels = open.reader->get_format()->num_channels;
+				}
+
+				const auto seconds{percentile(&times, 0.5)};
+
+				json->begin_object();
+				json->value("input", input.name);
+				json->value("format", bench::to_string(input.type));
+				json->value("source", to_string(source));
+				json->value("chunk_size", chunk_size);
+
+				if (error.empty())
+				{
+					json->value("frames", frames_read);
+					json->value("seconds", seconds);
+					json->value("frames_per_sec", double(frames_read) / seconds);
+					json->value("input_mb_per_sec", (double(input.bytes.size()) / 1e6) / seconds);
+					json->value("output_mb_per_sec", (double(frames_read * num_channels * sizeof(float)) / 1e6) / seconds);
+				}
+				else
+				{
+					json->value("error", error);
+				}
+
+				json->end_object();
+			}
+		}
+	}
+
+	json->end_array();
+}
+
+// A write stream into a block of memory
+class MemorySink
+{
+public:
+
+	[[nodiscard]] auto stream() -> blahdio::AudioWriter::Stream
+	{
+		blahdio::AudioWriter::Stream out;
+
+		out.write_bytes = [this](const void* data, std::uint32_t bytes_to_write)
+		{
+			if (position_ + bytes_to_write > bytes_.size())
+			{
+				bytes_.resize(position_ + bytes_to_write);
+			}
+
+			std::memcpy(bytes_.data() + position_, data, bytes_to_write);
+			position_ += bytes_to_write;
+
+			return bytes_to_write;
+		};
+
+		out.seek = [this](blahdio::AudioWriter::Stream::SeekOrigin origin, std::int64_t offset)
+		{
+			const auto base{origin == blahdio::AudioWriter::Stream::SeekOrigin::Start ? 0 : std::int64_t(position_)};
+			const auto position{base + offset};
+
+			if (position < 0 || std::uint64_t(position) > bytes_.size()) return false;
+
+			position_ = std::size_t(position);
+
+			return true;
+		};
+
+		return out;
+	}
+
+	[[nodiscard]] auto size() const { return bytes_.size(); }
+
+private:
+
+	std::vector<char> bytes_;
+	std::size_t position_{0};
+};
+
+static
+auto run_encode(const Options& options, const std::vector<float>& signal, std::uint64_t num_frames, JsonWriter* json) -> void
+{
+	using StorageType = blahdio::AudioDataFormat::StorageType;
+
+	struct Target
+	{
+		const char* name;
+		blahdio::AudioType type;
+		int bit_depth;
+		StorageType storage_type;
+	};
+
+	static constexpr Target TARGETS[] =
+	{
+		{ "wav_s16", blahdio::AudioType::wav, 16, StorageType::Int },
+		{ "wav_s24", blahdio::AudioType::wav, 24, StorageType::Int },
+		{ "wav_f32", blahdio::AudioType::wav, 32, StorageType::Float },
+		{ "wavpack_s16", blahdio::AudioType::wavpack, 16, StorageType::Int },
+		{ "wavpack_s24", blahdio::AudioType::wavpack, 24, StorageType::Int },
+		{ "wavpack_f32", blahdio::AudioType::wavpack, 32, StorageType::Float },
+	};
+
+	static constexpr Source WRITE_SOURCES[] = { Source::file, Source::stream };
+
+	json->begin_array("encode");
+
+	for (const auto& target : TARGETS)
+	{
+		blahdio::AudioDataFormat format;
+
+		format.num_frames = num_frames;
+		format.num_channels = options.num_channels;
+		format.sample_rate = options.sample_rate;
+		format.bit_depth = target.bit_depth;
+		format.storage_type = target.storage_type;
+
+		for (const auto source : WRITE_SOURCES)
+		{
+			for (const auto chunk_size : options.chunk_sizes)
+			{
+				std::vector<double> times;
+				std::uintmax_t bytes_written{0};
+				std::string error;
+
+				for (int i = 0; i < options.repeat && error.empty(); i++)
+				{
+					blahdio::AudioWriter::Callbacks callbacks;
+
+					callbacks.should_abort = []() { return false; };
+					callbacks.get_next_chunk = [&](float* buffer, std::uint64_t frame, std::uint32_t frames_to_write)
+					{
+						const auto first{signal.data() + (frame * options.num_channels)};
+
+						std::memcpy(buffer, first, std::size_t(frames_to_write) * options.num_channels * sizeof(float));
+					};
+
+					const auto path{options.work_dir / (std::string("encode_") + target.name)};
+
+					try
+					{
+						const auto start{Clock::now()};
+
+						if (source == Source::file)
+						{
+							blahdio::AudioWriter writer(path.string(), target.type, format);
+
+							writer.write_frames(callbacks, chunk_size);
+							times.push_back(seconds_since(start));
+							bytes_written = std::filesystem::file_size(path);
+						}
+						else
+						{
+							MemorySink sink;
+
+							blahdio::AudioWriter writer(sink.stream(), target.type, format);
+
+							writer.write_frames(callbacks, chunk_size);
+							times.push_back(seconds_since(start));
+							bytes_written = sink.size();
+						}
+					}
+					catch (const std::exception& err)
+					{
+						error = err.what();
+					}
+				}
+
+				const auto seconds{percentile(&times, 0.5)};
+
+				json->begin_object();
+				json->value("output", target.name);
+				json->value("format", bench::to_string(target.type));
+				json->value("target", source == Source::file ? "file" : "stream");
+				json->value("chunk_size", chunk_size);
+
+				if (error.empty())
+				{
+					json->value("frames", num_frames);
+					json->value("seconds", seconds);
+					json->value("frames_per_sec", double(num_frames) / seconds);
+					json->value("output_mb_per_sec", (double(bytes_written) / 1e6) / seconds);
+				}
+				else
+				{
+					json->value("error", error);
+				}
+
+				json->end_object();
+			}
+		}
+	}
+
+	json->end_array();
+}
+
+// The source is memory so that only the header parsing is measured
+static
+auto run_probe(const Options& options, const std::vector<Input>& inputs, JsonWriter* json) -> void
+{
+	json->begin_array("probe");
+
+	for (const auto& input : inputs)
+	{
+		for (const auto hint : HINTS)
+		{
+			std::vector<double> times;
+			bool ok{true};
+
+			for (int i = 0; i < options.probe_iterations; i++)
+			{
+				const auto start{Clock::now()};
+
+				blahdio::AudioReader reader((const void*)(input.bytes.data()), input.bytes.size(), hint);
+
+				ok = reader.read_header().has_value();
+
+				times.push_back(seconds_since(start) * 1e6);
+			}
+
+			json->begin_object();
+			json->value("input", input.name);
+			json->value("hint", to_string(hint));
+			json->value("ok", ok);
+			json->value("median_us", percentile(&times, 0.5));
+			json->value("p99_us", percentile(&times, 0.99));
+			json->end_object();
+		}
+	}
+
+	json->end_array();
+}
+
+// Each seek is followed by a short read, since some decoders only do
+// the work of a seek when the next frames are read
+static
+auto run_seek(const Options& options, const std::vector<Input>& inputs, JsonWriter* json) -> void
+{
+	static constexpr std::uint32_t READ_SIZE = 512;
+
+	json->begin_array("seek");
+
+	for (const auto& input : inputs)
+	{
+		for (const auto source : SOURCES)
+		{
+			OpenReader open;
+
+			open_reader(input, source, get_hint(input.type), &open);
+
+			json->begin_object();
+			json->value("input", input.name);
+			json->value("source", to_string(source));
+
+			const auto format{open.reader->read_header()};
+
+			if (!format)
+			{
+				json->value("error", format.error());
+				json->end_object();
+				continue;
+			}
+
+			// Opening the streamer can build a seek index, which isn't
+			// what's being measured
+			const auto open_start{Clock::now()};
+
+			auto streamer{open.reader->streamer()};
+
+			const auto open_seconds{seconds_since(open_start)};
+
+			std::vector<float> buffer(std::size_t(READ_SIZE) * format->num_channels);
+			std::vector<double> times;
+			std::mt19937_64 rng{42};
+			std::uniform_int_distribution<std::uint64_t> frames{0, format->num_frames > READ_SIZE ? format->num_frames - READ_SIZE : 0};
+			std::string error;
+
+			for (int i = 0; i < options.num_seeks; i++)
+			{
+				const auto start{Clock::now()};
+
+				if (const auto result{streamer.seek(frames(rng))}; !result)
+				{
+					error = result.error();
+					break;
+				}
+
+				if (const auto result{streamer.read_frames(buffer.data(), READ_SIZE)}; !result)
+				{
+					error = result.error();
+					break;
+				}
+
+				times.push_back(seconds_since(start) * 1e6);
+			}
+
+			json->value("streamer_open_us", open_seconds * 1e6);
+
+			if (error.empty())
+			{
+				json->value("seeks", std::uint64_t(times.size()));
+				json->value("median_us", percentile(&times, 0.5));
+				json->value("p99_us", percentile(&times, 0.99));
+				json->value("max_us", times.empty() ? 0.0 : times.back());
+			}
+			else
+			{
+				json->value("error", error);
+			}
+
+			json->end_object();
+		}
+	}
+
+	json->end_array();
+}
+
+static
+auto print_help() -> void
+{
+	std::cout <<
+		"Usage: blahdio_bench [options]\n"
+		"\n"
+		"  --seconds N            Length of the generated inputs (default 30)\n"
+		"  --channels N           Channels in the generated inputs (default 2)\n"
+		"  --sample-rate N        Sample rate of the generated inputs (default 44100)\n"
+		"  --repeat N             Runs of each decode and encode, the median is reported (default 5)\n"
+		"  --probe-iterations N   Header reads per input and type hint (default 200)\n"
+		"  --seeks N              Random seeks per input and source (default 200)\n"
+		"  --chunk-sizes A,B,...  Chunk sizes to decode and encode with (default 256,4096,65536)\n"
+		"  --work-dir DIR         Where the inputs are generated (default bench_files)\n"
+		"  --inputs DIR           Also benchmark the WAV, FLAC, MP3 and WavPack files in DIR\n"
+		"  --out FILE             Write the JSON results here instead of to stdout\n"
+		"  --skip NAME            Skip decode, encode, probe or seek. Can be repeated.\n";
+}
+
+[[nodiscard]] static
+auto parse_chunk_sizes(const std::string& list) -> std::vector<std::uint32_t>
+{
+	std::vector<std::uint32_t> out;
+	std::size_t start{0};
+
+	while (start < list.size())
+	{
+		const auto end{std::min(list.find(',', start), list.size())};
+
+		out.push_back(std::uint32_t(std::stoul(list.substr(start, end - start))));
+		start = end + 1;
+	}
+
+	return out;
+}
+
+} // bench
+
+int main(int argc, char** argv)
+{
+	using namespace bench;
+
+	Options options;
+	std::vector<std::string> skip;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg{argv[i]};
+
+		const auto next = [&]() -> std::string
+		{
+			if (i + 1 >= argc)
+			{
+				std::cerr << "Missing value for " << arg << "\n";
+				std::exit(EXIT_FAILURE);
+			}
+
+			return argv[++i];
+		};
+
+		if (arg == "--help" || arg == "-h") { print_help(); return EXIT_SUCCESS; }
+		else if (arg == "--seconds") options.seconds = std::stod(next());
+		else if (arg == "--channels") options.num_channels = std::stoi(next());
+		else if (arg == "--sample-rate") options.sample_rate = std::stoi(next());
+		else if (arg == "--repeat") options.repeat = std::max(1, std::stoi(next()));
+		else if (arg == "--probe-iterations") options.probe_iterations = std::max(1, std::stoi(next()));
+		else if (arg == "--seeks") options.num_seeks = std::max(1, std::stoi(next()));
+		else if (arg == "--chunk-sizes") options.chunk_sizes = parse_chunk_sizes(next());
+		else if (arg == "--work-dir") options.work_dir = next();
+		else if (arg == "--inputs") options.extra_dir = next();
+		else if (arg == "--out") options.out_path = next();
+		else if (arg == "--skip") skip.push_back(next());
+		else
+		{
+			std::cerr << "Unknown option " << arg << "\n";
+			print_help();
+			return EXIT_FAILURE;
+		}
+	}
+
+	const auto should_run = [&](const char* name) { return std::find(skip.begin(), skip.end(), name) == skip.end(); };
+
+	const auto num_frames{std::uint64_t(options.seconds * options.sample_rate)};
+	const auto signal{generate_signal(num_frames, options.num_channels, options.sample_rate)};
+
+	InputOptions input_options;
+
+	input_options.dir = options.work_dir;
+	input_options.num_frames = num_frames;
+	input_options.num_channels = options.num_channels;
+	input_options.sample_rate = options.sample_rate;
+	input_options.extra_dir = options.extra_dir;
+
+	std::vector<std::string> skipped;
+
+	const auto inputs{make_inputs(input_options, signal, &skipped)};
+
+	if (std::none_of(inputs.begin(), inputs.end(), [](const Input& input) { return input.type == blahdio::AudioType::mp3; }))
+	{
+		skipped.push_back("mp3: can't be generated, pass some with --inputs");
+	}
+
+	std::ofstream out_file;
+
+	if (!options.out_path.empty())
+	{
+		out_file.open(options.out_path);
+	}
+
+	JsonWriter json{options.out_path.empty() ? &std::cout : &out_file};
+
+	json.begin_object();
+	json.value("version", 1);
+
+	json.begin_object("settings");
+	json.value("frames", num_frames);
+	json.value("channels", options.num_channels);
+	json.value("sample_rate", options.sample_rate);
+	json.value("repeat", options.repeat);
+	json.value("probe_iterations", options.probe_iterations);
+	json.value("seeks", options.num_seeks);
+	json.end_object();
+
+	json.begin_array("skipped");
+
+	for (const auto& reason : skipped)
+	{
+		json.value({}, reason);
+	}
+
+	json.end_array();
+
+	if (should_run("decode")) run_decode(options, inputs, &json);
+	if (should_run("encode")) run_encode(options, signal, num_frames, &json);
+	if (should_run("probe")) run_probe(options, inputs, &json);
+	if (should_run("seek")) run_seek(options, inputs, &json);
+
+	json.end_object();
+
+	return EXIT_SUCCESS;
+}
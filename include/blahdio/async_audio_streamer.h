@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "blahdio/output_format.h"
+#include "blahdio/stats.h"
+
+namespace blahdio {
+
+namespace impl { class AudioReader; class AsyncAudioStreamer; }
+
+// A streamer which decodes ahead of the reader on a background thread.
+// read_frames() only copies frames which have already been decoded, so
+// it never waits for the source and can be called from an audio
+// callback. If the decoder has fallen behind it returns what it has and
+// reports an underrun instead of blocking.
+//
+// read_frames(), read_planar_frames() and seek() must all be called
+// from the same thread.
+class AsyncAudioStreamer
+{
+public:
+
+	struct Options
+	{
+		// Frames to keep decoded ahead of the read position. Raised to
+		// chunk_size if it is smaller.
+		std::uint32_t read_ahead{1 << 16};
+
+		// Frames decoded at a time by the background thread. Raised to
+		// 1 if it is 0.
+		std::uint32_t chunk_size{4096};
+	};
+
+	enum class Status
+	{
+		ok,
+
+		// Fewer frames were ready than were asked for, because the
+		// decoder is behind or is still refilling after a seek. The rest
+		// of the buffer is left untouched.
+		underrun,
+
+		// The end of the stream was reached. The rest of the buffer is
+		// left untouched.
+		end,
+
+		// Decoding failed. See get_error().
+		error,
+	};
+
+	struct ReadResult
+	{
+		std::uint32_t frames_read{};
+		Status status{Status::ok};
+	};
+
+	AsyncAudioStreamer();
+	AsyncAudioStreamer(AsyncAudioStreamer&&) noexcept;
+	auto operator=(AsyncAudioStreamer&&) noexcept -> AsyncAudioStreamer&;
+	AsyncAudioStreamer(std::shared_ptr<impl::AudioReader> reader, OutputFormat output_format, Options options);
+	~AsyncAudioStreamer();
+
+	// The frames are in the output format the streamer was created with
+	[[nodiscard]] auto read_frames(void* buffer, std::uint32_t frames_to_read) -> ReadResult;
+
+	// Same as read_frames() but into one buffer per channel
+	[[nodiscard]] auto read_planar_frames(void* const* channels, std::uint32_t frames_to_read) -> ReadResult;
+
+	// Drops the frames decoded so far and has the background thread
+	// refill from the new position. Reads report an underrun until it
+	// has started.
+	auto seek(std::uint64_t frame) -> void;
+
+	// The reason for the last Status::error. Not real-time safe.
+	[[nodiscard]] auto get_error() const -> std::string;
+
+	// Totals since the streamer was created, including the background
+	// thread's decoding. Can be called from any thread.
+	[[nodiscard]] auto get_stats() const -> Stats;
+
+private:
+
+	std::unique_ptr<impl::AsyncAudioStreamer> impl_;
+};
+
+}
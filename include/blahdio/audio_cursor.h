@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include "blahdio/expected.h"
+#include "blahdio/stats.h"
+
+namespace blahdio {
+
+namespace impl { class AudioCursor; }
+
+// A read position of its own in a reader's source, with its own decoder.
+// Any number of cursors can be open at once, alongside the reader's
+// streamer, and each one can be used from a different thread. They
+// share the reader's source (and its memory mapping) and seek index, and
+// keep the reader's internals alive. A single cursor is not thread safe.
+class AudioCursor
+{
+public:
+
+	AudioCursor();
+	AudioCursor(AudioCursor&&) noexcept;
+	auto operator=(AudioCursor&&) noexcept -> AudioCursor&;
+	AudioCursor(std::unique_ptr<impl::AudioCursor> impl);
+	~AudioCursor();
+
+	// Return value < frames_to_read indicates the end of the data. The
+	// frames are in the output format the cursor was opened with
+	auto read_frames(void* buffer, std::uint32_t frames_to_read) -> expected<std::uint32_t>;
+
+	// Same as read_frames() but into one buffer per channel
+	auto read_planar_frames(void* const* channels, std::uint32_t frames_to_read) -> expected<std::uint32_t>;
+	auto seek(std::uint64_t frame) -> expected<void>;
+
+	// Totals since the cursor was opened. Can be called from any thread.
+	[[nodiscard]] auto get_stats() const -> Stats;
+
+private:
+
+	std::unique_ptr<impl::AudioCursor> impl_;
+};
+
+}
@@ -20,6 +20,19 @@ struct AudioDataFormat
 	int sample_rate { 0 };
 	int bit_depth { 0 };
 
+	// False if num_frames is only an estimate, or 0 because it isn't
+	// known yet. This happens when reading MP3 data with no Xing/VBRI
+	// tag, since working out the exact length would mean decoding the
+	// whole stream. Once all
+	// the frames have been read by AudioReader::read_frames() the
+	// reader's format is updated with the exact count.
+	bool num_frames_exact { true };
+
+	// Number of frames of padding the encoder added at the start and end
+	// of the stream, if known (from the LAME tag of an MP3 file.)
+	std::uint32_t encoder_delay { 0 };
+	std::uint32_t encoder_padding { 0 };
+
 	StorageType storage_type { StorageType::Default };
 };
 
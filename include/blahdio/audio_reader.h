@@ -3,9 +3,14 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
+#include "blahdio/async_audio_streamer.h"
+#include "blahdio/audio_cursor.h"
 #include "blahdio/audio_data_format.h"
 #include "blahdio/audio_type.h"
 #include "blahdio/expected.h"
+#include "blahdio/output_format.h"
+#include "blahdio/stats.h"
 
 namespace blahdio {
 
@@ -21,9 +26,26 @@ public:
 	{
 		using ShouldAbortFunc = std::function<bool()>;
 		using ReturnChunkFunc = std::function<void(const void* data, uint64_t first_frame_index, uint32_t num_frames)>;
+		using ReturnPlanarChunkFunc = std::function<void(const void* const* channels, uint64_t first_frame_index, uint32_t num_frames)>;
 
 		ShouldAbortFunc should_abort;
 		ReturnChunkFunc return_chunk;
+
+		// Only called (instead of return_chunk) if the output format is
+		// planar. The channel buffers belong to the reader and are only
+		// valid during the call.
+		ReturnPlanarChunkFunc return_planar_chunk;
+	};
+
+	enum class ZeroCopy
+	{
+		// The source isn't in memory, or the samples aren't float32
+		unavailable,
+
+		// The samples aren't aligned for float access, so they are copied
+		misaligned,
+
+		available,
 	};
 
 	struct Stream
@@ -36,11 +58,20 @@ public:
 		// Returning a value < bytes_to_read indicates the end of the stream.
 		using ReadBytesFunc = std::function<uint32_t(void* buffer, uint32_t bytes_to_read)>;
 
-		SeekFunc seek; // Not needed for WavPack reading
+		// Returns the total size of the stream in bytes
+		using GetSizeFunc = std::function<uint64_t()>;
+
+		SeekFunc seek; // Not needed for WavPack reading, but see get_size
 		ReadBytesFunc read_bytes;
+
+		// Optional. WavPack streams can only be seeked if this and seek are
+		// both provided, otherwise they are decoded front to back.
+		GetSizeFunc get_size;
 	};
 	
-	// Read from file
+	// Read from file. If the library was built with BLAHDIO_ENABLE_MMAP
+	// the file is memory mapped where possible, in which case it must not
+	// be truncated while the reader (or any of its streamers) exists.
 	AudioReader(std::string utf8_path, AudioTypeHint type_hint);
 
 	// Read from stream
@@ -52,19 +83,76 @@ public:
 	// Size in bytes of each frame to return when reading AudioType::Binary data
 	auto set_binary_frame_size(int frame_size) -> void;
 
-	// Create a streamer
-	[[nodiscard]] auto streamer() -> AudioStreamer;
+	// In session mode the decoder which is opened by read_header() is kept
+	// open and handed over to the next call to read_frames() or streamer(),
+	// so the source only has to be opened and parsed once. The source stays
+	// open until then.
+	auto set_session_mode(bool enabled) -> void;
+
+	// Build a seek index for FLAC and WavPack data on a background thread,
+	// starting with the first call to read_frames() or streamer(). Until
+	// it is ready, streamers seek the usual way. Not supported for stream
+	// sources, which can't be scanned while they are being decoded.
+	auto set_build_seek_index(bool enabled) -> void;
+
+	// When enabled, read_frames() passes return_chunk() pointers straight
+	// into the source instead of copies, if the source is in memory (or
+	// a mapped file) and the samples are already little endian float32.
+	// Currently only for WAV data. The pointers are only valid during the
+	// call to return_chunk(). See get_zero_copy() for whether it applies.
+	auto set_zero_copy(bool enabled) -> void;
+
+	// Decode FLAC, WAV and WavPack data on up to this many threads in
+	// read_frames(), by splitting it into segments which are decoded
+	// independently. Chunks are still returned on the calling thread,
+	// and are the same chunks as when decoding on one thread. If in_order
+	// is false they are returned as soon as their segment is ready, so
+	// first_frame_index says where each one goes. Short files, MP3 data
+	// and stream sources are always decoded on the calling thread.
+	auto set_decode_threads(int num_threads, bool in_order = true) -> void;
+
+	// Create a streamer. Only one streamer can be open at a time, see
+	// cursor() for reading from more than one place at once.
+	[[nodiscard]] auto streamer(OutputFormat output_format = {}) -> AudioStreamer;
+
+	// Create a streamer which decodes ahead on a background thread. Like
+	// streamer(), only one can be open at a time.
+	[[nodiscard]] auto async_streamer(AsyncAudioStreamer::Options options, OutputFormat output_format = {}) -> AsyncAudioStreamer;
+
+	// Open an independent cursor over the source. The header must be
+	// read first. This can be called from any thread, also while a
+	// streamer is open or read_frames() is running. Not supported for
+	// MP3 data, whose seeks have to decode from the start, or for stream
+	// sources, which can't be read from two places at once.
+	[[nodiscard]] auto cursor(OutputFormat output_format = {}) -> expected<AudioCursor>;
 
 	// Just read the header
 	[[nodiscard]] auto read_header() -> expected<AudioDataFormat>;
 
 	// Read all of the frames
 	// If the header has not been read yet, it will be read automatically here
-	[[nodiscard]] auto read_frames(Callbacks callbacks, uint32_t chunk_size) -> expected<void>;
+	// Chunks are returned in the requested output format (float32 by
+	// default.) Zero copy only applies to interleaved float32 output.
+	[[nodiscard]] auto read_frames(Callbacks callbacks, uint32_t chunk_size, OutputFormat output_format = {}) -> expected<void>;
 
 	// Header must be read first before calling these
 	[[nodiscard]] auto get_format() const -> expected<AudioDataFormat>;
 	[[nodiscard]] auto get_type() const -> expected<AudioType>;
+	[[nodiscard]] auto get_zero_copy() const -> expected<ZeroCopy>;
+
+	// A seek index lets a streamer seek without searching through the
+	// source. For MP3 data one is built when the first streamer is
+	// opened, which means scanning the whole source once. For FLAC and
+	// WavPack data see set_build_seek_index(). It can be saved and given
+	// back to a reader of the same source in a later session to skip the
+	// scan. Set it before creating a streamer. Getting the index waits
+	// for it to finish building.
+	[[nodiscard]] auto set_seek_index(const std::vector<std::byte>& index) -> expected<void>;
+	[[nodiscard]] auto get_seek_index() const -> expected<std::vector<std::byte>>;
+
+	// Totals for read_header() and read_frames(). Streamers and cursors
+	// keep their own.
+	[[nodiscard]] auto get_stats() const -> Stats;
 
 private:
 
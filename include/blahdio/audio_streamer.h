@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <memory>
 #include "blahdio/expected.h"
+#include "blahdio/output_format.h"
+#include "blahdio/stats.h"
 
 namespace blahdio {
 
@@ -12,16 +14,65 @@ class AudioStreamer
 {
 public:
 
+	enum class Error
+	{
+		none,
+		uninitialized,
+
+		// The stream couldn't be opened, or reserve() hasn't been called
+		not_open,
+
+		// More frames were asked for than were reserved
+		too_many_frames,
+
+		seek_failed,
+	};
+
+	struct RealtimeResult
+	{
+		std::uint32_t frames_read{};
+		Error error{Error::none};
+	};
+
 	AudioStreamer();
 	AudioStreamer(AudioStreamer&&) noexcept;
 	auto operator=(AudioStreamer&&)  noexcept-> AudioStreamer&;
-	AudioStreamer(std::shared_ptr<impl::AudioReader> reader);
+	AudioStreamer(std::shared_ptr<impl::AudioReader> reader, OutputFormat output_format = {});
 	~AudioStreamer();
 
-	// Return value < frames_to_read indicates the end of the stream
+	// Return value < frames_to_read indicates the end of the stream. The
+	// frames are in the output format the streamer was created with
 	auto read_frames(void* buffer, std::uint32_t frames_to_read) -> expected<uint32_t>;
+
+	// Same as read_frames() but into one buffer per channel. Buffers
+	// aligned to 64 bytes are written fastest.
+	auto read_planar_frames(void* const* channels, std::uint32_t frames_to_read) -> expected<uint32_t>;
 	auto seek(std::uint64_t frame) -> expected<void>;
 
+	// Real-time safe streaming. After reserve(), the *_realtime()
+	// functions below don't allocate, lock or throw, as long as no more
+	// than max_frames_per_read are read at a time. This holds for WAV,
+	// FLAC and MP3 data in memory (including mapped files.) Other
+	// sources go through the caller's stream or the C library's file
+	// functions, and WavPack decoding allocates inside the library
+	// whenever it reaches a new block. Resampling doesn't allocate once
+	// reserve() has been called either.
+	//
+	// A seek index which is still being built in the background when
+	// reserve() is called is not picked up by later seeks. Call reserve()
+	// again (from a thread where that is allowed) to pick it up.
+	auto reserve(std::uint32_t max_frames_per_read) -> expected<void>;
+
+	[[nodiscard]] auto read_frames_realtime(void* buffer, std::uint32_t frames_to_read) noexcept -> RealtimeResult;
+	[[nodiscard]] auto read_planar_frames_realtime(void* const* channels, std::uint32_t frames_to_read) noexcept -> RealtimeResult;
+	[[nodiscard]] auto seek_realtime(std::uint64_t frame) noexcept -> Error;
+
+	// Totals since the streamer was created. Can be called from any
+	// thread.
+	[[nodiscard]] auto get_stats() const -> Stats;
+
+	[[nodiscard]] static auto get_error_message(Error error) noexcept -> const char*;
+
 private:
 
 	std::unique_ptr<impl::AudioStreamer> impl_;
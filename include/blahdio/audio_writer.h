@@ -4,11 +4,23 @@
 #include <string>
 #include "blahdio/audio_data_format.h"
 #include "blahdio/audio_type.h"
+#include "blahdio/stats.h"
 
 namespace blahdio {
 
 namespace impl { class AudioWriter; }
 
+// Noise added to float samples before they are rounded to integers, so
+// the rounding error doesn't follow the signal. Only used when the
+// format's storage type is Int.
+enum class Dither
+{
+	none,
+
+	// +/-1 LSB of triangular (TPDF) noise
+	triangular,
+};
+
 class AudioWriter
 {
 public:
@@ -44,8 +56,15 @@ public:
 
 	~AudioWriter();
 
+	// Triangular by default. Must be set before write_frames() is called.
+	void set_dither(Dither dither);
+
 	void write_frames(Callbacks callbacks, std::uint32_t chunk_size);
 
+	// Totals since the writer was created. Can be called from any
+	// thread, for example while write_frames() is running.
+	Stats get_stats() const;
+
 private:
 
 	impl::AudioWriter* impl_;
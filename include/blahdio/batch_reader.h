@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+#include "blahdio/audio_data_format.h"
+#include "blahdio/audio_reader.h"
+#include "blahdio/audio_type.h"
+#include "blahdio/expected.h"
+#include "blahdio/output_format.h"
+
+namespace blahdio {
+
+namespace impl { class BatchReader; }
+
+// Decodes many sources at once on a pool of threads which is kept
+// alive between calls to read(). Each thread works on one source at a
+// time and hands its chunks straight to the callbacks, so no more than
+// one chunk per thread is held in memory.
+class BatchReader
+{
+public:
+
+	struct Memory
+	{
+		const void* data{};
+		std::size_t size{};
+	};
+
+	// A file path, a block of memory, or a stream which must outlive the
+	// call to read()
+	using Source = std::variant<std::string, Memory, const AudioReader::Stream*>;
+
+	struct Item
+	{
+		Source source;
+		AudioTypeHint type_hint{AudioTypeHint::try_wav_first};
+	};
+
+	// Called from the pool's threads, possibly for several items at the
+	// same time. index is the item's position in the list passed to
+	// read(). The chunk buffers are only valid during the call.
+	struct Callbacks
+	{
+		using ShouldAbortFunc = std::function<bool()>;
+		using HeaderFunc = std::function<void(std::size_t index, const AudioDataFormat& format)>;
+		using ReturnChunkFunc = std::function<void(std::size_t index, const void* data, std::uint64_t first_frame_index, std::uint32_t num_frames)>;
+		using ReturnPlanarChunkFunc = std::function<void(std::size_t index, const void* const* channels, std::uint64_t first_frame_index, std::uint32_t num_frames)>;
+
+		// Optional. Checked before each item is started and between chunks.
+		ShouldAbortFunc should_abort;
+
+		// Optional. Called once the item's header has been read, before
+		// any of its chunks.
+		HeaderFunc header;
+
+		ReturnChunkFunc return_chunk;
+
+		// Only called (instead of return_chunk) if the output format is
+		// planar
+		ReturnPlanarChunkFunc return_planar_chunk;
+	};
+
+	// 0 means one thread per hardware thread
+	explicit BatchReader(int num_threads = 0);
+	~BatchReader();
+
+	// Returns once every item has been read (or failed), with one result
+	// per item in the same order. An item's result is its format, or the
+	// reason it couldn't be read.
+	[[nodiscard]] auto read(const std::vector<Item>& items, Callbacks callbacks, std::uint32_t chunk_size, OutputFormat output_format = {}) -> std::vector<expected<AudioDataFormat>>;
+
+private:
+
+	std::unique_ptr<impl::BatchReader> impl_;
+};
+
+}
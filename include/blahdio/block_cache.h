@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace blahdio {
+
+// AudioStreamer and AudioCursor can keep the frames they decode in a cache
+// which is shared by the whole process, so that reading the same part
+// of a source again (for example after seeking back to it) doesn't
+// decode it again. Frames are cached in blocks, per source and output
+// sample format. Files are identified by path, size and modification
+// time. Blocks decoded from memory are only shared by the streamers and
+// cursors of the reader they came from. Stream sources are never
+// cached.
+//
+// The cache is disabled until it is given a budget. Streamers and
+// cursors created while it is disabled don't use it.
+
+struct BlockCacheStats
+{
+	std::uint64_t hits{};
+	std::uint64_t misses{};
+	std::size_t bytes_used{};
+};
+
+// When the cache is over budget, the least recently used blocks are
+// dropped. 0 disables the cache and frees everything in it.
+extern auto set_block_cache_budget(std::size_t bytes) -> void;
+
+[[nodiscard]] extern
+auto get_block_cache_budget() -> std::size_t;
+
+[[nodiscard]] extern
+auto get_block_cache_stats() -> BlockCacheStats;
+
+extern auto clear_block_cache() -> void;
+
+} // blahdio
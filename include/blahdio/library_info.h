@@ -20,4 +20,13 @@ auto type_hint_for_file_extension(std::string file_extension, bool try_all_suppo
 [[nodiscard]] extern
 auto type_hint_for_type(AudioType type, bool try_all_supported_types) -> expected<AudioTypeHint>;
 
+// Deduce the audio type by looking for the magic bytes of each format
+// at the start of the data. This is much cheaper than trying to open a
+// decoder but it doesn't check that the rest of the data is valid.
+[[nodiscard]] extern
+auto sniff_type(const void* data, std::size_t data_size) -> expected<AudioType>;
+
+[[nodiscard]] extern
+auto sniff_type(std::string utf8_path) -> expected<AudioType>;
+
 } // blahdio
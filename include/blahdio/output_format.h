@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+namespace blahdio {
+
+enum class SampleFormat
+{
+	f32, // float, -1..1
+	f64, // double, -1..1
+	s16, // int16_t
+	s24, // 24 bit little endian integers packed into 3 bytes
+	s32, // int32_t
+};
+
+enum class ResampleQuality
+{
+	// Interpolates between neighbouring frames after a low-pass filter.
+	// Cheap, but lets some aliasing through.
+	linear,
+
+	// Windowed sinc. Several times slower, with very little aliasing
+	// or loss of high frequencies.
+	sinc,
+};
+
+// The format of the frames returned by AudioReader::read_frames() and
+// AudioStreamer::read_frames(). If the decoder can produce the format
+// itself the frames aren't converted at all.
+struct OutputFormat
+{
+	SampleFormat sample_format { SampleFormat::f32 };
+
+	// AudioReader::read_frames() passes each chunk to return_planar_chunk()
+	// as one 64 byte aligned buffer per channel, instead of interleaved
+	// to return_chunk(). Streamers can read either way regardless.
+	bool planar { false };
+
+	// Resample to this rate while decoding. 0 keeps the source's rate.
+	// Only AudioReader::read_frames() and AudioStreamer resample, in
+	// which case first_frame_index and seek positions are in frames at
+	// this rate. Other readers ignore it.
+	int sample_rate { 0 };
+
+	ResampleQuality resample_quality { ResampleQuality::sinc };
+
+	// Mix the source's channels into this many while decoding. 0 keeps
+	// the source's channels. Like sample_rate, only read_frames() and
+	// AudioStreamer mix.
+	int num_channels { 0 };
+
+	// Optional. The gain of each source channel in each output channel,
+	// as one row of source channel gains per output channel. When it is
+	// empty, mono goes to the front left and right, and surround sources
+	// in the usual WAV channel order are mixed down to stereo or mono
+	// with the centre and surrounds at -3dB and the LFE left out. Mixes
+	// down can go over full scale.
+	std::vector<float> channel_mix;
+};
+
+}
\ No newline at end of file
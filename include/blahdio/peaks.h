@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "blahdio/audio_reader.h"
+#include "blahdio/expected.h"
+
+namespace blahdio {
+
+// Waveform overviews of a source at several zoom levels, so a view can
+// be drawn at any zoom without decoding the source again
+struct Peaks
+{
+	struct Bin
+	{
+		float min{};
+		float max{};
+		float rms{};
+	};
+
+	struct Level
+	{
+		std::uint32_t frames_per_bin{};
+
+		// One bin per channel for each span of frames_per_bin frames,
+		// interleaved: bins[(index * num_channels) + channel]. The last
+		// span may be shorter.
+		std::vector<Bin> bins;
+	};
+
+	int num_channels{};
+	std::uint64_t num_frames{};
+
+	// Finest first
+	std::vector<Level> levels;
+
+	// The coarsest level whose bins are no wider than frames_per_pixel,
+	// or the finest level if they are all wider. Null if there are no
+	// levels.
+	[[nodiscard]] auto find_level(double frames_per_pixel) const -> const Level*;
+};
+
+// Each level must be a multiple of the one before it, since the coarser
+// levels are made from the finer ones. The source is only decoded once.
+[[nodiscard]] extern
+auto build_peaks(AudioReader* reader, const std::vector<std::uint32_t>& frames_per_bin = {64, 256, 1024, 4096}) -> expected<Peaks>;
+
+// Sidecar files are stamped with the size and modification time of the
+// source file, and fail to load if the source has changed since.
+[[nodiscard]] extern
+auto save_peaks(const Peaks& peaks, const std::string& utf8_source_path, const std::string& utf8_sidecar_path) -> expected<void>;
+
+[[nodiscard]] extern
+auto load_peaks(const std::string& utf8_source_path, const std::string& utf8_sidecar_path) -> expected<Peaks>;
+
+// Loads the sidecar if it is up to date and has the requested levels.
+// Otherwise builds the peaks and tries to save a new sidecar (failing
+// to save is not an error.)
+[[nodiscard]] extern
+auto load_or_build_peaks(const std::string& utf8_source_path, const std::string& utf8_sidecar_path, const std::vector<std::uint32_t>& frames_per_bin = {64, 256, 1024, 4096}) -> expected<Peaks>;
+
+} // blahdio
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+namespace blahdio {
+
+// Running totals kept by each reader, streamer, cursor and writer, from
+// the moment it is created. They are updated with relaxed atomics as the
+// work happens, so they can be read from any thread at any time, but a
+// snapshot taken while work is in progress isn't necessarily consistent
+// across fields. Times are nanoseconds of wall clock time, summed over
+// every thread which did the work (so with decode threads they can add
+// up to more than the time the call took.)
+//
+// A streamer, async streamer or cursor keeps its own totals. Those of
+// the reader it came from only cover the reader's own calls.
+struct Stats
+{
+	// Read from the source, or written to the file or stream. Counted
+	// where the library calls the stream's functions or does the I/O
+	// itself: streams, WavPack sources and header probing when reading,
+	// and the encoded data (not headers) when writing. WAV, FLAC and MP3
+	// decoders which read a file or memory (including a mapped file)
+	// directly don't report what they read.
+	std::uint64_t bytes{};
+
+	// Handed to the caller when reading, or taken from it when writing
+	std::uint64_t frames{};
+
+	// Inside the decoder (or the encoder when writing)
+	std::uint64_t codec_ns{};
+
+	// Converting sample formats, deinterleaving, quantizing, mixing and
+	// resampling
+	std::uint64_t convert_ns{};
+
+	// Inside the caller's callbacks
+	std::uint64_t callback_ns{};
+
+	// Seeks asked for by the caller, and the time they took. For an
+	// async streamer the time is spent on its background thread.
+	std::uint64_t seeks{};
+	std::uint64_t seek_ns{};
+
+	// Times one of the library's own sample buffers had to grow. Stays
+	// put after a streamer's reserve() for as long as the reads fit.
+	std::uint64_t allocations{};
+
+	// Async streamer reads which couldn't be given all the frames asked
+	// for (see AsyncAudioStreamer::Status::underrun)
+	std::uint64_t underruns{};
+};
+
+// The totals of every reader, streamer and cursor (reading) and writer
+// (writing) since the process started, including those which no longer
+// exist
+struct ProcessStats
+{
+	Stats reading;
+	Stats writing;
+};
+
+[[nodiscard]] extern
+auto get_process_stats() -> ProcessStats;
+
+} // blahdio
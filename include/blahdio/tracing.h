@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace blahdio {
+
+// Zones around the library's hot paths, for profilers such as Tracy or
+// Perfetto. Only reported if the library was built with
+// BLAHDIO_ENABLE_TRACING, otherwise the zones aren't compiled in at all.
+//
+// The zones are:
+//   "blahdio::probe <type>"  trying a decoder on the header in read_header()
+//   "blahdio::decode"        each chunk of frames pulled from a decoder
+//   "blahdio::convert"       converting, deinterleaving or quantizing samples
+//   "blahdio::process"       mixing and resampling
+//   "blahdio::seek"          each seek
+//   "blahdio::write block"   each block of encoded data handed to the file or stream
+
+// Every zone is a constant with static storage, so its address can be
+// used as a key (for example for Tracy's source locations)
+struct TraceZone
+{
+	const char* name;
+	const char* file;
+	std::uint32_t line;
+};
+
+// Called on the thread doing the work. Zones on the same thread nest.
+// Whatever begin returns is passed to the matching end. They must be
+// real-time safe if the library is used from an audio thread.
+struct TracingCallbacks
+{
+	using BeginFunc = std::uint64_t(*)(const TraceZone& zone, void* user_data);
+	using EndFunc = void(*)(const TraceZone& zone, std::uint64_t token, void* user_data);
+
+	BeginFunc begin{};
+	EndFunc end{};
+	void* user_data{};
+};
+
+// The callbacks must stay valid until they are replaced, and until any
+// zone which began with them has ended. Null stops reporting. Returns
+// false if the library was built without tracing.
+extern auto set_tracing_callbacks(const TracingCallbacks* callbacks) -> bool;
+
+} // blahdio
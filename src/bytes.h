@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace blahdio {
+namespace bytes {
+
+// Everything is stored little endian
+template <typename T>
+auto put(std::vector<std::byte>* out, T value) -> void
+{
+	for (std::size_t i = 0; i < sizeof(T); i++)
+	{
+		out->push_back(std::byte((std::uint64_t(value) >> (i * 8)) & 0xFF));
+	}
+}
+
+template <typename T> [[nodiscard]]
+auto get(const std::byte** pos) -> T
+{
+	std::uint64_t out{0};
+
+	for (std::size_t i = 0; i < sizeof(T); i++)
+	{
+		out |= std::to_integer<std::uint64_t>((*pos)[i]) << (i * 8);
+	}
+
+	*pos += sizeof(T);
+
+	return T(out);
+}
+
+}}
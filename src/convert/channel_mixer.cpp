@@ -0,0 +1,190 @@
+#include "channel_mixer.h"
+#include <algorithm>
+#include <cstring>
+#include "simd.h"
+
+namespace blahdio {
+namespace convert {
+
+static constexpr int LANES = 4;
+static constexpr float MINUS_3DB = 0.70710678f;
+
+ChannelMixer::ChannelMixer(int in_channels, int out_channels, const std::vector<float>& matrix)
+	: in_channels_{in_channels}
+	, out_channels_{out_channels}
+	, padded_out_channels_{((out_channels + LANES - 1) / LANES) * LANES}
+	, columns_(std::size_t(in_channels) * padded_out_channels_, 0.0f)
+{
+	for (int o = 0; o < out_channels; o++)
+	{
+		for (int i = 0; i < in_channels; i++)
+		{
+			columns_[(i * padded_out_channels_) + o] = matrix[(o * in_channels) + i];
+		}
+	}
+}
+
+// Each input sample is broadcast and multiplied by its column of
+// gains, four output channels at a time
+auto ChannelMixer::process(const float* in, std::uint32_t num_frames, float* out) const -> void
+{
+	for (std::uint32_t f = 0; f < num_frames; f++)
+	{
+		const auto frame{in + (std::size_t(f) * in_channels_)};
+		const auto out_frame{out + (std::size_t(f) * out_channels_)};
+
+		for (int o = 0; o < padded_out_channels_; o += LANES)
+		{
+			alignas(16) float lanes[LANES];
+
+#if BLAHDIO_SSE2
+			auto sum{_mm_setzero_ps()};
+
+			for (int i = 0; i < in_channels_; i++)
+			{
+				const auto gains{_mm_loadu_ps(columns_.data() + (i * padded_out_channels_) + o)};
+
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(frame[i]), gains));
+			}
+
+			_mm_store_ps(lanes, sum);
+#elif BLAHDIO_NEON
+			auto sum{vdupq_n_f32(0.0f)};
+
+			for (int i = 0; i < in_channels_; i++)
+			{
+				const auto gains{vld1q_f32(columns_.data() + (i * padded_out_channels_) + o)};
+
+				sum = vmlaq_f32(sum, gains, vdupq_n_f32(frame[i]));
+			}
+
+			vst1q_f32(lanes, sum);
+#else
+			std::fill(std::begin(lanes), std::end(lanes), 0.0f);
+
+			for (int i = 0; i < in_channels_; i++)
+			{
+				const auto gains{columns_.data() + (i * padded_out_channels_) + o};
+
+				for (int l = 0; l < LANES; l++)
+				{
+					lanes[l] += frame[i] * gains[l];
+				}
+			}
+#endif
+			std::memcpy(out_frame + o, lanes, sizeof(float) * std::min(LANES, out_channels_ - o));
+		}
+	}
+}
+
+[[nodiscard]] static
+auto make_stereo_downmix(int in_channels) -> std::vector<float>
+{
+	enum { FL, FR, FC, LFE, BL, BR, SL, SR };
+
+	std::vector<float> out(std::size_t(2) * in_channels, 0.0f);
+
+	const auto left{out.data()};
+	const auto right{out.data() + in_channels};
+
+	switch (in_channels)
+	{
+		// Front left, front right, centre
+		case 3:
+		{
+			left[FL] = 1.0f; left[FC] = MINUS_3DB;
+			right[FR] = 1.0f; right[FC] = MINUS_3DB;
+			break;
+		}
+
+		// Quad. Front left, front right, back left, back right
+		case 4:
+		{
+			left[0] = 1.0f; left[2] = MINUS_3DB;
+			right[1] = 1.0f; right[3] = MINUS_3DB;
+			break;
+		}
+
+		// 5.0. The same as 5.1 without the LFE
+		case 5:
+		{
+			left[FL] = 1.0f; left[FC] = MINUS_3DB; left[3] = MINUS_3DB;
+			right[FR] = 1.0f; right[FC] = MINUS_3DB; right[4] = MINUS_3DB;
+			break;
+		}
+
+		case 6:
+		case 8:
+		{
+			left[FL] = 1.0f; left[FC] = MINUS_3DB; left[BL] = MINUS_3DB;
+			right[FR] = 1.0f; right[FC] = MINUS_3DB; right[BR] = MINUS_3DB;
+
+			if (in_channels == 8)
+			{
+				left[SL] = MINUS_3DB;
+				right[SR] = MINUS_3DB;
+			}
+
+			break;
+		}
+
+		default:
+		{
+			left[0] = 1.0f;
+			right[1] = 1.0f;
+			break;
+		}
+	}
+
+	return out;
+}
+
+auto make_default_channel_mix(int in_channels, int out_channels) -> std::vector<float>
+{
+	if (in_channels > 2 && out_channels <= 2)
+	{
+		const auto stereo{make_stereo_downmix(in_channels)};
+
+		if (out_channels == 2) return stereo;
+
+		std::vector<float> mono(in_channels);
+
+		for (int i = 0; i < in_channels; i++)
+		{
+			mono[i] = 0.5f * (stereo[i] + stereo[in_channels + i]);
+		}
+
+		return mono;
+	}
+
+	std::vector<float> out(std::size_t(in_channels) * out_channels, 0.0f);
+
+	const auto gain = [&](int o, int i) -> float& { return out[(o * in_channels) + i]; };
+
+	if (in_channels == 1)
+	{
+		for (int o = 0; o < std::min(out_channels, 2); o++)
+		{
+			gain(o, 0) = 1.0f;
+		}
+
+		return out;
+	}
+
+	if (in_channels == 2 && out_channels == 1)
+	{
+		gain(0, 0) = 0.5f;
+		gain(0, 1) = 0.5f;
+
+		return out;
+	}
+
+	for (int c = 0; c < std::min(in_channels, out_channels); c++)
+	{
+		gain(c, c) = 1.0f;
+	}
+
+	return out;
+}
+
+}}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace blahdio {
+namespace convert {
+
+// Mixes interleaved float frames from one number of channels to
+// another. Each output frame is the sum of the input frame's channels,
+// each scaled by its own gain for that output channel.
+class ChannelMixer
+{
+public:
+
+	// One row of in_channels gains per output channel
+	ChannelMixer(int in_channels, int out_channels, const std::vector<float>& matrix);
+
+	// out must have room for out_channels * num_frames samples
+	auto process(const float* in, std::uint32_t num_frames, float* out) const -> void;
+
+	[[nodiscard]] auto get_in_channels() const { return in_channels_; }
+	[[nodiscard]] auto get_out_channels() const { return out_channels_; }
+
+private:
+
+	int in_channels_;
+	int out_channels_;
+
+	// The output channels rounded up to a whole number of vectors
+	int padded_out_channels_;
+
+	// The matrix turned on its side, so each input channel's gains for
+	// every output channel are next to each other
+	std::vector<float> columns_;
+};
+
+// The mix used when none is given. Mono goes to the front left and
+// right, and surround layouts in the usual WAV channel order (front
+// left, front right, centre, LFE, back left, back right, side left,
+// side right) are downmixed to stereo or mono with the centre and
+// surrounds at -3dB and the LFE left out. Anything else keeps the
+// channels both have and leaves the rest silent.
+[[nodiscard]] extern auto make_default_channel_mix(int in_channels, int out_channels) -> std::vector<float>;
+
+}}
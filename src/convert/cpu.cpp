@@ -0,0 +1,61 @@
+#include "cpu.h"
+#include "simd.h"
+
+#if BLAHDIO_X86 && defined(_MSC_VER) && !defined(__clang__)
+#	include <intrin.h>
+#endif
+
+namespace blahdio {
+namespace convert {
+
+[[nodiscard]] static
+auto detect_cpu_features() -> CpuFeatures
+{
+	CpuFeatures out;
+
+#	if BLAHDIO_X86
+#		if defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+
+			__cpuid(info, 0);
+
+			const auto max_leaf{info[0]};
+
+			if (max_leaf >= 1)
+			{
+				__cpuid(info, 1);
+
+				const auto osxsave{(info[2] & (1 << 27)) != 0};
+				const auto avx{(info[2] & (1 << 28)) != 0};
+
+				out.sse41 = (info[2] & (1 << 19)) != 0;
+
+				// AVX registers are only usable if the OS saves them
+				const auto os_saves_ymm{osxsave && avx && ((_xgetbv(0) & 0x6) == 0x6)};
+
+				if (os_saves_ymm && max_leaf >= 7)
+				{
+					__cpuidex(info, 7, 0);
+
+					out.avx2 = (info[1] & (1 << 5)) != 0;
+				}
+			}
+#		else
+			__builtin_cpu_init();
+
+			out.sse41 = __builtin_cpu_supports("sse4.1");
+			out.avx2 = __builtin_cpu_supports("avx2");
+#		endif
+#	endif
+
+	return out;
+}
+
+auto get_cpu_features() -> const CpuFeatures&
+{
+	static const CpuFeatures features{detect_cpu_features()};
+
+	return features;
+}
+
+}}
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace blahdio {
+namespace convert {
+
+// Instruction sets beyond the compile-time baseline in simd.h which the
+// CPU running the library turned out to have
+struct CpuFeatures
+{
+	bool sse41{false};
+	bool avx2{false};
+};
+
+// Detected once, on first use
+[[nodiscard]] extern auto get_cpu_features() -> const CpuFeatures&;
+
+}}
@@ -0,0 +1,298 @@
+#include "int_to_float.h"
+#include "cpu.h"
+#include "simd.h"
+
+namespace blahdio {
+namespace convert {
+
+static constexpr auto S16_SCALE{1.0f / 32768.0f};
+static constexpr auto S32_SCALE{1.0f / 2147483648.0f};
+
+// Each kernel converts as much as it can and returns the number of
+// samples done, leaving the rest to the scalar loops
+
+[[nodiscard]] static
+auto load_s24(const std::byte* in) -> std::int32_t
+{
+	const auto b0{std::to_integer<std::uint32_t>(in[0])};
+	const auto b1{std::to_integer<std::uint32_t>(in[1])};
+	const auto b2{std::to_integer<std::uint32_t>(in[2])};
+
+	// Left justified, so it is scaled the same way as 32 bit
+	return std::int32_t((b0 << 8) | (b1 << 16) | (b2 << 24));
+}
+
+static
+auto s16_to_f32_scalar(const std::int16_t* in, float* out, std::size_t first, std::size_t num_samples) -> void
+{
+	for (auto i = first; i < num_samples; i++)
+	{
+		out[i] = float(in[i]) * S16_SCALE;
+	}
+}
+
+static
+auto s24_to_f32_scalar(const std::byte* in, float* out, std::size_t first, std::size_t num_samples) -> void
+{
+	for (auto i = first; i < num_samples; i++)
+	{
+		out[i] = float(load_s24(in + (i * 3))) * S32_SCALE;
+	}
+}
+
+static
+auto s32_to_f32_scalar(const std::int32_t* in, float* out, std::size_t first, std::size_t num_samples, float scale) -> void
+{
+	for (auto i = first; i < num_samples; i++)
+	{
+		out[i] = float(in[i]) * scale;
+	}
+}
+
+#if BLAHDIO_X86
+
+[[nodiscard]] static
+auto s16_to_f32_sse2(const std::int16_t* in, float* out, std::size_t num_samples) -> std::size_t
+{
+	const auto scale{_mm_set1_ps(S16_SCALE)};
+
+	std::size_t i = 0;
+
+	for (; i + 8 <= num_samples; i += 8)
+	{
+		// Sign extend by unpacking each sample into the top half of a 32
+		// bit lane and shifting it back down
+		const auto x{_mm_loadu_si128((const __m128i*)(in + i))};
+
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale));
+		_mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), scale));
+	}
+
+	return i;
+}
+
+[[nodiscard]] static
+auto s32_to_f32_sse2(const std::int32_t* in, float* out, std::size_t num_samples, float scale) -> std::size_t
+{
+	const auto scale4{_mm_set1_ps(scale)};
+
+	std::size_t i = 0;
+
+	for (; i + 8 <= num_samples; i += 8)
+	{
+		const auto a{_mm_loadu_si128((const __m128i*)(in + i))};
+		const auto b{_mm_loadu_si128((const __m128i*)(in + i + 4))};
+
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale4));
+		_mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale4));
+	}
+
+	return i;
+}
+
+[[nodiscard]] BLAHDIO_TARGET("sse4.1") static
+auto s24_to_f32_sse41(const std::byte* in, float* out, std::size_t num_samples) -> std::size_t
+{
+	// Moves four packed samples into the top three bytes of each 32 bit
+	// lane
+	const auto mask{_mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11)};
+	const auto scale{_mm_set1_ps(S32_SCALE)};
+
+	std::size_t i = 0;
+
+	// Each load is 16 bytes for 12 bytes of samples, so stop while there
+	// are still at least two samples past the end of it
+	for (; i + 6 <= num_samples; i += 4)
+	{
+		const auto x{_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + (i * 3))), mask)};
+
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+	}
+
+	return i;
+}
+
+[[nodiscard]] BLAHDIO_TARGET("avx2") static
+auto s16_to_f32_avx2(const std::int16_t* in, float* out, std::size_t num_samples) -> std::size_t
+{
+	const auto scale{_mm256_set1_ps(S16_SCALE)};
+
+	std::size_t i = 0;
+
+	for (; i + 16 <= num_samples; i += 16)
+	{
+		const auto a{_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(in + i)))};
+		const auto b{_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(in + i + 8)))};
+
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+		_mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+	}
+
+	return i;
+}
+
+[[nodiscard]] BLAHDIO_TARGET("avx2") static
+auto s24_to_f32_avx2(const std::byte* in, float* out, std::size_t num_samples) -> std::size_t
+{
+	// The shuffle works within each 128 bit half, so each half gets its
+	// own four samples
+	const auto mask{_mm256_setr_epi8(
+		-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+		-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11)};
+
+	const auto scale{_mm256_set1_ps(S32_SCALE)};
+
+	std::size_t i = 0;
+
+	// The second load reads 4 bytes past the eighth sample
+	for (; i + 10 <= num_samples; i += 8)
+	{
+		const auto lo{_mm_loadu_si128((const __m128i*)(in + (i * 3)))};
+		const auto hi{_mm_loadu_si128((const __m128i*)(in + (i * 3) + 12))};
+		const auto x{_mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), mask)};
+
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+	}
+
+	return i;
+}
+
+[[nodiscard]] BLAHDIO_TARGET("avx2") static
+auto s32_to_f32_avx2(const std::int32_t* in, float* out, std::size_t num_samples, float scale) -> std::size_t
+{
+	const auto scale8{_mm256_set1_ps(scale)};
+
+	std::size_t i = 0;
+
+	for (; i + 16 <= num_samples; i += 16)
+	{
+		const auto a{_mm256_loadu_si256((const __m256i*)(in + i))};
+		const auto b{_mm256_loadu_si256((const __m256i*)(in + i + 8))};
+
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale8));
+		_mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale8));
+	}
+
+	return i;
+}
+
+#elif BLAHDIO_NEON
+
+[[nodiscard]] static
+auto s16_to_f32_neon(const std::int16_t* in, float* out, std::size_t num_samples) -> std::size_t
+{
+	std::size_t i = 0;
+
+	for (; i + 8 <= num_samples; i += 8)
+	{
+		const auto x{vld1q_s16(in + i)};
+
+		vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), S16_SCALE));
+		vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), S16_SCALE));
+	}
+
+	return i;
+}
+
+[[nodiscard]] static
+auto s24_to_f32_neon(const std::byte* in, float* out, std::size_t num_samples) -> std::size_t
+{
+	std::size_t i = 0;
+
+	for (; i + 8 <= num_samples; i += 8)
+	{
+		// Byte 0, 1 and 2 of eight samples
+		const auto x{vld3_u8((const std::uint8_t*)(in + (i * 3)))};
+
+		// The low and high 16 bits of each left justified sample, zipped
+		// back together into 32 bit lanes
+		const auto lo{vshll_n_u8(x.val[0], 8)};
+		const auto hi{vorrq_u16(vmovl_u8(x.val[1]), vshll_n_u8(x.val[2], 8))};
+		const auto s32{vzipq_u16(lo, hi)};
+
+		vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vreinterpretq_s32_u16(s32.val[0])), S32_SCALE));
+		vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vreinterpretq_s32_u16(s32.val[1])), S32_SCALE));
+	}
+
+	return i;
+}
+
+[[nodiscard]] static
+auto s32_to_f32_neon(const std::int32_t* in, float* out, std::size_t num_samples, float scale) -> std::size_t
+{
+	std::size_t i = 0;
+
+	for (; i + 8 <= num_samples; i += 8)
+	{
+		vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in + i)), scale));
+		vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in + i + 4)), scale));
+	}
+
+	return i;
+}
+
+#endif
+
+// For when there is no kernel at all
+[[maybe_unused]] [[nodiscard]] static
+auto s16_to_f32_none(const std::int16_t*, float*, std::size_t) -> std::size_t { return 0; }
+
+[[maybe_unused]] [[nodiscard]] static
+auto s24_to_f32_none(const std::byte*, float*, std::size_t) -> std::size_t { return 0; }
+
+[[maybe_unused]] [[nodiscard]] static
+auto s32_to_f32_none(const std::int32_t*, float*, std::size_t, float) -> std::size_t { return 0; }
+
+struct Kernels
+{
+	std::size_t (*s16)(const std::int16_t*, float*, std::size_t);
+	std::size_t (*s24)(const std::byte*, float*, std::size_t);
+	std::size_t (*s32)(const std::int32_t*, float*, std::size_t, float);
+};
+
+[[nodiscard]] static
+auto choose_kernels() -> Kernels
+{
+#	if BLAHDIO_X86
+		const auto& cpu{get_cpu_features()};
+
+		if (cpu.avx2) return { s16_to_f32_avx2, s24_to_f32_avx2, s32_to_f32_avx2 };
+		if (cpu.sse41) return { s16_to_f32_sse2, s24_to_f32_sse41, s32_to_f32_sse2 };
+
+		return { s16_to_f32_sse2, s24_to_f32_none, s32_to_f32_sse2 };
+#	elif BLAHDIO_NEON
+		return { s16_to_f32_neon, s24_to_f32_neon, s32_to_f32_neon };
+#	else
+		return { s16_to_f32_none, s24_to_f32_none, s32_to_f32_none };
+#	endif
+}
+
+[[nodiscard]] static
+auto get_kernels() -> const Kernels&
+{
+	static const Kernels kernels{choose_kernels()};
+
+	return kernels;
+}
+
+auto s16_to_f32(const std::int16_t* in, float* out, std::size_t num_samples) -> void
+{
+	s16_to_f32_scalar(in, out, get_kernels().s16(in, out, num_samples), num_samples);
+}
+
+auto s24_to_f32(const std::byte* in, float* out, std::size_t num_samples) -> void
+{
+	s24_to_f32_scalar(in, out, get_kernels().s24(in, out, num_samples), num_samples);
+}
+
+auto s32_to_f32(const std::int32_t* in, float* out, std::size_t num_samples) -> void
+{
+	s32_to_f32(in, out, num_samples, S32_SCALE);
+}
+
+auto s32_to_f32(const std::int32_t* in, float* out, std::size_t num_samples, float scale) -> void
+{
+	s32_to_f32_scalar(in, out, get_kernels().s32(in, out, num_samples, scale), num_samples, scale);
+}
+
+}}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace blahdio {
+namespace convert {
+
+// Integer to float32 kernels. The instruction set is picked once, at
+// runtime, from what the CPU has (AVX2, SSE4.1, SSE2 or NEON). The
+// results are exactly the same as the scalar conversion in
+// convert_samples(). The buffers don't need to be aligned.
+
+// Scaled by 2^15
+extern auto s16_to_f32(const std::int16_t* in, float* out, std::size_t num_samples) -> void;
+
+// Packed little endian 24 bit, scaled by 2^23
+extern auto s24_to_f32(const std::byte* in, float* out, std::size_t num_samples) -> void;
+
+// Scaled by 2^31
+extern auto s32_to_f32(const std::int32_t* in, float* out, std::size_t num_samples) -> void;
+
+// Each sample multiplied by scale. For decoders which unpack smaller
+// integers right justified into 32 bits.
+extern auto s32_to_f32(const std::int32_t* in, float* out, std::size_t num_samples, float scale) -> void;
+
+}}
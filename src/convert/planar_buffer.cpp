@@ -0,0 +1,27 @@
+#include "planar_buffer.h"
+#include "counters.h"
+
+namespace blahdio {
+namespace convert {
+
+auto PlanarBuffer::resize(int num_channels, std::size_t channel_bytes) -> void
+{
+	const auto stride{(channel_bytes + (ALIGNMENT - 1)) & ~(ALIGNMENT - 1)};
+	const auto size{stride * std::size_t(num_channels)};
+
+	if (size > capacity_)
+	{
+		data_.reset(static_cast<std::byte*>(::operator new[](size, std::align_val_t{ALIGNMENT})));
+		capacity_ = size;
+		stats::add(stats::Counter::allocations, 1);
+	}
+
+	channels_.resize(std::size_t(num_channels));
+
+	for (int c = 0; c < num_channels; c++)
+	{
+		channels_[c] = data_.get() + (stride * std::size_t(c));
+	}
+}
+
+}}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace blahdio {
+namespace convert {
+
+// One buffer per channel, each starting on a 64 byte boundary. Only
+// grows, so it can be resized for every chunk without reallocating.
+class PlanarBuffer
+{
+public:
+
+	static constexpr std::size_t ALIGNMENT = 64;
+
+	auto resize(int num_channels, std::size_t channel_bytes) -> void;
+	auto channels() const -> void* const* { return channels_.data(); }
+
+private:
+
+	struct Free
+	{
+		auto operator()(std::byte* data) const -> void
+		{
+			::operator delete[](data, std::align_val_t{ALIGNMENT});
+		}
+	};
+
+	std::unique_ptr<std::byte[], Free> data_;
+	std::size_t capacity_{};
+	std::vector<void*> channels_;
+};
+
+}}
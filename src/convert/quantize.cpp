@@ -0,0 +1,430 @@
+#include "quantize.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "cpu.h"
+#include "simd.h"
+
+namespace blahdio {
+namespace convert {
+
+using Params = Quantizer::Params;
+
+static constexpr auto NOISE_SCALE{1.0f / 65536.0f};
+
+// Samples are quantized through a small buffer when they have to be
+// packed into something other than 32 bits afterwards
+static constexpr std::size_t PACK_BLOCK_SIZE = 256;
+
+// xorshift32
+[[nodiscard]] static
+auto next_random(std::uint32_t* state) -> std::uint32_t
+{
+	auto x{*state};
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return *state = x;
+}
+
+// The difference of two uniform values (the two halves of one random
+// number) is triangular, between -1 and 1
+[[nodiscard]] static
+auto get_noise(std::uint32_t random) -> float
+{
+	return float(std::int32_t(random >> 16) - std::int32_t(random & 0xFFFF)) * NOISE_SCALE;
+}
+
+[[nodiscard]] static
+auto quantize_sample(float value, const Params& params) -> std::int32_t
+{
+	// NaN ends up at the minimum, the same as the vector kernels
+	return std::int32_t(std::nearbyint(std::min(std::max(params.min, value * params.scale), params.max)));
+}
+
+[[nodiscard]] static
+auto quantize_sample(float value, const Params& params, float noise) -> std::int32_t
+{
+	return std::int32_t(std::nearbyint(std::min(std::max(params.min, (value * params.scale) + noise), params.max)));
+}
+
+// Each kernel quantizes whole groups of NUM_LANES samples, starting at
+// lane 0, and returns the number of samples done
+
+#if BLAHDIO_X86
+
+template <bool DITHER> [[nodiscard]] static
+auto quantize_sse2(const float* in, std::int32_t* out, std::size_t num_samples, const Params& params, std::uint32_t* noise) -> std::size_t
+{
+	const auto scale{_mm_set1_ps(params.scale)};
+	const auto min{_mm_set1_ps(params.min)};
+	const auto max{_mm_set1_ps(params.max)};
+
+	const auto quantize = [&](__m128 x, __m128 n)
+	{
+		// min/max return the second operand for NaN
+		return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(x, scale), n), min), max));
+	};
+
+	std::size_t i = 0;
+
+	if constexpr (DITHER)
+	{
+		const auto noise_scale{_mm_set1_ps(NOISE_SCALE)};
+		const auto low_mask{_mm_set1_epi32(0xFFFF)};
+
+		auto r0{_mm_loadu_si128((const __m128i*)(noise))};
+		auto r1{_mm_loadu_si128((const __m128i*)(noise + 4))};
+
+		const auto next = [&](__m128i* r)
+		{
+			auto x{*r};
+
+			x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+			x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+			x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+
+			*r = x;
+
+			return _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(x, 16), _mm_and_si128(x, low_mask))), noise_scale);
+		};
+
+		for (; i + 8 <= num_samples; i += 8)
+		{
+			_mm_storeu_si128((__m128i*)(out + i), quantize(_mm_loadu_ps(in + i), next(&r0)));
+			_mm_storeu_si128((__m128i*)(out + i + 4), quantize(_mm_loadu_ps(in + i + 4), next(&r1)));
+		}
+
+		_mm_storeu_si128((__m128i*)(noise), r0);
+		_mm_storeu_si128((__m128i*)(noise + 4), r1);
+	}
+	else
+	{
+		const auto zero{_mm_setzero_ps()};
+
+		for (; i + 8 <= num_samples; i += 8)
+		{
+			_mm_storeu_si128((__m128i*)(out + i), quantize(_mm_loadu_ps(in + i), zero));
+			_mm_storeu_si128((__m128i*)(out + i + 4), quantize(_mm_loadu_ps(in + i + 4), zero));
+		}
+	}
+
+	return i;
+}
+
+template <bool DITHER> [[nodiscard]] BLAHDIO_TARGET("avx2") static
+auto quantize_avx2(const float* in, std::int32_t* out, std::size_t num_samples, const Params& params, std::uint32_t* noise) -> std::size_t
+{
+	const auto scale{_mm256_set1_ps(params.scale)};
+	const auto min{_mm256_set1_ps(params.min)};
+	const auto max{_mm256_set1_ps(params.max)};
+
+	std::size_t i = 0;
+
+	if constexpr (DITHER)
+	{
+		const auto noise_scale{_mm256_set1_ps(NOISE_SCALE)};
+		const auto low_mask{_mm256_set1_epi32(0xFFFF)};
+
+		auto r{_mm256_loadu_si256((const __m256i*)(noise))};
+
+		for (; i + 8 <= num_samples; i += 8)
+		{
+			r = _mm256_xor_si256(r, _mm256_slli_epi32(r, 13));
+			r = _mm256_xor_si256(r, _mm256_srli_epi32(r, 17));
+			r = _mm256_xor_si256(r, _mm256_slli_epi32(r, 5));
+
+			const auto n{_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(r, 16), _mm256_and_si256(r, low_mask))), noise_scale)};
+			const auto x{_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scale), n)};
+
+			_mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(x, min), max)));
+		}
+
+		_mm256_storeu_si256((__m256i*)(noise), r);
+	}
+	else
+	{
+		for (; i + 8 <= num_samples; i += 8)
+		{
+			const auto x{_mm256_mul_ps(_mm256_loadu_ps(in + i), scale)};
+
+			_mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(x, min), max)));
+		}
+	}
+
+	return i;
+}
+
+#elif BLAHDIO_NEON
+
+template <bool DITHER> [[nodiscard]] static
+auto quantize_neon(const float* in, std::int32_t* out, std::size_t num_samples, const Params& params, std::uint32_t* noise) -> std::size_t
+{
+	const auto min{vdupq_n_f32(params.min)};
+	const auto max{vdupq_n_f32(params.max)};
+
+	const auto quantize = [&](float32x4_t x, float32x4_t n)
+	{
+		auto y{vaddq_f32(vmulq_n_f32(x, params.scale), n)};
+
+		// vmaxq/vminq would pass NaN through
+		y = vbslq_f32(vcgtq_f32(y, min), y, min);
+		y = vbslq_f32(vcltq_f32(y, max), y, max);
+
+		return vcvtnq_s32_f32(y);
+	};
+
+	std::size_t i = 0;
+
+	if constexpr (DITHER)
+	{
+		auto r0{vld1q_u32(noise)};
+		auto r1{vld1q_u32(noise + 4)};
+
+		const auto next = [](uint32x4_t* r)
+		{
+			auto x{*r};
+
+			x = veorq_u32(x, vshlq_n_u32(x, 13));
+			x = veorq_u32(x, vshrq_n_u32(x, 17));
+			x = veorq_u32(x, vshlq_n_u32(x, 5));
+
+			*r = x;
+
+			const auto diff{vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(x, 16)), vreinterpretq_s32_u32(vandq_u32(x, vdupq_n_u32(0xFFFF))))};
+
+			return vmulq_n_f32(vcvtq_f32_s32(diff), NOISE_SCALE);
+		};
+
+		for (; i + 8 <= num_samples; i += 8)
+		{
+			vst1q_s32(out + i, quantize(vld1q_f32(in + i), next(&r0)));
+			vst1q_s32(out + i + 4, quantize(vld1q_f32(in + i + 4), next(&r1)));
+		}
+
+		vst1q_u32(noise, r0);
+		vst1q_u32(noise + 4, r1);
+	}
+	else
+	{
+		const auto zero{vdupq_n_f32(0.0f)};
+
+		for (; i + 8 <= num_samples; i += 8)
+		{
+			vst1q_s32(out + i, quantize(vld1q_f32(in + i), zero));
+			vst1q_s32(out + i + 4, quantize(vld1q_f32(in + i + 4), zero));
+		}
+	}
+
+	return i;
+}
+
+#endif
+
+[[maybe_unused]] [[nodiscard]] static
+auto quantize_none(const float*, std::int32_t*, std::size_t, const Params&, std::uint32_t*) -> std::size_t { return 0; }
+
+using QuantizeFn = std::size_t(*)(const float*, std::int32_t*, std::size_t, const Params&, std::uint32_t*);
+
+struct Kernels
+{
+	QuantizeFn plain;
+	QuantizeFn dither;
+};
+
+[[nodiscard]] static
+auto choose_kernels() -> Kernels
+{
+#	if BLAHDIO_X86
+		if (get_cpu_features().avx2) return { quantize_avx2<false>, quantize_avx2<true> };
+
+		return { quantize_sse2<false>, quantize_sse2<true> };
+#	elif BLAHDIO_NEON
+		return { quantize_neon<false>, quantize_neon<true> };
+#	else
+		return { quantize_none, quantize_none };
+#	endif
+}
+
+[[nodiscard]] static
+auto get_kernels() -> const Kernels&
+{
+	static const Kernels kernels{choose_kernels()};
+
+	return kernels;
+}
+
+// Packing from right justified 32 bit. The values have already been
+// clipped so they fit.
+
+static
+auto pack_s16(const std::int32_t* in, std::byte* out, std::size_t num_samples) -> void
+{
+	std::size_t i = 0;
+
+#	if BLAHDIO_SSE2
+		for (; i + 8 <= num_samples; i += 8)
+		{
+			const auto a{_mm_loadu_si128((const __m128i*)(in + i))};
+			const auto b{_mm_loadu_si128((const __m128i*)(in + i + 4))};
+
+			_mm_storeu_si128((__m128i*)(out + (i * 2)), _mm_packs_epi32(a, b));
+		}
+#	elif BLAHDIO_NEON
+		for (; i + 8 <= num_samples; i += 8)
+		{
+			vst1q_s16((std::int16_t*)(out + (i * 2)), vcombine_s16(vmovn_s32(vld1q_s32(in + i)), vmovn_s32(vld1q_s32(in + i + 4))));
+		}
+#	endif
+
+	for (; i < num_samples; i++)
+	{
+		const auto value{std::int16_t(in[i])};
+
+		std::memcpy(out + (i * 2), &value, 2);
+	}
+}
+
+static
+auto pack_s24_scalar(const std::int32_t* in, std::byte* out, std::size_t first, std::size_t num_samples) -> void
+{
+	for (auto i = first; i < num_samples; i++)
+	{
+		out[(i * 3) + 0] = std::byte(in[i] & 0xFF);
+		out[(i * 3) + 1] = std::byte((in[i] >> 8) & 0xFF);
+		out[(i * 3) + 2] = std::byte((in[i] >> 16) & 0xFF);
+	}
+}
+
+#if BLAHDIO_X86
+
+// Drops the top byte of each of four samples
+[[nodiscard]] BLAHDIO_TARGET("sse4.1") static
+auto pack_s24_sse41(const std::int32_t* in, std::byte* out, std::size_t num_samples) -> std::size_t
+{
+	const auto mask{_mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1)};
+
+	std::size_t i = 0;
+
+	// Each store writes 16 bytes for 12 bytes of samples, so stop while
+	// there are still at least two samples to come after it
+	for (; i + 6 <= num_samples; i += 4)
+	{
+		_mm_storeu_si128((__m128i*)(out + (i * 3)), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + i)), mask));
+	}
+
+	return i;
+}
+
+#endif
+
+static
+auto pack_s24(const std::int32_t* in, std::byte* out, std::size_t num_samples) -> void
+{
+	std::size_t first{0};
+
+#	if BLAHDIO_X86
+		static const auto sse41{get_cpu_features().sse41};
+
+		if (sse41)
+		{
+			first = pack_s24_sse41(in, out, num_samples);
+		}
+#	endif
+
+	pack_s24_scalar(in, out, first, num_samples);
+}
+
+static
+auto pack_u8(const std::int32_t* in, std::byte* out, std::size_t num_samples) -> void
+{
+	for (std::size_t i = 0; i < num_samples; i++)
+	{
+		out[i] = std::byte(in[i] + 128);
+	}
+}
+
+Quantizer::Quantizer(int bit_depth, float scale, Dither dither)
+	: bit_depth_{bit_depth}
+	, dither_{dither}
+{
+	const auto range{double(std::int64_t(1) << (bit_depth - 1))};
+
+	params_.scale = scale;
+	params_.min = float(-range);
+
+	// The largest float below 2^31 for 32 bit
+	params_.max = std::min(float(range - 1.0), 2147483520.0f);
+
+	for (std::size_t lane = 0; lane < NUM_LANES; lane++)
+	{
+		noise_[lane] = 0x9E3779B9u * std::uint32_t(lane + 1);
+	}
+}
+
+auto Quantizer::quantize_scalar(const float* in, std::int32_t* out, std::size_t num_samples) -> void
+{
+	if (dither_ == Dither::none)
+	{
+		for (std::size_t i = 0; i < num_samples; i++)
+		{
+			out[i] = quantize_sample(in[i], params_);
+		}
+
+		return;
+	}
+
+	for (std::size_t i = 0; i < num_samples; i++)
+	{
+		out[i] = quantize_sample(in[i], params_, get_noise(next_random(&noise_[next_lane_])));
+
+		next_lane_ = (next_lane_ + 1) % NUM_LANES;
+	}
+}
+
+auto Quantizer::quantize(const float* in, std::int32_t* out, std::size_t num_samples) -> void
+{
+	// Line the noise lanes back up with the start of a group
+	const auto head{std::min(num_samples, (NUM_LANES - next_lane_) % NUM_LANES)};
+
+	quantize_scalar(in, out, head);
+
+	in += head;
+	out += head;
+	num_samples -= head;
+
+	const auto& kernels{get_kernels()};
+	const auto kernel{dither_ == Dither::none ? kernels.plain : kernels.dither};
+	const auto done{kernel(in, out, num_samples, params_, noise_.data())};
+
+	quantize_scalar(in + done, out + done, num_samples - done);
+}
+
+auto Quantizer::quantize_pcm(const float* in, std::byte* out, std::size_t num_samples) -> void
+{
+	const auto bytes_per_sample{std::size_t(bit_depth_ / 8)};
+
+	std::int32_t block[PACK_BLOCK_SIZE];
+
+	for (std::size_t i = 0; i < num_samples; i += PACK_BLOCK_SIZE)
+	{
+		const auto block_size{std::min(PACK_BLOCK_SIZE, num_samples - i)};
+		const auto block_out{out + (i * bytes_per_sample)};
+
+		quantize(in + i, block, block_size);
+
+		switch (bit_depth_)
+		{
+			case 8: pack_u8(block, block_out, block_size); break;
+			case 16: pack_s16(block, block_out, block_size); break;
+			case 24: pack_s24(block, block_out, block_size); break;
+
+			// The output might not be aligned for int32
+			case 32: default: std::memcpy(block_out, block, block_size * 4); break;
+		}
+	}
+}
+
+}}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "blahdio/audio_writer.h"
+
+namespace blahdio {
+namespace convert {
+
+// Rounds float samples to integers for the writers, clipping anything
+// out of range and optionally adding triangular (TPDF) dither of +/-1
+// LSB first. Vectorized with the best instruction set the CPU has, like
+// the int_to_float.h kernels. The noise starts from a fixed seed so the
+// same input always gives the same file.
+class Quantizer
+{
+public:
+
+	// Samples are multiplied by scale and clipped to bit_depth bits
+	Quantizer(int bit_depth, float scale, Dither dither);
+
+	// Right justified in 32 bits
+	auto quantize(const float* in, std::int32_t* out, std::size_t num_samples) -> void;
+
+	// Packed little endian PCM, the way WAV files store it. 8 bit is
+	// unsigned.
+	auto quantize_pcm(const float* in, std::byte* out, std::size_t num_samples) -> void;
+
+	// The noise generator has one lane per sample in a group of this
+	// many, so every instruction set produces the same noise
+	static constexpr std::size_t NUM_LANES = 8;
+
+	struct Params
+	{
+		float scale;
+		float min;
+		float max;
+	};
+
+private:
+
+	auto quantize_scalar(const float* in, std::int32_t* out, std::size_t num_samples) -> void;
+
+	int bit_depth_;
+	Dither dither_;
+	Params params_;
+	std::array<std::uint32_t, NUM_LANES> noise_;
+	std::size_t next_lane_{0};
+};
+
+}}
@@ -0,0 +1,340 @@
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <miniaudio.h>
+#include <numeric>
+#include <numbers>
+#include <stdexcept>
+
+namespace blahdio {
+namespace convert {
+
+// Zero crossings of the sinc on each side of the centre, and table
+// entries between each one
+static constexpr int SINC_ZERO_CROSSINGS = 16;
+static constexpr int SINC_PHASES = 512;
+
+// A little below Nyquist so the transition band isn't folded back
+static constexpr double SINC_CUTOFF = 0.95;
+
+// Flushing feeds silence through the linear resampler in blocks
+static constexpr std::uint32_t LINEAR_FLUSH_FRAMES = 256;
+
+// Longest run of source frames the linear resampler is allowed to
+// decode again after a seek to get back in phase
+static constexpr std::uint64_t LINEAR_MAX_PREROLL = 4096;
+
+struct Resampler::Linear
+{
+	ma_linear_resampler resampler;
+};
+
+// The right half of a Blackman windowed sinc, from 0 out to the last
+// zero crossing, with one extra zero for interpolating past the end
+[[nodiscard]] static
+auto get_sinc_table() -> const std::vector<float>&
+{
+	static const auto table = []()
+	{
+		constexpr auto size{SINC_ZERO_CROSSINGS * SINC_PHASES};
+		constexpr auto pi{std::numbers::pi};
+
+		std::vector<float> out(size + 2, 0.0f);
+
+		out[0] = 1.0f;
+
+		for (int i = 1; i <= size; i++)
+		{
+			const auto x{double(i) / SINC_PHASES};
+			const auto w{double(i) / size};
+			const auto window{0.42 + (0.5 * std::cos(pi * w)) + (0.08 * std::cos(2.0 * pi * w))};
+
+			out[i] = float((std::sin(pi * x) / (pi * x)) * window);
+		}
+
+		return out;
+	}();
+
+	return table;
+}
+
+[[nodiscard]] static
+auto get_sinc(double x) -> float
+{
+	const auto& table{get_sinc_table()};
+	const auto pos{std::abs(x) * SINC_PHASES};
+	const auto index{std::size_t(pos)};
+
+	if (index >= table.size() - 1) return 0.0f;
+
+	const auto t{float(pos - double(index))};
+
+	return table[index] + (t * (table[index + 1] - table[index]));
+}
+
+Resampler::Resampler(int num_channels, std::uint32_t in_rate, std::uint32_t out_rate, ResampleQuality quality)
+	: num_channels_{num_channels}
+	, in_rate_{in_rate}
+	, out_rate_{out_rate}
+	, quality_{quality}
+{
+	if (in_rate == out_rate) return;
+
+	if (quality == ResampleQuality::linear)
+	{
+		const auto config{ma_linear_resampler_config_init(ma_format_f32, ma_uint32(num_channels), in_rate, out_rate)};
+
+		linear_ = std::make_unique<Linear>();
+
+		if (ma_linear_resampler_init(&config, nullptr, &linear_->resampler) != MA_SUCCESS)
+		{
+			throw std::runtime_error("Failed to initialize the linear resampler");
+		}
+
+		return;
+	}
+
+	// When downsampling the filter is stretched so it cuts off below the
+	// new Nyquist frequency
+	cutoff_ = SINC_CUTOFF * std::min(1.0, double(out_rate) / double(in_rate));
+	reach_ = std::int64_t(std::ceil(SINC_ZERO_CROSSINGS / cutoff_));
+	weights_.resize(std::size_t(reach_ * 2));
+
+	(void)(reset(0));
+}
+
+Resampler::Resampler(Resampler&&) noexcept = default;
+auto Resampler::operator=(Resampler&&) noexcept -> Resampler& = default;
+
+Resampler::~Resampler()
+{
+	if (linear_)
+	{
+		ma_linear_resampler_uninit(&linear_->resampler, nullptr);
+	}
+}
+
+auto Resampler::get_input_frames(std::uint64_t out_frames) const -> std::uint64_t
+{
+	return ((out_frames * in_rate_) + out_rate_ - 1) / out_rate_;
+}
+
+auto Resampler::get_output_frames(std::uint64_t in_frames) const -> std::uint64_t
+{
+	return ((in_frames * out_rate_) + in_rate_ - 1) / in_rate_;
+}
+
+auto Resampler::reset(std::uint64_t out_frame) -> std::uint64_t
+{
+	const auto in_frame{(out_frame * in_rate_) / out_rate_};
+
+	out_frame_ = out_frame;
+
+	if (linear_)
+	{
+		ma_linear_resampler_reset(&linear_->resampler);
+		skip_frames_ = 0;
+
+		// The resampler always starts on a whole source frame, so it is
+		// started from the last place before this where the source and
+		// output frames line up, as long as that isn't too far back. A
+		// period more than that gives the filter time to settle too. The
+		// output in between is thrown away.
+		const auto period{in_rate_ / std::gcd(in_rate_, out_rate_)};
+
+		if (period > LINEAR_MAX_PREROLL)
+		{
+			in_end_ = in_frame;
+			return in_frame;
+		}
+
+		const auto start{(in_frame / period) > 0 ? ((in_frame / period) - 1) * period : 0};
+
+		out_frame_ = (start * out_rate_) / in_rate_;
+		skip_frames_ = out_frame - out_frame_;
+		in_end_ = start;
+		return start;
+	}
+
+	if (in_rate_ == out_rate_)
+	{
+		in_end_ = out_frame;
+		return out_frame;
+	}
+
+	// The filter needs the frames before the first output frame too.
+	// Before the start of the source they are silence.
+	const auto first_needed{std::int64_t(in_frame) - reach_ + 1};
+
+	history_start_ = first_needed;
+	history_.clear();
+
+	if (first_needed < 0)
+	{
+		history_.resize(std::size_t(-first_needed) * num_channels_, 0.0f);
+	}
+
+	in_end_ = std::uint64_t(std::max<std::int64_t>(0, first_needed));
+
+	return in_end_;
+}
+
+auto Resampler::reserve(std::uint32_t max_in_frames) -> void
+{
+	history_.reserve((std::size_t(max_in_frames) + std::size_t(reach_ * 2) + 1) * num_channels_);
+}
+
+auto Resampler::process(const float* in, std::uint32_t in_frames, std::vector<float>* out) -> void
+{
+	if (in_rate_ == out_rate_)
+	{
+		out->insert(out->end(), in, in + (std::size_t(in_frames) * num_channels_));
+		in_end_ += in_frames;
+		out_frame_ += in_frames;
+		return;
+	}
+
+	if (linear_)
+	{
+		process_linear(in, in_frames, out);
+		return;
+	}
+
+	process_sinc(in, in_frames, out);
+}
+
+auto Resampler::flush(std::vector<float>* out) -> void
+{
+	if (in_rate_ == out_rate_) return;
+
+	const auto end_frame{get_output_frames(in_end_)};
+
+	if (out_frame_ >= end_frame) return;
+
+	if (linear_)
+	{
+		// Push silence through until the filter has let go of the last
+		// of the source
+		const std::vector<float> silence(std::size_t(LINEAR_FLUSH_FRAMES) * num_channels_, 0.0f);
+
+		const auto in_end{in_end_};
+		const auto out_size{out->size()};
+
+		while (out_frame_ < end_frame)
+		{
+			const auto frame_before{out_frame_};
+
+			process_linear(silence.data(), LINEAR_FLUSH_FRAMES, out);
+
+			if (out_frame_ == frame_before) break;
+		}
+
+		const auto excess{std::min(out_frame_ - end_frame, std::uint64_t((out->size() - out_size) / num_channels_))};
+
+		out->resize(out->size() - (std::size_t(excess) * num_channels_));
+		out_frame_ -= excess;
+		in_end_ = in_end;
+		return;
+	}
+
+	history_.resize(history_.size() + (std::size_t(reach_) * num_channels_), 0.0f);
+
+	produce_sinc(end_frame, out);
+}
+
+auto Resampler::process_linear(const float* in, std::uint32_t in_frames, std::vector<float>* out) -> void
+{
+	std::uint64_t in_done{0};
+
+	while (in_done < in_frames)
+	{
+		ma_uint64 expected_out{0};
+
+		ma_linear_resampler_get_expected_output_frame_count(&linear_->resampler, in_frames - in_done, &expected_out);
+
+		const auto out_size{out->size()};
+
+		out->resize(out_size + (std::size_t(expected_out + 1) * num_channels_));
+
+		ma_uint64 frames_in{in_frames - in_done};
+		ma_uint64 frames_out{expected_out + 1};
+
+		ma_linear_resampler_process_pcm_frames(&linear_->resampler, in + (in_done * num_channels_), &frames_in, out->data() + out_size, &frames_out);
+
+		const auto skip{std::min<std::uint64_t>(skip_frames_, frames_out)};
+
+		out->resize(out_size + (std::size_t(frames_out) * num_channels_));
+		out->erase(out->begin() + out_size, out->begin() + out_size + (skip * num_channels_));
+
+		in_done += frames_in;
+		out_frame_ += frames_out;
+		skip_frames_ -= skip;
+
+		if (frames_in == 0 && frames_out == 0) break;
+	}
+
+	in_end_ += in_frames;
+}
+
+auto Resampler::process_sinc(const float* in, std::uint32_t in_frames, std::vector<float>* out) -> void
+{
+	history_.insert(history_.end(), in, in + (std::size_t(in_frames) * num_channels_));
+	in_end_ += in_frames;
+
+	produce_sinc(std::numeric_limits<std::uint64_t>::max(), out);
+}
+
+auto Resampler::produce_sinc(std::uint64_t max_out_frame, std::vector<float>* out) -> void
+{
+	const auto history_frames{std::int64_t(history_.size() / num_channels_)};
+	const auto history_end{history_start_ + history_frames};
+
+	while (out_frame_ < max_out_frame)
+	{
+		const auto position{out_frame_ * in_rate_};
+		const auto centre{std::int64_t(position / out_rate_)};
+		const auto fraction{double(position % out_rate_) / double(out_rate_)};
+		const auto first{centre - reach_ + 1};
+
+		if (centre + reach_ >= history_end) break;
+
+		float sum{0.0f};
+
+		for (std::int64_t i = 0; i < reach_ * 2; i++)
+		{
+			const auto distance{double(first + i - centre) - fraction};
+
+			weights_[i] = get_sinc(distance * cutoff_);
+			sum += weights_[i];
+		}
+
+		// Normalized so that the table's interpolation error doesn't
+		// change the gain
+		const auto scale{1.0f / sum};
+		const auto frames{history_.data() + ((first - history_start_) * num_channels_)};
+
+		for (int c = 0; c < num_channels_; c++)
+		{
+			float value{0.0f};
+
+			for (std::int64_t i = 0; i < reach_ * 2; i++)
+			{
+				value += frames[(i * num_channels_) + c] * weights_[i];
+			}
+
+			out->push_back(value * scale);
+		}
+
+		out_frame_++;
+	}
+
+	// Drop the frames no later output frame will need
+	const auto next_first{std::int64_t((out_frame_ * in_rate_) / out_rate_) - reach_ + 1};
+	const auto drop{std::clamp<std::int64_t>(next_first - history_start_, 0, history_frames)};
+
+	history_.erase(history_.begin(), history_.begin() + (drop * num_channels_));
+	history_start_ += drop;
+}
+
+}}
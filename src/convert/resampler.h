@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "blahdio/output_format.h"
+
+namespace blahdio {
+namespace convert {
+
+// Streaming sample rate conversion of interleaved float frames. Output
+// frame n is taken from the source at time n * in_rate / out_rate, so
+// after reset() the output carries on as though it had been produced
+// from the start of the source. For the sinc resampler it is exactly
+// the same. The linear resampler's filter has to settle again, so it is
+// only very close. If the rates are the same, frames are copied as they
+// are.
+class Resampler
+{
+public:
+
+	Resampler(int num_channels, std::uint32_t in_rate, std::uint32_t out_rate, ResampleQuality quality);
+	Resampler(Resampler&&) noexcept;
+	auto operator=(Resampler&&) noexcept -> Resampler&;
+	~Resampler();
+
+	// Makes the next output frame out_frame. Returns the source frame
+	// the input has to continue from.
+	[[nodiscard]] auto reset(std::uint64_t out_frame) -> std::uint64_t;
+
+	// Appends as many output frames as this input makes possible. Some
+	// of the input is held back until the frames after it arrive.
+	auto process(const float* in, std::uint32_t in_frames, std::vector<float>* out) -> void;
+
+	// Appends the rest of the output once the input has ended
+	auto flush(std::vector<float>* out) -> void;
+
+	// Makes room for processing up to this many input frames at a time
+	// without allocating
+	auto reserve(std::uint32_t max_in_frames) -> void;
+
+	// Input frames needed for this much output, roughly
+	[[nodiscard]] auto get_input_frames(std::uint64_t out_frames) const -> std::uint64_t;
+
+	// Output frames for a source of this length
+	[[nodiscard]] auto get_output_frames(std::uint64_t in_frames) const -> std::uint64_t;
+
+private:
+
+	struct Linear;
+
+	auto process_linear(const float* in, std::uint32_t in_frames, std::vector<float>* out) -> void;
+	auto process_sinc(const float* in, std::uint32_t in_frames, std::vector<float>* out) -> void;
+	auto produce_sinc(std::uint64_t max_out_frame, std::vector<float>* out) -> void;
+
+	int num_channels_;
+	std::uint64_t in_rate_;
+	std::uint64_t out_rate_;
+	ResampleQuality quality_;
+
+	// The next output frame, and the source frame after the last one
+	// passed to process()
+	std::uint64_t out_frame_{0};
+	std::uint64_t in_end_{0};
+
+	// Linear. Output frames still to be thrown away after a reset.
+	std::unique_ptr<Linear> linear_;
+	std::uint64_t skip_frames_{0};
+
+	// Sinc. history_ holds the source frames from history_start_ on,
+	// which can be before the start of the source (as silence.)
+	double cutoff_{1.0};
+	std::int64_t reach_{0};
+	std::int64_t history_start_{0};
+	std::vector<float> history_;
+	std::vector<float> weights_;
+};
+
+}}
@@ -0,0 +1,370 @@
+#include "sample_format.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "int_to_float.h"
+#include "simd.h"
+
+namespace blahdio {
+namespace convert {
+
+template <SampleFormat FORMAT> struct Traits;
+
+template <> struct Traits<SampleFormat::f32> { static constexpr std::size_t size = 4; static constexpr int bits = 0; };
+template <> struct Traits<SampleFormat::f64> { static constexpr std::size_t size = 8; static constexpr int bits = 0; };
+template <> struct Traits<SampleFormat::s16> { static constexpr std::size_t size = 2; static constexpr int bits = 16; };
+template <> struct Traits<SampleFormat::s24> { static constexpr std::size_t size = 3; static constexpr int bits = 24; };
+template <> struct Traits<SampleFormat::s32> { static constexpr std::size_t size = 4; static constexpr int bits = 32; };
+
+template <typename T> [[nodiscard]] static
+auto load(const std::byte* in) -> T
+{
+	T out;
+	std::memcpy(&out, in, sizeof(T));
+	return out;
+}
+
+template <typename T> static
+auto store(std::byte* out, T value) -> void
+{
+	std::memcpy(out, &value, sizeof(T));
+}
+
+// Integers are loaded left justified so they can all be treated as 32 bit
+template <SampleFormat FORMAT> [[nodiscard]] static
+auto load_int(const std::byte* in) -> std::int32_t
+{
+	if constexpr (FORMAT == SampleFormat::s16)
+	{
+		return std::int32_t(std::uint32_t(load<std::int16_t>(in)) << 16);
+	}
+	else if constexpr (FORMAT == SampleFormat::s24)
+	{
+		const auto b0{std::to_integer<std::uint32_t>(in[0])};
+		const auto b1{std::to_integer<std::uint32_t>(in[1])};
+		const auto b2{std::to_integer<std::uint32_t>(in[2])};
+
+		return std::int32_t((b0 << 8) | (b1 << 16) | (b2 << 24));
+	}
+	else
+	{
+		return load<std::int32_t>(in);
+	}
+}
+
+template <SampleFormat FORMAT> static
+auto store_int(std::byte* out, std::int32_t value) -> void
+{
+	if constexpr (FORMAT == SampleFormat::s16)
+	{
+		store(out, std::int16_t(value >> 16));
+	}
+	else if constexpr (FORMAT == SampleFormat::s24)
+	{
+		out[0] = std::byte((value >> 8) & 0xFF);
+		out[1] = std::byte((value >> 16) & 0xFF);
+		out[2] = std::byte((value >> 24) & 0xFF);
+	}
+	else
+	{
+		store(out, value);
+	}
+}
+
+template <SampleFormat FORMAT> [[nodiscard]] static
+auto load_float(const std::byte* in) -> double
+{
+	if constexpr (FORMAT == SampleFormat::f32) return load<float>(in);
+	else if constexpr (FORMAT == SampleFormat::f64) return load<double>(in);
+	else return double(load_int<FORMAT>(in)) / 2147483648.0;
+}
+
+template <SampleFormat FORMAT> static
+auto store_float(std::byte* out, double value) -> void
+{
+	if constexpr (FORMAT == SampleFormat::f32)
+	{
+		store(out, float(value));
+	}
+	else if constexpr (FORMAT == SampleFormat::f64)
+	{
+		store(out, value);
+	}
+	else
+	{
+		constexpr auto scale{double(std::int64_t(1) << (Traits<FORMAT>::bits - 1))};
+		constexpr auto shift{32 - Traits<FORMAT>::bits};
+
+		const auto scaled{std::clamp(std::nearbyint(value * scale), -scale, scale - 1.0)};
+
+		store_int<FORMAT>(out, std::int32_t(std::uint32_t(std::int32_t(scaled)) << shift));
+	}
+}
+
+template <SampleFormat IN, SampleFormat OUT> static
+auto convert_sample(const std::byte* in, std::byte* out) -> void
+{
+	if constexpr (IN == OUT)
+	{
+		std::memcpy(out, in, Traits<IN>::size);
+	}
+	else if constexpr (Traits<IN>::bits > 0 && Traits<OUT>::bits > 0)
+	{
+		store_int<OUT>(out, load_int<IN>(in));
+	}
+	else
+	{
+		store_float<OUT>(out, load_float<IN>(in));
+	}
+}
+
+template <SampleFormat IN, SampleFormat OUT> static
+auto convert_loop(const std::byte* in, std::byte* out, std::size_t num_samples) -> void
+{
+	constexpr auto in_size{Traits<IN>::size};
+	constexpr auto out_size{Traits<OUT>::size};
+
+	if constexpr (IN == OUT)
+	{
+		std::memcpy(out, in, num_samples * in_size);
+	}
+	else if constexpr (IN == SampleFormat::s16 && OUT == SampleFormat::f32)
+	{
+		s16_to_f32((const std::int16_t*)(in), (float*)(out), num_samples);
+	}
+	else if constexpr (IN == SampleFormat::s24 && OUT == SampleFormat::f32)
+	{
+		s24_to_f32(in, (float*)(out), num_samples);
+	}
+	else if constexpr (IN == SampleFormat::s32 && OUT == SampleFormat::f32)
+	{
+		s32_to_f32((const std::int32_t*)(in), (float*)(out), num_samples);
+	}
+	else
+	{
+		for (std::size_t i = 0; i < num_samples; i++)
+		{
+			convert_sample<IN, OUT>(in + (i * in_size), out + (i * out_size));
+		}
+	}
+}
+
+// Stereo deinterleave kernels. They return the number of frames done,
+// leaving the rest to the scalar loop.
+
+static
+auto deinterleave_stereo(const float* in, float* left, float* right, std::size_t num_frames) -> std::size_t
+{
+	std::size_t i = 0;
+
+#	if BLAHDIO_SSE2
+		for (; i + 4 <= num_frames; i += 4)
+		{
+			const auto a{_mm_loadu_ps(in + (i * 2))};
+			const auto b{_mm_loadu_ps(in + (i * 2) + 4)};
+
+			_mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+#	elif BLAHDIO_NEON
+		for (; i + 4 <= num_frames; i += 4)
+		{
+			const auto x{vld2q_f32(in + (i * 2))};
+
+			vst1q_f32(left + i, x.val[0]);
+			vst1q_f32(right + i, x.val[1]);
+		}
+#	endif
+
+	return i;
+}
+
+// Converted on the way, so the samples are only touched once
+static
+auto deinterleave_stereo(const std::int16_t* in, float* left, float* right, std::size_t num_frames) -> std::size_t
+{
+	std::size_t i = 0;
+
+#	if BLAHDIO_SSE2
+		const auto scale{_mm_set1_ps(1.0f / 32768.0f)};
+
+		for (; i + 4 <= num_frames; i += 4)
+		{
+			// Sign extend by unpacking each sample into the top half of a
+			// 32 bit lane and shifting it back down
+			const auto x{_mm_loadu_si128((const __m128i*)(in + (i * 2)))};
+			const auto a{_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale)};
+			const auto b{_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), scale)};
+
+			_mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+#	elif BLAHDIO_NEON
+		for (; i + 4 <= num_frames; i += 4)
+		{
+			const auto x{vld2_s16(in + (i * 2))};
+
+			vst1q_f32(left + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(x.val[0])), 1.0f / 32768.0f));
+			vst1q_f32(right + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(x.val[1])), 1.0f / 32768.0f));
+		}
+#	endif
+
+	return i;
+}
+
+static
+auto deinterleave_stereo(const std::int32_t* in, float* left, float* right, std::size_t num_frames) -> std::size_t
+{
+	std::size_t i = 0;
+
+#	if BLAHDIO_SSE2
+		const auto scale{_mm_set1_ps(1.0f / 2147483648.0f)};
+
+		for (; i + 4 <= num_frames; i += 4)
+		{
+			const auto a{_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(in + (i * 2)))), scale)};
+			const auto b{_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(in + (i * 2) + 4))), scale)};
+
+			_mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+#	elif BLAHDIO_NEON
+		for (; i + 4 <= num_frames; i += 4)
+		{
+			const auto x{vld2q_s32(in + (i * 2))};
+
+			vst1q_f32(left + i, vmulq_n_f32(vcvtq_f32_s32(x.val[0]), 1.0f / 2147483648.0f));
+			vst1q_f32(right + i, vmulq_n_f32(vcvtq_f32_s32(x.val[1]), 1.0f / 2147483648.0f));
+		}
+#	endif
+
+	return i;
+}
+
+template <SampleFormat IN, SampleFormat OUT> static
+auto deinterleave_loop(const std::byte* in, std::byte* const* out, int num_channels, std::size_t num_frames) -> void
+{
+	constexpr auto in_size{Traits<IN>::size};
+	constexpr auto out_size{Traits<OUT>::size};
+
+	// Nothing to split up
+	if (num_channels == 1)
+	{
+		convert_loop<IN, OUT>(in, out[0], num_frames);
+		return;
+	}
+
+	std::size_t first_frame{0};
+
+	if constexpr ((IN == SampleFormat::f32 || IN == SampleFormat::s16 || IN == SampleFormat::s32) && OUT == SampleFormat::f32)
+	{
+		if (num_channels == 2)
+		{
+			using InType =
+				std::conditional_t<IN == SampleFormat::f32, float,
+				std::conditional_t<IN == SampleFormat::s16, std::int16_t, std::int32_t>>;
+
+			first_frame = deinterleave_stereo((const InType*)(in), (float*)(out[0]), (float*)(out[1]), num_frames);
+		}
+	}
+
+	const auto in_stride{in_size * std::size_t(num_channels)};
+
+	for (int c = 0; c < num_channels; c++)
+	{
+		const auto channel_in{in + (in_size * std::size_t(c))};
+		const auto channel_out{out[c]};
+
+		for (auto i = first_frame; i < num_frames; i++)
+		{
+			convert_sample<IN, OUT>(channel_in + (i * in_stride), channel_out + (i * out_size));
+		}
+	}
+}
+
+using ConvertFn = void(*)(const std::byte*, std::byte*, std::size_t);
+
+template <SampleFormat IN> [[nodiscard]] static
+auto get_convert_fn(SampleFormat out_format) -> ConvertFn
+{
+	switch (out_format)
+	{
+		case SampleFormat::f32: return convert_loop<IN, SampleFormat::f32>;
+		case SampleFormat::f64: return convert_loop<IN, SampleFormat::f64>;
+		case SampleFormat::s16: return convert_loop<IN, SampleFormat::s16>;
+		case SampleFormat::s24: return convert_loop<IN, SampleFormat::s24>;
+		case SampleFormat::s32: default: return convert_loop<IN, SampleFormat::s32>;
+	}
+}
+
+[[nodiscard]] static
+auto get_convert_fn(SampleFormat in_format, SampleFormat out_format) -> ConvertFn
+{
+	switch (in_format)
+	{
+		case SampleFormat::f32: return get_convert_fn<SampleFormat::f32>(out_format);
+		case SampleFormat::f64: return get_convert_fn<SampleFormat::f64>(out_format);
+		case SampleFormat::s16: return get_convert_fn<SampleFormat::s16>(out_format);
+		case SampleFormat::s24: return get_convert_fn<SampleFormat::s24>(out_format);
+		case SampleFormat::s32: default: return get_convert_fn<SampleFormat::s32>(out_format);
+	}
+}
+
+using DeinterleaveFn = void(*)(const std::byte*, std::byte* const*, int, std::size_t);
+
+template <SampleFormat IN> [[nodiscard]] static
+auto get_deinterleave_fn(SampleFormat out_format) -> DeinterleaveFn
+{
+	switch (out_format)
+	{
+		case SampleFormat::f32: return deinterleave_loop<IN, SampleFormat::f32>;
+		case SampleFormat::f64: return deinterleave_loop<IN, SampleFormat::f64>;
+		case SampleFormat::s16: return deinterleave_loop<IN, SampleFormat::s16>;
+		case SampleFormat::s24: return deinterleave_loop<IN, SampleFormat::s24>;
+		case SampleFormat::s32: default: return deinterleave_loop<IN, SampleFormat::s32>;
+	}
+}
+
+[[nodiscard]] static
+auto get_deinterleave_fn(SampleFormat in_format, SampleFormat out_format) -> DeinterleaveFn
+{
+	switch (in_format)
+	{
+		case SampleFormat::f32: return get_deinterleave_fn<SampleFormat::f32>(out_format);
+		case SampleFormat::f64: return get_deinterleave_fn<SampleFormat::f64>(out_format);
+		case SampleFormat::s16: return get_deinterleave_fn<SampleFormat::s16>(out_format);
+		case SampleFormat::s24: return get_deinterleave_fn<SampleFormat::s24>(out_format);
+		case SampleFormat::s32: default: return get_deinterleave_fn<SampleFormat::s32>(out_format);
+	}
+}
+
+auto get_sample_size(SampleFormat format) -> std::size_t
+{
+	switch (format)
+	{
+		case SampleFormat::f32: return Traits<SampleFormat::f32>::size;
+		case SampleFormat::f64: return Traits<SampleFormat::f64>::size;
+		case SampleFormat::s16: return Traits<SampleFormat::s16>::size;
+		case SampleFormat::s24: return Traits<SampleFormat::s24>::size;
+		case SampleFormat::s32: default: return Traits<SampleFormat::s32>::size;
+	}
+}
+
+auto is_float(SampleFormat format) -> bool
+{
+	return format == SampleFormat::f32 || format == SampleFormat::f64;
+}
+
+auto convert_samples(const void* in, SampleFormat in_format, void* out, SampleFormat out_format, std::size_t num_samples) -> void
+{
+	get_convert_fn(in_format, out_format)((const std::byte*)(in), (std::byte*)(out), num_samples);
+}
+
+auto deinterleave_samples(const void* in, SampleFormat in_format, void* const* out, SampleFormat out_format, int num_channels, std::size_t num_frames) -> void
+{
+	get_deinterleave_fn(in_format, out_format)((const std::byte*)(in), (std::byte* const*)(out), num_channels, num_frames);
+}
+
+}}
\ No newline at end of file
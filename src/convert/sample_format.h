@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include "blahdio/output_format.h"
+
+namespace blahdio {
+namespace convert {
+
+[[nodiscard]] extern auto get_sample_size(SampleFormat format) -> std::size_t;
+[[nodiscard]] extern auto is_float(SampleFormat format) -> bool;
+
+// Converts interleaved or planar samples, it doesn't matter which. The
+// buffers don't need to be aligned, and can be the same buffer if both
+// formats are the same size. Float is scaled to and from integer
+// by 2^(bits-1), clipping where needed, so int -> float -> int is
+// lossless. Integer to float32 is vectorized (see int_to_float.h).
+extern auto convert_samples(const void* in, SampleFormat in_format, void* out, SampleFormat out_format, std::size_t num_samples) -> void;
+
+// Splits interleaved samples into one buffer per channel, converting
+// them at the same time. Mono is converted as above, and stereo
+// float32, int16 and int32 to float32 are vectorized. The output
+// buffers don't need to be aligned but it helps.
+extern auto deinterleave_samples(const void* in, SampleFormat in_format, void* const* out, SampleFormat out_format, int num_channels, std::size_t num_frames) -> void;
+
+}}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+// Instruction sets which are always available on the target, so they can
+// be used without checking at runtime
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define BLAHDIO_SSE2 1
+#	include <emmintrin.h>
+#else
+#	define BLAHDIO_SSE2 0
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#	define BLAHDIO_NEON 1
+#	include <arm_neon.h>
+#else
+#	define BLAHDIO_NEON 0
+#endif
+
+// Newer x86 instruction sets have to be checked for at runtime (see
+// cpu.h). Functions which use them are compiled for them one at a time
+// with BLAHDIO_TARGET, so the rest of the library still runs anywhere.
+
+#if BLAHDIO_SSE2 && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#	define BLAHDIO_X86 1
+#	include <immintrin.h>
+#	if defined(__GNUC__) || defined(__clang__)
+#		define BLAHDIO_TARGET(isa) __attribute__((target(isa)))
+#	else
+#		define BLAHDIO_TARGET(isa)
+#	endif
+#else
+#	define BLAHDIO_X86 0
+#endif
@@ -0,0 +1,82 @@
+#include "counters.h"
+
+namespace blahdio {
+namespace stats {
+
+static thread_local Counters* current_counters{};
+
+Counters::Counters(Kind kind)
+	: process_values_{&get_process_values(kind)}
+{
+}
+
+auto Counters::get_process_values(Kind kind) -> Values&
+{
+	static Values reading{};
+	static Values writing{};
+
+	return kind == Kind::reading ? reading : writing;
+}
+
+auto Counters::to_stats(const Values& values) -> Stats
+{
+	const auto get = [&values](Counter counter)
+	{
+		return values[std::size_t(counter)].load(std::memory_order_relaxed);
+	};
+
+	Stats out;
+
+	out.bytes = get(Counter::bytes);
+	out.frames = get(Counter::frames);
+	out.codec_ns = get(Counter::codec_ns);
+	out.convert_ns = get(Counter::convert_ns);
+	out.callback_ns = get(Counter::callback_ns);
+	out.seeks = get(Counter::seeks);
+	out.seek_ns = get(Counter::seek_ns);
+	out.allocations = get(Counter::allocations);
+	out.underruns = get(Counter::underruns);
+
+	return out;
+}
+
+auto Counters::add(Counter counter, std::uint64_t n) -> void
+{
+	values_[std::size_t(counter)].fetch_add(n, std::memory_order_relaxed);
+	(*process_values_)[std::size_t(counter)].fetch_add(n, std::memory_order_relaxed);
+}
+
+auto Counters::get() const -> Stats
+{
+	return to_stats(values_);
+}
+
+auto Counters::get_process(Kind kind) -> Stats
+{
+	return to_stats(get_process_values(kind));
+}
+
+auto current() -> Counters*
+{
+	return current_counters;
+}
+
+Scope::Scope(Counters* counters)
+	: previous_{current_counters}
+{
+	current_counters = counters;
+}
+
+Scope::~Scope()
+{
+	current_counters = previous_;
+}
+
+} // stats
+
+auto get_process_stats() -> ProcessStats
+{
+	return { stats::Counters::get_process(stats::Kind::reading), stats::Counters::get_process(stats::Kind::writing) };
+}
+
+} // blahdio
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "blahdio/stats.h"
+
+namespace blahdio {
+namespace stats {
+
+enum class Kind { reading, writing };
+
+enum class Counter
+{
+	bytes,
+	frames,
+	codec_ns,
+	convert_ns,
+	callback_ns,
+	seeks,
+	seek_ns,
+	allocations,
+	underruns,
+};
+
+// One object's totals. Every count is also added to the process wide
+// totals for its kind, so nothing has to be gathered up (or locked) to
+// take a snapshot of the whole process, and nothing is lost when the
+// object goes away.
+class Counters
+{
+public:
+
+	explicit Counters(Kind kind);
+
+	Counters(const Counters&) = delete;
+	auto operator=(const Counters&) -> Counters& = delete;
+
+	auto add(Counter counter, std::uint64_t n) -> void;
+
+	[[nodiscard]] auto get() const -> Stats;
+
+	// The totals of every object of this kind
+	[[nodiscard]] static auto get_process(Kind kind) -> Stats;
+
+private:
+
+	using Values = std::array<std::atomic<std::uint64_t>, std::size_t(Counter::underruns) + 1>;
+
+	[[nodiscard]] static auto get_process_values(Kind kind) -> Values&;
+	[[nodiscard]] static auto to_stats(const Values& values) -> Stats;
+
+	Values values_{};
+	Values* process_values_;
+};
+
+// The counters which work on this thread is charged to. Set by Scope at
+// the public entry points (and by the threads they start), so the code
+// in between doesn't have to pass them around. Null otherwise, in which
+// case nothing is counted.
+[[nodiscard]] extern auto current() -> Counters*;
+
+class Scope
+{
+public:
+
+	explicit Scope(Counters* counters);
+	~Scope();
+
+	Scope(const Scope&) = delete;
+	auto operator=(const Scope&) -> Scope& = delete;
+
+private:
+
+	Counters* previous_;
+};
+
+inline auto add(Counter counter, std::uint64_t n) -> void
+{
+	if (const auto counters{current()})
+	{
+		counters->add(counter, n);
+	}
+}
+
+// Adds the time until it goes out of scope. The clock isn't read if
+// nothing is being counted.
+class Timer
+{
+public:
+
+	using Clock = std::chrono::steady_clock;
+
+	explicit Timer(Counter counter)
+		: counters_{current()}
+		, counter_{counter}
+	{
+		if (counters_) start_ = Clock::now();
+	}
+
+	~Timer()
+	{
+		if (!counters_) return;
+
+		counters_->add(counter_, std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count()));
+	}
+
+	Timer(const Timer&) = delete;
+	auto operator=(const Timer&) -> Timer& = delete;
+
+private:
+
+	Counters* counters_;
+	Counter counter_;
+	Clock::time_point start_{};
+};
+
+// Resizes one of the library's sample buffers, counting an allocation
+// if it has to grow
+template <typename T>
+auto resize(std::vector<T>* buffer, std::size_t size) -> void
+{
+	if (size > buffer->capacity())
+	{
+		add(Counter::allocations, 1);
+	}
+
+	buffer->resize(size);
+}
+
+}}
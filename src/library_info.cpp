@@ -1,6 +1,8 @@
 #include <algorithm>
 #include <format>
 #include "blahdio/library_info.h"
+#include "read/raw_source.h"
+#include "read/sniff.h"
 
 using namespace std::literals::string_view_literals;
 
@@ -109,4 +111,34 @@ auto type_hint_for_type(AudioType type, bool try_all_supported_types) -> expecte
 	return get_type_hint(*pos, try_all_supported_types);
 }
 
+[[nodiscard]] static
+auto sniffed_type_or_error(AudioType type) -> expected<AudioType>
+{
+	if (type == AudioType::none)
+	{
+		return tl::make_unexpected("File format not recognized");
+	}
+
+	return type;
+}
+
+[[nodiscard]]
+auto sniff_type(const void* data, std::size_t data_size) -> expected<AudioType>
+{
+	return sniffed_type_or_error(read::sniff_type(data, data_size));
+}
+
+[[nodiscard]]
+auto sniff_type(std::string utf8_path) -> expected<AudioType>
+{
+	const auto source{read::make_raw_source(utf8_path)};
+
+	if (!source.size())
+	{
+		return tl::make_unexpected(std::format("Failed to open file: '{}'", utf8_path));
+	}
+
+	return sniffed_type_or_error(read::sniff_type(source));
+}
+
 } // blahdio
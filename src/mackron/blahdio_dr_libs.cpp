@@ -78,9 +78,8 @@ bool init_file_write(drwav* wav, std::string_view utf8_path, const drwav_data_fo
 
 [[nodiscard]] auto generic_frame_reader_loop(
 	AudioReader::Callbacks callbacks,
-	std::function<std::uint32_t(float*, std::uint32_t)> read_func,
+	read::FormatReader* reader,
 	std::uint32_t chunk_size,
-	int num_channels,
 	std::uint64_t num_frames) -> tl::expected<void, std::string>
 {
 	std::uint64_t frame = 0;
@@ -89,8 +88,6 @@ bool init_file_write(drwav* wav, std::string_view utf8_path, const drwav_data_fo
 	{
 		if (callbacks.should_abort()) break;
 
-		std::vector<float> interleaved_frames;
-
 		auto read_size = chunk_size;
 
 		if (frame + read_size >= num_frames)
@@ -98,11 +95,9 @@ bool init_file_write(drwav* wav, std::string_view utf8_path, const drwav_data_fo
 			read_size = std::uint32_t(num_frames - frame);
 		}
 
-		interleaved_frames.resize(size_t(read_size) * num_channels);
+		const auto frames_read = reader->read_chunk(read_size);
 
-		const auto frames_read = read_func(interleaved_frames.data(), read_size);
-		
-		callbacks.return_chunk((const void*)(interleaved_frames.data()), frame, frames_read);
+		reader->return_chunk(callbacks, frame, frames_read);
 
 		if (frames_read < read_size)
 		{
@@ -117,9 +112,8 @@ bool init_file_write(drwav* wav, std::string_view utf8_path, const drwav_data_fo
 
 void generic_stream_reader_loop(
 	AudioReader::Callbacks callbacks,
-	std::function<std::uint32_t(float*, std::uint32_t)> read_func,
-	std::uint32_t chunk_size,
-	int num_channels)
+	read::FormatReader* reader,
+	std::uint32_t chunk_size)
 {
 	std::uint64_t frame = 0;
 
@@ -127,13 +121,12 @@ void generic_stream_reader_loop(
 	{
 		if (callbacks.should_abort()) break;
 
-		std::vector<float> interleaved_frames;
-
-		interleaved_frames.resize(size_t(chunk_size) * num_channels);
+		const auto frames_read = reader->read_chunk(chunk_size);
 
-		const auto frames_read = read_func(interleaved_frames.data(), chunk_size);
-
-		callbacks.return_chunk((const void*)(interleaved_frames.data()), frame, frames_read);
+		if (frames_read > 0)
+		{
+			reader->return_chunk(callbacks, frame, frames_read);
+		}
 
 		if (frames_read < chunk_size) break;
 
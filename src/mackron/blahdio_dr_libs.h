@@ -6,6 +6,7 @@
 #include <dr_wav.h>
 #include "blahdio/audio_reader.h"
 #include "blahdio/expected.h"
+#include "read/format_reader.h"
 
 namespace blahdio {
 namespace dr_libs {
@@ -30,16 +31,14 @@ extern bool init_file_write(drwav* wav, std::string_view utf8_path, const drwav_
 
 [[nodiscard]] extern auto generic_frame_reader_loop(
 	AudioReader::Callbacks callbacks,
-	std::function<std::uint32_t(float*, std::uint32_t)> read_func,
+	read::FormatReader* reader,
 	std::uint32_t chunk_size,
-	int num_channels,
 	std::uint64_t num_frames) -> expected<void>;
 
 extern void generic_stream_reader_loop(
 	AudioReader::Callbacks callbacks,
-	std::function<std::uint32_t(float*, std::uint32_t)> read_func,
-	std::uint32_t chunk_size,
-	int num_channels);
+	read::FormatReader* reader,
+	std::uint32_t chunk_size);
 
 }
 }
\ No newline at end of file
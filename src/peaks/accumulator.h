@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "blahdio/peaks.h"
+#include "summarize.h"
+
+namespace blahdio {
+namespace peaks {
+
+// Running totals for one bin of one channel. Coarser bins are made by
+// adding finer ones together, which is why the sum of squares is kept
+// rather than the RMS.
+struct Accumulator
+{
+	float min{std::numeric_limits<float>::max()};
+	float max{std::numeric_limits<float>::lowest()};
+	double sum_of_squares{0.0};
+	std::uint64_t num_frames{0};
+
+	auto add(const Summary& summary, std::uint64_t summary_frames) -> void
+	{
+		min = std::min(min, summary.min);
+		max = std::max(max, summary.max);
+		sum_of_squares += summary.sum_of_squares;
+		num_frames += summary_frames;
+	}
+
+	auto add(const Accumulator& other) -> void
+	{
+		add(Summary{other.min, other.max, other.sum_of_squares}, other.num_frames);
+	}
+
+	[[nodiscard]] auto get_bin() const -> Peaks::Bin
+	{
+		if (num_frames == 0) return {};
+
+		return { min, max, float(std::sqrt(sum_of_squares / double(num_frames))) };
+	}
+};
+
+}}
@@ -0,0 +1,236 @@
+#include "blahdio/peaks.h"
+#include <bit>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <utf8.h>
+#include "bytes.h"
+
+namespace blahdio {
+
+namespace peaks {
+
+static constexpr char MAGIC[4] = { 'B', 'D', 'P', 'K' };
+static constexpr std::uint32_t VERSION = 1;
+static constexpr std::size_t HEADER_SIZE = 4 + 4 + 8 + 8 + 4 + 8 + 4;
+static constexpr std::size_t LEVEL_HEADER_SIZE = 4 + 8;
+static constexpr std::size_t BIN_SIZE = 4 + 4 + 4;
+
+// What the sidecar was made from. If either has changed the peaks are
+// out of date.
+struct SourceKey
+{
+	std::uint64_t size{};
+	std::int64_t modified{};
+};
+
+[[nodiscard]] static
+auto to_path(const std::string& utf8_path) -> std::filesystem::path
+{
+#ifdef _WIN32
+	return std::filesystem::path((const wchar_t*)(utf8::utf8to16(utf8_path).c_str()));
+#else
+	return std::filesystem::path(utf8_path);
+#endif
+}
+
+[[nodiscard]] static
+auto get_source_key(const std::string& utf8_source_path) -> expected<SourceKey>
+{
+	const auto path{to_path(utf8_source_path)};
+
+	std::error_code err;
+
+	const auto size{std::filesystem::file_size(path, err)};
+
+	if (err)
+	{
+		return tl::make_unexpected(std::format("Failed to read the source file's size ({})", err.message()));
+	}
+
+	const auto modified{std::filesystem::last_write_time(path, err)};
+
+	if (err)
+	{
+		return tl::make_unexpected(std::format("Failed to read the source file's modification time ({})", err.message()));
+	}
+
+	return SourceKey{size, std::int64_t(modified.time_since_epoch().count())};
+}
+
+[[nodiscard]] static
+auto serialize(const Peaks& peaks, SourceKey key) -> std::vector<std::byte>
+{
+	std::vector<std::byte> out;
+
+	auto size{HEADER_SIZE};
+
+	for (const auto& level : peaks.levels)
+	{
+		size += LEVEL_HEADER_SIZE + (level.bins.size() * BIN_SIZE);
+	}
+
+	out.reserve(size);
+
+	for (auto c : MAGIC)
+	{
+		out.push_back(std::byte(c));
+	}
+
+	bytes::put<std::uint32_t>(&out, VERSION);
+	bytes::put<std::uint64_t>(&out, key.size);
+	bytes::put<std::uint64_t>(&out, std::uint64_t(key.modified));
+	bytes::put<std::uint32_t>(&out, std::uint32_t(peaks.num_channels));
+	bytes::put<std::uint64_t>(&out, peaks.num_frames);
+	bytes::put<std::uint32_t>(&out, std::uint32_t(peaks.levels.size()));
+
+	for (const auto& level : peaks.levels)
+	{
+		bytes::put<std::uint32_t>(&out, level.frames_per_bin);
+		bytes::put<std::uint64_t>(&out, level.bins.size());
+
+		for (const auto& bin : level.bins)
+		{
+			bytes::put<std::uint32_t>(&out, std::bit_cast<std::uint32_t>(bin.min));
+			bytes::put<std::uint32_t>(&out, std::bit_cast<std::uint32_t>(bin.max));
+			bytes::put<std::uint32_t>(&out, std::bit_cast<std::uint32_t>(bin.rms));
+		}
+	}
+
+	return out;
+}
+
+[[nodiscard]] static
+auto deserialize(const std::vector<std::byte>& data, SourceKey key) -> expected<Peaks>
+{
+	if (data.size() < HEADER_SIZE)
+	{
+		return tl::make_unexpected("Failed to load peaks (Not enough data)");
+	}
+
+	for (std::size_t i = 0; i < sizeof(MAGIC); i++)
+	{
+		if (data[i] != std::byte(MAGIC[i]))
+		{
+			return tl::make_unexpected("Failed to load peaks (This is not a peaks file)");
+		}
+	}
+
+	auto pos{data.data() + sizeof(MAGIC)};
+	const auto end{data.data() + data.size()};
+
+	const auto version{bytes::get<std::uint32_t>(&pos)};
+
+	if (version != VERSION)
+	{
+		return tl::make_unexpected(std::format("Failed to load peaks (Unsupported version: {})", version));
+	}
+
+	const auto source_size{bytes::get<std::uint64_t>(&pos)};
+	const auto source_modified{std::int64_t(bytes::get<std::uint64_t>(&pos))};
+
+	if (source_size != key.size || source_modified != key.modified)
+	{
+		return tl::make_unexpected("Failed to load peaks (The source file has changed)");
+	}
+
+	Peaks out;
+
+	out.num_channels = int(bytes::get<std::uint32_t>(&pos));
+	out.num_frames = bytes::get<std::uint64_t>(&pos);
+
+	const auto num_levels{bytes::get<std::uint32_t>(&pos)};
+
+	for (std::uint32_t i = 0; i < num_levels; i++)
+	{
+		if (std::size_t(end - pos) < LEVEL_HEADER_SIZE)
+		{
+			return tl::make_unexpected("Failed to load peaks (Not enough data)");
+		}
+
+		Peaks::Level level;
+
+		level.frames_per_bin = bytes::get<std::uint32_t>(&pos);
+
+		const auto num_bins{bytes::get<std::uint64_t>(&pos)};
+
+		if (std::size_t(end - pos) / BIN_SIZE < num_bins)
+		{
+			return tl::make_unexpected("Failed to load peaks (Not enough data)");
+		}
+
+		level.bins.resize(std::size_t(num_bins));
+
+		for (auto& bin : level.bins)
+		{
+			bin.min = std::bit_cast<float>(bytes::get<std::uint32_t>(&pos));
+			bin.max = std::bit_cast<float>(bytes::get<std::uint32_t>(&pos));
+			bin.rms = std::bit_cast<float>(bytes::get<std::uint32_t>(&pos));
+		}
+
+		out.levels.push_back(std::move(level));
+	}
+
+	return out;
+}
+
+} // peaks
+
+auto save_peaks(const Peaks& peaks, const std::string& utf8_source_path, const std::string& utf8_sidecar_path) -> expected<void>
+{
+	const auto key{peaks::get_source_key(utf8_source_path)};
+
+	if (!key)
+	{
+		return tl::make_unexpected(key.error());
+	}
+
+	const auto data{peaks::serialize(peaks, *key)};
+
+	std::ofstream file(peaks::to_path(utf8_sidecar_path), std::fstream::binary);
+
+	file.write((const char*)(data.data()), std::streamsize(data.size()));
+
+	if (!file)
+	{
+		return tl::make_unexpected("Failed to save peaks (The sidecar file couldn't be written)");
+	}
+
+	return {};
+}
+
+auto load_peaks(const std::string& utf8_source_path, const std::string& utf8_sidecar_path) -> expected<Peaks>
+{
+	const auto key{peaks::get_source_key(utf8_source_path)};
+
+	if (!key)
+	{
+		return tl::make_unexpected(key.error());
+	}
+
+	const auto path{peaks::to_path(utf8_sidecar_path)};
+
+	std::error_code err;
+
+	const auto size{std::filesystem::file_size(path, err)};
+
+	std::ifstream file(path, std::fstream::binary);
+
+	if (err || !file)
+	{
+		return tl::make_unexpected("Failed to load peaks (The sidecar file couldn't be opened)");
+	}
+
+	std::vector<std::byte> data(static_cast<std::size_t>(size));
+
+	file.read((char*)(data.data()), std::streamsize(data.size()));
+
+	if (!file)
+	{
+		return tl::make_unexpected("Failed to load peaks (The sidecar file couldn't be read)");
+	}
+
+	return peaks::deserialize(data, *key);
+}
+
+} // blahdio
@@ -0,0 +1,208 @@
+#include "blahdio/peaks.h"
+#include "accumulator.h"
+
+namespace blahdio {
+
+namespace peaks {
+
+// Roughly how many frames to decode at a time. Rounded to a multiple of
+// the finest level so that every bin falls inside a single chunk.
+static constexpr std::uint32_t CHUNK_FRAMES = 16384;
+
+[[nodiscard]] static
+auto check_levels(const std::vector<std::uint32_t>& frames_per_bin) -> expected<void>
+{
+	if (frames_per_bin.empty())
+	{
+		return tl::make_unexpected("Failed to build peaks (No levels were requested)");
+	}
+
+	if (frames_per_bin.front() == 0)
+	{
+		return tl::make_unexpected("Failed to build peaks (A level can't have 0 frames per bin)");
+	}
+
+	for (std::size_t i = 1; i < frames_per_bin.size(); i++)
+	{
+		if (frames_per_bin[i] <= frames_per_bin[i - 1] || frames_per_bin[i] % frames_per_bin[i - 1] != 0)
+		{
+			return tl::make_unexpected("Failed to build peaks (Each level must be a larger multiple of the one before it)");
+		}
+	}
+
+	return {};
+}
+
+[[nodiscard]] static
+auto merge(const std::vector<Accumulator>& finer, int num_channels, std::uint32_t ratio) -> std::vector<Accumulator>
+{
+	const auto num_finer_bins{finer.size() / num_channels};
+	const auto num_bins{(num_finer_bins + ratio - 1) / ratio};
+
+	std::vector<Accumulator> out(num_bins * num_channels);
+
+	for (std::size_t bin = 0; bin < num_finer_bins; bin++)
+	{
+		for (int c = 0; c < num_channels; c++)
+		{
+			out[((bin / ratio) * num_channels) + c].add(finer[(bin * num_channels) + c]);
+		}
+	}
+
+	return out;
+}
+
+[[nodiscard]] static
+auto make_level(std::uint32_t frames_per_bin, const std::vector<Accumulator>& bins) -> Peaks::Level
+{
+	Peaks::Level out;
+
+	out.frames_per_bin = frames_per_bin;
+	out.bins.reserve(bins.size());
+
+	for (const auto& bin : bins)
+	{
+		out.bins.push_back(bin.get_bin());
+	}
+
+	return out;
+}
+
+} // peaks
+
+auto Peaks::find_level(double frames_per_pixel) const -> const Level*
+{
+	if (levels.empty()) return nullptr;
+
+	auto out{&levels.front()};
+
+	for (const auto& level : levels)
+	{
+		if (level.frames_per_bin <= frames_per_pixel)
+		{
+			out = &level;
+		}
+	}
+
+	return out;
+}
+
+auto build_peaks(AudioReader* reader, const std::vector<std::uint32_t>& frames_per_bin) -> expected<Peaks>
+{
+	if (const auto result{peaks::check_levels(frames_per_bin)}; !result)
+	{
+		return tl::make_unexpected(result.error());
+	}
+
+	auto format{reader->get_format()};
+
+	if (!format)
+	{
+		format = reader->read_header();
+	}
+
+	if (!format)
+	{
+		return tl::make_unexpected(format.error());
+	}
+
+	const auto num_channels{format->num_channels};
+	const auto finest{frames_per_bin.front()};
+	const auto chunk_size{finest * std::max<std::uint32_t>(1, peaks::CHUNK_FRAMES / finest)};
+
+	std::vector<peaks::Accumulator> bins;
+	std::uint64_t num_frames{0};
+
+	if (format->num_frames_exact)
+	{
+		bins.reserve(std::size_t((format->num_frames + finest - 1) / finest) * num_channels);
+	}
+
+	AudioReader::Callbacks callbacks;
+
+	callbacks.should_abort = []() { return false; };
+	callbacks.return_planar_chunk = [&](const void* const* channels, std::uint64_t first_frame, std::uint32_t chunk_frames)
+	{
+		const auto first_bin{std::size_t(first_frame / finest)};
+		const auto num_bins{(chunk_frames + finest - 1) / finest};
+
+		if (bins.size() < (first_bin + num_bins) * num_channels)
+		{
+			bins.resize((first_bin + num_bins) * num_channels);
+		}
+
+		for (std::uint32_t bin = 0; bin < num_bins; bin++)
+		{
+			const auto offset{bin * finest};
+			const auto bin_frames{std::min(finest, chunk_frames - offset)};
+
+			for (int c = 0; c < num_channels; c++)
+			{
+				const auto samples{(const float*)(channels[c]) + offset};
+
+				bins[((first_bin + bin) * num_channels) + c].add(peaks::summarize(samples, bin_frames), bin_frames);
+			}
+		}
+
+		num_frames = std::max(num_frames, first_frame + chunk_frames);
+	};
+
+	OutputFormat output_format;
+
+	output_format.sample_format = SampleFormat::f32;
+	output_format.planar = true;
+
+	const auto result{reader->read_frames(callbacks, chunk_size, output_format)};
+
+	if (!result)
+	{
+		return tl::make_unexpected(result.error());
+	}
+
+	Peaks out;
+
+	out.num_channels = num_channels;
+	out.num_frames = num_frames;
+	out.levels.push_back(peaks::make_level(finest, bins));
+
+	for (std::size_t i = 1; i < frames_per_bin.size(); i++)
+	{
+		bins = peaks::merge(bins, num_channels, frames_per_bin[i] / frames_per_bin[i - 1]);
+		out.levels.push_back(peaks::make_level(frames_per_bin[i], bins));
+	}
+
+	return out;
+}
+
+auto load_or_build_peaks(const std::string& utf8_source_path, const std::string& utf8_sidecar_path, const std::vector<std::uint32_t>& frames_per_bin) -> expected<Peaks>
+{
+	const auto has_levels = [&frames_per_bin](const Peaks& peaks)
+	{
+		if (peaks.levels.size() != frames_per_bin.size()) return false;
+
+		for (std::size_t i = 0; i < frames_per_bin.size(); i++)
+		{
+			if (peaks.levels[i].frames_per_bin != frames_per_bin[i]) return false;
+		}
+
+		return true;
+	};
+
+	if (auto peaks{load_peaks(utf8_source_path, utf8_sidecar_path)}; peaks && has_levels(*peaks))
+	{
+		return peaks;
+	}
+
+	AudioReader reader(utf8_source_path, AudioTypeHint::try_wav_first);
+
+	auto peaks{build_peaks(&reader, frames_per_bin)};
+
+	if (peaks)
+	{
+		(void)(save_peaks(*peaks, utf8_source_path, utf8_sidecar_path));
+	}
+
+	return peaks;
+}
+
+} // blahdio
@@ -0,0 +1,80 @@
+#include "summarize.h"
+#include <algorithm>
+#include "convert/simd.h"
+
+namespace blahdio {
+namespace peaks {
+
+auto summarize(const float* samples, std::size_t num_samples) -> Summary
+{
+	std::size_t i = 0;
+
+	Summary out{samples[0], samples[0], 0.0};
+
+	// Each vector lane only sums a quarter of the samples, so single
+	// precision is enough for bins of a few thousand samples
+#	if BLAHDIO_SSE2
+		if (num_samples >= 4)
+		{
+			auto min{_mm_loadu_ps(samples)};
+			auto max{min};
+			auto sum{_mm_setzero_ps()};
+
+			for (; i + 4 <= num_samples; i += 4)
+			{
+				const auto x{_mm_loadu_ps(samples + i)};
+
+				min = _mm_min_ps(min, x);
+				max = _mm_max_ps(max, x);
+				sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+			}
+
+			float mins[4], maxs[4], sums[4];
+
+			_mm_storeu_ps(mins, min);
+			_mm_storeu_ps(maxs, max);
+			_mm_storeu_ps(sums, sum);
+
+			out.min = std::min({mins[0], mins[1], mins[2], mins[3]});
+			out.max = std::max({maxs[0], maxs[1], maxs[2], maxs[3]});
+			out.sum_of_squares = double(sums[0]) + sums[1] + sums[2] + sums[3];
+		}
+#	elif BLAHDIO_NEON
+		if (num_samples >= 4)
+		{
+			auto min{vld1q_f32(samples)};
+			auto max{min};
+			auto sum{vdupq_n_f32(0.0f)};
+
+			for (; i + 4 <= num_samples; i += 4)
+			{
+				const auto x{vld1q_f32(samples + i)};
+
+				min = vminq_f32(min, x);
+				max = vmaxq_f32(max, x);
+				sum = vmlaq_f32(sum, x, x);
+			}
+
+			float mins[4], maxs[4], sums[4];
+
+			vst1q_f32(mins, min);
+			vst1q_f32(maxs, max);
+			vst1q_f32(sums, sum);
+
+			out.min = std::min({mins[0], mins[1], mins[2], mins[3]});
+			out.max = std::max({maxs[0], maxs[1], maxs[2], maxs[3]});
+			out.sum_of_squares = double(sums[0]) + sums[1] + sums[2] + sums[3];
+		}
+#	endif
+
+	for (; i < num_samples; i++)
+	{
+		out.min = std::min(out.min, samples[i]);
+		out.max = std::max(out.max, samples[i]);
+		out.sum_of_squares += double(samples[i]) * samples[i];
+	}
+
+	return out;
+}
+
+}}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+namespace blahdio {
+namespace peaks {
+
+struct Summary
+{
+	float min;
+	float max;
+	double sum_of_squares;
+};
+
+// Vectorized where possible. num_samples must be at least 1.
+[[nodiscard]] extern auto summarize(const float* samples, std::size_t num_samples) -> Summary;
+
+}}
@@ -0,0 +1,60 @@
+#include "blahdio/async_audio_streamer.h"
+#include "async_audio_streamer_impl.h"
+
+namespace blahdio {
+
+AsyncAudioStreamer::AsyncAudioStreamer() = default;
+AsyncAudioStreamer::AsyncAudioStreamer(AsyncAudioStreamer&&) noexcept = default;
+auto AsyncAudioStreamer::operator=(AsyncAudioStreamer&&) noexcept -> AsyncAudioStreamer& = default;
+AsyncAudioStreamer::~AsyncAudioStreamer() = default;
+
+AsyncAudioStreamer::AsyncAudioStreamer(std::shared_ptr<impl::AudioReader> reader, OutputFormat output_format, Options options)
+	: impl_{std::make_unique<impl::AsyncAudioStreamer>(reader, output_format, options)}
+{
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	impl_->open();
+}
+
+auto AsyncAudioStreamer::read_frames(void* buffer, std::uint32_t frames_to_read) -> ReadResult
+{
+	if (!impl_) return { 0, Status::error };
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->read_frames(buffer, frames_to_read);
+}
+
+auto AsyncAudioStreamer::read_planar_frames(void* const* channels, std::uint32_t frames_to_read) -> ReadResult
+{
+	if (!impl_) return { 0, Status::error };
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->read_planar_frames(channels, frames_to_read);
+}
+
+auto AsyncAudioStreamer::seek(std::uint64_t frame) -> void
+{
+	if (!impl_) return;
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	impl_->seek(frame);
+}
+
+auto AsyncAudioStreamer::get_stats() const -> Stats
+{
+	if (!impl_) return {};
+
+	return impl_->get_stats();
+}
+
+auto AsyncAudioStreamer::get_error() const -> std::string
+{
+	if (!impl_) return "The streamer is uninitialized.";
+
+	return impl_->get_error();
+}
+
+}
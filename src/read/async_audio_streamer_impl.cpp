@@ -0,0 +1,238 @@
+#include "async_audio_streamer_impl.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "audio_reader_impl.h"
+#include "convert/sample_format.h"
+#include "counters.h"
+#include "trace.h"
+
+namespace blahdio {
+namespace impl {
+
+// How often the background thread checks for room in the ring or a
+// seek, when it has nothing else to do. The reading thread never wakes
+// it, since that could mean taking a lock.
+static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(2);
+
+AsyncAudioStreamer::AsyncAudioStreamer(std::shared_ptr<impl::AudioReader> reader, OutputFormat output_format, Options options)
+	: reader_(reader)
+	, output_format_(output_format)
+	, options_(options)
+{
+}
+
+AsyncAudioStreamer::~AsyncAudioStreamer()
+{
+	if (!thread_.joinable()) return;
+
+	{
+		std::lock_guard lock{mutex_};
+		stop_ = true;
+	}
+
+	cv_.notify_all();
+	thread_.join();
+
+	(void)(reader_->stream_close());
+}
+
+auto AsyncAudioStreamer::open() -> void
+{
+	const auto format{reader_->stream_open(output_format_)};
+
+	if (!format)
+	{
+		fail(format.error());
+		return;
+	}
+
+	num_channels_ = format->num_channels;
+	frame_bytes_ = convert::get_sample_size(output_format_.sample_format) * num_channels_;
+
+	// The background thread would never get anywhere with chunks of 0
+	// frames, or a ring with no room for a whole chunk
+	options_.chunk_size = std::max(options_.chunk_size, std::uint32_t(1));
+	options_.read_ahead = std::max(options_.read_ahead, options_.chunk_size);
+
+	capacity_ = options_.read_ahead;
+
+	stats::resize(&ring_, capacity_ * frame_bytes_);
+	planar_offsets_.resize(num_channels_);
+
+	thread_ = std::thread{[this]() { run(); }};
+}
+
+template <typename CopyFn>
+auto AsyncAudioStreamer::read(std::uint32_t frames_to_read, CopyFn copy) -> ReadResult
+{
+	if (failed_.load(std::memory_order_acquire))
+	{
+		return { 0, Status::error };
+	}
+
+	if (seek_requested_.load(std::memory_order_relaxed) != seek_done_.load(std::memory_order_acquire))
+	{
+		stats::add(stats::Counter::underruns, 1);
+		return { 0, Status::underrun };
+	}
+
+	// ended_ is set after the last frames are written, so load it first
+	const auto ended{ended_.load(std::memory_order_acquire)};
+	const auto write_pos{write_pos_.load(std::memory_order_acquire)};
+	const auto read_pos{read_pos_.load(std::memory_order_relaxed)};
+	const auto num_frames{std::uint32_t(std::min<std::uint64_t>(frames_to_read, write_pos - read_pos))};
+	const auto start{read_pos % capacity_};
+	const auto first_part{std::uint32_t(std::min<std::uint64_t>(num_frames, capacity_ - start))};
+
+	copy(start, 0, first_part);
+
+	if (first_part < num_frames)
+	{
+		copy(0, first_part, num_frames - first_part);
+	}
+
+	read_pos_.store(read_pos + num_frames, std::memory_order_release);
+	stats::add(stats::Counter::frames, num_frames);
+
+	if (num_frames < frames_to_read)
+	{
+		if (ended) return { num_frames, Status::end };
+
+		stats::add(stats::Counter::underruns, 1);
+		return { num_frames, Status::underrun };
+	}
+
+	return { num_frames, Status::ok };
+}
+
+auto AsyncAudioStreamer::read_frames(void* buffer, std::uint32_t frames_to_read) -> ReadResult
+{
+	const auto copy = [this, buffer](std::uint64_t ring_frame, std::uint32_t buffer_frame, std::uint32_t num_frames)
+	{
+		std::memcpy((std::byte*)(buffer) + (buffer_frame * frame_bytes_), ring_.data() + (ring_frame * frame_bytes_), num_frames * frame_bytes_);
+	};
+
+	return read(frames_to_read, copy);
+}
+
+auto AsyncAudioStreamer::read_planar_frames(void* const* channels, std::uint32_t frames_to_read) -> ReadResult
+{
+	const auto sample_size{convert::get_sample_size(output_format_.sample_format)};
+
+	const auto copy = [this, channels, sample_size](std::uint64_t ring_frame, std::uint32_t buffer_frame, std::uint32_t num_frames)
+	{
+		for (int c = 0; c < num_channels_; c++)
+		{
+			planar_offsets_[c] = (std::byte*)(channels[c]) + (buffer_frame * sample_size);
+		}
+
+		BLAHDIO_TRACE_ZONE("blahdio::convert");
+		stats::Timer timer{stats::Counter::convert_ns};
+
+		convert::deinterleave_samples(ring_.data() + (ring_frame * frame_bytes_), output_format_.sample_format, planar_offsets_.data(), output_format_.sample_format, num_channels_, num_frames);
+	};
+
+	return read(frames_to_read, copy);
+}
+
+auto AsyncAudioStreamer::seek(std::uint64_t frame) -> void
+{
+	stats::add(stats::Counter::seeks, 1);
+	seek_frame_.store(frame, std::memory_order_relaxed);
+	seek_requested_.fetch_add(1, std::memory_order_release);
+}
+
+auto AsyncAudioStreamer::get_error() const -> std::string
+{
+	if (!failed_.load(std::memory_order_acquire)) return {};
+
+	return error_;
+}
+
+auto AsyncAudioStreamer::fail(std::string error) -> void
+{
+	if (failed_.load(std::memory_order_relaxed)) return;
+
+	error_ = std::move(error);
+	failed_.store(true, std::memory_order_release);
+}
+
+// Runs on the background thread
+auto AsyncAudioStreamer::run() -> void
+{
+	stats::Scope stats_scope{&counters_};
+
+	for (;;)
+	{
+		seek_if_requested();
+
+		if (decode_chunk()) continue;
+
+		std::unique_lock lock{mutex_};
+
+		if (cv_.wait_for(lock, POLL_INTERVAL, [this]() { return stop_; })) return;
+	}
+}
+
+// Returns true if a seek was done
+auto AsyncAudioStreamer::seek_if_requested() -> bool
+{
+	const auto requested{seek_requested_.load(std::memory_order_acquire)};
+
+	if (requested == seek_done_.load(std::memory_order_relaxed)) return false;
+
+	if (!failed_.load(std::memory_order_relaxed))
+	{
+		BLAHDIO_TRACE_ZONE("blahdio::seek");
+		stats::Timer timer{stats::Counter::seek_ns};
+
+		if (!reader_->stream_seek(seek_frame_.load(std::memory_order_relaxed)))
+		{
+			fail("Failed to seek the stream");
+		}
+	}
+
+	// The reading thread stays out of the ring until the seek is done,
+	// so it is safe to empty it here
+	write_pos_.store(read_pos_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	ended_.store(false, std::memory_order_relaxed);
+	seek_done_.store(requested, std::memory_order_release);
+
+	return true;
+}
+
+// Returns true if there was room to decode another chunk
+auto AsyncAudioStreamer::decode_chunk() -> bool
+{
+	if (failed_.load(std::memory_order_relaxed) || ended_.load(std::memory_order_relaxed)) return false;
+
+	const auto write_pos{write_pos_.load(std::memory_order_relaxed)};
+	const auto free_frames{capacity_ - (write_pos - read_pos_.load(std::memory_order_acquire))};
+
+	if (free_frames < options_.chunk_size) return false;
+
+	// Chunks are cut short at the end of the ring so each one can be
+	// decoded straight into it
+	const auto start{write_pos % capacity_};
+	const auto num_frames{std::uint32_t(std::min<std::uint64_t>(options_.chunk_size, capacity_ - start))};
+	const auto frames_read{reader_->stream_read_frames(ring_.data() + (start * frame_bytes_), num_frames)};
+
+	if (!frames_read)
+	{
+		fail(frames_read.error());
+		return false;
+	}
+
+	write_pos_.store(write_pos + *frames_read, std::memory_order_release);
+
+	if (*frames_read < num_frames)
+	{
+		ended_.store(true, std::memory_order_release);
+	}
+
+	return true;
+}
+
+} // impl
+} // blahdio
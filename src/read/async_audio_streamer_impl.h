@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "blahdio/async_audio_streamer.h"
+#include "blahdio/output_format.h"
+#include "counters.h"
+
+namespace blahdio {
+namespace impl {
+
+class AudioReader;
+
+// The decoded frames are kept interleaved in a single producer, single
+// consumer ring. The background thread only ever advances write_pos_
+// and the reading thread only ever advances read_pos_, except while a
+// seek is pending, when the reading thread stays out of the ring and
+// the background thread empties it.
+class AsyncAudioStreamer
+{
+public:
+
+	using Options = blahdio::AsyncAudioStreamer::Options;
+	using ReadResult = blahdio::AsyncAudioStreamer::ReadResult;
+	using Status = blahdio::AsyncAudioStreamer::Status;
+
+	AsyncAudioStreamer(std::shared_ptr<impl::AudioReader> reader, OutputFormat output_format, Options options);
+	~AsyncAudioStreamer();
+
+	auto open() -> void;
+	auto read_frames(void* buffer, std::uint32_t frames_to_read) -> ReadResult;
+	auto read_planar_frames(void* const* channels, std::uint32_t frames_to_read) -> ReadResult;
+	auto seek(std::uint64_t frame) -> void;
+	auto get_error() const -> std::string;
+
+	[[nodiscard]] auto get_counters() -> stats::Counters* { return &counters_; }
+	[[nodiscard]] auto get_stats() const -> Stats { return counters_.get(); }
+
+private:
+
+	template <typename CopyFn>
+	auto read(std::uint32_t frames_to_read, CopyFn copy) -> ReadResult;
+
+	auto fail(std::string error) -> void;
+	auto run() -> void;
+	auto seek_if_requested() -> bool;
+	auto decode_chunk() -> bool;
+
+	std::shared_ptr<impl::AudioReader> reader_;
+	OutputFormat output_format_;
+	Options options_;
+	int num_channels_{};
+	std::size_t frame_bytes_{};
+	std::uint64_t capacity_{};
+	std::vector<std::byte> ring_;
+	std::vector<void*> planar_offsets_;
+
+	// Monotonic frame counts, so write_pos_ - read_pos_ is the number of
+	// frames ready to read
+	std::atomic<std::uint64_t> write_pos_{0};
+	std::atomic<std::uint64_t> read_pos_{0};
+
+	std::atomic<bool> ended_{false};
+	std::atomic<bool> failed_{false};
+	std::string error_;
+
+	std::atomic<std::uint64_t> seek_frame_{0};
+	std::atomic<std::uint32_t> seek_requested_{0};
+	std::atomic<std::uint32_t> seek_done_{0};
+
+	// Shared by the reading thread and the background thread
+	stats::Counters counters_{stats::Kind::reading};
+
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	bool stop_{false};
+	std::thread thread_;
+};
+
+} // impl
+} // blahdio
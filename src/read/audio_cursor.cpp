@@ -0,0 +1,59 @@
+#include "blahdio/audio_cursor.h"
+#include "audio_cursor_impl.h"
+
+namespace blahdio {
+
+AudioCursor::AudioCursor() = default;
+AudioCursor::AudioCursor(AudioCursor&&) noexcept = default;
+auto AudioCursor::operator=(AudioCursor&&) noexcept -> AudioCursor& = default;
+AudioCursor::~AudioCursor() = default;
+
+AudioCursor::AudioCursor(std::unique_ptr<impl::AudioCursor> impl)
+	: impl_{std::move(impl)}
+{
+}
+
+auto AudioCursor::read_frames(void* buffer, std::uint32_t frames_to_read) -> expected<std::uint32_t>
+{
+	if (!impl_)
+	{
+		return tl::make_unexpected("Can't read frames. The cursor is uninitialized.");
+	}
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->read_frames(buffer, frames_to_read);
+}
+
+auto AudioCursor::read_planar_frames(void* const* channels, std::uint32_t frames_to_read) -> expected<std::uint32_t>
+{
+	if (!impl_)
+	{
+		return tl::make_unexpected("Can't read frames. The cursor is uninitialized.");
+	}
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->read_planar_frames(channels, frames_to_read);
+}
+
+auto AudioCursor::seek(std::uint64_t frame) -> expected<void>
+{
+	if (!impl_)
+	{
+		return tl::make_unexpected("Can't seek. The cursor is uninitialized.");
+	}
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->seek(frame);
+}
+
+auto AudioCursor::get_stats() const -> Stats
+{
+	if (!impl_) return {};
+
+	return impl_->get_stats();
+}
+
+}
@@ -0,0 +1,72 @@
+#include "audio_cursor_impl.h"
+#include "audio_reader_impl.h"
+#include "trace.h"
+
+namespace blahdio {
+namespace impl {
+
+AudioCursor::AudioCursor(std::shared_ptr<impl::AudioReader> reader, read::Cursor cursor)
+	: reader_(reader)
+	, cursor_(std::move(cursor))
+{
+	const auto source{reader_->get_cache_source_id()};
+	const auto format{reader_->get_format()};
+
+	if (!source || !format) return;
+
+	const auto read = [this](void* buffer, std::uint32_t frames_to_read) -> expected<std::uint32_t>
+	{
+		return cursor_.reader.read(buffer, frames_to_read);
+	};
+
+	const auto seek = [this](std::uint64_t frame)
+	{
+		return cursor_.seek(frame);
+	};
+
+	cache_.emplace(*source, cursor_.reader.get_format().sample_format, format->num_channels, read, seek);
+}
+
+[[nodiscard]] static
+auto count_frames(expected<std::uint32_t> frames_read) -> expected<std::uint32_t>
+{
+	if (frames_read)
+	{
+		stats::add(stats::Counter::frames, *frames_read);
+	}
+
+	return frames_read;
+}
+
+auto AudioCursor::read_frames(void* buffer, std::uint32_t frames_to_read) -> expected<std::uint32_t>
+{
+	if (cache_) return count_frames(cache_->read(buffer, frames_to_read));
+
+	return count_frames(cursor_.reader.read(buffer, frames_to_read));
+}
+
+auto AudioCursor::read_planar_frames(void* const* channels, std::uint32_t frames_to_read) -> expected<std::uint32_t>
+{
+	if (cache_) return count_frames(cache_->read_planar(channels, frames_to_read));
+
+	return count_frames(cursor_.reader.read_planar(channels, frames_to_read));
+}
+
+auto AudioCursor::seek(std::uint64_t frame) -> expected<void>
+{
+	stats::add(stats::Counter::seeks, 1);
+	BLAHDIO_TRACE_ZONE("blahdio::seek");
+	stats::Timer timer{stats::Counter::seek_ns};
+
+	const auto ok{cache_ ? cache_->seek(frame) : cursor_.seek(frame)};
+
+	if (!ok)
+	{
+		return tl::make_unexpected("Failed to seek cursor (The position is out of range or the decoder failed)");
+	}
+
+	return {};
+}
+
+} // impl
+} // blahdio
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include "blahdio/expected.h"
+#include "cached_stream.h"
+#include "cursor.h"
+#include "counters.h"
+
+namespace blahdio {
+namespace impl {
+
+class AudioReader;
+class AudioCursor
+{
+public:
+
+	AudioCursor(std::shared_ptr<impl::AudioReader> reader, read::Cursor cursor);
+
+	auto read_frames(void* buffer, std::uint32_t frames_to_read) -> expected<std::uint32_t>;
+	auto read_planar_frames(void* const* channels, std::uint32_t frames_to_read) -> expected<std::uint32_t>;
+	auto seek(std::uint64_t frame) -> expected<void>;
+
+	[[nodiscard]] auto get_counters() -> stats::Counters* { return &counters_; }
+	[[nodiscard]] auto get_stats() const -> Stats { return counters_.get(); }
+
+private:
+
+	// Only held to keep the source open (or mapped)
+	std::shared_ptr<impl::AudioReader> reader_;
+
+	read::Cursor cursor_;
+
+	// Only if the block cache was enabled when the cursor was opened
+	std::optional<read::CachedStream> cache_;
+
+	stats::Counters counters_{stats::Kind::reading};
+};
+
+} // impl
+} // blahdio
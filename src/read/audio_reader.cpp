@@ -1,4 +1,5 @@
 #include "audio_reader_impl.h"
+#include "audio_cursor_impl.h"
 #include "blahdio/audio_streamer.h"
 
 namespace blahdio {
@@ -18,14 +19,38 @@ AudioReader::AudioReader(const blahdio::AudioReader::Stream& stream, AudioTypeHi
 {
 }
 
+auto AudioReader::set_session_mode(bool enabled) -> void
+{
+	impl_->set_session_mode(enabled);
+}
+
+auto AudioReader::set_build_seek_index(bool enabled) -> void
+{
+	impl_->set_build_seek_index(enabled);
+}
+
+auto AudioReader::set_zero_copy(bool enabled) -> void
+{
+	impl_->set_zero_copy(enabled);
+}
+
+auto AudioReader::set_decode_threads(int num_threads, bool in_order) -> void
+{
+	impl_->set_decode_threads(num_threads, in_order);
+}
+
 auto AudioReader::read_header() -> expected<AudioDataFormat>
 {
+	stats::Scope stats_scope{impl_->get_counters()};
+
 	return impl_->read_header();
 }
 
-auto AudioReader::read_frames(Callbacks callbacks, uint32_t chunk_size) -> expected<void>
+auto AudioReader::read_frames(Callbacks callbacks, uint32_t chunk_size, OutputFormat output_format) -> expected<void>
 {
-	return impl_->read_frames(callbacks, chunk_size);
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->read_frames(callbacks, chunk_size, output_format);
 }
 
 auto AudioReader::get_format() const -> expected<AudioDataFormat>
@@ -38,9 +63,46 @@ auto AudioReader::get_type() const -> expected<AudioType>
 	return impl_->get_type();
 }
 
-auto AudioReader::streamer() -> AudioStreamer
+auto AudioReader::get_zero_copy() const -> expected<ZeroCopy>
+{
+	return impl_->get_zero_copy();
+}
+
+auto AudioReader::set_seek_index(const std::vector<std::byte>& index) -> expected<void>
+{
+	return impl_->set_seek_index(index);
+}
+
+auto AudioReader::get_seek_index() const -> expected<std::vector<std::byte>>
+{
+	return impl_->get_seek_index();
+}
+
+auto AudioReader::get_stats() const -> Stats
+{
+	return impl_->get_stats();
+}
+
+auto AudioReader::streamer(OutputFormat output_format) -> AudioStreamer
+{
+	return {impl_, output_format};
+}
+
+auto AudioReader::cursor(OutputFormat output_format) -> expected<AudioCursor>
+{
+	auto cursor{impl_->open_cursor(output_format)};
+
+	if (!cursor)
+	{
+		return tl::make_unexpected(cursor.error());
+	}
+
+	return AudioCursor{std::make_unique<impl::AudioCursor>(impl_, std::move(*cursor))};
+}
+
+auto AudioReader::async_streamer(AsyncAudioStreamer::Options options, OutputFormat output_format) -> AsyncAudioStreamer
 {
-	return {impl_};
+	return {impl_, output_format, options};
 }
 
 } // blahdio
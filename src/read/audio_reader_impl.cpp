@@ -1,5 +1,10 @@
 #include "audio_reader_impl.h"
 #include <stdexcept>
+#include "block_cache.h"
+#include "parallel_read.h"
+#include "processed_read.h"
+#include "sniff.h"
+#include "trace.h"
 
 namespace blahdio {
 namespace impl {
@@ -20,7 +25,8 @@ auto AudioReader::make_memory_handler(const void* data, size_t data_size) -> Typ
 }
 
 AudioReader::AudioReader(std::string utf8_path, AudioTypeHint type_hint)
-	: handler_{make_file_handler(std::move(utf8_path))}
+	: handler_{make_file_handler(utf8_path)}
+	, cache_source_{std::move(utf8_path)}
 {
 	hints_.type = type_hint;
 }
@@ -33,6 +39,7 @@ AudioReader::AudioReader(const blahdio::AudioReader::Stream& stream, AudioTypeHi
 
 AudioReader::AudioReader(const void* data, std::size_t data_size, AudioTypeHint type_hint)
 	: handler_{make_memory_handler(data, data_size)}
+	, cache_source_{MemorySource{read::BlockCache::get().make_source_id()}}
 {
 	hints_.type = type_hint;
 }
@@ -52,18 +59,89 @@ auto AudioReader::get_type() const -> expected<AudioType>
 	return handler_.get_type();
 }
 
+auto AudioReader::get_zero_copy() const -> expected<blahdio::AudioReader::ZeroCopy>
+{
+	return handler_.get_zero_copy();
+}
+
+auto AudioReader::set_session_mode(bool enabled) -> void
+{
+	options_.session_mode = enabled;
+}
+
+auto AudioReader::set_build_seek_index(bool enabled) -> void
+{
+	options_.build_seek_index = enabled;
+}
+
+auto AudioReader::set_zero_copy(bool enabled) -> void
+{
+	options_.zero_copy = enabled;
+}
+
+auto AudioReader::set_decode_threads(int num_threads, bool in_order) -> void
+{
+	options_.decode_threads = num_threads;
+	options_.chunks_in_order = in_order;
+}
+
 [[nodiscard]] auto AudioReader::read_header() -> expected<AudioDataFormat>
 {
-	return handler_.read_header(hints_);
+	return handler_.read_header(hints_, options_);
 }
 
-auto AudioReader::read_frames(blahdio::AudioReader::Callbacks callbacks, uint32_t chunk_size) -> expected<void>
+// Times the caller's callbacks and counts the frames handed to them.
+// The wrappers refer to the callbacks passed in, which must outlive
+// them.
+[[nodiscard]] static
+auto make_counted_callbacks(const blahdio::AudioReader::Callbacks& callbacks) -> blahdio::AudioReader::Callbacks
 {
+	auto out{callbacks};
+
+	if (callbacks.should_abort)
+	{
+		out.should_abort = [&callbacks]()
+		{
+			stats::Timer timer{stats::Counter::callback_ns};
+
+			return callbacks.should_abort();
+		};
+	}
+
+	if (callbacks.return_chunk)
+	{
+		out.return_chunk = [&callbacks](const void* data, std::uint64_t first_frame_index, std::uint32_t num_frames)
+		{
+			stats::add(stats::Counter::frames, num_frames);
+			stats::Timer timer{stats::Counter::callback_ns};
+
+			callbacks.return_chunk(data, first_frame_index, num_frames);
+		};
+	}
+
+	if (callbacks.return_planar_chunk)
+	{
+		out.return_planar_chunk = [&callbacks](const void* const* channels, std::uint64_t first_frame_index, std::uint32_t num_frames)
+		{
+			stats::add(stats::Counter::frames, num_frames);
+			stats::Timer timer{stats::Counter::callback_ns};
+
+			callbacks.return_planar_chunk(channels, first_frame_index, num_frames);
+		};
+	}
+
+	return out;
+}
+
+auto AudioReader::read_frames(blahdio::AudioReader::Callbacks client_callbacks, uint32_t chunk_size, OutputFormat output_format) -> expected<void>
+{
+	const auto callbacks{make_counted_callbacks(client_callbacks)};
+
 	const auto read_header_if_not_already_read_yet = [&]() -> expected<void>
 	{
 		if (!handler_.format)
 		{
-			auto result{handler_.read_header(hints_)};
+			auto result{handler_.read_header(hints_, options_)};
 
 			if (!result)
 			{
@@ -76,15 +154,76 @@ auto AudioReader::read_frames(blahdio::AudioReader::Callbacks callbacks, uint32_
 
 	const auto read_frames = [&]() -> expected<void>
 	{
-		return handler_.read_frames(hints_, callbacks, chunk_size);
+		if (!read::needs_processing(output_format, *handler_.format))
+		{
+			return handler_.read_frames(hints_, options_, callbacks, chunk_size, output_format);
+		}
+
+		// The frames have to be processed in order
+		auto options{options_};
+
+		options.chunks_in_order = true;
+
+		const auto read_decoded = [&](blahdio::AudioReader::Callbacks decode_callbacks, uint32_t decode_chunk_size, OutputFormat decode_format)
+		{
+			return handler_.read_frames(hints_, options, decode_callbacks, decode_chunk_size, decode_format);
+		};
+
+		return read::read_frames_processed(read_decoded, callbacks, chunk_size, output_format, *handler_.format);
 	};
 
 	return read_header_if_not_already_read_yet().and_then(read_frames);
 }
 
-auto AudioReader::stream_open() -> expected<AudioDataFormat>
+auto AudioReader::set_seek_index(const std::vector<std::byte>& index) -> expected<void>
 {
-	return handler_.stream_open(hints_);
+	const auto set_index = [this](read::SeekIndex index)
+	{
+		return handler_.set_seek_index(std::move(index));
+	};
+
+	return read::deserialize_seek_index(index).and_then(set_index);
+}
+
+auto AudioReader::get_seek_index() const -> expected<std::vector<std::byte>>
+{
+	const auto serialize = [](const read::SeekIndex& index) -> std::vector<std::byte>
+	{
+		return read::serialize(index);
+	};
+
+	return handler_.get_seek_index().map(serialize);
+}
+
+auto AudioReader::get_cache_source_id() const -> std::optional<std::uint64_t>
+{
+	auto& cache{read::BlockCache::get()};
+
+	if (cache.get_budget() == 0) return std::nullopt;
+
+	struct Visitor
+	{
+		read::BlockCache* cache;
+
+		auto operator()(std::monostate) const -> std::optional<std::uint64_t> { return std::nullopt; }
+		auto operator()(const MemorySource& memory) const -> std::optional<std::uint64_t> { return memory.id; }
+
+		auto operator()(const std::string& utf8_path) const -> std::optional<std::uint64_t>
+		{
+			const auto identity{read::get_file_identity(utf8_path)};
+
+			if (!identity) return std::nullopt;
+
+			return cache->get_source_id(*identity);
+		}
+	};
+
+	return std::visit(Visitor{&cache}, cache_source_);
+}
+
+auto AudioReader::stream_open(OutputFormat output_format) -> expected<AudioDataFormat>
+{
+	return handler_.stream_open(hints_, options_, output_format);
 }
 
 auto AudioReader::stream_close() -> expected<void>
@@ -97,11 +236,26 @@ auto AudioReader::stream_read_frames(void* buffer, uint32_t frames_to_read) -> e
 	return handler_.stream_read_frames(buffer, frames_to_read);
 }
 
-auto AudioReader::stream_seek(uint64_t frame) -> expected<void>
+auto AudioReader::stream_read_planar_frames(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>
+{
+	return handler_.stream_read_planar_frames(channels, frames_to_read);
+}
+
+auto AudioReader::stream_seek(uint64_t frame) -> bool
 {
 	return handler_.stream_seek(frame);
 }
 
+auto AudioReader::stream_reserve(uint32_t max_frames_per_read) -> void
+{
+	handler_.stream_reserve(max_frames_per_read);
+}
+
+auto AudioReader::open_cursor(OutputFormat output_format) -> expected<read::Cursor>
+{
+	return handler_.open_cursor(output_format);
+}
+
 auto AudioReader::TypedHandler::get_type() const -> expected<AudioType>
 {
 	if (!active_handler)
@@ -112,13 +266,52 @@ auto AudioReader::TypedHandler::get_type() const -> expected<AudioType>
 	return active_handler->type();
 }
 
-auto AudioReader::TypedHandler::read_header(Hints hints) -> expected<AudioDataFormat>
+auto AudioReader::TypedHandler::get_zero_copy() const -> expected<blahdio::AudioReader::ZeroCopy>
 {
-	const auto type_handlers_to_try = handlers.make_type_attempt_order(hints.type);
+	if (!active_handler)
+	{
+		return tl::make_unexpected("Failed to get zero copy support (The header has not been read yet)");
+	}
+
+	return active_handler->zero_copy();
+}
+
+#if BLAHDIO_ENABLE_TRACING
+[[nodiscard]] static
+auto get_probe_zone(AudioType type) -> const TraceZone&
+{
+	static constexpr TraceZone FLAC{"blahdio::probe FLAC", __FILE__, __LINE__};
+	static constexpr TraceZone MP3{"blahdio::probe MP3", __FILE__, __LINE__};
+	static constexpr TraceZone WAV{"blahdio::probe WAV", __FILE__, __LINE__};
+	static constexpr TraceZone WAVPACK{"blahdio::probe WavPack", __FILE__, __LINE__};
+	static constexpr TraceZone OTHER{"blahdio::probe", __FILE__, __LINE__};
+
+	switch (type)
+	{
+		case AudioType::flac: return FLAC;
+		case AudioType::mp3: return MP3;
+		case AudioType::wav: return WAV;
+		case AudioType::wavpack: return WAVPACK;
+		default: return OTHER;
+	}
+}
+#endif
+
+auto AudioReader::TypedHandler::read_header(Hints hints, Options options) -> expected<AudioDataFormat>
+{
+	// Looking at the magic bytes is much cheaper than initializing each
+	// decoder in turn until one succeeds (an MP3 decoder will scan the
+	// whole file.) The other types are still tried if the sniffed type
+	// fails to open. If the header was already read then the source
+	// might be in use by a decoder so it is left alone.
+	const auto sniffed_type{active_handler ? active_handler->type() : sniff_type(handlers.raw_source)};
+	const auto type_handlers_to_try = handlers.make_type_attempt_order(hints.type, sniffed_type);
 
 	for (auto type_handler : type_handlers_to_try)
 	{
-		auto result{type_handler->try_read_header()};
+		BLAHDIO_TRACE_ZONE_AT(get_probe_zone(type_handler->type()));
+
+		auto result{type_handler->try_read_header(options.session_mode)};
 
 		if (result)
 		{
@@ -131,23 +324,139 @@ auto AudioReader::TypedHandler::read_header(Hints hints) -> expected<AudioDataFo
 	return tl::make_unexpected("File format not recognized");
 }
 
-auto AudioReader::TypedHandler::read_frames(Hints, blahdio::AudioReader::Callbacks callbacks, uint32_t chunk_size) -> expected<void>
+auto AudioReader::TypedHandler::read_frames(Hints, Options options, blahdio::AudioReader::Callbacks callbacks, uint32_t chunk_size, OutputFormat output_format) -> expected<void>
+{
+	if (options.build_seek_index)
+	{
+		active_handler->build_seek_index();
+	}
+
+	handlers.advise(read::AccessPattern::sequential);
+
+	read::typed::ReadOptions read_options;
+
+	read_options.zero_copy = options.zero_copy;
+	read_options.output_format = output_format;
+
+	if (auto result{try_read_frames_parallel(options, callbacks, chunk_size, output_format)})
+	{
+		return *result;
+	}
+
+	if (format->num_frames_exact)
+	{
+		return active_handler->read_frames(callbacks, *format, chunk_size, read_options);
+	}
+
+	// The handler reads until the end of the data, so we can count the
+	// frames as they go past
+	std::uint64_t num_frames{0};
+	bool aborted{false};
+
+	auto counting_callbacks{callbacks};
+
+	counting_callbacks.should_abort = [&]()
+	{
+		aborted = callbacks.should_abort();
+		return aborted;
+	};
+
+	counting_callbacks.return_chunk = [&](const void* data, std::uint64_t first_frame_index, std::uint32_t chunk_frames)
+	{
+		num_frames = first_frame_index + chunk_frames;
+		callbacks.return_chunk(data, first_frame_index, chunk_frames);
+	};
+
+	counting_callbacks.return_planar_chunk = [&](const void* const* channels, std::uint64_t first_frame_index, std::uint32_t chunk_frames)
+	{
+		num_frames = first_frame_index + chunk_frames;
+		callbacks.return_planar_chunk(channels, first_frame_index, chunk_frames);
+	};
+
+	auto result{active_handler->read_frames(counting_callbacks, *format, chunk_size, read_options)};
+
+	if (result && !aborted)
+	{
+		format->num_frames = num_frames;
+		format->num_frames_exact = true;
+	}
+
+	return result;
+}
+
+auto AudioReader::TypedHandler::try_read_frames_parallel(Options options, blahdio::AudioReader::Callbacks callbacks, uint32_t chunk_size, OutputFormat output_format) -> std::optional<expected<void>>
 {
-	return active_handler->read_frames(callbacks, *format, chunk_size);
+	if (options.decode_threads < 2) return std::nullopt;
+	if (!format->num_frames_exact) return std::nullopt;
+
+	// Nothing to decode
+	if (options.zero_copy && active_handler->zero_copy() != blahdio::AudioReader::ZeroCopy::unavailable) return std::nullopt;
+
+	read::ParallelReadOptions parallel_options;
+
+	parallel_options.in_order = options.chunks_in_order;
+
+	// Not worth starting threads for less than a couple of segments each
+	const auto max_threads{format->num_frames / (parallel_options.segment_size * 2)};
+	const auto num_threads{std::min(std::uint64_t(options.decode_threads), max_threads)};
+
+	if (num_threads < 2) return std::nullopt;
+
+	std::vector<read::Cursor> cursors;
+
+	for (std::uint64_t i = 0; i < num_threads; i++)
+	{
+		auto cursor{active_handler->open_cursor(output_format)};
+
+		if (!cursor) break;
+
+		cursors.push_back(std::move(*cursor));
+	}
+
+	if (cursors.size() < 2) return std::nullopt;
+
+	return read::read_frames_parallel(std::move(cursors), callbacks, format->num_frames, format->num_channels, chunk_size, parallel_options);
 }
 
-auto AudioReader::TypedHandler::stream_open(Hints hints) -> expected<AudioDataFormat>
+auto AudioReader::TypedHandler::stream_open(Hints hints, Options options, OutputFormat output_format) -> expected<AudioDataFormat>
 {
+	handlers.advise(read::AccessPattern::random);
+
+	const auto build_seek_index = [options](read::typed::Handler* type_handler)
+	{
+		if (options.build_seek_index)
+		{
+			type_handler->build_seek_index();
+		}
+	};
+
+	if (active_handler)
+	{
+		// The header was already read so we know which type to open (and
+		// the handler might be holding on to the decoder it opened.)
+		auto open_result{active_handler->stream_open(output_format)};
+
+		if (!open_result)
+		{
+			return tl::make_unexpected(open_result.error());
+		}
+
+		format = *open_result;
+		build_seek_index(active_handler);
+		return *format;
+	}
+
 	const auto type_handlers_to_try{handlers.make_type_attempt_order(hints.type)};
 
 	for (auto type_handler : type_handlers_to_try)
 	{
-		auto open_result{type_handler->stream_open()};
+		auto open_result{type_handler->stream_open(output_format)};
 
 		if (open_result)
 		{
 			active_handler = type_handler;
 			format = *open_result;
+			build_seek_index(active_handler);
 			return *format;
 		}
 	}
@@ -165,10 +474,73 @@ auto AudioReader::TypedHandler::stream_read_frames(void* buffer, uint32_t frames
 	return active_handler->stream_read(buffer, frames_to_read);
 }
 
-auto AudioReader::TypedHandler::stream_seek(uint64_t frame) -> expected<void>
+auto AudioReader::TypedHandler::stream_read_planar_frames(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>
+{
+	return active_handler->stream_read_planar(channels, frames_to_read);
+}
+
+auto AudioReader::TypedHandler::stream_seek(uint64_t frame) -> bool
 {
 	return active_handler->stream_seek(frame);
 }
 
+auto AudioReader::TypedHandler::stream_reserve(uint32_t max_frames_per_read) -> void
+{
+	active_handler->stream_reserve(max_frames_per_read);
+}
+
+auto AudioReader::TypedHandler::open_cursor(OutputFormat output_format) -> expected<read::Cursor>
+{
+	if (!active_handler)
+	{
+		return tl::make_unexpected("Failed to open cursor (The header has not been read yet)");
+	}
+
+	return active_handler->open_cursor(output_format);
+}
+
+auto AudioReader::TypedHandler::set_seek_index(read::SeekIndex index) -> expected<void>
+{
+	const auto type_handler{handlers.find(index.type)};
+
+	if (!type_handler)
+	{
+		return tl::make_unexpected("Failed to set seek index (The audio type is not supported)");
+	}
+
+	if (active_handler && active_handler != type_handler)
+	{
+		return tl::make_unexpected("Failed to set seek index (It is for a different audio type)");
+	}
+
+	const auto source_size{handlers.raw_source ? handlers.raw_source.size() : std::nullopt};
+
+	if (index.source_size > 0 && source_size && *source_size != index.source_size)
+	{
+		return tl::make_unexpected("Failed to set seek index (It was built from a different source)");
+	}
+
+	return type_handler->set_seek_index(std::move(index));
+}
+
+auto AudioReader::TypedHandler::get_seek_index() const -> expected<read::SeekIndex>
+{
+	if (!active_handler)
+	{
+		return tl::make_unexpected("Failed to get seek index (The header has not been read yet)");
+	}
+
+	auto index{active_handler->get_seek_index()};
+
+	if (index)
+	{
+		const auto source_size{handlers.raw_source ? handlers.raw_source.size() : std::nullopt};
+
+		index->source_size = source_size.value_or(0);
+	}
+
+	return index;
+}
+
 } // impl
 } // blahdio
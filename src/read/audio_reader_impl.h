@@ -3,6 +3,7 @@
 #include <optional>
 #include <variant>
 #include <tl/expected.hpp>
+#include "counters.h"
 #include "typed_read_handler.h"
 
 namespace blahdio {
@@ -16,15 +17,34 @@ public:
 	AudioReader(const blahdio::AudioReader::Stream& stream, AudioTypeHint type_hint);
 	AudioReader(const void* data, std::size_t data_size, AudioTypeHint type_hint);
 
+	auto set_session_mode(bool enabled) -> void;
+	auto set_build_seek_index(bool enabled) -> void;
+	auto set_zero_copy(bool enabled) -> void;
+	auto set_decode_threads(int num_threads, bool in_order) -> void;
+
 	[[nodiscard]] auto read_header() -> expected<AudioDataFormat>;
-	[[nodiscard]] auto read_frames(blahdio::AudioReader::Callbacks callbacks, uint32_t chunk_size) -> expected<void>;
-	[[nodiscard]] auto stream_open() -> expected<AudioDataFormat>;
+	[[nodiscard]] auto read_frames(blahdio::AudioReader::Callbacks callbacks, uint32_t chunk_size, OutputFormat output_format) -> expected<void>;
+	[[nodiscard]] auto stream_open(OutputFormat output_format) -> expected<AudioDataFormat>;
 	[[nodiscard]] auto stream_close() -> expected<void>;
 	[[nodiscard]] auto stream_read_frames(void* buffer, uint32_t frames_to_read) -> expected<uint32_t>;
-	[[nodiscard]] auto stream_seek(uint64_t frame) -> expected<void>;
+	[[nodiscard]] auto stream_read_planar_frames(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>;
+	[[nodiscard]] auto stream_seek(uint64_t frame) -> bool;
+	auto stream_reserve(uint32_t max_frames_per_read) -> void;
+	[[nodiscard]] auto open_cursor(OutputFormat output_format) -> expected<read::Cursor>;
 
 	auto get_format() const -> expected<AudioDataFormat>;
 	auto get_type() const -> expected<AudioType>;
+	auto get_zero_copy() const -> expected<blahdio::AudioReader::ZeroCopy>;
+	auto set_seek_index(const std::vector<std::byte>& index) -> expected<void>;
+	auto get_seek_index() const -> expected<std::vector<std::byte>>;
+
+	// Null if the block cache is disabled or the source can't be cached
+	[[nodiscard]] auto get_cache_source_id() const -> std::optional<std::uint64_t>;
+
+	// Only for the reader's own calls. Streamers and cursors have their
+	// own.
+	[[nodiscard]] auto get_counters() -> stats::Counters* { return &counters_; }
+	[[nodiscard]] auto get_stats() const -> Stats { return counters_.get(); }
 
 private:
 
@@ -33,6 +53,15 @@ private:
 		AudioTypeHint type;
 	};
 
+	struct Options
+	{
+		bool session_mode{false};
+		bool build_seek_index{false};
+		bool zero_copy{false};
+		int decode_threads{1};
+		bool chunks_in_order{true};
+	};
+
 	struct TypedHandler
 	{
 		read::typed::Handlers handlers;
@@ -40,16 +69,39 @@ private:
 		std::optional<AudioDataFormat> format{};
 
 		[[nodiscard]] auto get_type() const -> expected<AudioType>;
-		[[nodiscard]] auto read_header(Hints hints) -> expected<AudioDataFormat>;
-		[[nodiscard]] auto read_frames(Hints hints, blahdio::AudioReader::Callbacks callbacks, uint32_t chunk_size) -> expected<void>;
-		[[nodiscard]] auto stream_open(Hints hints) -> expected<AudioDataFormat>;
+		[[nodiscard]] auto get_zero_copy() const -> expected<blahdio::AudioReader::ZeroCopy>;
+		[[nodiscard]] auto read_header(Hints hints, Options options) -> expected<AudioDataFormat>;
+		[[nodiscard]] auto read_frames(Hints hints, Options options, blahdio::AudioReader::Callbacks callbacks, uint32_t chunk_size, OutputFormat output_format) -> expected<void>;
+		[[nodiscard]] auto stream_open(Hints hints, Options options, OutputFormat output_format) -> expected<AudioDataFormat>;
 		[[nodiscard]] auto stream_close() -> expected<void>;
 		[[nodiscard]] auto stream_read_frames(void* buffer, uint32_t frames_to_read) -> expected<uint32_t>;
-		[[nodiscard]] auto stream_seek(uint64_t frame) -> expected<void>;
+		[[nodiscard]] auto stream_read_planar_frames(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>;
+		[[nodiscard]] auto stream_seek(uint64_t frame) -> bool;
+		auto stream_reserve(uint32_t max_frames_per_read) -> void;
+		[[nodiscard]] auto open_cursor(OutputFormat output_format) -> expected<read::Cursor>;
+		[[nodiscard]] auto set_seek_index(read::SeekIndex index) -> expected<void>;
+		[[nodiscard]] auto get_seek_index() const -> expected<read::SeekIndex>;
+
+		// Returns nothing if the frames can't be read in parallel, in
+		// which case nothing was read
+		[[nodiscard]] auto try_read_frames_parallel(Options options, blahdio::AudioReader::Callbacks callbacks, uint32_t chunk_size, OutputFormat output_format) -> std::optional<expected<void>>;
 	};
 
+	// Memory can be freed and its address reused for another source, so
+	// each reader of memory gets an id of its own instead
+	struct MemorySource
+	{
+		std::uint64_t id;
+	};
+
+	// What the block cache knows the source by. Streams are never cached.
+	using CacheSource = std::variant<std::monostate, std::string, MemorySource>;
+
 	Hints hints_;
+	Options options_;
 	TypedHandler handler_;
+	CacheSource cache_source_;
+	stats::Counters counters_{stats::Kind::reading};
 
 	[[nodiscard]] static
 	auto make_file_handler(std::string utf8_path) -> TypedHandler;
@@ -7,9 +7,11 @@ AudioStreamer::AudioStreamer() = default;
 AudioStreamer::AudioStreamer(AudioStreamer&&) noexcept = default;
 auto AudioStreamer::operator=(AudioStreamer&&) noexcept -> AudioStreamer& = default;
 
-AudioStreamer::AudioStreamer(std::shared_ptr<impl::AudioReader> reader)
-	: impl_{std::make_unique<impl::AudioStreamer>(reader)}
+AudioStreamer::AudioStreamer(std::shared_ptr<impl::AudioReader> reader, OutputFormat output_format)
+	: impl_{std::make_unique<impl::AudioStreamer>(reader, output_format)}
 {
+	stats::Scope stats_scope{impl_->get_counters()};
+
 	impl_->open();
 }
 
@@ -28,9 +30,23 @@ auto AudioStreamer::read_frames(void* buffer, uint32_t frames_to_read) -> expect
 		return tl::make_unexpected("Can't read frames. The streamer is uninitialized.");
 	}
 
+	stats::Scope stats_scope{impl_->get_counters()};
+
 	return impl_->read_frames(buffer, frames_to_read);
 }
 
+auto AudioStreamer::read_planar_frames(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>
+{
+	if (!impl_)
+	{
+		return tl::make_unexpected("Can't read frames. The streamer is uninitialized.");
+	}
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->read_planar_frames(channels, frames_to_read);
+}
+
 auto AudioStreamer::seek(uint64_t frame) -> expected<void>
 {
 	if (!impl_)
@@ -38,7 +54,68 @@ auto AudioStreamer::seek(uint64_t frame) -> expected<void>
 		return tl::make_unexpected("Can't seek. The streamer is uninitialized.");
 	}
 
+	stats::Scope stats_scope{impl_->get_counters()};
+
 	return impl_->seek(frame);
 }
 
+auto AudioStreamer::reserve(uint32_t max_frames_per_read) -> expected<void>
+{
+	if (!impl_)
+	{
+		return tl::make_unexpected("Can't reserve. The streamer is uninitialized.");
+	}
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->reserve(max_frames_per_read);
+}
+
+auto AudioStreamer::read_frames_realtime(void* buffer, uint32_t frames_to_read) noexcept -> RealtimeResult
+{
+	if (!impl_) return { 0, Error::uninitialized };
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->read_frames_realtime(buffer, frames_to_read);
+}
+
+auto AudioStreamer::read_planar_frames_realtime(void* const* channels, uint32_t frames_to_read) noexcept -> RealtimeResult
+{
+	if (!impl_) return { 0, Error::uninitialized };
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->read_planar_frames_realtime(channels, frames_to_read);
+}
+
+auto AudioStreamer::seek_realtime(uint64_t frame) noexcept -> Error
+{
+	if (!impl_) return Error::uninitialized;
+
+	stats::Scope stats_scope{impl_->get_counters()};
+
+	return impl_->seek_realtime(frame);
+}
+
+auto AudioStreamer::get_stats() const -> Stats
+{
+	if (!impl_) return {};
+
+	return impl_->get_stats();
+}
+
+auto AudioStreamer::get_error_message(Error error) noexcept -> const char*
+{
+	switch (error)
+	{
+		case Error::none: return "No error";
+		case Error::uninitialized: return "The streamer is uninitialized";
+		case Error::not_open: return "The stream is not open";
+		case Error::too_many_frames: return "More frames were requested than were reserved";
+		case Error::seek_failed: return "Failed to seek the stream";
+		default: return "Unknown error";
+	}
+}
+
 }
\ No newline at end of file
@@ -1,33 +1,238 @@
 #include "audio_streamer_impl.h"
 #include "audio_reader_impl.h"
+#include "trace.h"
 
 namespace blahdio {
 namespace impl {
 
-AudioStreamer::AudioStreamer(std::shared_ptr<impl::AudioReader> reader)
+AudioStreamer::AudioStreamer(std::shared_ptr<impl::AudioReader> reader, OutputFormat output_format)
 	: reader_(reader)
+	, output_format_(output_format)
 {
 }
 
+[[nodiscard]] static
+auto count_frames(expected<uint32_t> frames_read) -> expected<uint32_t>
+{
+	if (frames_read)
+	{
+		stats::add(stats::Counter::frames, *frames_read);
+	}
+
+	return frames_read;
+}
+
 auto AudioStreamer::read_frames(void* buffer, uint32_t frames_to_read) -> expected<uint32_t>
 {
+	if (processor_) return count_frames(processor_->read(buffer, frames_to_read));
+
+	return count_frames(read_decoded_frames(buffer, frames_to_read));
+}
+
+auto AudioStreamer::read_planar_frames(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>
+{
+	if (processor_) return count_frames(processor_->read_planar(channels, frames_to_read));
+	if (cache_) return count_frames(cache_->read_planar(channels, frames_to_read));
+
+	return count_frames(reader_->stream_read_planar_frames(channels, frames_to_read));
+}
+
+auto AudioStreamer::read_decoded_frames(void* buffer, uint32_t frames_to_read) -> expected<uint32_t>
+{
+	if (cache_) return cache_->read(buffer, frames_to_read);
+
 	return reader_->stream_read_frames(buffer, frames_to_read);
 }
 
-auto AudioStreamer::seek(uint64_t frame) -> expected<void>
+auto AudioStreamer::seek_stream(uint64_t frame) -> bool
+{
+	stats::add(stats::Counter::seeks, 1);
+	BLAHDIO_TRACE_ZONE("blahdio::seek");
+	stats::Timer timer{stats::Counter::seek_ns};
+
+	if (processor_) return processor_->seek(frame);
+
+	return seek_decoder(frame);
+}
+
+auto AudioStreamer::seek_decoder(uint64_t frame) -> bool
 {
+	if (cache_) return cache_->seek(frame);
+
 	return reader_->stream_seek(frame);
 }
 
+auto AudioStreamer::seek(uint64_t frame) -> expected<void>
+{
+	if (!open_)
+	{
+		return tl::make_unexpected(blahdio::AudioStreamer::get_error_message(Error::not_open));
+	}
+
+	if (!seek_stream(frame))
+	{
+		return tl::make_unexpected(blahdio::AudioStreamer::get_error_message(Error::seek_failed));
+	}
+
+	return {};
+}
+
 auto AudioStreamer::open() -> expected<AudioDataFormat>
 {
-	return reader_->stream_open();
+	// If the header hasn't been read yet the source's format isn't known,
+	// so the decoder produces float frames for processing either way
+	const auto format{reader_->get_format()};
+	const auto process{output_format_.sample_rate > 0 || output_format_.num_channels > 0 || !output_format_.channel_mix.empty()};
+	const auto decode{process && !(format && !read::needs_processing(output_format_, *format))};
+	const auto decode_format{decode ? read::get_processing_decode_format() : output_format_};
+
+	auto result{reader_->stream_open(decode_format)};
+
+	if (!result)
+	{
+		return result;
+	}
+
+	enable_cache(result->num_channels, decode_format.sample_format);
+
+	// Even if it turns out nothing needs doing to the frames, they still
+	// have to be converted from float
+	if (decode)
+	{
+		if (const auto enabled{enable_processor(*result)}; !enabled)
+		{
+			cache_.reset();
+			(void)(reader_->stream_close());
+			return tl::make_unexpected(enabled.error());
+		}
+	}
+
+	open_ = true;
+
+	return result;
 }
 
 auto AudioStreamer::close() -> expected<void>
 {
+	open_ = false;
+	processor_.reset();
+	cache_.reset();
+
 	return reader_->stream_close();
 }
 
+auto AudioStreamer::reserve(uint32_t max_frames_per_read) -> expected<void>
+{
+	if (!open_)
+	{
+		return tl::make_unexpected(blahdio::AudioStreamer::get_error_message(Error::not_open));
+	}
+
+	if (cache_)
+	{
+		const auto synced{cache_->sync_decoder()};
+
+		cache_.reset();
+
+		if (!synced)
+		{
+			return tl::make_unexpected(blahdio::AudioStreamer::get_error_message(Error::seek_failed));
+		}
+	}
+
+	if (processor_)
+	{
+		processor_->reserve(max_frames_per_read);
+	}
+
+	reader_->stream_reserve(max_frames_per_read);
+	max_realtime_frames_ = max_frames_per_read;
+
+	return {};
+}
+
+auto AudioStreamer::enable_cache(int num_channels, SampleFormat sample_format) -> void
+{
+	const auto source{reader_->get_cache_source_id()};
+
+	if (!source) return;
+
+	const auto read = [this](void* buffer, uint32_t frames_to_read)
+	{
+		return reader_->stream_read_frames(buffer, frames_to_read);
+	};
+
+	const auto seek = [this](uint64_t frame)
+	{
+		return reader_->stream_seek(frame);
+	};
+
+	cache_.emplace(*source, sample_format, num_channels, read, seek);
+}
+
+auto AudioStreamer::enable_processor(const AudioDataFormat& format) -> expected<void>
+{
+	auto processor{read::Processor::make(output_format_, format)};
+
+	if (!processor)
+	{
+		return tl::make_unexpected(processor.error());
+	}
+
+	const auto read = [this](void* buffer, uint32_t frames_to_read)
+	{
+		return read_decoded_frames(buffer, frames_to_read);
+	};
+
+	const auto seek = [this](uint64_t frame)
+	{
+		return seek_decoder(frame);
+	};
+
+	processor_.emplace(std::move(*processor), output_format_.sample_format, read, seek);
+
+	return {};
+}
+
+auto AudioStreamer::check_realtime_read(uint32_t frames_to_read) const noexcept -> Error
+{
+	if (!open_ || max_realtime_frames_ == 0) return Error::not_open;
+	if (frames_to_read > max_realtime_frames_) return Error::too_many_frames;
+
+	return Error::none;
+}
+
+// The streams can only fail to read when they aren't open, which is
+// checked first, so the expected's error string is never built here
+auto AudioStreamer::read_frames_realtime(void* buffer, uint32_t frames_to_read) noexcept -> RealtimeResult
+{
+	if (const auto error{check_realtime_read(frames_to_read)}; error != Error::none)
+	{
+		return { 0, error };
+	}
+
+	return { *read_frames(buffer, frames_to_read), Error::none };
+}
+
+auto AudioStreamer::read_planar_frames_realtime(void* const* channels, uint32_t frames_to_read) noexcept -> RealtimeResult
+{
+	if (const auto error{check_realtime_read(frames_to_read)}; error != Error::none)
+	{
+		return { 0, error };
+	}
+
+	return { *read_planar_frames(channels, frames_to_read), Error::none };
+}
+
+auto AudioStreamer::seek_realtime(uint64_t frame) noexcept -> Error
+{
+	if (const auto error{check_realtime_read(0)}; error != Error::none)
+	{
+		return error;
+	}
+
+	return seek_stream(frame) ? Error::none : Error::seek_failed;
+}
+
 } // impl
 } // blahdio
@@ -2,8 +2,14 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include "blahdio/audio_data_format.h"
+#include "blahdio/audio_streamer.h"
 #include "blahdio/expected.h"
+#include "blahdio/output_format.h"
+#include "cached_stream.h"
+#include "processed_read.h"
+#include "counters.h"
 
 namespace blahdio {
 namespace impl {
@@ -13,16 +19,47 @@ class AudioStreamer
 {
 public:
 
-	AudioStreamer(std::shared_ptr<impl::AudioReader> reader);
+	using Error = blahdio::AudioStreamer::Error;
+	using RealtimeResult = blahdio::AudioStreamer::RealtimeResult;
+
+	AudioStreamer(std::shared_ptr<impl::AudioReader> reader, OutputFormat output_format);
 
 	auto read_frames(void* buffer, uint32_t frames_to_read) -> expected<uint32_t>;
+	auto read_planar_frames(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>;
 	auto seek(uint64_t frame) -> expected<void>;
 	auto open() -> expected<AudioDataFormat>;
 	auto close() -> expected<void>;
 
+	auto reserve(uint32_t max_frames_per_read) -> expected<void>;
+	auto read_frames_realtime(void* buffer, uint32_t frames_to_read) noexcept -> RealtimeResult;
+	auto read_planar_frames_realtime(void* const* channels, uint32_t frames_to_read) noexcept -> RealtimeResult;
+	auto seek_realtime(uint64_t frame) noexcept -> Error;
+
+	[[nodiscard]] auto get_counters() -> stats::Counters* { return &counters_; }
+	[[nodiscard]] auto get_stats() const -> Stats { return counters_.get(); }
+
 private:
 
+	auto read_decoded_frames(void* buffer, uint32_t frames_to_read) -> expected<uint32_t>;
+	auto seek_stream(uint64_t frame) -> bool;
+	auto seek_decoder(uint64_t frame) -> bool;
+	auto enable_cache(int num_channels, SampleFormat sample_format) -> void;
+	auto enable_processor(const AudioDataFormat& format) -> expected<void>;
+	auto check_realtime_read(uint32_t frames_to_read) const noexcept -> Error;
+
 	std::shared_ptr<impl::AudioReader> reader_;
+	OutputFormat output_format_;
+	bool open_{false};
+	uint32_t max_realtime_frames_{0};
+	stats::Counters counters_{stats::Kind::reading};
+
+	// Only if the block cache was enabled when the stream was opened.
+	// Dropped by reserve() since the realtime reads can't use it.
+	std::optional<read::CachedStream> cache_;
+
+	// Only if the output format has a sample rate or channels other than
+	// the source's. Reads from the cache, if there is one, or the decoder.
+	std::optional<read::ProcessedStream> processor_;
 };
 
 } // impl
@@ -0,0 +1,167 @@
+#include "blahdio/batch_reader.h"
+#include <condition_variable>
+#include <mutex>
+#include "audio_reader_impl.h"
+#include "thread_pool.h"
+
+namespace blahdio {
+
+namespace impl {
+
+class BatchReader
+{
+public:
+
+	BatchReader(int num_threads) : pool_{num_threads} {}
+
+	auto read(const std::vector<blahdio::BatchReader::Item>& items, blahdio::BatchReader::Callbacks callbacks, std::uint32_t chunk_size, OutputFormat output_format) -> std::vector<expected<AudioDataFormat>>;
+
+private:
+
+	ThreadPool pool_;
+};
+
+[[nodiscard]] static
+auto make_reader(const blahdio::BatchReader::Item& item) -> std::unique_ptr<AudioReader>
+{
+	struct Visitor
+	{
+		AudioTypeHint type_hint;
+
+		auto operator()(const std::string& utf8_path) const { return std::make_unique<AudioReader>(utf8_path, type_hint); }
+		auto operator()(const blahdio::BatchReader::Memory& memory) const { return std::make_unique<AudioReader>(memory.data, memory.size, type_hint); }
+		auto operator()(const blahdio::AudioReader::Stream* stream) const { return std::make_unique<AudioReader>(*stream, type_hint); }
+	};
+
+	return std::visit(Visitor{item.type_hint}, item.source);
+}
+
+[[nodiscard]] static
+auto read_item(std::size_t index, const blahdio::BatchReader::Item& item, const blahdio::BatchReader::Callbacks& callbacks, std::uint32_t chunk_size, OutputFormat output_format) -> expected<AudioDataFormat>
+{
+	bool aborted{false};
+
+	const auto should_abort = [&]()
+	{
+		aborted = aborted || (callbacks.should_abort && callbacks.should_abort());
+		return aborted;
+	};
+
+	if (should_abort())
+	{
+		return tl::make_unexpected("Aborted");
+	}
+
+	// The header is read in session mode so the decoder which found the
+	// type goes on to read the frames
+	auto reader{make_reader(item)};
+	stats::Scope stats_scope{reader->get_counters()};
+
+	reader->set_session_mode(true);
+
+	const auto header{reader->read_header()};
+
+	if (!header)
+	{
+		return header;
+	}
+
+	if (callbacks.header)
+	{
+		callbacks.header(index, *header);
+	}
+
+	blahdio::AudioReader::Callbacks item_callbacks;
+
+	item_callbacks.should_abort = should_abort;
+
+	if (output_format.planar)
+	{
+		item_callbacks.return_planar_chunk = [&](const void* const* channels, std::uint64_t first_frame_index, std::uint32_t num_frames)
+		{
+			callbacks.return_planar_chunk(index, channels, first_frame_index, num_frames);
+		};
+	}
+	else
+	{
+		item_callbacks.return_chunk = [&](const void* data, std::uint64_t first_frame_index, std::uint32_t num_frames)
+		{
+			callbacks.return_chunk(index, data, first_frame_index, num_frames);
+		};
+	}
+
+	const auto result{reader->read_frames(item_callbacks, chunk_size, output_format)};
+
+	if (!result)
+	{
+		return tl::make_unexpected(result.error());
+	}
+
+	if (aborted)
+	{
+		return tl::make_unexpected("Aborted");
+	}
+
+	// The number of frames might only be known now that they have all
+	// been read
+	return reader->get_format();
+}
+
+auto BatchReader::read(const std::vector<blahdio::BatchReader::Item>& items, blahdio::BatchReader::Callbacks callbacks, std::uint32_t chunk_size, OutputFormat output_format) -> std::vector<expected<AudioDataFormat>>
+{
+	std::vector<expected<AudioDataFormat>> results(items.size(), tl::make_unexpected(std::string{"Not read"}));
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::size_t num_remaining{items.size()};
+
+	std::vector<ThreadPool::Task> tasks;
+
+	tasks.reserve(items.size());
+
+	for (std::size_t i = 0; i < items.size(); i++)
+	{
+		tasks.push_back([&, i]()
+		{
+			try
+			{
+				results[i] = read_item(i, items[i], callbacks, chunk_size, output_format);
+			}
+			catch (const std::exception& err)
+			{
+				results[i] = tl::make_unexpected(std::string{err.what()});
+			}
+
+			std::lock_guard lock{mutex};
+
+			if (--num_remaining == 0)
+			{
+				cv.notify_one();
+			}
+		});
+	}
+
+	pool_.submit(std::move(tasks));
+
+	std::unique_lock lock{mutex};
+
+	cv.wait(lock, [&]() { return num_remaining == 0; });
+
+	return results;
+}
+
+} // impl
+
+BatchReader::BatchReader(int num_threads)
+	: impl_{std::make_unique<impl::BatchReader>(num_threads)}
+{
+}
+
+BatchReader::~BatchReader() = default;
+
+auto BatchReader::read(const std::vector<Item>& items, Callbacks callbacks, std::uint32_t chunk_size, OutputFormat output_format) -> std::vector<expected<AudioDataFormat>>
+{
+	return impl_->read(items, callbacks, chunk_size, output_format);
+}
+
+}
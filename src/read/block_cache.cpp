@@ -0,0 +1,203 @@
+#include "block_cache.h"
+#include <filesystem>
+#include <format>
+#include <utf8.h>
+
+namespace blahdio {
+namespace read {
+
+auto BlockCache::get() -> BlockCache&
+{
+	static BlockCache cache;
+
+	return cache;
+}
+
+auto BlockCache::KeyHash::operator()(const Key& key) const -> std::size_t
+{
+	auto hash{std::hash<std::uint64_t>{}(key.source)};
+
+	hash ^= std::hash<std::uint64_t>{}(key.block) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+	hash ^= std::hash<int>{}(int(key.format)) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+
+	return hash;
+}
+
+auto BlockCache::get_stripe(const Key& key) -> Stripe&
+{
+	// Neighbouring blocks of one source go to different stripes, so a
+	// single busy source doesn't all land on one lock
+	return stripes_[(key.source * 31 + key.block) % NUM_STRIPES];
+}
+
+auto BlockCache::set_budget(std::size_t bytes) -> void
+{
+	budget_ = bytes;
+
+	for (auto& stripe : stripes_)
+	{
+		std::lock_guard lock{stripe.mutex};
+
+		evict(&stripe, bytes / NUM_STRIPES);
+	}
+
+	if (bytes == 0) clear_sources();
+}
+
+auto BlockCache::clear() -> void
+{
+	for (auto& stripe : stripes_)
+	{
+		std::lock_guard lock{stripe.mutex};
+
+		evict(&stripe, 0);
+	}
+
+	clear_sources();
+}
+
+auto BlockCache::clear_sources() -> void
+{
+	std::lock_guard lock{sources_mutex_};
+
+	sources_.clear();
+}
+
+auto BlockCache::get_stats() const -> BlockCacheStats
+{
+	BlockCacheStats out;
+
+	out.hits = hits_;
+	out.misses = misses_;
+
+	for (auto& stripe : stripes_)
+	{
+		std::lock_guard lock{stripe.mutex};
+
+		out.bytes_used += stripe.bytes_used;
+	}
+
+	return out;
+}
+
+auto BlockCache::get_source_id(const std::string& identity) -> std::uint64_t
+{
+	std::lock_guard lock{sources_mutex_};
+
+	const auto pos{sources_.find(identity)};
+
+	if (pos != sources_.end()) return pos->second;
+
+	// Ids are never reused, so a streamer still holding one from before
+	// this can't be handed another source's blocks
+	if (sources_.size() >= MAX_SOURCES) sources_.clear();
+
+	const auto id{make_source_id()};
+
+	sources_.emplace(identity, id);
+
+	return id;
+}
+
+auto BlockCache::find(const Key& key) -> Block
+{
+	auto& stripe{get_stripe(key)};
+
+	std::lock_guard lock{stripe.mutex};
+
+	const auto pos{stripe.index.find(key)};
+
+	if (pos == stripe.index.end())
+	{
+		misses_++;
+		return nullptr;
+	}
+
+	hits_++;
+
+	stripe.entries.splice(stripe.entries.begin(), stripe.entries, pos->second);
+
+	return pos->second->block;
+}
+
+auto BlockCache::insert(const Key& key, Block block) -> void
+{
+	const auto stripe_budget{budget_ / NUM_STRIPES};
+
+	// Would be evicted straight away
+	if (block->size() > stripe_budget) return;
+
+	auto& stripe{get_stripe(key)};
+
+	std::lock_guard lock{stripe.mutex};
+
+	// Another reader might have decoded the same block at the same time
+	if (stripe.index.contains(key)) return;
+
+	stripe.bytes_used += block->size();
+	stripe.entries.push_front({key, std::move(block)});
+	stripe.index[key] = stripe.entries.begin();
+
+	evict(&stripe, stripe_budget);
+}
+
+auto BlockCache::evict(Stripe* stripe, std::size_t stripe_budget) -> void
+{
+	while (stripe->bytes_used > stripe_budget && !stripe->entries.empty())
+	{
+		const auto& entry{stripe->entries.back()};
+
+		stripe->bytes_used -= entry.block->size();
+		stripe->index.erase(entry.key);
+		stripe->entries.pop_back();
+	}
+}
+
+auto get_file_identity(const std::string& utf8_path) -> std::optional<std::string>
+{
+#ifdef _WIN32
+	const auto path{std::filesystem::path((const wchar_t*)(utf8::utf8to16(utf8_path).c_str()))};
+#else
+	const auto path{std::filesystem::path(utf8_path)};
+#endif
+
+	std::error_code err;
+
+	const auto canonical_path{std::filesystem::weakly_canonical(path, err)};
+
+	if (err) return std::nullopt;
+
+	const auto size{std::filesystem::file_size(canonical_path, err)};
+
+	if (err) return std::nullopt;
+
+	const auto modified{std::filesystem::last_write_time(canonical_path, err)};
+
+	if (err) return std::nullopt;
+
+	return std::format("file:{}:{}:{}", canonical_path.string(), size, modified.time_since_epoch().count());
+}
+
+} // read
+
+auto set_block_cache_budget(std::size_t bytes) -> void
+{
+	read::BlockCache::get().set_budget(bytes);
+}
+
+auto get_block_cache_budget() -> std::size_t
+{
+	return read::BlockCache::get().get_budget();
+}
+
+auto get_block_cache_stats() -> BlockCacheStats
+{
+	return read::BlockCache::get().get_stats();
+}
+
+auto clear_block_cache() -> void
+{
+	read::BlockCache::get().clear();
+}
+
+} // blahdio
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "blahdio/block_cache.h"
+#include "blahdio/output_format.h"
+
+namespace blahdio {
+namespace read {
+
+// Process-wide cache of decoded blocks. Lookups are spread over several
+// independently locked stripes so that readers on different threads
+// rarely wait for each other. Each stripe evicts its own least recently
+// used blocks once it is over its share of the budget.
+class BlockCache
+{
+public:
+
+	// Interleaved frames in the key's sample format. A block shorter than
+	// BLOCK_FRAMES is the end of the source.
+	using Block = std::shared_ptr<const std::vector<std::byte>>;
+
+	static constexpr std::uint32_t BLOCK_FRAMES = 8192;
+
+	struct Key
+	{
+		std::uint64_t source;
+		SampleFormat format;
+		std::uint64_t block;
+
+		auto operator==(const Key& rhs) const -> bool = default;
+	};
+
+	[[nodiscard]] static auto get() -> BlockCache&;
+
+	auto set_budget(std::size_t bytes) -> void;
+	auto clear() -> void;
+
+	[[nodiscard]] auto get_budget() const -> std::size_t { return budget_; }
+	[[nodiscard]] auto get_stats() const -> BlockCacheStats;
+
+	// The same identity gets the same id until the cache is cleared or
+	// disabled, or it has seen MAX_SOURCES identities since then. After
+	// that it gets a new one, so blocks cached for the old id are just
+	// never found again.
+	[[nodiscard]] auto get_source_id(const std::string& identity) -> std::uint64_t;
+
+	// An id no other source has, for sources with no identity of their own
+	[[nodiscard]] auto make_source_id() -> std::uint64_t { return next_source_id_++; }
+
+	// Returns null if the block isn't cached
+	[[nodiscard]] auto find(const Key& key) -> Block;
+	auto insert(const Key& key, Block block) -> void;
+
+private:
+
+	static constexpr std::size_t NUM_STRIPES = 16;
+	static constexpr std::size_t MAX_SOURCES = 65536;
+
+	struct KeyHash
+	{
+		auto operator()(const Key& key) const -> std::size_t;
+	};
+
+	struct Entry
+	{
+		Key key;
+		Block block;
+	};
+
+	struct Stripe
+	{
+		mutable std::mutex mutex;
+
+		// Most recently used first
+		std::list<Entry> entries;
+		std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+		std::size_t bytes_used{0};
+	};
+
+	[[nodiscard]] auto get_stripe(const Key& key) -> Stripe&;
+	auto evict(Stripe* stripe, std::size_t stripe_budget) -> void;
+
+	std::atomic<std::size_t> budget_{0};
+	std::atomic<std::uint64_t> hits_{0};
+	std::atomic<std::uint64_t> misses_{0};
+	std::array<Stripe, NUM_STRIPES> stripes_;
+
+	std::atomic<std::uint64_t> next_source_id_{0};
+	std::mutex sources_mutex_;
+	std::unordered_map<std::string, std::uint64_t> sources_;
+
+	auto clear_sources() -> void;
+};
+
+// Identity of a file for the cache. Null if the file can't be looked at.
+[[nodiscard]] extern auto get_file_identity(const std::string& utf8_path) -> std::optional<std::string>;
+
+}}
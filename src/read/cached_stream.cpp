@@ -0,0 +1,186 @@
+#include "cached_stream.h"
+#include <algorithm>
+#include <cstring>
+#include "convert/sample_format.h"
+
+namespace blahdio {
+namespace read {
+
+CachedStream::CachedStream(std::uint64_t source, SampleFormat sample_format, int num_channels, ReadFn read, SeekFn seek)
+	: source_{source}
+	, sample_format_{sample_format}
+	, num_channels_{num_channels}
+	, sample_bytes_{convert::get_sample_size(sample_format)}
+	, frame_bytes_{sample_bytes_ * num_channels}
+	, read_{std::move(read)}
+	, seek_{std::move(seek)}
+	, planar_out_(num_channels)
+{
+}
+
+auto CachedStream::read(void* buffer, std::uint32_t frames_to_read) -> expected<std::uint32_t>
+{
+	const auto copy = [this, buffer](const std::byte* frames, std::uint32_t frames_done, std::uint32_t num_frames)
+	{
+		std::memcpy(static_cast<std::byte*>(buffer) + (frames_done * frame_bytes_), frames, num_frames * frame_bytes_);
+	};
+
+	return read(frames_to_read, copy);
+}
+
+auto CachedStream::read_planar(void* const* channels, std::uint32_t frames_to_read) -> expected<std::uint32_t>
+{
+	const auto copy = [this, channels](const std::byte* frames, std::uint32_t frames_done, std::uint32_t num_frames)
+	{
+		for (int c = 0; c < num_channels_; c++)
+		{
+			planar_out_[c] = static_cast<std::byte*>(channels[c]) + (frames_done * sample_bytes_);
+		}
+
+		convert::deinterleave_samples(frames, sample_format_, planar_out_.data(), sample_format_, num_channels_, num_frames);
+	};
+
+	return read(frames_to_read, copy);
+}
+
+auto CachedStream::read(std::uint32_t frames_to_read, const CopyFn& copy) -> expected<std::uint32_t>
+{
+	std::uint32_t frames_done{0};
+
+	while (frames_done < frames_to_read)
+	{
+		const auto block_index{position_ / BlockCache::BLOCK_FRAMES};
+		const auto offset{std::uint32_t(position_ % BlockCache::BLOCK_FRAMES)};
+		const auto block{get_block(block_index)};
+
+		if (!block)
+		{
+			return tl::make_unexpected(block.error());
+		}
+
+		const auto block_frames{std::uint32_t((*block)->size() / frame_bytes_)};
+
+		if (offset >= block_frames) break;
+
+		const auto num_frames{std::min(block_frames - offset, frames_to_read - frames_done)};
+
+		copy((*block)->data() + (offset * frame_bytes_), frames_done, num_frames);
+
+		frames_done += num_frames;
+		position_ += num_frames;
+
+		// A short block is the end of the source
+		if (block_frames < BlockCache::BLOCK_FRAMES && offset + num_frames >= block_frames) break;
+	}
+
+	return frames_done;
+}
+
+auto CachedStream::seek(std::uint64_t frame) -> bool
+{
+	const auto block_index{frame / BlockCache::BLOCK_FRAMES};
+
+	if (!current_ || current_index_ != block_index)
+	{
+		auto cached{BlockCache::get().find({source_, sample_format_, block_index})};
+
+		if (cached)
+		{
+			current_index_ = block_index;
+			current_ = std::move(cached);
+		}
+		else
+		{
+			// Seek the decoder to the start of the block now, so that a bad
+			// position is reported here rather than by the next read, and
+			// decode_block() finds it already there
+			const auto first_frame{block_index * BlockCache::BLOCK_FRAMES};
+
+			if (decoder_position_ != first_frame)
+			{
+				if (!seek_(first_frame)) return false;
+
+				decoder_position_ = first_frame;
+			}
+		}
+	}
+
+	position_ = frame;
+
+	return true;
+}
+
+auto CachedStream::sync_decoder() -> bool
+{
+	if (decoder_position_ == position_) return true;
+	if (!seek_(position_)) return false;
+
+	decoder_position_ = position_;
+
+	return true;
+}
+
+auto CachedStream::get_block(std::uint64_t block) -> expected<BlockCache::Block>
+{
+	if (current_ && current_index_ == block) return current_;
+
+	auto cached{BlockCache::get().find({source_, sample_format_, block})};
+
+	if (!cached)
+	{
+		auto decoded{decode_block(block)};
+
+		if (!decoded) return decoded;
+
+		cached = std::move(*decoded);
+	}
+
+	current_index_ = block;
+	current_ = cached;
+
+	return cached;
+}
+
+auto CachedStream::decode_block(std::uint64_t block) -> expected<BlockCache::Block>
+{
+	const auto first_frame{block * BlockCache::BLOCK_FRAMES};
+
+	if (decoder_position_ != first_frame)
+	{
+		if (!seek_(first_frame))
+		{
+			return tl::make_unexpected("Failed to seek the stream");
+		}
+
+		decoder_position_ = first_frame;
+	}
+
+	std::vector<std::byte> frames(BlockCache::BLOCK_FRAMES * frame_bytes_);
+	std::uint32_t frames_read{0};
+
+	while (frames_read < BlockCache::BLOCK_FRAMES)
+	{
+		const auto result{read_(frames.data() + (frames_read * frame_bytes_), BlockCache::BLOCK_FRAMES - frames_read)};
+
+		if (!result)
+		{
+			return tl::make_unexpected(result.error());
+		}
+
+		if (*result == 0) break;
+
+		frames_read += *result;
+	}
+
+	decoder_position_ += frames_read;
+
+	frames.resize(frames_read * frame_bytes_);
+
+	auto out{std::make_shared<const std::vector<std::byte>>(std::move(frames))};
+
+	BlockCache::get().insert({source_, sample_format_, block}, out);
+
+	return out;
+}
+
+}}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "blahdio/expected.h"
+#include "blahdio/output_format.h"
+#include "block_cache.h"
+
+namespace blahdio {
+namespace read {
+
+// Reads a decoder's frames through the block cache. The decoder is only
+// used for blocks which aren't cached, and is only seeked when the next
+// block it is asked for isn't the one it is already at.
+class CachedStream
+{
+public:
+
+	using ReadFn = std::function<expected<std::uint32_t>(void* buffer, std::uint32_t frames_to_read)>;
+	using SeekFn = std::function<bool(std::uint64_t frame)>;
+
+	CachedStream(std::uint64_t source, SampleFormat sample_format, int num_channels, ReadFn read, SeekFn seek);
+
+	[[nodiscard]] auto read(void* buffer, std::uint32_t frames_to_read) -> expected<std::uint32_t>;
+	[[nodiscard]] auto read_planar(void* const* channels, std::uint32_t frames_to_read) -> expected<std::uint32_t>;
+
+	// Only seeks the decoder if the block isn't cached
+	[[nodiscard]] auto seek(std::uint64_t frame) -> bool;
+
+	// Leaves the decoder at the stream's position, for reading from it
+	// directly once the cache is no longer used
+	[[nodiscard]] auto sync_decoder() -> bool;
+
+private:
+
+	using CopyFn = std::function<void(const std::byte* frames, std::uint32_t frames_done, std::uint32_t num_frames)>;
+
+	[[nodiscard]] auto read(std::uint32_t frames_to_read, const CopyFn& copy) -> expected<std::uint32_t>;
+	[[nodiscard]] auto get_block(std::uint64_t block) -> expected<BlockCache::Block>;
+	[[nodiscard]] auto decode_block(std::uint64_t block) -> expected<BlockCache::Block>;
+
+	std::uint64_t source_;
+	SampleFormat sample_format_;
+	int num_channels_;
+	std::size_t sample_bytes_;
+	std::size_t frame_bytes_;
+	ReadFn read_;
+	SeekFn seek_;
+	std::uint64_t position_{0};
+	std::uint64_t decoder_position_{0};
+
+	// The last block read from, so that small reads don't look it up
+	// again each time
+	std::uint64_t current_index_{0};
+	BlockCache::Block current_;
+
+	std::vector<void*> planar_out_;
+};
+
+}}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "format_reader.h"
+
+namespace blahdio {
+namespace read {
+
+// A decoder of its own over the same source as the handler which opened
+// it, so any number of them can be read at once (from different threads)
+struct Cursor
+{
+	using SeekFn = std::function<bool(std::uint64_t frame)>;
+
+	// Keeps the decoder open. The reader and seek function point into it.
+	std::shared_ptr<void> decoder;
+
+	FormatReader reader;
+	SeekFn seek;
+};
+
+}}
@@ -0,0 +1,299 @@
+#include "flac_index.h"
+#include <algorithm>
+#include <vector>
+
+namespace blahdio {
+namespace read {
+namespace flac {
+
+static constexpr std::size_t CHUNK_SIZE = 1 << 20;
+
+// Frame headers are at most this long
+static constexpr std::size_t MAX_HEADER_SIZE = 16;
+
+// dr_flac searches the seek table linearly so it is thinned out to at
+// most this many points. That leaves a few frames to decode after
+// jumping to a point in very long files.
+static constexpr std::size_t MAX_POINTS = 32768;
+
+struct StreamInfo
+{
+	std::uint64_t first_frame_offset{0};
+	std::uint32_t min_block_size{0};
+	std::uint32_t min_frame_size{0};
+};
+
+[[nodiscard]] static
+auto byte(const std::byte* data, std::size_t index) -> std::uint32_t
+{
+	return std::to_integer<std::uint32_t>(data[index]);
+}
+
+[[nodiscard]] static
+auto crc8(const std::byte* data, std::size_t size) -> std::uint8_t
+{
+	std::uint32_t crc{0};
+
+	for (std::size_t i = 0; i < size; i++)
+	{
+		crc ^= byte(data, i);
+
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+		}
+	}
+
+	return std::uint8_t(crc);
+}
+
+[[nodiscard]] static
+auto read_stream_info(const RawSource& source) -> std::optional<StreamInfo>
+{
+	std::byte head[10];
+	std::uint64_t pos{0};
+
+	if (source.read_at(pos, head, 10) != 10) return std::nullopt;
+
+	// Skip an ID3v2 tag. dr_flac does the same.
+	if (byte(head, 0) == 'I' && byte(head, 1) == 'D' && byte(head, 2) == '3')
+	{
+		const auto tag_size{(byte(head, 6) << 21) | (byte(head, 7) << 14) | (byte(head, 8) << 7) | byte(head, 9)};
+
+		pos = 10 + tag_size + ((byte(head, 5) & 0x10) ? 10 : 0);
+	}
+
+	std::byte magic[4];
+
+	if (source.read_at(pos, magic, 4) != 4) return std::nullopt;
+	if (byte(magic, 0) != 'f' || byte(magic, 1) != 'L' || byte(magic, 2) != 'a' || byte(magic, 3) != 'C') return std::nullopt;
+
+	pos += 4;
+
+	StreamInfo out;
+	bool got_stream_info{false};
+
+	for (;;)
+	{
+		std::byte block_header[4];
+
+		if (source.read_at(pos, block_header, 4) != 4) return std::nullopt;
+
+		const auto is_last{(byte(block_header, 0) & 0x80) != 0};
+		const auto block_type{byte(block_header, 0) & 0x7F};
+		const auto block_size{(byte(block_header, 1) << 16) | (byte(block_header, 2) << 8) | byte(block_header, 3)};
+
+		pos += 4;
+
+		if (block_type == 0)
+		{
+			std::byte info[10];
+
+			if (block_size < 10 || source.read_at(pos, info, 10) != 10) return std::nullopt;
+
+			out.min_block_size = (byte(info, 0) << 8) | byte(info, 1);
+			out.min_frame_size = (byte(info, 4) << 16) | (byte(info, 5) << 8) | byte(info, 6);
+			got_stream_info = true;
+		}
+
+		pos += block_size;
+
+		if (is_last) break;
+	}
+
+	if (!got_stream_info) return std::nullopt;
+
+	out.first_frame_offset = pos;
+
+	return out;
+}
+
+struct FrameHeader
+{
+	std::uint64_t first_frame{0};
+	std::uint32_t num_frames{0};
+};
+
+[[nodiscard]] static
+auto read_utf8_number(const std::byte* data, std::size_t* pos, std::size_t end) -> std::optional<std::uint64_t>
+{
+	const auto first{byte(data, *pos)};
+
+	int extra_bytes{0};
+	std::uint64_t value{0};
+
+	if (!(first & 0x80)) { value = first; }
+	else if ((first & 0xE0) == 0xC0) { value = first & 0x1F; extra_bytes = 1; }
+	else if ((first & 0xF0) == 0xE0) { value = first & 0x0F; extra_bytes = 2; }
+	else if ((first & 0xF8) == 0xF0) { value = first & 0x07; extra_bytes = 3; }
+	else if ((first & 0xFC) == 0xF8) { value = first & 0x03; extra_bytes = 4; }
+	else if ((first & 0xFE) == 0xFC) { value = first & 0x01; extra_bytes = 5; }
+	else if (first == 0xFE) { value = 0; extra_bytes = 6; }
+	else return std::nullopt;
+
+	(*pos)++;
+
+	if (*pos + extra_bytes > end) return std::nullopt;
+
+	for (int i = 0; i < extra_bytes; i++)
+	{
+		const auto next{byte(data, (*pos)++)};
+
+		if ((next & 0xC0) != 0x80) return std::nullopt;
+
+		value = (value << 6) | (next & 0x3F);
+	}
+
+	return value;
+}
+
+// Returns nothing if the bytes at data aren't a valid frame header
+[[nodiscard]] static
+auto parse_frame_header(const std::byte* data, std::size_t size, const StreamInfo& info) -> std::optional<FrameHeader>
+{
+	if (size < MAX_HEADER_SIZE) return std::nullopt;
+	if (byte(data, 0) != 0xFF || (byte(data, 1) & 0xFE) != 0xF8) return std::nullopt;
+
+	const auto variable_block_size{(byte(data, 1) & 0x01) != 0};
+	const auto block_size_code{byte(data, 2) >> 4};
+	const auto sample_rate_code{byte(data, 2) & 0x0F};
+	const auto channel_assignment{byte(data, 3) >> 4};
+	const auto sample_size_code{(byte(data, 3) >> 1) & 0x07};
+
+	if (block_size_code == 0) return std::nullopt;
+	if (sample_rate_code == 0x0F) return std::nullopt;
+	if (channel_assignment > 10) return std::nullopt;
+	if (sample_size_code == 3) return std::nullopt;
+	if (byte(data, 3) & 0x01) return std::nullopt;
+
+	std::size_t pos{4};
+
+	const auto number{read_utf8_number(data, &pos, size)};
+
+	if (!number) return std::nullopt;
+
+	std::uint32_t num_frames{0};
+
+	switch (block_size_code)
+	{
+		case 1: num_frames = 192; break;
+		case 2: case 3: case 4: case 5: num_frames = 576 << (block_size_code - 2); break;
+		case 6: num_frames = byte(data, pos) + 1; pos += 1; break;
+		case 7: num_frames = ((byte(data, pos) << 8) | byte(data, pos + 1)) + 1; pos += 2; break;
+		default: num_frames = 256 << (block_size_code - 8); break;
+	}
+
+	switch (sample_rate_code)
+	{
+		case 12: pos += 1; break;
+		case 13: case 14: pos += 2; break;
+		default: break;
+	}
+
+	if (pos >= size) return std::nullopt;
+	if (crc8(data, pos) != std::uint8_t(byte(data, pos))) return std::nullopt;
+
+	FrameHeader out;
+
+	out.num_frames = num_frames;
+	out.first_frame = variable_block_size ? *number : *number * info.min_block_size;
+
+	return out;
+}
+
+[[nodiscard]] static
+auto thin_out(std::vector<SeekPoint> points) -> std::vector<SeekPoint>
+{
+	if (points.size() <= MAX_POINTS) return points;
+
+	const auto stride{(points.size() + MAX_POINTS - 1) / MAX_POINTS};
+
+	std::vector<SeekPoint> out;
+
+	out.reserve(MAX_POINTS);
+
+	for (std::size_t i = 0; i < points.size(); i += stride)
+	{
+		out.push_back(points[i]);
+	}
+
+	return out;
+}
+
+auto build_seek_index(const RawSource& source, const std::atomic<bool>& cancel) -> std::optional<SeekIndex>
+{
+	const auto info{read_stream_info(source)};
+
+	if (!info) return std::nullopt;
+
+	std::vector<SeekPoint> points;
+	std::vector<std::byte> chunk(CHUNK_SIZE + MAX_HEADER_SIZE);
+
+	auto chunk_offset{info->first_frame_offset};
+	std::size_t skip{0};
+
+	for (;;)
+	{
+		if (cancel) return std::nullopt;
+
+		const auto chunk_size{source.read_at(chunk_offset, chunk.data(), chunk.size())};
+
+		if (chunk_size < MAX_HEADER_SIZE) break;
+
+		// Headers which start in the last few bytes are found in the next
+		// chunk, which overlaps this one
+		const auto search_end{chunk_size == chunk.size() ? CHUNK_SIZE : chunk_size - MAX_HEADER_SIZE + 1};
+
+		auto pos{skip};
+
+		while (pos < search_end)
+		{
+			if (byte(chunk.data(), pos) != 0xFF)
+			{
+				pos++;
+				continue;
+			}
+
+			const auto header{parse_frame_header(chunk.data() + pos, chunk_size - pos, *info)};
+
+			// Audio data can look like a frame header (even with a valid
+			// CRC) so each frame also has to follow on from the last one
+			const auto expected_first_frame{points.empty() ? 0 : points.back().frame + points.back().num_frames};
+
+			if (!header || header->first_frame != expected_first_frame)
+			{
+				pos++;
+				continue;
+			}
+
+			SeekPoint point;
+
+			point.frame = header->first_frame;
+			point.byte_offset = chunk_offset + pos;
+			point.num_frames = header->num_frames;
+
+			points.push_back(point);
+
+			// No frame is shorter than this so there is no need to look
+			// for a header inside it
+			pos += std::max<std::size_t>(info->min_frame_size, 1);
+		}
+
+		if (chunk_size < chunk.size()) break;
+
+		chunk_offset += CHUNK_SIZE;
+		skip = pos - CHUNK_SIZE;
+	}
+
+	if (points.empty()) return std::nullopt;
+
+	SeekIndex out;
+
+	out.type = AudioType::flac;
+	out.source_size = source.size().value_or(0);
+	out.points = thin_out(std::move(points));
+
+	return out;
+}
+
+}}}
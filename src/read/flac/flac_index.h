@@ -0,0 +1,18 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include "read/raw_source.h"
+#include "read/seek_index.h"
+
+namespace blahdio {
+namespace read {
+namespace flac {
+
+// Finds the start of every FLAC frame by scanning the source for frame
+// headers (which are checked against their CRC) without decoding any
+// audio. Returns nothing if the source isn't FLAC or the scan was
+// cancelled.
+[[nodiscard]] extern auto build_seek_index(const RawSource& source, const std::atomic<bool>& cancel) -> std::optional<SeekIndex>;
+
+}}}
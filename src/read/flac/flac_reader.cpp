@@ -1,8 +1,12 @@
 #include <cassert>
 #include <optional>
 #include <format>
+#include <vector>
 #include "flac_reader.h"
+#include "flac_index.h"
+#include "read/format_reader.h"
 #include "mackron/blahdio_dr_libs.h"
+#include "counters.h"
 
 namespace blahdio {
 namespace read {
@@ -14,8 +18,20 @@ struct FLAC
 	FLAC(const FLAC&) = delete;
 	auto operator=(const FLAC&&) -> FLAC& = delete;
 
-	FLAC(FLAC&& rhs) : flac_{rhs.flac_}, header_{rhs.header_} { rhs.flac_ = nullptr; }
-	auto operator=(FLAC&& rhs) -> FLAC& { flac_ = rhs.flac_; rhs.flac_ = nullptr; return *this; }
+	FLAC(FLAC&& rhs) : flac_{rhs.flac_}, header_{rhs.header_}, seek_points_{std::move(rhs.seek_points_)} { rhs.flac_ = nullptr; }
+	auto operator=(FLAC&& rhs) -> FLAC&
+	{
+		if (flac_)
+		{
+			drflac_close(flac_);
+		}
+
+		flac_ = rhs.flac_;
+		header_ = rhs.header_;
+		seek_points_ = std::move(rhs.seek_points_);
+		rhs.flac_ = nullptr;
+		return *this;
+	}
 
 	~FLAC()
 	{
@@ -28,6 +44,36 @@ struct FLAC
 	operator bool() const { return flac_; }
 	operator drflac*() const { return flac_; }
 	auto get_header_info() const { return header_; }
+	auto has_seek_index() const { return !seek_points_.empty(); }
+
+	// Replaces the SEEKTABLE from the file (if there was one.) dr_flac
+	// doesn't free the seek points separately from the decoder so they
+	// can point into our own storage.
+	auto bind_seek_index(const SeekIndex& index) -> void
+	{
+		const auto first_frame_pos{flac_->firstFLACFramePosInBytes};
+
+		seek_points_.clear();
+		seek_points_.reserve(index.points.size());
+
+		for (const auto& point : index.points)
+		{
+			if (point.byte_offset < first_frame_pos) continue;
+
+			drflac_seekpoint seek_point;
+
+			seek_point.firstPCMFrame = point.frame;
+			seek_point.flacFrameOffset = point.byte_offset - first_frame_pos;
+			seek_point.pcmFrameCount = drflac_uint16(point.num_frames);
+
+			seek_points_.push_back(seek_point);
+		}
+
+		if (seek_points_.empty()) return;
+
+		flac_->pSeekpoints = seek_points_.data();
+		flac_->seekpointCount = drflac_uint32(seek_points_.size());
+	}
 
 	[[nodiscard]] static
 	auto file(std::string_view utf8_path) -> expected<FLAC>
@@ -91,28 +137,38 @@ private:
 
 	drflac* flac_{};
 	AudioDataFormat header_{};
+	std::vector<drflac_seekpoint> seek_points_;
 };
 
 [[nodiscard]] static
-auto read_frame_data(drflac* flac, AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> expected<void>
+auto make_format_reader(drflac* flac, OutputFormat output_format) -> FormatReader
 {
-	const auto read_func = [flac](float* buffer, std::uint32_t read_size)
+	FormatReader::NativeReaders native_readers;
+
+	native_readers.f32 = [flac](void* buffer, std::uint32_t read_size)
 	{
-		return std::uint32_t(drflac_read_pcm_frames_f32(flac, read_size, buffer));
+		return std::uint32_t(drflac_read_pcm_frames_f32(flac, read_size, (float*)(buffer)));
 	};
 
-	return dr_libs::generic_frame_reader_loop(callbacks, read_func, chunk_size, format.num_channels, format.num_frames);
-}
+	native_readers.s16 = [flac](void* buffer, std::uint32_t read_size)
+	{
+		return std::uint32_t(drflac_read_pcm_frames_s16(flac, read_size, (drflac_int16*)(buffer)));
+	};
 
-static
-auto read_stream_data(drflac* flac, AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> void
-{
-	const auto read_func = [flac](float* buffer, std::uint32_t read_size)
+	native_readers.s32 = [flac](void* buffer, std::uint32_t read_size)
 	{
-		return std::uint32_t(drflac_read_pcm_frames_f32(flac, read_size, buffer));
+		return std::uint32_t(drflac_read_pcm_frames_s32(flac, read_size, (drflac_int32*)(buffer)));
 	};
 
-	dr_libs::generic_stream_reader_loop(callbacks, read_func, chunk_size, format.num_channels);
+	return FormatReader{native_readers, flac->channels, output_format};
+}
+
+[[nodiscard]] static
+auto read_frame_data(drflac* flac, AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size, OutputFormat output_format) -> expected<void>
+{
+	auto reader{make_format_reader(flac, output_format)};
+
+	return dr_libs::generic_frame_reader_loop(callbacks, &reader, chunk_size, format.num_frames);
 }
 
 static
@@ -129,8 +185,11 @@ static
 auto drflac_stream_read(void* user_data, void* buffer, size_t bytes_to_read) -> size_t
 {
 	const auto stream = (AudioReader::Stream*)(user_data);
+	const auto bytes_read = stream->read_bytes(buffer, std::uint32_t(bytes_to_read));
 
-	return stream->read_bytes(buffer, std::uint32_t(bytes_to_read));
+	stats::add(stats::Counter::bytes, bytes_read);
+
+	return bytes_read;
 }
 
 static
@@ -145,30 +204,43 @@ struct FLACHandler
 {
 	using OpenFn = std::function<expected<FLAC>()>;
 
-	FLACHandler(OpenFn open_fn) : open_fn_{open_fn} {}
+	FLACHandler(OpenFn open_fn, RawSource raw_source) : open_fn_{open_fn}, raw_source_{raw_source} {}
 
 	auto type() const -> AudioType { return AudioType::flac; }
+	auto zero_copy() const -> AudioReader::ZeroCopy { return AudioReader::ZeroCopy::unavailable; }
 
 	[[nodiscard]]
-	auto try_read_header() -> expected<AudioDataFormat>
+	auto try_read_header(bool keep_decoder) -> expected<AudioDataFormat>
 	{
-		const auto get_header_info = [=](FLAC&& flac) -> expected<AudioDataFormat>
+		if (header_decoder_)
 		{
-			return flac.get_header_info();
+			return header_decoder_->get_header_info();
+		}
+
+		const auto get_header_info = [this, keep_decoder](FLAC&& flac) -> expected<AudioDataFormat>
+		{
+			const auto header{flac.get_header_info()};
+
+			if (keep_decoder)
+			{
+				header_decoder_ = std::move(flac);
+			}
+
+			return header;
 		};
 
 		return open_fn_().and_then(get_header_info);
 	}
 
 	[[nodiscard]]
-	auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> expected<void>
+	auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size, typed::ReadOptions options) -> expected<void>
 	{
 		const auto read_frames = [=](FLAC&& flac)
 		{
-			return read_frame_data(flac, callbacks, format, chunk_size);
+			return read_frame_data(flac, callbacks, format, chunk_size, options.output_format);
 		};
 
-		return open_fn_().and_then(read_frames);
+		return open_decoder().and_then(read_frames);
 	}
 
 	[[nodiscard]]
@@ -179,20 +251,31 @@ struct FLACHandler
 			return tl::make_unexpected("Failed to read frames from the FLAC stream (The stream is not open)");
 		}
 
-		return uint32_t(drflac_read_pcm_frames_f32(*stream_, uint64_t(frames_to_read), (float*)(buffer)));
+		return stream_reader_->read(buffer, frames_to_read);
+	}
+
+	[[nodiscard]]
+	auto stream_read_planar(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>
+	{
+		if (!stream_)
+		{
+			return tl::make_unexpected("Failed to read frames from the FLAC stream (The stream is not open)");
+		}
+
+		return stream_reader_->read_planar(channels, frames_to_read);
 	}
 
 	[[nodiscard]]
-	auto stream_open() -> expected<AudioDataFormat>
+	auto stream_open(OutputFormat output_format) -> expected<AudioDataFormat>
 	{
 		if (stream_)
 		{
 			return tl::make_unexpected("Failed to open FLAC stream (It is already open)");
 		}
 
-		const auto open_stream = [=]() -> expected<void>
+		const auto open_stream = [=, this]() -> expected<void>
 		{
-			auto result{open_fn_()};
+			auto result{open_decoder()};
 
 			if (!result)
 			{
@@ -200,6 +283,7 @@ struct FLACHandler
 			}
 
 			stream_ = std::move(*result);
+			stream_reader_.emplace(make_format_reader(*stream_, output_format));
 			return {};
 		};
 
@@ -212,21 +296,25 @@ struct FLACHandler
 	}
 
 	[[nodiscard]]
-	auto stream_seek(uint64_t target_frame) -> expected<void>
+	auto stream_seek(uint64_t target_frame) -> bool
 	{
-		if (!stream_)
+		if (!stream_) return false;
+
+		if (!reserved_)
 		{
-			return tl::make_unexpected("Failed to seek the FLAC stream (The stream is not open)");
+			bind_seek_index_if_ready();
 		}
 
-		const auto result{drflac_seek_to_pcm_frame(*stream_, target_frame)};
+		return drflac_seek_to_pcm_frame(*stream_, target_frame);
+	}
 
-		if (!result)
-		{
-			return tl::make_unexpected("Failed to seek the FLAC stream for some reason");
-		}
+	auto stream_reserve(uint32_t max_frames_per_read) -> void
+	{
+		if (!stream_) return;
 
-		return {};
+		bind_seek_index_if_ready();
+		stream_reader_->reserve(max_frames_per_read);
+		reserved_ = true;
 	}
 
 	[[nodiscard]]
@@ -237,24 +325,118 @@ struct FLACHandler
 			return tl::make_unexpected("Failed to close FLAC stream (The stream is not open)");
 		}
 
+		stream_reader_ = std::nullopt;
 		stream_ = std::nullopt;
+		reserved_ = false;
 		return {};
 	}
 
+	[[nodiscard]]
+	auto open_cursor(OutputFormat output_format) -> expected<Cursor>
+	{
+		// Sources which can be scanned for a seek index (files and memory)
+		// can also be decoded by more than one decoder at once
+		if (!raw_source_)
+		{
+			return tl::make_unexpected("Failed to open FLAC cursor (The source can't be decoded more than once at a time)");
+		}
+
+		const auto make_cursor = [this, output_format](FLAC&& flac) -> expected<Cursor>
+		{
+			const auto decoder{std::make_shared<FLAC>(std::move(flac))};
+
+			if (const auto index{seek_index_.try_get()})
+			{
+				decoder->bind_seek_index(*index);
+			}
+
+			const auto seek = [decoder = decoder.get()](uint64_t frame)
+			{
+				return bool(drflac_seek_to_pcm_frame(*decoder, frame));
+			};
+
+			return Cursor{decoder, make_format_reader(*decoder, output_format), seek};
+		};
+
+		return open_fn_().and_then(make_cursor);
+	}
+
+	auto build_seek_index() -> void
+	{
+		if (!raw_source_) return;
+
+		seek_index_.start([raw_source = raw_source_](const std::atomic<bool>& cancel)
+		{
+			return flac::build_seek_index(raw_source, cancel);
+		});
+	}
+
+	[[nodiscard]]
+	auto set_seek_index(SeekIndex index) -> expected<void>
+	{
+		seek_index_.set(std::move(index));
+		return {};
+	}
+
+	[[nodiscard]]
+	auto get_seek_index() const -> expected<SeekIndex>
+	{
+		const auto index{seek_index_.wait()};
+
+		if (!index)
+		{
+			return tl::make_unexpected("Failed to get FLAC seek index (It hasn't been built)");
+		}
+
+		return *index;
+	}
+
 private:
 
+	// Hands over the decoder which was kept open by try_read_header(), or
+	// opens a new one if there isn't one
+	[[nodiscard]]
+	auto open_decoder() -> expected<FLAC>
+	{
+		if (header_decoder_)
+		{
+			auto decoder{std::move(*header_decoder_)};
+
+			header_decoder_ = std::nullopt;
+
+			return decoder;
+		}
+
+		return open_fn_();
+	}
+
+	auto bind_seek_index_if_ready() -> void
+	{
+		if (stream_->has_seek_index()) return;
+
+		if (const auto index{seek_index_.try_get()})
+		{
+			stream_->bind_seek_index(*index);
+		}
+	}
+
 	OpenFn open_fn_;
+	RawSource raw_source_;
+	std::optional<FLAC> header_decoder_;
 	std::optional<FLAC> stream_;
+	std::optional<FormatReader> stream_reader_;
+	mutable BackgroundSeekIndex seek_index_;
+	bool reserved_{false};
 };
 
-auto make_handler(std::string utf8_path) -> typed::Handler
+auto make_handler(std::string utf8_path, RawSource raw_source) -> typed::Handler
 {
 	auto open_fn = [utf8_path]
 	{
 		return FLAC::file(utf8_path);
 	};
 
-	return FLACHandler{open_fn};
+	return FLACHandler{open_fn, raw_source};
 }
 
 auto make_handler(const AudioReader::Stream& stream) -> typed::Handler
@@ -264,17 +446,18 @@ auto make_handler(const AudioReader::Stream& stream) -> typed::Handler
 		return FLAC::stream(drflac_stream_read, drflac_stream_seek, (void*)(&stream));
 	};
 
-	return FLACHandler{open_fn};
+	// The stream can't be scanned while it is being decoded
+	return FLACHandler{open_fn, {}};
 }
 
-auto make_handler(const void* data, std::size_t data_size) -> typed::Handler
+auto make_handler(const void* data, std::size_t data_size, RawSource raw_source) -> typed::Handler
 {
 	auto open_fn = [data, data_size]
 	{
 		return FLAC::memory(data, data_size);
 	};
 
-	return FLACHandler{open_fn};
+	return FLACHandler{open_fn, raw_source};
 }
 
 auto make_attempt_order(typed::Handlers* handlers) -> std::vector<typed::Handler*>
@@ -284,7 +467,7 @@ auto make_attempt_order(typed::Handlers* handlers) -> std::vector<typed::Handler
 	out.push_back(&handlers->flac);
 
 #	if BLAHDIO_ENABLE_WAV
-		out.push_back(&handlers->flac);
+		out.push_back(&handlers->wav);
 #	endif
 
 #	if BLAHDIO_ENABLE_MP3
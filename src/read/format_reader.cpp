@@ -0,0 +1,141 @@
+#include "format_reader.h"
+#include <cassert>
+#include "convert/sample_format.h"
+#include "counters.h"
+#include "trace.h"
+
+namespace blahdio {
+namespace read {
+
+struct ChosenReader
+{
+	FormatReader::ReadFn read_fn;
+	SampleFormat read_format;
+};
+
+[[nodiscard]] static
+auto choose_reader(const FormatReader::NativeReaders& native_readers, SampleFormat format) -> ChosenReader
+{
+	assert (native_readers.f32);
+
+	switch (format)
+	{
+		case SampleFormat::s16:
+		{
+			if (native_readers.s16) return { native_readers.s16, SampleFormat::s16 };
+			if (native_readers.s32) return { native_readers.s32, SampleFormat::s32 };
+			break;
+		}
+
+		case SampleFormat::s24:
+		{
+			if (native_readers.s24) return { native_readers.s24, SampleFormat::s24 };
+			if (native_readers.s32) return { native_readers.s32, SampleFormat::s32 };
+			break;
+		}
+
+		case SampleFormat::s32:
+		{
+			if (native_readers.s32) return { native_readers.s32, SampleFormat::s32 };
+			break;
+		}
+
+		case SampleFormat::f32:
+		case SampleFormat::f64:
+		{
+			const auto bits{native_readers.integer_bits};
+
+			if (bits <= 0) break;
+			if (bits <= 16 && native_readers.s16) return { native_readers.s16, SampleFormat::s16 };
+			if (bits <= 24 && native_readers.s24) return { native_readers.s24, SampleFormat::s24 };
+			if (bits <= 32 && native_readers.s32) return { native_readers.s32, SampleFormat::s32 };
+			break;
+		}
+
+		default: break;
+	}
+
+	return { native_readers.f32, SampleFormat::f32 };
+}
+
+FormatReader::FormatReader(NativeReaders native_readers, int num_channels, OutputFormat format)
+	: format_{format}
+	, num_channels_{num_channels}
+{
+	auto chosen{choose_reader(native_readers, format.sample_format)};
+
+	read_fn_ = std::move(chosen.read_fn);
+	read_format_ = chosen.read_format;
+}
+
+auto FormatReader::get_frame_bytes() const -> std::size_t
+{
+	return convert::get_sample_size(format_.sample_format) * std::size_t(num_channels_);
+}
+
+auto FormatReader::reserve(std::uint32_t max_frames_per_read) -> void
+{
+	scratch_.reserve(convert::get_sample_size(read_format_) * std::size_t(num_channels_) * max_frames_per_read);
+}
+
+auto FormatReader::decode(void* buffer, std::uint32_t frames_to_read) -> std::uint32_t
+{
+	BLAHDIO_TRACE_ZONE("blahdio::decode");
+	stats::Timer timer{stats::Counter::codec_ns};
+
+	return read_fn_(buffer, frames_to_read);
+}
+
+auto FormatReader::read_scratch(std::uint32_t frames_to_read) -> std::uint32_t
+{
+	stats::resize(&scratch_, convert::get_sample_size(read_format_) * std::size_t(num_channels_) * frames_to_read);
+
+	return decode(scratch_.data(), frames_to_read);
+}
+
+auto FormatReader::read(void* buffer, std::uint32_t frames_to_read) -> std::uint32_t
+{
+	if (is_native())
+	{
+		return decode(buffer, frames_to_read);
+	}
+
+	const auto frames_read{read_scratch(frames_to_read)};
+
+	BLAHDIO_TRACE_ZONE("blahdio::convert");
+	stats::Timer timer{stats::Counter::convert_ns};
+
+	convert::convert_samples(scratch_.data(), read_format_, buffer, format_.sample_format, std::size_t(frames_read) * num_channels_);
+
+	return frames_read;
+}
+
+auto FormatReader::read_planar(void* const* channels, std::uint32_t frames_to_read) -> std::uint32_t
+{
+	// Decoders only produce interleaved frames, so they always go through
+	// the scratch buffer. Conversion happens during the deinterleave.
+	const auto frames_read{read_scratch(frames_to_read)};
+
+	BLAHDIO_TRACE_ZONE("blahdio::convert");
+	stats::Timer timer{stats::Counter::convert_ns};
+
+	convert::deinterleave_samples(scratch_.data(), read_format_, channels, format_.sample_format, num_channels_, frames_read);
+
+	return frames_read;
+}
+
+auto FormatReader::read_chunk(std::uint32_t frames_to_read) -> std::uint32_t
+{
+	if (format_.planar)
+	{
+		planar_chunk_.resize(num_channels_, convert::get_sample_size(format_.sample_format) * frames_to_read);
+
+		return read_planar(planar_chunk_.channels(), frames_to_read);
+	}
+
+	stats::resize(&chunk_, get_frame_bytes() * frames_to_read);
+
+	return read(chunk_.data(), frames_to_read);
+}
+
+}}
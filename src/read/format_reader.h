@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "blahdio/output_format.h"
+#include "convert/planar_buffer.h"
+
+namespace blahdio {
+namespace read {
+
+// Reads frames in the requested output format, using the decoder's own
+// conversion where it has one for that sample format and converting from
+// the closest one it does have otherwise
+class FormatReader
+{
+public:
+
+	using ReadFn = std::function<std::uint32_t(void* buffer, std::uint32_t frames_to_read)>;
+
+	// The formats the decoder can produce itself. f32 is required.
+	struct NativeReaders
+	{
+		ReadFn f32;
+		ReadFn s16;
+		ReadFn s24;
+		ReadFn s32;
+
+		// The bit depth of the decoder's samples if they are integers
+		// which it would only convert to float one at a time. Float
+		// formats are then read as the smallest integer format that
+		// holds them and converted here, which is vectorized and gives
+		// exactly the same values. 0 leaves float to the decoder.
+		int integer_bits{0};
+	};
+
+	FormatReader(NativeReaders native_readers, int num_channels, OutputFormat format);
+
+	// Interleaved, into the caller's buffer
+	[[nodiscard]] auto read(void* buffer, std::uint32_t frames_to_read) -> std::uint32_t;
+
+	// One buffer per channel, provided by the caller
+	[[nodiscard]] auto read_planar(void* const* channels, std::uint32_t frames_to_read) -> std::uint32_t;
+
+	// Makes room for reads of up to this many frames, so that read() and
+	// read_planar() don't allocate
+	auto reserve(std::uint32_t max_frames_per_read) -> void;
+
+	// Reads into the reader's own buffers, interleaved or planar
+	// depending on the output format, for return_chunk()
+	[[nodiscard]] auto read_chunk(std::uint32_t frames_to_read) -> std::uint32_t;
+
+	// Passes the last chunk to the callback the output format asks for
+	template <typename Callbacks>
+	auto return_chunk(const Callbacks& callbacks, std::uint64_t frame, std::uint32_t num_frames) const -> void
+	{
+		if (format_.planar)
+		{
+			callbacks.return_planar_chunk(planar_chunk_.channels(), frame, num_frames);
+		}
+		else
+		{
+			callbacks.return_chunk((const void*)(chunk_.data()), frame, num_frames);
+		}
+	}
+
+	[[nodiscard]] auto get_format() const { return format_; }
+	[[nodiscard]] auto get_frame_bytes() const -> std::size_t;
+
+	// True if the decoder produces the requested sample format itself
+	[[nodiscard]] auto is_native() const { return read_format_ == format_.sample_format; }
+
+private:
+
+	[[nodiscard]] auto decode(void* buffer, std::uint32_t frames_to_read) -> std::uint32_t;
+	[[nodiscard]] auto read_scratch(std::uint32_t frames_to_read) -> std::uint32_t;
+
+	ReadFn read_fn_;
+	SampleFormat read_format_;
+	OutputFormat format_;
+	int num_channels_;
+	std::vector<std::byte> scratch_;
+	std::vector<std::byte> chunk_;
+	convert::PlanarBuffer planar_chunk_;
+};
+
+}}
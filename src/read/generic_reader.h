@@ -4,6 +4,7 @@
 #include <functional>
 #include "blahdio/audio_data_format.h"
 #include "blahdio/expected.h"
+#include "blahdio/output_format.h"
 
 namespace blahdio {
 
@@ -15,9 +16,11 @@ public:
 	{
 		using ShouldAbortFunc = std::function<bool()>;
 		using ReturnChunkFunc = std::function<void(const void* data, std::uint64_t frame, std::uint32_t size)>;
+		using ReturnPlanarChunkFunc = std::function<void(const void* const* channels, std::uint64_t frame, std::uint32_t size)>;
 
 		ShouldAbortFunc should_abort;
 		ReturnChunkFunc return_chunk;
+		ReturnPlanarChunkFunc return_planar_chunk;
 	};
 
 	int get_frame_size() const { return frame_size_; }
@@ -39,7 +42,7 @@ public:
 		return out;
 	}
 
-	virtual auto read_all_frames(Callbacks callbacks, uint32_t chunk_size) -> expected<void> = 0;
+	virtual auto read_all_frames(Callbacks callbacks, uint32_t chunk_size, OutputFormat output_format) -> expected<void> = 0;
 
 protected:
 
@@ -0,0 +1,120 @@
+#include "mapped_file.h"
+#include <cstdint>
+#include <utf8.h>
+
+#ifdef _WIN32
+#	define NOMINMAX
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace blahdio {
+namespace read {
+
+#ifdef _WIN32
+
+MappedFile::~MappedFile()
+{
+	if (data_) UnmapViewOfFile(data_);
+	if (mapping_) CloseHandle(mapping_);
+}
+
+auto MappedFile::open(const std::string& utf8_path) -> std::shared_ptr<MappedFile>
+{
+	const auto path{utf8::utf8to16(utf8_path)};
+	const auto file{CreateFileW((const wchar_t*)(path.c_str()), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+
+	if (file == INVALID_HANDLE_VALUE) return {};
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || std::uint64_t(size.QuadPart) > SIZE_MAX)
+	{
+		CloseHandle(file);
+		return {};
+	}
+
+	// The mapping keeps the file open
+	const auto mapping{CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+
+	CloseHandle(file);
+
+	if (!mapping) return {};
+
+	const auto data{MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)};
+
+	if (!data)
+	{
+		CloseHandle(mapping);
+		return {};
+	}
+
+	std::shared_ptr<MappedFile> out{new MappedFile};
+
+	out->data_ = data;
+	out->size_ = std::size_t(size.QuadPart);
+	out->mapping_ = mapping;
+
+	return out;
+}
+
+auto MappedFile::advise(AccessPattern) const -> void
+{
+	// Windows has no equivalent of madvise() for mapped files. The cache
+	// manager notices sequential reads by itself.
+}
+
+#else
+
+MappedFile::~MappedFile()
+{
+	if (data_) munmap(const_cast<void*>(data_), size_);
+}
+
+auto MappedFile::open(const std::string& utf8_path) -> std::shared_ptr<MappedFile>
+{
+	const auto fd{::open(utf8_path.c_str(), O_RDONLY | O_CLOEXEC)};
+
+	if (fd < 0) return {};
+
+	struct stat info;
+
+	if (fstat(fd, &info) != 0 || info.st_size <= 0 || std::uint64_t(info.st_size) > SIZE_MAX)
+	{
+		close(fd);
+		return {};
+	}
+
+	const auto size{std::size_t(info.st_size)};
+
+	// A shared mapping means every process reading the file uses the
+	// same pages of the page cache. The mapping keeps the file open.
+	const auto data{mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)};
+
+	close(fd);
+
+	if (data == MAP_FAILED) return {};
+
+	std::shared_ptr<MappedFile> out{new MappedFile};
+
+	out->data_ = data;
+	out->size_ = size;
+
+	return out;
+}
+
+auto MappedFile::advise(AccessPattern pattern) const -> void
+{
+	const auto advice{pattern == AccessPattern::sequential ? MADV_SEQUENTIAL : MADV_RANDOM};
+
+	madvise(const_cast<void*>(data_), size_, advice);
+}
+
+#endif
+
+}}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace blahdio {
+namespace read {
+
+enum class AccessPattern
+{
+	sequential,
+	random,
+};
+
+// A read-only memory mapping of a whole file. The file must not be
+// truncated while it is mapped.
+class MappedFile
+{
+public:
+
+	MappedFile(const MappedFile&) = delete;
+	auto operator=(const MappedFile&) -> MappedFile& = delete;
+	~MappedFile();
+
+	// Returns null if the file couldn't be mapped (e.g. it is empty, or
+	// too big for the address space) and should be read some other way
+	[[nodiscard]] static auto open(const std::string& utf8_path) -> std::shared_ptr<MappedFile>;
+
+	[[nodiscard]] auto data() const -> const void* { return data_; }
+	[[nodiscard]] auto size() const -> std::size_t { return size_; }
+
+	// Tells the OS how the pages are going to be read. Only a hint.
+	auto advise(AccessPattern pattern) const -> void;
+
+private:
+
+	MappedFile() = default;
+
+	const void* data_{};
+	std::size_t size_{0};
+
+#ifdef _WIN32
+	void* mapping_{};
+#endif
+};
+
+}}
@@ -0,0 +1,182 @@
+#include "mp3_length.h"
+#include <vector>
+#include "read/mpeg_header.h"
+
+namespace blahdio {
+namespace read {
+namespace mp3 {
+
+static constexpr std::size_t HEAD_SIZE = 4096;
+
+static constexpr std::uint32_t XING_FLAG_FRAMES = 0x1;
+static constexpr std::uint32_t XING_FLAG_BYTES = 0x2;
+static constexpr std::uint32_t XING_FLAG_TOC = 0x4;
+static constexpr std::uint32_t XING_FLAG_QUALITY = 0x8;
+
+// Offset of the VBRI tag from the start of the frame
+static constexpr std::size_t VBRI_OFFSET = 4 + 32;
+
+[[nodiscard]] static
+auto byte(const std::byte* data, std::size_t index) -> std::uint32_t
+{
+	return std::to_integer<std::uint32_t>(data[index]);
+}
+
+[[nodiscard]] static
+auto read_u32_be(const std::byte* data) -> std::uint32_t
+{
+	return (byte(data, 0) << 24) | (byte(data, 1) << 16) | (byte(data, 2) << 8) | byte(data, 3);
+}
+
+[[nodiscard]] static
+auto matches(const std::byte* data, const char* magic) -> bool
+{
+	for (int i = 0; magic[i]; i++)
+	{
+		if (byte(data, i) != std::uint32_t((unsigned char)(magic[i]))) return false;
+	}
+
+	return true;
+}
+
+// The LAME tag follows the Xing fields. Encoders derived from LAME and
+// FFmpeg write the same layout.
+static
+auto read_lame_tag(const std::byte* data, std::size_t size, LengthInfo* info) -> void
+{
+	static constexpr std::size_t DELAY_OFFSET = 21;
+
+	if (size < DELAY_OFFSET + 3) return;
+
+	if (!matches(data, "LAME") && !matches(data, "Lavf") && !matches(data, "Lavc")) return;
+
+	const auto delay_padding{data + DELAY_OFFSET};
+
+	info->encoder_delay = (byte(delay_padding, 0) << 4) | (byte(delay_padding, 1) >> 4);
+	info->encoder_padding = ((byte(delay_padding, 1) & 0xF) << 8) | byte(delay_padding, 2);
+}
+
+[[nodiscard]] static
+auto read_xing_tag(const std::byte* frame, std::size_t size, const mpeg::FrameHeader& header) -> std::optional<LengthInfo>
+{
+	auto pos{std::size_t(header.side_info_end())};
+
+	if (pos + 8 > size) return std::nullopt;
+	if (!matches(frame + pos, "Xing") && !matches(frame + pos, "Info")) return std::nullopt;
+
+	const auto flags{read_u32_be(frame + pos + 4)};
+
+	pos += 8;
+
+	if (!(flags & XING_FLAG_FRAMES)) return std::nullopt;
+	if (pos + 4 > size) return std::nullopt;
+
+	LengthInfo out;
+
+	out.num_frames = std::uint64_t(read_u32_be(frame + pos)) * header.frame_length;
+	out.exact = true;
+
+	pos += 4;
+
+	if (flags & XING_FLAG_BYTES) pos += 4;
+	if (flags & XING_FLAG_TOC) pos += 100;
+	if (flags & XING_FLAG_QUALITY) pos += 4;
+
+	if (pos < size)
+	{
+		read_lame_tag(frame + pos, size - pos, &out);
+	}
+
+	// dr_mp3 skips the delay and drops the padding when it decodes
+	const auto trimmed{std::uint64_t(out.encoder_delay) + out.encoder_padding};
+
+	out.num_frames = out.num_frames > trimmed ? out.num_frames - trimmed : 0;
+
+	return out;
+}
+
+[[nodiscard]] static
+auto read_vbri_tag(const std::byte* frame, std::size_t size, const mpeg::FrameHeader& header) -> std::optional<LengthInfo>
+{
+	static constexpr std::size_t FRAMES_OFFSET = 14;
+
+	if (VBRI_OFFSET + FRAMES_OFFSET + 4 > size) return std::nullopt;
+	if (!matches(frame + VBRI_OFFSET, "VBRI")) return std::nullopt;
+
+	LengthInfo out;
+
+	out.num_frames = std::uint64_t(read_u32_be(frame + VBRI_OFFSET + FRAMES_OFFSET)) * header.frame_length;
+	out.exact = true;
+
+	return out;
+}
+
+[[nodiscard]] static
+auto has_id3v1_tag(const RawSource& source, std::uint64_t source_size) -> bool
+{
+	static constexpr std::uint64_t ID3V1_SIZE = 128;
+
+	if (source_size < ID3V1_SIZE) return false;
+
+	std::byte magic[3];
+
+	if (source.read_at(source_size - ID3V1_SIZE, magic, 3) != 3) return false;
+
+	return byte(magic, 0) == 'T' && byte(magic, 1) == 'A' && byte(magic, 2) == 'G';
+}
+
+auto read_length_info(const RawSource& source) -> std::optional<LengthInfo>
+{
+	if (!source) return std::nullopt;
+
+	std::vector<std::byte> buffer(HEAD_SIZE);
+
+	auto size{source.read_at(0, buffer.data(), buffer.size())};
+
+	const auto id3_size{mpeg::id3v2_tag_size(buffer.data(), size)};
+
+	if (id3_size > 0)
+	{
+		size = source.read_at(id3_size, buffer.data(), buffer.size());
+	}
+
+	const auto frame_offset{mpeg::find_first_frame(buffer.data(), size, size < buffer.size())};
+
+	if (!frame_offset) return std::nullopt;
+
+	const auto frame{buffer.data() + *frame_offset};
+	const auto frame_size{size - *frame_offset};
+	const auto header{mpeg::parse_frame_header(frame, frame_size)};
+
+	if (const auto xing{read_xing_tag(frame, frame_size, *header)})
+	{
+		return xing;
+	}
+
+	if (const auto vbri{read_vbri_tag(frame, frame_size, *header)})
+	{
+		return vbri;
+	}
+
+	// No tag, so assume the whole stream has the bitrate of the first
+	// frame
+	const auto source_size{source.size()};
+
+	if (!source_size) return std::nullopt;
+
+	const auto audio_start{std::uint64_t(id3_size) + *frame_offset};
+	const auto audio_end{*source_size - (has_id3v1_tag(source, *source_size) ? 128 : 0)};
+
+	if (audio_end <= audio_start) return std::nullopt;
+
+	const auto audio_bytes{audio_end - audio_start};
+	const auto seconds{double(audio_bytes) * 8.0 / header->bitrate};
+
+	LengthInfo out;
+
+	out.num_frames = std::uint64_t(seconds * header->sample_rate);
+
+	return out;
+}
+
+}}}
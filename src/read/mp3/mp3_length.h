@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include "read/raw_source.h"
+
+namespace blahdio {
+namespace read {
+namespace mp3 {
+
+struct LengthInfo
+{
+	// Not counting the encoder delay and padding, which dr_mp3 leaves out
+	std::uint64_t num_frames{0};
+	std::uint32_t encoder_delay{0};
+	std::uint32_t encoder_padding{0};
+
+	// False if num_frames is only an estimate
+	bool exact{false};
+};
+
+// Works out the length of the stream without decoding it, using the
+// Xing/Info or VBRI tag in the first frame if there is one, which gives
+// the exact length, otherwise by assuming a constant bitrate. Returns
+// nothing if there is no tag and the size of the source isn't known.
+[[nodiscard]] extern auto read_length_info(const RawSource& source) -> std::optional<LengthInfo>;
+
+}}}
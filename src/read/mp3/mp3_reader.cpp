@@ -1,8 +1,12 @@
+#include <algorithm>
 #include <cassert>
 #include <optional>
 #include <format>
 #include "mp3_reader.h"
+#include "mp3_length.h"
+#include "read/format_reader.h"
 #include "mackron/blahdio_dr_libs.h"
+#include "counters.h"
 
 namespace blahdio {
 namespace read {
@@ -19,6 +23,7 @@ struct MP3
 	{
 		mp3_ = std::move(rhs.mp3_);
 		header_ = rhs.header_;
+		seek_points_ = std::move(rhs.seek_points_);
 		return *this;
 	}
 
@@ -34,8 +39,52 @@ struct MP3
 	operator drmp3*() { return mp3_.get(); }
 	auto get_header_info() const { return header_; }
 
+	// Scans the whole stream. The read position is left where it was.
+	[[nodiscard]]
+	auto calculate_seek_index() -> std::optional<SeekIndex>
+	{
+		auto num_points{get_seek_point_count(header_)};
+
+		std::vector<drmp3_seek_point> points(num_points);
+
+		if (!drmp3_calculate_seek_points(mp3_.get(), &num_points, points.data()))
+		{
+			return std::nullopt;
+		}
+
+		SeekIndex out;
+
+		out.type = AudioType::mp3;
+		out.points.resize(num_points);
+
+		for (drmp3_uint32 i = 0; i < num_points; i++)
+		{
+			out.points[i].frame = points[i].pcmFrameIndex;
+			out.points[i].byte_offset = points[i].seekPosInBytes;
+			out.points[i].mp3_frames_to_discard = points[i].mp3FramesToDiscard;
+			out.points[i].frames_to_discard = points[i].pcmFramesToDiscard;
+		}
+
+		return out;
+	}
+
+	auto bind_seek_table(const SeekIndex& index) -> bool
+	{
+		seek_points_.resize(index.points.size());
+
+		for (std::size_t i = 0; i < index.points.size(); i++)
+		{
+			seek_points_[i].pcmFrameIndex = index.points[i].frame;
+			seek_points_[i].seekPosInBytes = index.points[i].byte_offset;
+			seek_points_[i].mp3FramesToDiscard = index.points[i].mp3_frames_to_discard;
+			seek_points_[i].pcmFramesToDiscard = index.points[i].frames_to_discard;
+		}
+
+		return drmp3_bind_seek_table(mp3_.get(), drmp3_uint32(seek_points_.size()), seek_points_.data());
+	}
+
 	[[nodiscard]] static
-	auto file(std::string_view utf8_path) -> expected<MP3>
+	auto file(std::string_view utf8_path, std::optional<LengthInfo> length) -> expected<MP3>
 	{
 		auto mp3{std::make_unique<drmp3>()};
 
@@ -44,11 +93,11 @@ struct MP3
 			return tl::make_unexpected(std::format("Failed to open MP3 decoder for file: '{}'", utf8_path));
 		}
 
-		return MP3{std::move(mp3)};
+		return MP3{std::move(mp3), length};
 	}
 
 	[[nodiscard]] static
-	auto memory(const void* data, size_t data_size) -> expected<MP3>
+	auto memory(const void* data, size_t data_size, std::optional<LengthInfo> length) -> expected<MP3>
 	{
 		auto mp3{std::make_unique<drmp3>()};
 
@@ -57,11 +106,11 @@ struct MP3
 			return tl::make_unexpected("Failed to open MP3 decoder for memory");
 		}
 
-		return MP3{std::move(mp3)};
+		return MP3{std::move(mp3), length};
 	}
 
 	[[nodiscard]] static
-	auto stream(drmp3_read_proc on_read, drmp3_seek_proc on_seek, void* user_data) -> expected<MP3>
+	auto stream(drmp3_read_proc on_read, drmp3_seek_proc on_seek, void* user_data, std::optional<LengthInfo> length) -> expected<MP3>
 	{
 		auto mp3{std::make_unique<drmp3>()};
 
@@ -70,15 +119,19 @@ struct MP3
 			return tl::make_unexpected("Failed to open MP3 decoder for stream");
 		}
 		
-		return MP3{std::move(mp3)};
+		return MP3{std::move(mp3), length};
 	}
 
 private:
 
-	MP3(std::unique_ptr<drmp3> mp3) : mp3_{std::move(mp3)}, header_{get_header_info(mp3_.get())} {}
+	MP3(std::unique_ptr<drmp3> mp3, std::optional<LengthInfo> length) : mp3_{std::move(mp3)}, header_{get_header_info(mp3_.get(), length)} {}
 
+	// drmp3_get_pcm_frame_count() would decode every frame of an untagged
+	// stream, so the length comes from the tags instead. Without a tag it
+	// is only estimated from the bitrate, or left for read_frames() to
+	// work out.
 	[[nodiscard]] static
-	auto get_header_info(drmp3* mp3) -> AudioDataFormat
+	auto get_header_info(drmp3* mp3, std::optional<LengthInfo> length) -> AudioDataFormat
 	{
 		assert (mp3);
 
@@ -86,37 +139,76 @@ private:
 
 		out.frame_size = sizeof(float);
 		out.num_channels = mp3->channels;
-		out.num_frames = drmp3_get_pcm_frame_count(mp3);
 		out.sample_rate = mp3->sampleRate;
 		out.bit_depth = 32;
+		out.num_frames_exact = false;
+
+		if (length)
+		{
+			out.num_frames = length->num_frames;
+			out.num_frames_exact = length->exact;
+			out.encoder_delay = length->encoder_delay;
+			out.encoder_padding = length->encoder_padding;
+		}
 
 		return out;
 	}
 
+	// Roughly four seek points per second, which keeps the amount of
+	// decoding after a seek small
+	[[nodiscard]] static
+	auto get_seek_point_count(const AudioDataFormat& header) -> drmp3_uint32
+	{
+		static constexpr std::uint64_t MAX_SEEK_POINTS = 16384;
+		static constexpr int POINTS_PER_SECOND = 4;
+
+		if (header.num_frames == 0 || header.sample_rate < POINTS_PER_SECOND)
+		{
+			return drmp3_uint32(MAX_SEEK_POINTS);
+		}
+
+		const auto frames_per_point{std::uint64_t(header.sample_rate / POINTS_PER_SECOND)};
+
+		return drmp3_uint32(std::clamp(header.num_frames / frames_per_point, std::uint64_t(1), MAX_SEEK_POINTS));
+	}
+
 	std::unique_ptr<drmp3> mp3_{};
 	AudioDataFormat header_{};
+
+	// dr_mp3 doesn't copy the seek table so it lives here
+	std::vector<drmp3_seek_point> seek_points_;
 };
 
-static
-auto read_frame_data(drmp3* mp3, AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> expected<void>
+[[nodiscard]] static
+auto make_format_reader(drmp3* mp3, OutputFormat output_format) -> FormatReader
 {
-	const auto read_func = [mp3](float* buffer, uint32_t read_size)
+	FormatReader::NativeReaders native_readers;
+
+	native_readers.f32 = [mp3](void* buffer, uint32_t read_size)
+	{
+		return uint32_t(drmp3_read_pcm_frames_f32(mp3, read_size, (float*)(buffer)));
+	};
+
+	native_readers.s16 = [mp3](void* buffer, uint32_t read_size)
 	{
-		return uint32_t(drmp3_read_pcm_frames_f32(mp3, read_size, buffer));
+		return uint32_t(drmp3_read_pcm_frames_s16(mp3, read_size, (drmp3_int16*)(buffer)));
 	};
 
-	return dr_libs::generic_frame_reader_loop(callbacks, read_func, chunk_size, format.num_channels, format.num_frames);
+	return FormatReader{native_readers, int(mp3->channels), output_format};
 }
 
 static
-auto read_stream_data(drmp3* mp3, AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> void
+auto read_frame_data(drmp3* mp3, AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size, OutputFormat output_format) -> expected<void>
 {
-	const auto read_func = [mp3](float* buffer, uint32_t read_size)
+	auto reader{make_format_reader(mp3, output_format)};
+
+	if (!format.num_frames_exact)
 	{
-		return uint32_t(drmp3_read_pcm_frames_f32(mp3, read_size, buffer));
-	};
+		dr_libs::generic_stream_reader_loop(callbacks, &reader, chunk_size);
+		return {};
+	}
 
-	dr_libs::generic_stream_reader_loop(callbacks, read_func, chunk_size, format.num_channels);
+	return dr_libs::generic_frame_reader_loop(callbacks, &reader, chunk_size, format.num_frames);
 }
 
 [[nodiscard]] static
@@ -133,8 +225,11 @@ static
 auto drmp3_stream_read(void* user_data, void* buffer, size_t bytes_to_read) -> size_t
 {
 	const auto stream = (AudioReader::Stream*)(user_data);
+	const auto bytes_read = stream->read_bytes(buffer, uint32_t(bytes_to_read));
 
-	return stream->read_bytes(buffer, uint32_t(bytes_to_read));
+	stats::add(stats::Counter::bytes, bytes_read);
+
+	return bytes_read;
 }
 
 static
@@ -152,27 +247,40 @@ struct MP3Handler
 	MP3Handler(OpenFn open_fn) : open_fn_{open_fn} {}
 
 	auto type() const -> AudioType { return AudioType::mp3; }
+	auto zero_copy() const -> AudioReader::ZeroCopy { return AudioReader::ZeroCopy::unavailable; }
 
 	[[nodiscard]]
-	auto try_read_header() -> expected<AudioDataFormat>
+	auto try_read_header(bool keep_decoder) -> expected<AudioDataFormat>
 	{
-		const auto get_header_info = [=](MP3&& mp3) -> expected<AudioDataFormat>
+		if (header_decoder_)
 		{
-			return mp3.get_header_info();
+			return header_decoder_->get_header_info();
+		}
+
+		const auto get_header_info = [this, keep_decoder](MP3&& mp3) -> expected<AudioDataFormat>
+		{
+			const auto header{mp3.get_header_info()};
+
+			if (keep_decoder)
+			{
+				header_decoder_ = std::move(mp3);
+			}
+
+			return header;
 		};
 
 		return open_fn_().and_then(get_header_info);
 	}
 
 	[[nodiscard]]
-	auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> expected<void>
+	auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size, typed::ReadOptions options) -> expected<void>
 	{
 		const auto read_frames = [=](MP3&& mp3)
 		{
-			return read_frame_data(mp3, callbacks, format, chunk_size);
+			return read_frame_data(mp3, callbacks, format, chunk_size, options.output_format);
 		};
 
-		return open_fn_().and_then(read_frames);
+		return open_decoder().and_then(read_frames);
 	}
 
 	[[nodiscard]]
@@ -183,20 +291,31 @@ struct MP3Handler
 			return tl::make_unexpected("Failed to read frames from the MP3 stream (The stream is not open)");
 		}
 
-		return uint32_t(drmp3_read_pcm_frames_f32(*stream_, uint64_t(frames_to_read), (float*)(buffer)));
+		return stream_reader_->read(buffer, frames_to_read);
 	}
 
 	[[nodiscard]]
-	auto stream_open() -> expected<AudioDataFormat>
+	auto stream_read_planar(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>
+	{
+		if (!stream_)
+		{
+			return tl::make_unexpected("Failed to read frames from the MP3 stream (The stream is not open)");
+		}
+
+		return stream_reader_->read_planar(channels, frames_to_read);
+	}
+
+	[[nodiscard]]
+	auto stream_open(OutputFormat output_format) -> expected<AudioDataFormat>
 	{
 		if (stream_)
 		{
 			return tl::make_unexpected("Failed to open MP3 stream (It is already open)");
 		}
 
-		const auto open_stream = [=]() -> expected<void>
+		const auto open_stream = [=, this]() -> expected<void>
 		{
-			auto result{open_fn_()};
+			auto result{open_decoder()};
 
 			if (!result)
 			{
@@ -204,6 +323,26 @@ struct MP3Handler
 			}
 
 			stream_ = std::move(*result);
+			stream_reader_.emplace(make_format_reader(*stream_, output_format));
+			return {};
+		};
+
+		// Without a seek table dr_mp3 has to decode from the start of the
+		// stream to reach the target frame, so build one now (or use the
+		// one we were given.) If that fails seeking still works, just
+		// slowly.
+		const auto bind_seek_table = [=, this]() -> expected<void>
+		{
+			if (!seek_index_)
+			{
+				seek_index_ = stream_->calculate_seek_index();
+			}
+
+			if (seek_index_)
+			{
+				stream_->bind_seek_table(*seek_index_);
+			}
+
 			return {};
 		};
 
@@ -212,25 +351,22 @@ struct MP3Handler
 			return stream_->get_header_info();
 		};
 
-		return open_stream().and_then(get_header_info);
+		return open_stream().and_then(bind_seek_table).and_then(get_header_info);
 	}
 
 	[[nodiscard]]
-	auto stream_seek(uint64_t target_frame) -> expected<void>
+	auto stream_seek(uint64_t target_frame) -> bool
 	{
-		if (!stream_)
-		{
-			return tl::make_unexpected("Failed to seek the MP3 stream (The stream is not open)");
-		}
+		if (!stream_) return false;
 
-		const auto result{drmp3_seek_to_pcm_frame(*stream_, target_frame)};
+		return drmp3_seek_to_pcm_frame(*stream_, target_frame);
+	}
 
-		if (!result)
-		{
-			return tl::make_unexpected("Failed to seek the MP3 stream for some reason");
-		}
+	auto stream_reserve(uint32_t max_frames_per_read) -> void
+	{
+		if (!stream_reader_) return;
 
-		return {};
+		stream_reader_->reserve(max_frames_per_read);
 	}
 
 	[[nodiscard]]
@@ -241,41 +377,95 @@ struct MP3Handler
 			return tl::make_unexpected("Failed to close MP3 stream (The stream is not open)");
 		}
 
+		stream_reader_ = std::nullopt;
 		stream_ = std::nullopt;
 		return {};
 	}
 
+	// Frame accurate seeking means decoding from the start (or from the
+	// nearest point in the seek table) so it isn't worth it
+	[[nodiscard]]
+	auto open_cursor(OutputFormat) -> expected<Cursor>
+	{
+		return tl::make_unexpected("Failed to open MP3 cursor (Not supported)");
+	}
+
+	// The seek index is built when the stream is opened
+	auto build_seek_index() -> void {}
+
+	[[nodiscard]]
+	auto set_seek_index(SeekIndex index) -> expected<void>
+	{
+		seek_index_ = std::move(index);
+		return {};
+	}
+
+	[[nodiscard]]
+	auto get_seek_index() const -> expected<SeekIndex>
+	{
+		if (!seek_index_)
+		{
+			return tl::make_unexpected("There is no seek index for the MP3 data yet (One is built when a streamer is opened)");
+		}
+
+		return *seek_index_;
+	}
+
 private:
 
+	// Hands over the decoder which was kept open by try_read_header(), or
+	// opens a new one if there isn't one
+	[[nodiscard]]
+	auto open_decoder() -> expected<MP3>
+	{
+		if (header_decoder_)
+		{
+			auto decoder{std::move(*header_decoder_)};
+
+			header_decoder_ = std::nullopt;
+
+			return decoder;
+		}
+
+		return open_fn_();
+	}
+
 	OpenFn open_fn_;
+	std::optional<MP3> header_decoder_;
 	std::optional<MP3> stream_;
+	std::optional<FormatReader> stream_reader_;
+	std::optional<SeekIndex> seek_index_;
 };
 
-auto make_handler(std::string utf8_path) -> typed::Handler
+auto make_handler(std::string utf8_path, RawSource raw_source) -> typed::Handler
 {
-	auto open_fn = [utf8_path]
+	auto open_fn = [utf8_path, raw_source]
 	{
-		return MP3::file(utf8_path);
+		return MP3::file(utf8_path, read_length_info(raw_source));
 	};
 
 	return MP3Handler{open_fn};
 }
 
-auto make_handler(const AudioReader::Stream& stream) -> typed::Handler
+auto make_handler(const AudioReader::Stream& stream, RawSource raw_source) -> typed::Handler
 {
-	auto open_fn = [&stream]
+	auto open_fn = [&stream, raw_source]
 	{
-		return MP3::stream(drmp3_stream_read, drmp3_stream_seek, (void*)(&stream));
+		// The stream is rewound after reading the tags, so this has to
+		// happen before the decoder starts reading it
+		auto length{read_length_info(raw_source)};
+
+		return MP3::stream(drmp3_stream_read, drmp3_stream_seek, (void*)(&stream), length);
 	};
 
 	return MP3Handler{open_fn};
 }
 
-auto make_handler(const void* data, std::size_t data_size) -> typed::Handler
+auto make_handler(const void* data, std::size_t data_size, RawSource raw_source) -> typed::Handler
 {
-	auto open_fn = [data, data_size]
+	auto open_fn = [data, data_size, raw_source]
 	{
-		return MP3::memory(data, data_size);
+		return MP3::memory(data, data_size, read_length_info(raw_source));
 	};
 
 	return MP3Handler{open_fn};
@@ -287,8 +477,8 @@ auto make_attempt_order(typed::Handlers* handlers) -> std::vector<typed::Handler
 
 	out.push_back(&handlers->mp3);
 
-#	if BLAHDIO_ENABLE_MP3
-		out.push_back(&handlers->mp3);
+#	if BLAHDIO_ENABLE_WAV
+		out.push_back(&handlers->wav);
 #	endif
 
 #	if BLAHDIO_ENABLE_FLAC
@@ -6,9 +6,9 @@ namespace blahdio {
 namespace read {
 namespace mp3 {
 
-extern auto make_handler(std::string utf8_path) -> typed::Handler;
-extern auto make_handler(const AudioReader::Stream& stream) -> typed::Handler;
-extern auto make_handler(const void* data, std::size_t data_size) -> typed::Handler;
+extern auto make_handler(std::string utf8_path, RawSource raw_source) -> typed::Handler;
+extern auto make_handler(const AudioReader::Stream& stream, RawSource raw_source) -> typed::Handler;
+extern auto make_handler(const void* data, std::size_t data_size, RawSource raw_source) -> typed::Handler;
 extern auto make_attempt_order(typed::Handlers* handlers) -> std::vector<typed::Handler*>;
 
 }}}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "mpeg_header.h"
+
+namespace blahdio {
+namespace read {
+namespace mpeg {
+
+// kbps, indexed by [version is mpeg1 ? 0 : 1][layer - 1][index]
+static constexpr int BITRATES[2][3][16] =
+{
+	{
+		{ 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 },
+		{ 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 0 },
+		{ 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 },
+	},
+	{
+		{ 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0 },
+		{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+		{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+	},
+};
+
+static constexpr int SAMPLE_RATES[3] = { 44100, 48000, 32000 };
+
+static auto byte(const std::byte* data, std::size_t index) -> std::uint32_t
+{
+	return std::to_integer<std::uint32_t>(data[index]);
+}
+
+auto FrameHeader::side_info_end() const -> int
+{
+	const auto crc_size{has_crc ? 2 : 0};
+
+	if (version == Version::mpeg1)
+	{
+		return 4 + crc_size + (num_channels == 1 ? 17 : 32);
+	}
+
+	return 4 + crc_size + (num_channels == 1 ? 9 : 17);
+}
+
+auto id3v2_tag_size(const std::byte* data, std::size_t size) -> std::size_t
+{
+	if (size < 10) return 0;
+	if (byte(data, 0) != 'I' || byte(data, 1) != 'D' || byte(data, 2) != '3') return 0;
+
+	const auto flags{byte(data, 5)};
+	const auto footer_size{(flags & 0x10) ? 10 : 0};
+
+	// Syncsafe integer (7 bits per byte)
+	const auto tag_size =
+		((byte(data, 6) & 0x7F) << 21) |
+		((byte(data, 7) & 0x7F) << 14) |
+		((byte(data, 8) & 0x7F) << 7) |
+		((byte(data, 9) & 0x7F));
+
+	return 10 + std::size_t(tag_size) + footer_size;
+}
+
+auto parse_frame_header(const std::byte* data, std::size_t size) -> std::optional<FrameHeader>
+{
+	if (size < 4) return std::nullopt;
+
+	const auto b0{byte(data, 0)};
+	const auto b1{byte(data, 1)};
+	const auto b2{byte(data, 2)};
+	const auto b3{byte(data, 3)};
+
+	if (b0 != 0xFF || (b1 & 0xE0) != 0xE0) return std::nullopt;
+
+	const auto version_bits{(b1 >> 3) & 0x3};
+	const auto layer_bits{(b1 >> 1) & 0x3};
+	const auto bitrate_index{(b2 >> 4) & 0xF};
+	const auto sample_rate_index{(b2 >> 2) & 0x3};
+	const auto padding{int((b2 >> 1) & 0x1)};
+	const auto channel_mode{(b3 >> 6) & 0x3};
+
+	if (version_bits == 1 || layer_bits == 0) return std::nullopt;
+
+	// Free format streams are not supported
+	if (bitrate_index == 0 || bitrate_index == 15) return std::nullopt;
+	if (sample_rate_index == 3) return std::nullopt;
+
+	FrameHeader out;
+
+	switch (version_bits)
+	{
+		case 0: out.version = FrameHeader::Version::mpeg2_5; break;
+		case 2: out.version = FrameHeader::Version::mpeg2; break;
+		case 3: default: out.version = FrameHeader::Version::mpeg1; break;
+	}
+
+	const auto is_mpeg1{out.version == FrameHeader::Version::mpeg1};
+
+	out.layer = 4 - int(layer_bits);
+	out.bitrate = BITRATES[is_mpeg1 ? 0 : 1][out.layer - 1][bitrate_index] * 1000;
+	out.sample_rate = SAMPLE_RATES[sample_rate_index];
+
+	switch (out.version)
+	{
+		case FrameHeader::Version::mpeg2: out.sample_rate /= 2; break;
+		case FrameHeader::Version::mpeg2_5: out.sample_rate /= 4; break;
+		default: break;
+	}
+
+	out.num_channels = channel_mode == 3 ? 1 : 2;
+	out.has_crc = (b1 & 0x1) == 0;
+
+	switch (out.layer)
+	{
+		case 1:
+		{
+			out.frame_length = 384;
+			out.frame_size = ((12 * out.bitrate / out.sample_rate) + padding) * 4;
+			break;
+		}
+
+		case 2:
+		{
+			out.frame_length = 1152;
+			out.frame_size = (144 * out.bitrate / out.sample_rate) + padding;
+			break;
+		}
+
+		case 3: default:
+		{
+			out.frame_length = is_mpeg1 ? 1152 : 576;
+			out.frame_size = ((is_mpeg1 ? 144 : 72) * out.bitrate / out.sample_rate) + padding;
+			break;
+		}
+	}
+
+	return out;
+}
+
+auto find_first_frame(const std::byte* data, std::size_t size, bool data_ends) -> std::optional<std::size_t>
+{
+	for (std::size_t offset = 0; offset + 4 <= size; offset++)
+	{
+		const auto header{parse_frame_header(data + offset, size - offset)};
+
+		if (!header) continue;
+
+		const auto next_offset{offset + std::size_t(header->frame_size)};
+
+		if (next_offset + 4 > size)
+		{
+			if (data_ends) return offset;
+
+			continue;
+		}
+
+		const auto next_header{parse_frame_header(data + next_offset, size - next_offset)};
+
+		if (next_header && next_header->version == header->version && next_header->layer == header->layer && next_header->sample_rate == header->sample_rate)
+		{
+			return offset;
+		}
+	}
+
+	return std::nullopt;
+}
+
+}}}
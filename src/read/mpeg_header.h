@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace blahdio {
+namespace read {
+namespace mpeg {
+
+struct FrameHeader
+{
+	enum class Version { mpeg1, mpeg2, mpeg2_5 };
+
+	Version version;
+	int layer;
+	int bitrate;        // bits per second
+	int sample_rate;
+	int num_channels;
+	int frame_size;     // bytes, including the header
+	int frame_length;   // PCM frames decoded from this frame
+	bool has_crc;
+
+	// Offset of the Xing/Info tag from the start of the frame, which is
+	// just after the side information
+	[[nodiscard]] auto side_info_end() const -> int;
+};
+
+// Size of the ID3v2 tag at the start of the data including the header
+// and footer, or 0 if there isn't one.
+[[nodiscard]] extern auto id3v2_tag_size(const std::byte* data, std::size_t size) -> std::size_t;
+
+[[nodiscard]] extern auto parse_frame_header(const std::byte* data, std::size_t size) -> std::optional<FrameHeader>;
+
+// Looks for two consecutive valid frame headers and returns the offset
+// of the first. A single header whose frame runs past the end of the
+// data is only accepted if data_ends is set, i.e. the data is the whole
+// source rather than a window onto the start of it, otherwise a chance
+// sync near the end of a window of junk would be taken for a frame.
+[[nodiscard]] extern auto find_first_frame(const std::byte* data, std::size_t size, bool data_ends) -> std::optional<std::size_t>;
+
+}}}
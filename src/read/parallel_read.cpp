@@ -0,0 +1,294 @@
+#include "parallel_read.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "convert/planar_buffer.h"
+#include "convert/sample_format.h"
+#include "counters.h"
+#include "trace.h"
+
+namespace blahdio {
+namespace read {
+
+namespace {
+
+struct Slot
+{
+	enum class State { free, decoding, ready };
+
+	State state{State::free};
+	std::uint64_t segment{};
+	std::uint64_t frames_read{};
+	std::vector<std::byte> frames;
+};
+
+class ParallelRead
+{
+public:
+
+	ParallelRead(std::vector<Cursor> cursors, AudioReader::Callbacks callbacks, std::uint64_t num_frames, int num_channels, std::uint32_t chunk_size, ParallelReadOptions options)
+		: cursors_{std::move(cursors)}
+		, callbacks_{callbacks}
+		, num_frames_{num_frames}
+		, num_channels_{num_channels}
+		, chunk_size_{chunk_size}
+		, in_order_{options.in_order}
+		, output_format_{cursors_.front().reader.get_format()}
+		, frame_bytes_{cursors_.front().reader.get_frame_bytes()}
+		, counters_{stats::current()}
+	{
+		// Segments start on chunk boundaries so the chunks are the same
+		// as they would be when reading sequentially
+		const auto chunks_per_segment{std::max<std::uint64_t>(1, (options.segment_size + chunk_size - 1) / chunk_size)};
+
+		segment_size_ = chunks_per_segment * chunk_size;
+		num_segments_ = (num_frames + segment_size_ - 1) / segment_size_;
+
+		// Enough slots to keep every thread busy while the oldest
+		// segments are waiting to be returned
+		slots_.resize(cursors_.size() * 2);
+	}
+
+	~ParallelRead()
+	{
+		stop();
+
+		for (auto& thread : threads_)
+		{
+			thread.join();
+		}
+	}
+
+	auto run() -> expected<void>
+	{
+		for (auto& cursor : cursors_)
+		{
+			threads_.emplace_back([this, &cursor]() { decode_segments(&cursor); });
+		}
+
+		return return_segments();
+	}
+
+private:
+
+	auto stop() -> void
+	{
+		{
+			std::lock_guard lock{mutex_};
+			stop_ = true;
+		}
+
+		cv_.notify_all();
+	}
+
+	auto get_segment_frames(std::uint64_t segment) const -> std::uint64_t
+	{
+		return std::min(segment_size_, num_frames_ - (segment * segment_size_));
+	}
+
+	static auto seek(Cursor* cursor, std::uint64_t frame) -> bool
+	{
+		BLAHDIO_TRACE_ZONE("blahdio::seek");
+
+		return cursor->seek(frame);
+	}
+
+	// Runs on each worker thread
+	auto decode_segments(Cursor* cursor) -> void
+	{
+		stats::Scope stats_scope{counters_};
+
+		for (;;)
+		{
+			std::uint64_t segment;
+			Slot* slot;
+
+			{
+				std::unique_lock lock{mutex_};
+
+				const auto can_continue = [this]()
+				{
+					return stop_ || next_segment_ >= num_segments_ || slots_[next_segment_ % slots_.size()].state == Slot::State::free;
+				};
+
+				cv_.wait(lock, can_continue);
+
+				if (stop_ || next_segment_ >= num_segments_) return;
+
+				segment = next_segment_++;
+				slot = &slots_[segment % slots_.size()];
+				slot->state = Slot::State::decoding;
+				slot->segment = segment;
+			}
+
+			const auto segment_frames{get_segment_frames(segment)};
+
+			std::uint64_t frames_read{0};
+
+			stats::resize(&slot->frames, segment_frames * frame_bytes_);
+
+			if (seek(cursor, segment * segment_size_))
+			{
+				frames_read = cursor->reader.read(slot->frames.data(), std::uint32_t(segment_frames));
+			}
+
+			{
+				std::lock_guard lock{mutex_};
+
+				slot->frames_read = frames_read;
+				slot->state = Slot::State::ready;
+			}
+
+			cv_.notify_all();
+		}
+	}
+
+	// Runs on the calling thread
+	auto return_segments() -> expected<void>
+	{
+		std::uint64_t next_segment_to_return{0};
+
+		for (std::uint64_t num_returned = 0; num_returned < num_segments_; num_returned++)
+		{
+			Slot* slot{};
+
+			const auto find_ready_slot = [&]()
+			{
+				if (in_order_)
+				{
+					auto& next{slots_[next_segment_to_return % slots_.size()]};
+
+					if (next.state == Slot::State::ready && next.segment == next_segment_to_return)
+					{
+						slot = &next;
+					}
+
+					return slot != nullptr;
+				}
+
+				for (auto& candidate : slots_)
+				{
+					if (candidate.state == Slot::State::ready)
+					{
+						slot = &candidate;
+						return true;
+					}
+				}
+
+				return false;
+			};
+
+			{
+				std::unique_lock lock{mutex_};
+
+				cv_.wait(lock, find_ready_slot);
+			}
+
+			next_segment_to_return++;
+
+			const auto segment_frames{get_segment_frames(slot->segment)};
+			const auto aborted{!return_chunks(*slot)};
+			const auto short_read{slot->frames_read < segment_frames};
+
+			{
+				std::lock_guard lock{mutex_};
+
+				slot->state = Slot::State::free;
+			}
+
+			cv_.notify_all();
+
+			if (aborted) break;
+
+			if (short_read)
+			{
+				return tl::make_unexpected("Read error");
+			}
+		}
+
+		return {};
+	}
+
+	// Returns false if the read was aborted
+	auto return_chunks(const Slot& slot) -> bool
+	{
+		const auto first_frame{slot.segment * segment_size_};
+
+		for (std::uint64_t offset = 0; offset < slot.frames_read; offset += chunk_size_)
+		{
+			if (callbacks_.should_abort()) return false;
+
+			const auto num_frames{std::uint32_t(std::min<std::uint64_t>(chunk_size_, slot.frames_read - offset))};
+			const auto data{slot.frames.data() + (offset * frame_bytes_)};
+
+			if (output_format_.planar)
+			{
+				planar_chunk_.resize(num_channels_, convert::get_sample_size(output_format_.sample_format) * num_frames);
+
+				{
+					BLAHDIO_TRACE_ZONE("blahdio::convert");
+					stats::Timer timer{stats::Counter::convert_ns};
+
+					convert::deinterleave_samples(data, output_format_.sample_format, planar_chunk_.channels(), output_format_.sample_format, num_channels_, num_frames);
+				}
+
+				callbacks_.return_planar_chunk(planar_chunk_.channels(), first_frame + offset, num_frames);
+			}
+			else
+			{
+				callbacks_.return_chunk((const void*)(data), first_frame + offset, num_frames);
+			}
+		}
+
+		return true;
+	}
+
+	std::vector<Cursor> cursors_;
+	AudioReader::Callbacks callbacks_;
+	std::uint64_t num_frames_;
+	int num_channels_;
+	std::uint32_t chunk_size_;
+	bool in_order_;
+	OutputFormat output_format_;
+	std::size_t frame_bytes_;
+
+	// The caller's, so the decoding done by the workers is charged to
+	// the reader
+	stats::Counters* counters_;
+
+	std::uint64_t segment_size_;
+	std::uint64_t num_segments_;
+
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::vector<Slot> slots_;
+	std::uint64_t next_segment_{0};
+	bool stop_{false};
+	std::vector<std::thread> threads_;
+
+	convert::PlanarBuffer planar_chunk_;
+};
+
+} // namespace
+
+auto read_frames_parallel(
+	std::vector<Cursor> cursors,
+	AudioReader::Callbacks callbacks,
+	std::uint64_t num_frames,
+	int num_channels,
+	std::uint32_t chunk_size,
+	ParallelReadOptions options) -> expected<void>
+{
+	if (cursors.empty())
+	{
+		return tl::make_unexpected("Failed to read frames in parallel (No cursors)");
+	}
+
+	ParallelRead read{std::move(cursors), callbacks, num_frames, num_channels, chunk_size, options};
+
+	return read.run();
+}
+
+}}
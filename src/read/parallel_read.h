@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "blahdio/audio_reader.h"
+#include "blahdio/expected.h"
+#include "cursor.h"
+
+namespace blahdio {
+namespace read {
+
+struct ParallelReadOptions
+{
+	// Return chunks in frame order. Otherwise each segment's chunks are
+	// returned as soon as it has been decoded.
+	bool in_order{true};
+
+	// Frames per segment, rounded up to a multiple of the chunk size
+	std::uint64_t segment_size{std::uint64_t(1) << 18};
+};
+
+// Splits the frames into segments and decodes them with one cursor per
+// thread. Chunks are still returned on the calling thread, and are the
+// same chunks a sequential read would return. All of the cursors must
+// have the same output format.
+[[nodiscard]] extern auto read_frames_parallel(
+	std::vector<Cursor> cursors,
+	AudioReader::Callbacks callbacks,
+	std::uint64_t num_frames,
+	int num_channels,
+	std::uint32_t chunk_size,
+	ParallelReadOptions options) -> expected<void>;
+
+}}
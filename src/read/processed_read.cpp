@@ -0,0 +1,387 @@
+#include "processed_read.h"
+#include <algorithm>
+#include "convert/planar_buffer.h"
+#include "convert/sample_format.h"
+#include "counters.h"
+#include "trace.h"
+
+namespace blahdio {
+namespace read {
+
+// Frames asked of the decoder at a time when pulling
+static constexpr std::uint32_t INPUT_CHUNK_FRAMES = 4096;
+
+[[nodiscard]] static
+auto get_output_channels(const OutputFormat& output_format, const AudioDataFormat& format) -> int
+{
+	return output_format.num_channels > 0 ? output_format.num_channels : format.num_channels;
+}
+
+[[nodiscard]] static
+auto needs_mixing(const OutputFormat& output_format, const AudioDataFormat& format) -> bool
+{
+	return !output_format.channel_mix.empty() || get_output_channels(output_format, format) != format.num_channels;
+}
+
+[[nodiscard]] static
+auto needs_resampling(const OutputFormat& output_format, const AudioDataFormat& format) -> bool
+{
+	return output_format.sample_rate > 0 && output_format.sample_rate != format.sample_rate;
+}
+
+auto needs_processing(const OutputFormat& output_format, const AudioDataFormat& format) -> bool
+{
+	return needs_mixing(output_format, format) || needs_resampling(output_format, format);
+}
+
+auto get_processing_decode_format() -> OutputFormat
+{
+	OutputFormat out;
+
+	out.sample_format = SampleFormat::f32;
+	out.planar = false;
+
+	return out;
+}
+
+auto Processor::make(const OutputFormat& output_format, const AudioDataFormat& format) -> expected<Processor>
+{
+	const auto in_channels{format.num_channels};
+	const auto out_channels{get_output_channels(output_format, format)};
+
+	if (in_channels < 1 || out_channels < 1)
+	{
+		return tl::make_unexpected("Failed to mix channels (No channels)");
+	}
+
+	std::optional<convert::ChannelMixer> mixer;
+
+	if (needs_mixing(output_format, format))
+	{
+		if (output_format.channel_mix.empty())
+		{
+			mixer.emplace(in_channels, out_channels, convert::make_default_channel_mix(in_channels, out_channels));
+		}
+		else if (output_format.channel_mix.size() == std::size_t(in_channels) * out_channels)
+		{
+			mixer.emplace(in_channels, out_channels, output_format.channel_mix);
+		}
+		else
+		{
+			return tl::make_unexpected("Failed to mix channels (The channel mix doesn't have a gain for each pair of source and output channels)");
+		}
+	}
+
+	const auto resampling{needs_resampling(output_format, format)};
+	const auto out_rate{resampling ? output_format.sample_rate : format.sample_rate};
+
+	// Mixing down happens first, so the resampler works on the output's
+	// channels
+	const auto resampler_channels{std::min(in_channels, out_channels)};
+
+	convert::Resampler resampler{resampler_channels, std::uint32_t(format.sample_rate), std::uint32_t(out_rate), output_format.resample_quality};
+
+	return Processor{in_channels, out_channels, std::move(mixer), std::move(resampler), resampling};
+}
+
+Processor::Processor(int in_channels, int out_channels, std::optional<convert::ChannelMixer> mixer, convert::Resampler resampler, bool resampling)
+	: in_channels_{in_channels}
+	, out_channels_{out_channels}
+	, mixer_{std::move(mixer)}
+	, resampler_{std::move(resampler)}
+	, resampling_{resampling}
+{
+}
+
+auto Processor::reset(std::uint64_t out_frame) -> std::uint64_t
+{
+	return resampler_.reset(out_frame);
+}
+
+auto Processor::get_input_frames(std::uint64_t out_frames) const -> std::uint64_t
+{
+	return resampler_.get_input_frames(out_frames);
+}
+
+auto Processor::reserve(std::uint32_t max_in_frames) -> void
+{
+	resampler_.reserve(max_in_frames);
+
+	// Enough for a whole read's worth of frames at either rate, plus
+	// whatever the resampler was holding back
+	const auto max_frames{std::max<std::uint64_t>(max_in_frames, resampler_.get_output_frames(max_in_frames)) + 4096};
+
+	scratch_.reserve(std::size_t(max_frames) * std::max(in_channels_, out_channels_));
+}
+
+auto Processor::mix(const float* in, std::uint32_t num_frames, std::vector<float>* out) const -> void
+{
+	const auto out_size{out->size()};
+
+	out->resize(out_size + (std::size_t(num_frames) * out_channels_));
+
+	mixer_->process(in, num_frames, out->data() + out_size);
+}
+
+auto Processor::process(const float* in, std::uint32_t in_frames, std::vector<float>* out) -> void
+{
+	BLAHDIO_TRACE_ZONE("blahdio::process");
+	stats::Timer timer{stats::Counter::convert_ns};
+
+	// Copies if the rates are the same
+	if (!mixer_)
+	{
+		resampler_.process(in, in_frames, out);
+		return;
+	}
+
+	if (!resampling_)
+	{
+		mix(in, in_frames, out);
+		return;
+	}
+
+	scratch_.clear();
+
+	if (out_channels_ < in_channels_)
+	{
+		mix(in, in_frames, &scratch_);
+		resampler_.process(scratch_.data(), in_frames, out);
+		return;
+	}
+
+	resampler_.process(in, in_frames, &scratch_);
+	mix(scratch_.data(), std::uint32_t(scratch_.size() / in_channels_), out);
+}
+
+auto Processor::flush(std::vector<float>* out) -> void
+{
+	if (!resampling_) return;
+
+	BLAHDIO_TRACE_ZONE("blahdio::process");
+	stats::Timer timer{stats::Counter::convert_ns};
+
+	if (!mixer_ || out_channels_ < in_channels_)
+	{
+		resampler_.flush(out);
+		return;
+	}
+
+	scratch_.clear();
+	resampler_.flush(&scratch_);
+	mix(scratch_.data(), std::uint32_t(scratch_.size() / in_channels_), out);
+}
+
+auto read_frames_processed(
+	ReadFramesFn read_frames,
+	AudioReader::Callbacks callbacks,
+	std::uint32_t chunk_size,
+	const OutputFormat& output_format,
+	const AudioDataFormat& format) -> expected<void>
+{
+	auto processor{Processor::make(output_format, format)};
+
+	if (!processor)
+	{
+		return tl::make_unexpected(processor.error());
+	}
+
+	const auto num_channels{processor->get_out_channels()};
+	const auto frame_samples{std::size_t(num_channels)};
+
+	std::vector<float> pending;
+	std::vector<std::byte> chunk;
+	convert::PlanarBuffer planar_chunk;
+	std::uint64_t out_frame{0};
+	bool aborted{false};
+
+	// Returns every full chunk, and the last partial one if final is set
+	const auto return_chunks = [&](bool final)
+	{
+		std::size_t offset{0};
+
+		for (;;)
+		{
+			const auto available{(pending.size() / frame_samples) - offset};
+			const auto num_frames{std::uint32_t(std::min<std::size_t>(available, chunk_size))};
+
+			if (num_frames == 0 || (num_frames < chunk_size && !final)) break;
+
+			const auto frames{pending.data() + (offset * frame_samples)};
+
+			if (output_format.planar)
+			{
+				planar_chunk.resize(num_channels, convert::get_sample_size(output_format.sample_format) * num_frames);
+
+				{
+					BLAHDIO_TRACE_ZONE("blahdio::convert");
+					stats::Timer timer{stats::Counter::convert_ns};
+
+					convert::deinterleave_samples(frames, SampleFormat::f32, planar_chunk.channels(), output_format.sample_format, num_channels, num_frames);
+				}
+
+				callbacks.return_planar_chunk(planar_chunk.channels(), out_frame, num_frames);
+			}
+			else
+			{
+				stats::resize(&chunk, convert::get_sample_size(output_format.sample_format) * frame_samples * num_frames);
+
+				{
+					BLAHDIO_TRACE_ZONE("blahdio::convert");
+					stats::Timer timer{stats::Counter::convert_ns};
+
+					convert::convert_samples(frames, SampleFormat::f32, chunk.data(), output_format.sample_format, frame_samples * num_frames);
+				}
+
+				callbacks.return_chunk((const void*)(chunk.data()), out_frame, num_frames);
+			}
+
+			offset += num_frames;
+			out_frame += num_frames;
+		}
+
+		pending.erase(pending.begin(), pending.begin() + (offset * frame_samples));
+	};
+
+	AudioReader::Callbacks decode_callbacks;
+
+	decode_callbacks.should_abort = [&]()
+	{
+		aborted = callbacks.should_abort();
+		return aborted;
+	};
+
+	decode_callbacks.return_chunk = [&](const void* data, std::uint64_t, std::uint32_t num_frames)
+	{
+		processor->process(static_cast<const float*>(data), num_frames, &pending);
+		return_chunks(false);
+	};
+
+	const auto result{read_frames(decode_callbacks, chunk_size, get_processing_decode_format())};
+
+	if (!result || aborted) return result;
+
+	processor->flush(&pending);
+	return_chunks(true);
+
+	return {};
+}
+
+ProcessedStream::ProcessedStream(Processor processor, SampleFormat sample_format, ReadFn read, SeekFn seek)
+	: processor_{std::move(processor)}
+	, sample_format_{sample_format}
+	, num_channels_{processor_.get_out_channels()}
+	, read_{std::move(read)}
+	, seek_{std::move(seek)}
+{
+}
+
+auto ProcessedStream::get_pending_frames() const -> std::size_t
+{
+	return (pending_.size() / num_channels_) - pending_start_;
+}
+
+auto ProcessedStream::reserve(std::uint32_t max_frames_per_read) -> void
+{
+	const auto max_input{std::max(INPUT_CHUNK_FRAMES, std::uint32_t(processor_.get_input_frames(max_frames_per_read)))};
+
+	processor_.reserve(max_input);
+	input_.reserve(std::size_t(max_input) * processor_.get_in_channels());
+
+	// Whatever was left over, plus a full read's worth, plus the flush
+	pending_.reserve((std::size_t(max_frames_per_read) * 2 + (std::size_t(max_input) * 2) + 4096) * num_channels_);
+}
+
+auto ProcessedStream::fill(std::uint32_t num_frames) -> expected<void>
+{
+	while (get_pending_frames() < num_frames && !ended_)
+	{
+		const auto frames_needed{processor_.get_input_frames(num_frames - get_pending_frames())};
+		const auto frames_to_read{std::uint32_t(std::clamp<std::uint64_t>(frames_needed, 1, INPUT_CHUNK_FRAMES))};
+
+		stats::resize(&input_, std::size_t(frames_to_read) * processor_.get_in_channels());
+
+		const auto frames_read{read_(input_.data(), frames_to_read)};
+
+		if (!frames_read)
+		{
+			return tl::make_unexpected(frames_read.error());
+		}
+
+		processor_.process(input_.data(), *frames_read, &pending_);
+
+		if (*frames_read < frames_to_read)
+		{
+			processor_.flush(&pending_);
+			ended_ = true;
+		}
+	}
+
+	return {};
+}
+
+auto ProcessedStream::consume(std::uint32_t num_frames) -> void
+{
+	pending_start_ += num_frames;
+
+	if (pending_start_ * num_channels_ >= pending_.size())
+	{
+		pending_.clear();
+		pending_start_ = 0;
+		return;
+	}
+
+	// Moved to the front now and then, rather than on every read
+	if (pending_start_ * num_channels_ * 2 > pending_.size())
+	{
+		pending_.erase(pending_.begin(), pending_.begin() + (pending_start_ * num_channels_));
+		pending_start_ = 0;
+	}
+}
+
+auto ProcessedStream::read(void* buffer, std::uint32_t frames_to_read) -> expected<std::uint32_t>
+{
+	if (const auto result{fill(frames_to_read)}; !result)
+	{
+		return tl::make_unexpected(result.error());
+	}
+
+	const auto num_frames{std::uint32_t(std::min<std::size_t>(frames_to_read, get_pending_frames()))};
+
+	BLAHDIO_TRACE_ZONE("blahdio::convert");
+	stats::Timer timer{stats::Counter::convert_ns};
+
+	convert::convert_samples(pending_.data() + (pending_start_ * num_channels_), SampleFormat::f32, buffer, sample_format_, std::size_t(num_frames) * num_channels_);
+	consume(num_frames);
+
+	return num_frames;
+}
+
+auto ProcessedStream::read_planar(void* const* channels, std::uint32_t frames_to_read) -> expected<std::uint32_t>
+{
+	if (const auto result{fill(frames_to_read)}; !result)
+	{
+		return tl::make_unexpected(result.error());
+	}
+
+	const auto num_frames{std::uint32_t(std::min<std::size_t>(frames_to_read, get_pending_frames()))};
+
+	BLAHDIO_TRACE_ZONE("blahdio::convert");
+	stats::Timer timer{stats::Counter::convert_ns};
+
+	convert::deinterleave_samples(pending_.data() + (pending_start_ * num_channels_), SampleFormat::f32, channels, sample_format_, num_channels_, num_frames);
+	consume(num_frames);
+
+	return num_frames;
+}
+
+auto ProcessedStream::seek(std::uint64_t frame) -> bool
+{
+	pending_.clear();
+	pending_start_ = 0;
+	ended_ = false;
+
+	return seek_(processor_.reset(frame));
+}
+
+}}
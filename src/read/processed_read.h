@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+#include "blahdio/audio_data_format.h"
+#include "blahdio/audio_reader.h"
+#include "blahdio/expected.h"
+#include "blahdio/output_format.h"
+#include "convert/channel_mixer.h"
+#include "convert/resampler.h"
+
+namespace blahdio {
+namespace read {
+
+// True if frames read in this output format have to be mixed or
+// resampled on their way out of the decoder
+[[nodiscard]] extern auto needs_processing(const OutputFormat& output_format, const AudioDataFormat& format) -> bool;
+
+// What the decoder is asked for when processing
+[[nodiscard]] extern auto get_processing_decode_format() -> OutputFormat;
+
+// Mixes and resamples interleaved float frames. Mixing down happens
+// before resampling and mixing up after it, so the resampler sees as
+// few channels as possible.
+class Processor
+{
+public:
+
+	[[nodiscard]] static auto make(const OutputFormat& output_format, const AudioDataFormat& format) -> expected<Processor>;
+
+	// See convert::Resampler
+	[[nodiscard]] auto reset(std::uint64_t out_frame) -> std::uint64_t;
+	auto process(const float* in, std::uint32_t in_frames, std::vector<float>* out) -> void;
+	auto flush(std::vector<float>* out) -> void;
+	auto reserve(std::uint32_t max_in_frames) -> void;
+
+	[[nodiscard]] auto get_input_frames(std::uint64_t out_frames) const -> std::uint64_t;
+	[[nodiscard]] auto get_in_channels() const { return in_channels_; }
+	[[nodiscard]] auto get_out_channels() const { return out_channels_; }
+
+private:
+
+	Processor(int in_channels, int out_channels, std::optional<convert::ChannelMixer> mixer, convert::Resampler resampler, bool resampling);
+
+	// Appends the mixed frames to out
+	auto mix(const float* in, std::uint32_t num_frames, std::vector<float>* out) const -> void;
+
+	int in_channels_;
+	int out_channels_;
+	std::optional<convert::ChannelMixer> mixer_;
+	convert::Resampler resampler_;
+	bool resampling_;
+	std::vector<float> scratch_;
+};
+
+using ReadFramesFn = std::function<expected<void>(AudioReader::Callbacks callbacks, std::uint32_t chunk_size, OutputFormat output_format)>;
+
+// Reads float frames with read_frames and returns them processed, in
+// chunks of chunk_size frames after processing. The decoder's chunks
+// must arrive in order.
+[[nodiscard]] extern auto read_frames_processed(
+	ReadFramesFn read_frames,
+	AudioReader::Callbacks callbacks,
+	std::uint32_t chunk_size,
+	const OutputFormat& output_format,
+	const AudioDataFormat& format) -> expected<void>;
+
+// Pulls float frames from a decoder and processes them. Positions are
+// in frames at the output rate.
+class ProcessedStream
+{
+public:
+
+	using ReadFn = std::function<expected<std::uint32_t>(void* buffer, std::uint32_t frames_to_read)>;
+	using SeekFn = std::function<bool(std::uint64_t frame)>;
+
+	ProcessedStream(Processor processor, SampleFormat sample_format, ReadFn read, SeekFn seek);
+
+	[[nodiscard]] auto read(void* buffer, std::uint32_t frames_to_read) -> expected<std::uint32_t>;
+	[[nodiscard]] auto read_planar(void* const* channels, std::uint32_t frames_to_read) -> expected<std::uint32_t>;
+	[[nodiscard]] auto seek(std::uint64_t frame) -> bool;
+
+	// Makes room for reads of up to this many frames, so that read() and
+	// read_planar() don't allocate
+	auto reserve(std::uint32_t max_frames_per_read) -> void;
+
+private:
+
+	// Processes until there are at least this many frames waiting, or
+	// the source has ended
+	[[nodiscard]] auto fill(std::uint32_t num_frames) -> expected<void>;
+
+	// Drops the frames which have been returned
+	auto consume(std::uint32_t num_frames) -> void;
+
+	[[nodiscard]] auto get_pending_frames() const -> std::size_t;
+
+	Processor processor_;
+	SampleFormat sample_format_;
+	int num_channels_;
+	ReadFn read_;
+	SeekFn seek_;
+	bool ended_{false};
+	std::vector<float> input_;
+	std::vector<float> pending_;
+	std::size_t pending_start_{0};
+};
+
+}}
@@ -0,0 +1,134 @@
+#include "raw_source.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <utf8.h>
+#include "counters.h"
+
+namespace blahdio {
+namespace read {
+
+struct RawFile
+{
+	std::mutex mutex;
+	std::ifstream file;
+};
+
+static auto open_file(std::ifstream* file, const std::string& utf8_path) -> void
+{
+#ifdef _WIN32
+	file->open((const wchar_t*)(utf8::utf8to16(utf8_path).c_str()), std::fstream::binary);
+#else
+	file->open(utf8_path, std::fstream::binary);
+#endif
+}
+
+static auto file_size(const std::string& utf8_path) -> std::optional<std::uint64_t>
+{
+	std::error_code err;
+
+#ifdef _WIN32
+	const auto size{std::filesystem::file_size(std::filesystem::path((const wchar_t*)(utf8::utf8to16(utf8_path).c_str())), err)};
+#else
+	const auto size{std::filesystem::file_size(utf8_path, err)};
+#endif
+
+	if (err) return std::nullopt;
+
+	return size;
+}
+
+auto make_raw_source(std::string utf8_path) -> RawSource
+{
+	auto raw_file{std::make_shared<RawFile>()};
+
+	const auto read_at = [raw_file, utf8_path](std::uint64_t offset, void* buffer, std::size_t size) -> std::size_t
+	{
+		std::lock_guard lock{raw_file->mutex};
+
+		if (!raw_file->file.is_open())
+		{
+			open_file(&raw_file->file, utf8_path);
+		}
+
+		raw_file->file.clear();
+		raw_file->file.seekg(std::streamoff(offset));
+		raw_file->file.read((char*)(buffer), std::streamsize(size));
+
+		const auto bytes_read{std::size_t(raw_file->file.gcount())};
+
+		stats::add(stats::Counter::bytes, bytes_read);
+
+		return bytes_read;
+	};
+
+	const auto size = [utf8_path]
+	{
+		return file_size(utf8_path);
+	};
+
+	return { read_at, size };
+}
+
+auto make_raw_source(const AudioReader::Stream& stream) -> RawSource
+{
+	if (!stream.seek)
+	{
+		// We can't look at the stream without consuming it
+		return {};
+	}
+
+	// The stream is rewound afterwards, so this can only be used before
+	// a decoder starts reading it.
+	const auto read_at = [&stream](std::uint64_t offset, void* buffer, std::size_t size) -> std::size_t
+	{
+		if (!stream.seek(AudioReader::Stream::SeekOrigin::Start, std::int64_t(offset)))
+		{
+			return 0;
+		}
+
+		const auto bytes_read{stream.read_bytes(buffer, std::uint32_t(size))};
+
+		stats::add(stats::Counter::bytes, bytes_read);
+		stream.seek(AudioReader::Stream::SeekOrigin::Start, 0);
+
+		return bytes_read;
+	};
+
+	const auto size = [&stream]() -> std::optional<std::uint64_t>
+	{
+		if (!stream.get_size) return std::nullopt;
+
+		return stream.get_size();
+	};
+
+	return { read_at, size };
+}
+
+auto make_raw_source(const void* data, std::size_t data_size) -> RawSource
+{
+	const auto read_at = [data, data_size](std::uint64_t offset, void* buffer, std::size_t size) -> std::size_t
+	{
+		if (offset >= data_size) return 0;
+
+		const auto read_size{std::min(size, std::size_t(data_size - offset))};
+		const auto beg{(const char*)(data) + offset};
+
+		std::copy(beg, beg + read_size, (char*)(buffer));
+
+		stats::add(stats::Counter::bytes, read_size);
+
+		return read_size;
+	};
+
+	const auto size = [data_size]() -> std::optional<std::uint64_t>
+	{
+		return data_size;
+	};
+
+	return { read_at, size };
+}
+
+}}
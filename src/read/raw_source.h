@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include "blahdio/audio_reader.h"
+
+namespace blahdio {
+namespace read {
+
+// Access to the undecoded bytes of a source, independently of any
+// decoder which is reading it.
+struct RawSource
+{
+	// Returns the number of bytes copied to the buffer
+	using ReadAtFn = std::function<std::size_t(std::uint64_t offset, void* buffer, std::size_t size)>;
+	using SizeFn = std::function<std::optional<std::uint64_t>()>;
+
+	ReadAtFn read_at;
+	SizeFn size;
+
+	operator bool() const { return bool(read_at); }
+};
+
+extern auto make_raw_source(std::string utf8_path) -> RawSource;
+extern auto make_raw_source(const AudioReader::Stream& stream) -> RawSource;
+extern auto make_raw_source(const void* data, std::size_t data_size) -> RawSource;
+
+}}
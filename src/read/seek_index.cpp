@@ -0,0 +1,163 @@
+#include "seek_index.h"
+#include <chrono>
+#include <format>
+#include "bytes.h"
+
+namespace blahdio {
+namespace read {
+
+static constexpr char MAGIC[4] = { 'B', 'D', 'S', 'I' };
+static constexpr std::uint32_t VERSION = 1;
+static constexpr std::size_t HEADER_SIZE = 4 + 4 + 4 + 8 + 8;
+static constexpr std::size_t POINT_SIZE = 8 + 8 + 4 + 2 + 2;
+
+BackgroundSeekIndex::~BackgroundSeekIndex()
+{
+	// The future will wait for the thread to finish
+	if (cancel_)
+	{
+		*cancel_ = true;
+	}
+}
+
+auto BackgroundSeekIndex::start(BuildFn build) -> void
+{
+	std::lock_guard lock{*mutex_};
+
+	if (index_ || future_.valid()) return;
+
+	cancel_ = std::make_shared<std::atomic<bool>>(false);
+
+	future_ = std::async(std::launch::async, [build, cancel = cancel_]
+	{
+		return build(*cancel);
+	});
+}
+
+auto BackgroundSeekIndex::set(SeekIndex index) -> void
+{
+	std::lock_guard lock{*mutex_};
+
+	if (future_.valid())
+	{
+		*cancel_ = true;
+		future_.wait();
+		future_ = {};
+	}
+
+	index_ = std::make_shared<const SeekIndex>(std::move(index));
+}
+
+auto BackgroundSeekIndex::try_get() -> std::shared_ptr<const SeekIndex>
+{
+	std::lock_guard lock{*mutex_};
+
+	if (future_.valid() && future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		take_result();
+	}
+
+	return index_;
+}
+
+auto BackgroundSeekIndex::wait() -> std::shared_ptr<const SeekIndex>
+{
+	std::lock_guard lock{*mutex_};
+
+	if (future_.valid())
+	{
+		take_result();
+	}
+
+	return index_;
+}
+
+auto BackgroundSeekIndex::take_result() -> void
+{
+	auto result{future_.get()};
+
+	if (result)
+	{
+		index_ = std::make_shared<const SeekIndex>(std::move(*result));
+	}
+}
+
+auto serialize(const SeekIndex& index) -> std::vector<std::byte>
+{
+	std::vector<std::byte> out;
+
+	out.reserve(HEADER_SIZE + (index.points.size() * POINT_SIZE));
+
+	for (auto c : MAGIC)
+	{
+		out.push_back(std::byte(c));
+	}
+
+	bytes::put<std::uint32_t>(&out, VERSION);
+	bytes::put<std::uint32_t>(&out, std::uint32_t(index.type));
+	bytes::put<std::uint64_t>(&out, index.source_size);
+	bytes::put<std::uint64_t>(&out, index.points.size());
+
+	for (const auto& point : index.points)
+	{
+		bytes::put<std::uint64_t>(&out, point.frame);
+		bytes::put<std::uint64_t>(&out, point.byte_offset);
+		bytes::put<std::uint32_t>(&out, point.num_frames);
+		bytes::put<std::uint16_t>(&out, point.mp3_frames_to_discard);
+		bytes::put<std::uint16_t>(&out, point.frames_to_discard);
+	}
+
+	return out;
+}
+
+auto deserialize_seek_index(const std::vector<std::byte>& data) -> expected<SeekIndex>
+{
+	if (data.size() < HEADER_SIZE)
+	{
+		return tl::make_unexpected("Failed to read seek index (Not enough data)");
+	}
+
+	for (std::size_t i = 0; i < sizeof(MAGIC); i++)
+	{
+		if (data[i] != std::byte(MAGIC[i]))
+		{
+			return tl::make_unexpected("Failed to read seek index (This is not a seek index)");
+		}
+	}
+
+	auto pos{data.data() + sizeof(MAGIC)};
+
+	const auto version{bytes::get<std::uint32_t>(&pos)};
+
+	if (version != VERSION)
+	{
+		return tl::make_unexpected(std::format("Failed to read seek index (Unsupported version: {})", version));
+	}
+
+	SeekIndex out;
+
+	out.type = AudioType(bytes::get<std::uint32_t>(&pos));
+	out.source_size = bytes::get<std::uint64_t>(&pos);
+
+	const auto num_points{bytes::get<std::uint64_t>(&pos)};
+
+	if ((data.size() - HEADER_SIZE) / POINT_SIZE < num_points)
+	{
+		return tl::make_unexpected("Failed to read seek index (Not enough data)");
+	}
+
+	out.points.resize(std::size_t(num_points));
+
+	for (auto& point : out.points)
+	{
+		point.frame = bytes::get<std::uint64_t>(&pos);
+		point.byte_offset = bytes::get<std::uint64_t>(&pos);
+		point.num_frames = bytes::get<std::uint32_t>(&pos);
+		point.mp3_frames_to_discard = bytes::get<std::uint16_t>(&pos);
+		point.frames_to_discard = bytes::get<std::uint16_t>(&pos);
+	}
+
+	return out;
+}
+
+}}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "blahdio/audio_type.h"
+#include "blahdio/expected.h"
+
+namespace blahdio {
+namespace read {
+
+struct SeekPoint
+{
+	std::uint64_t frame{0};
+	std::uint64_t byte_offset{0};
+	std::uint32_t num_frames{0};
+	std::uint16_t mp3_frames_to_discard{0};
+	std::uint16_t frames_to_discard{0};
+};
+
+// A list of places in the source where decoding can start, so that
+// seeking doesn't have to search through the source. Which fields of
+// each point are used depends on the type.
+struct SeekIndex
+{
+	AudioType type{AudioType::none};
+
+	// Size of the source the index was built from, or 0 if not known
+	std::uint64_t source_size{0};
+
+	std::vector<SeekPoint> points;
+};
+
+// Holds a seek index which is either supplied by the client or built on
+// a background thread. Safe to use from more than one thread, so that
+// cursors can be opened while the handler is streaming.
+class BackgroundSeekIndex
+{
+public:
+
+	using BuildFn = std::function<std::optional<SeekIndex>(const std::atomic<bool>& cancel)>;
+
+	BackgroundSeekIndex() = default;
+	BackgroundSeekIndex(BackgroundSeekIndex&&) noexcept = default;
+	auto operator=(BackgroundSeekIndex&&) noexcept -> BackgroundSeekIndex& = default;
+	~BackgroundSeekIndex();
+
+	// Does nothing if there is already an index or one is being built
+	auto start(BuildFn build) -> void;
+	auto set(SeekIndex index) -> void;
+
+	// Returns null if the index isn't ready yet
+	[[nodiscard]] auto try_get() -> std::shared_ptr<const SeekIndex>;
+
+	// Waits for the index to finish building if it is being built
+	[[nodiscard]] auto wait() -> std::shared_ptr<const SeekIndex>;
+
+private:
+
+	auto take_result() -> void;
+
+	// Held by pointer to keep the index movable
+	std::unique_ptr<std::mutex> mutex_{std::make_unique<std::mutex>()};
+	std::shared_ptr<std::atomic<bool>> cancel_;
+	std::future<std::optional<SeekIndex>> future_;
+	std::shared_ptr<const SeekIndex> index_;
+};
+
+[[nodiscard]] extern auto serialize(const SeekIndex& index) -> std::vector<std::byte>;
+[[nodiscard]] extern auto deserialize_seek_index(const std::vector<std::byte>& data) -> expected<SeekIndex>;
+
+}}
@@ -0,0 +1,117 @@
+#include "sniff.h"
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "mpeg_header.h"
+
+namespace blahdio {
+namespace read {
+
+static constexpr std::array<unsigned char, 16> W64_RIFF_GUID =
+{
+	'r', 'i', 'f', 'f', 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00
+};
+
+template <std::size_t N> [[nodiscard]] static
+auto matches(const std::byte* data, std::size_t size, std::size_t offset, const char (&magic)[N]) -> bool
+{
+	constexpr auto magic_size{N - 1};
+
+	if (offset + magic_size > size) return false;
+
+	return std::equal(magic, magic + magic_size, data + offset, [](char a, std::byte b)
+	{
+		return std::byte(a) == b;
+	});
+}
+
+[[nodiscard]] static
+auto is_w64(const std::byte* data, std::size_t size) -> bool
+{
+	if (size < W64_RIFF_GUID.size()) return false;
+
+	return std::equal(W64_RIFF_GUID.begin(), W64_RIFF_GUID.end(), data, [](unsigned char a, std::byte b)
+	{
+		return std::byte(a) == b;
+	});
+}
+
+[[nodiscard]] static
+auto sniff_container(const std::byte* data, std::size_t size) -> AudioType
+{
+	if (matches(data, size, 0, "fLaC")) return AudioType::flac;
+	if (matches(data, size, 0, "wvpk")) return AudioType::wavpack;
+
+	if (matches(data, size, 0, "RIFF") || matches(data, size, 0, "RIFX") || matches(data, size, 0, "RF64") || matches(data, size, 0, "BW64"))
+	{
+		if (matches(data, size, 8, "WAVE")) return AudioType::wav;
+	}
+
+	if (matches(data, size, 0, "FORM"))
+	{
+		if (matches(data, size, 8, "AIFF") || matches(data, size, 8, "AIFC")) return AudioType::wav;
+	}
+
+	if (is_w64(data, size)) return AudioType::wav;
+
+	return AudioType::none;
+}
+
+// The data is assumed to begin after any ID3v2 tag. data_ends is set
+// if there is nothing in the source after it.
+[[nodiscard]] static
+auto sniff_after_id3(const std::byte* data, std::size_t size, bool data_ends, bool has_id3) -> AudioType
+{
+	const auto type{sniff_container(data, size)};
+
+	if (type != AudioType::none) return type;
+
+	if (mpeg::find_first_frame(data, size, data_ends)) return AudioType::mp3;
+
+	// An ID3 tag followed by something we don't recognize is most likely
+	// an MP3 file with some junk after the tag
+	if (has_id3) return AudioType::mp3;
+
+	return AudioType::none;
+}
+
+auto sniff_type(const void* data, std::size_t size) -> AudioType
+{
+	const auto bytes{(const std::byte*)(data)};
+	const auto id3_size{mpeg::id3v2_tag_size(bytes, size)};
+
+	if (id3_size == 0)
+	{
+		return sniff_after_id3(bytes, std::min(size, SNIFF_SIZE), size <= SNIFF_SIZE, false);
+	}
+
+	if (id3_size >= size)
+	{
+		return AudioType::mp3;
+	}
+
+	const auto size_after_id3{size - id3_size};
+
+	return sniff_after_id3(bytes + id3_size, std::min(size_after_id3, SNIFF_SIZE), size_after_id3 <= SNIFF_SIZE, true);
+}
+
+auto sniff_type(const RawSource& source) -> AudioType
+{
+	if (!source) return AudioType::none;
+
+	std::vector<std::byte> buffer(SNIFF_SIZE);
+
+	const auto size{source.read_at(0, buffer.data(), buffer.size())};
+	const auto id3_size{mpeg::id3v2_tag_size(buffer.data(), size)};
+
+	if (id3_size == 0)
+	{
+		return sniff_after_id3(buffer.data(), size, size < buffer.size(), false);
+	}
+
+	const auto size_after_id3{source.read_at(id3_size, buffer.data(), buffer.size())};
+
+	return sniff_after_id3(buffer.data(), size_after_id3, size_after_id3 < buffer.size(), true);
+}
+
+}}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include "blahdio/audio_type.h"
+#include "raw_source.h"
+
+namespace blahdio {
+namespace read {
+
+// How many bytes are looked at to deduce the type
+static constexpr std::size_t SNIFF_SIZE = 4096;
+
+// Deduces the audio type from the magic bytes at the start of the
+// data. Returns AudioType::none if nothing was recognized.
+[[nodiscard]] extern auto sniff_type(const void* data, std::size_t size) -> AudioType;
+
+// Same as above but reads what it needs from the source, skipping over
+// an ID3v2 tag if there is one.
+[[nodiscard]] extern auto sniff_type(const RawSource& source) -> AudioType;
+
+}}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include "typed_read_handler.h"
@@ -24,14 +25,27 @@ namespace typed {
 
 auto make_handlers(std::string utf8_path) -> Handlers
 {
+#	if BLAHDIO_ENABLE_MMAP
+		if (auto mapped_file{MappedFile::open(utf8_path)})
+		{
+			auto handlers{make_handlers(mapped_file->data(), mapped_file->size())};
+
+			handlers.mapped_file = std::move(mapped_file);
+
+			return handlers;
+		}
+#	endif
+
+	const auto raw_source{make_raw_source(utf8_path)};
+
 	return
 	{
 #	if BLAHDIO_ENABLE_FLAC
-		read::flac::make_handler(utf8_path),
+		read::flac::make_handler(utf8_path, raw_source),
 #	endif
 
 #	if BLAHDIO_ENABLE_MP3
-		read::mp3::make_handler(utf8_path),
+		read::mp3::make_handler(utf8_path, raw_source),
 #	endif
 
 #	if BLAHDIO_ENABLE_WAV
@@ -39,13 +53,18 @@ auto make_handlers(std::string utf8_path) -> Handlers
 #	endif
 
 #	if BLAHDIO_ENABLE_WAVPACK
-		read::wavpack::make_handler(utf8_path)
+		read::wavpack::make_handler(utf8_path, raw_source),
 #	endif
+
+		raw_source,
+		nullptr,
 	};
 }
 
 auto make_handlers(const AudioReader::Stream& stream) -> Handlers
 {
+	const auto raw_source{make_raw_source(stream)};
+
 	return
 	{
 #	if BLAHDIO_ENABLE_FLAC
@@ -53,7 +72,7 @@ auto make_handlers(const AudioReader::Stream& stream) -> Handlers
 #	endif
 
 #	if BLAHDIO_ENABLE_MP3
-		read::mp3::make_handler(stream),
+		read::mp3::make_handler(stream, raw_source),
 #	endif
 
 #	if BLAHDIO_ENABLE_WAV
@@ -61,21 +80,26 @@ auto make_handlers(const AudioReader::Stream& stream) -> Handlers
 #	endif
 
 #	if BLAHDIO_ENABLE_WAVPACK
-		read::wavpack::make_handler(stream)
+		read::wavpack::make_handler(stream),
 #	endif
+
+		raw_source,
+		nullptr,
 	};
 }
 
 auto make_handlers(const void* data, size_t data_size) -> Handlers
 {
+	const auto raw_source{make_raw_source(data, data_size)};
+
 	return
 	{
 #	if BLAHDIO_ENABLE_FLAC
-		read::flac::make_handler(data, data_size),
+		read::flac::make_handler(data, data_size, raw_source),
 #	endif
 
 #	if BLAHDIO_ENABLE_MP3
-		read::mp3::make_handler(data, data_size),
+		read::mp3::make_handler(data, data_size, raw_source),
 #	endif
 
 #	if BLAHDIO_ENABLE_WAV
@@ -83,11 +107,48 @@ auto make_handlers(const void* data, size_t data_size) -> Handlers
 #	endif
 
 #	if BLAHDIO_ENABLE_WAVPACK
-		read::wavpack::make_handler(data, data_size)
+		read::wavpack::make_handler(data, data_size, raw_source),
 #	endif
+
+		raw_source,
+		nullptr,
 	};
 }
 
+auto Handlers::find(AudioType type) -> typed::Handler*
+{
+	switch (type)
+	{
+#		if BLAHDIO_ENABLE_FLAC
+			case AudioType::flac: return &flac;
+#		endif
+
+#		if BLAHDIO_ENABLE_MP3
+			case AudioType::mp3: return &mp3;
+#		endif
+
+#		if BLAHDIO_ENABLE_WAV
+			case AudioType::wav: return &wav;
+#		endif
+
+#		if BLAHDIO_ENABLE_WAVPACK
+			case AudioType::wavpack: return &wavpack;
+#		endif
+
+		default: return nullptr;
+	}
+}
+
+auto Handlers::advise(AccessPattern pattern) const -> void
+{
+#	if BLAHDIO_ENABLE_MMAP
+		if (mapped_file)
+		{
+			mapped_file->advise(pattern);
+		}
+#	endif
+}
+
 auto Handlers::make_type_attempt_order(AudioTypeHint type_hint) -> std::vector<typed::Handler*>
 {
 	switch (type_hint)
@@ -120,4 +181,23 @@ auto Handlers::make_type_attempt_order(AudioTypeHint type_hint) -> std::vector<t
 	}
 }
 
+auto Handlers::make_type_attempt_order(AudioTypeHint type_hint, AudioType sniffed_type) -> std::vector<typed::Handler*>
+{
+	auto out{make_type_attempt_order(type_hint)};
+
+	const auto is_sniffed_type = [sniffed_type](typed::Handler* handler)
+	{
+		return handler->type() == sniffed_type;
+	};
+
+	const auto pos{std::find_if(out.begin(), out.end(), is_sniffed_type)};
+
+	if (pos != out.end())
+	{
+		std::rotate(out.begin(), pos, pos + 1);
+	}
+
+	return out;
+}
+
 }}}
\ No newline at end of file
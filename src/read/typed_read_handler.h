@@ -5,11 +5,25 @@
 #include "blahdio/audio_data_format.h"
 #include "blahdio/audio_reader.h"
 #include "blahdio/expected.h"
+#include "blahdio/output_format.h"
+#include "cursor.h"
+#include "mapped_file.h"
+#include "raw_source.h"
+#include "seek_index.h"
 
 namespace blahdio {
 namespace read {
 namespace typed {
 
+struct ReadOptions
+{
+	// Chunks may point straight into the source instead of being copied,
+	// if the handler supports it
+	bool zero_copy{false};
+
+	OutputFormat output_format;
+};
+
 struct Handler
 {
 	template <
@@ -23,18 +37,27 @@ struct Handler
 		return impl_->type();
 	}
 
-	[[nodiscard]] auto try_read_header() {
-		return impl_->try_read_header();
+	// If keep_decoder is true, the decoder opened to read the header is
+	// held on to and handed over to the next read_frames() or stream_open()
+	[[nodiscard]] auto try_read_header(bool keep_decoder) {
+		return impl_->try_read_header(keep_decoder);
 	}
 
-	[[nodiscard]] auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) {
-		return impl_->read_frames(callbacks, format, chunk_size);
+	[[nodiscard]] auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size, ReadOptions options) {
+		return impl_->read_frames(callbacks, format, chunk_size, options);
 	}
 
-	[[nodiscard]] auto stream_open() {
-		return impl_->stream_open();
+	// Whether read_frames() can avoid copying. Only valid after the
+	// header has been read.
+	[[nodiscard]] auto zero_copy() const {
+		return impl_->zero_copy();
 	}
 
+	[[nodiscard]] auto stream_open(OutputFormat output_format) {
+		return impl_->stream_open(output_format);
+	}
+
+	// Returns false if the seek failed or the stream isn't open
 	[[nodiscard]] auto stream_seek(uint64_t target_frame) {
 		return impl_->stream_seek(target_frame);
 	}
@@ -43,22 +66,64 @@ struct Handler
 		return impl_->stream_read(buffer, frames_to_read);
 	}
 
+	[[nodiscard]] auto stream_read_planar(void* const* channels, uint32_t frames_to_read) {
+		return impl_->stream_read_planar(channels, frames_to_read);
+	}
+
 	[[nodiscard]] auto stream_close() {
 		return impl_->stream_close();
 	}
 
+	// Allocates what the open stream needs for reads of up to this many
+	// frames, so that stream_read(), stream_read_planar() and
+	// stream_seek() don't allocate or lock. From then on a seek index
+	// which finishes building in the background is only picked up by
+	// calling this again.
+	auto stream_reserve(uint32_t max_frames_per_read) {
+		impl_->stream_reserve(max_frames_per_read);
+	}
+
+	// Only possible for types which can seek exactly, and sources which
+	// can be decoded more than once at the same time (not streams). Safe
+	// to call while another thread is streaming from the handler.
+	[[nodiscard]] auto open_cursor(OutputFormat output_format) {
+		return impl_->open_cursor(output_format);
+	}
+
+	// Starts building a seek index on a background thread, if the type
+	// needs one built that way and the source can be scanned
+	auto build_seek_index() {
+		impl_->build_seek_index();
+	}
+
+	// Used by the next stream_open() instead of building a new one
+	[[nodiscard]] auto set_seek_index(SeekIndex index) {
+		return impl_->set_seek_index(std::move(index));
+	}
+
+	[[nodiscard]] auto get_seek_index() const {
+		return impl_->get_seek_index();
+	}
+
 private:
 
 	struct Concept
 	{
 		virtual ~Concept() {}
 		virtual auto type() const -> AudioType = 0;
-		virtual auto try_read_header() -> expected<AudioDataFormat> = 0;
-		virtual auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> expected<void> = 0;
-		virtual auto stream_open() -> expected<AudioDataFormat> = 0;
-		virtual auto stream_seek(uint64_t target_frame) -> expected<void> = 0;
+		virtual auto try_read_header(bool keep_decoder) -> expected<AudioDataFormat> = 0;
+		virtual auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size, ReadOptions options) -> expected<void> = 0;
+		virtual auto zero_copy() const -> AudioReader::ZeroCopy = 0;
+		virtual auto stream_open(OutputFormat output_format) -> expected<AudioDataFormat> = 0;
+		virtual auto stream_seek(uint64_t target_frame) -> bool = 0;
 		virtual auto stream_read(void* buffer, uint32_t frames_to_read) -> expected<uint32_t> = 0;
+		virtual auto stream_read_planar(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t> = 0;
 		virtual auto stream_close() -> expected<void> = 0;
+		virtual auto stream_reserve(uint32_t max_frames_per_read) -> void = 0;
+		virtual auto open_cursor(OutputFormat output_format) -> expected<Cursor> = 0;
+		virtual auto build_seek_index() -> void = 0;
+		virtual auto set_seek_index(SeekIndex index) -> expected<void> = 0;
+		virtual auto get_seek_index() const -> expected<SeekIndex> = 0;
 	};
 
 	template <typename T>
@@ -70,24 +135,45 @@ private:
 		auto type() const -> AudioType override {
 			return object_.type();
 		}
-		auto try_read_header() -> expected<AudioDataFormat> override {
-			return object_.try_read_header();
+		auto try_read_header(bool keep_decoder) -> expected<AudioDataFormat> override {
+			return object_.try_read_header(keep_decoder);
+		}
+		auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size, ReadOptions options) -> expected<void> override {
+			return object_.read_frames(callbacks, format, chunk_size, options);
 		}
-		auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> expected<void> override {
-			return object_.read_frames(callbacks, format, chunk_size);
+		auto zero_copy() const -> AudioReader::ZeroCopy override {
+			return object_.zero_copy();
 		}
-		auto stream_open() -> expected<AudioDataFormat> override {
-			return object_.stream_open();
+		auto stream_open(OutputFormat output_format) -> expected<AudioDataFormat> override {
+			return object_.stream_open(output_format);
 		}
-		auto stream_seek(uint64_t target_frame) -> expected<void> override {
+		auto stream_seek(uint64_t target_frame) -> bool override {
 			return object_.stream_seek(target_frame);
 		}
 		auto stream_read(void* buffer, uint32_t frames_to_read) -> expected<uint32_t> override {
 			return object_.stream_read(buffer, frames_to_read);
 		}
+		auto stream_read_planar(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t> override {
+			return object_.stream_read_planar(channels, frames_to_read);
+		}
 		auto stream_close() -> expected<void> override {
 			return object_.stream_close();
 		}
+		auto stream_reserve(uint32_t max_frames_per_read) -> void override {
+			object_.stream_reserve(max_frames_per_read);
+		}
+		auto open_cursor(OutputFormat output_format) -> expected<Cursor> override {
+			return object_.open_cursor(output_format);
+		}
+		auto build_seek_index() -> void override {
+			object_.build_seek_index();
+		}
+		auto set_seek_index(SeekIndex index) -> expected<void> override {
+			return object_.set_seek_index(std::move(index));
+		}
+		auto get_seek_index() const -> expected<SeekIndex> override {
+			return object_.get_seek_index();
+		}
 
 	private:
 
@@ -115,7 +201,21 @@ struct Handlers
 		Handler wavpack;
 #	endif
 
+	RawSource raw_source;
+
+	// If the file could be mapped then the handlers are reading it as
+	// memory, and this keeps it mapped
+	std::shared_ptr<MappedFile> mapped_file;
+
+	auto find(AudioType type) -> Handler*;
+
+	// Passed on to the OS if the source is a mapped file
+	auto advise(AccessPattern pattern) const -> void;
 	auto make_type_attempt_order(AudioTypeHint type) -> std::vector<Handler*>;
+
+	// Same as above except the handler for the sniffed type (if it is
+	// in the list) is moved to the front
+	auto make_type_attempt_order(AudioTypeHint type, AudioType sniffed_type) -> std::vector<Handler*>;
 };
 
 extern auto make_handlers(std::string utf8_path) -> Handlers;
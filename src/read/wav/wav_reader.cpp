@@ -1,9 +1,14 @@
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstdint>
 #include <optional>
 #include <format>
 #include "wav_reader.h"
 #include "blahdio/audio_writer.h"
+#include "read/format_reader.h"
 #include "mackron/blahdio_dr_libs.h"
+#include "counters.h"
 
 namespace blahdio {
 namespace read {
@@ -20,6 +25,8 @@ struct WAV
 	{
 		wav_ = std::move(rhs.wav_);
 		header_ = rhs.header_;
+		memory_ = rhs.memory_;
+		memory_size_ = rhs.memory_size_;
 		return *this;
 	}
 
@@ -35,6 +42,43 @@ struct WAV
 	operator drwav*() { return wav_.get(); }
 	auto get_header_info() const { return header_; }
 
+	// The samples can be handed out directly if they are already little
+	// endian float32 and the whole source is in memory
+	[[nodiscard]]
+	auto get_zero_copy() const -> AudioReader::ZeroCopy
+	{
+		if (!memory_) return AudioReader::ZeroCopy::unavailable;
+		if (std::endian::native != std::endian::little) return AudioReader::ZeroCopy::unavailable;
+		if (wav_->translatedFormatTag != DR_WAVE_FORMAT_IEEE_FLOAT) return AudioReader::ZeroCopy::unavailable;
+		if (wav_->bitsPerSample != 32) return AudioReader::ZeroCopy::unavailable;
+		if (wav_->container == drwav_container_rifx) return AudioReader::ZeroCopy::unavailable;
+		if (wav_->container == drwav_container_aiff) return AudioReader::ZeroCopy::unavailable;
+		if (wav_->dataChunkDataPos >= memory_size_) return AudioReader::ZeroCopy::unavailable;
+
+		if (std::uintptr_t(memory_ + wav_->dataChunkDataPos) % alignof(float) != 0)
+		{
+			return AudioReader::ZeroCopy::misaligned;
+		}
+
+		return AudioReader::ZeroCopy::available;
+	}
+
+	// Only valid if get_zero_copy() returns available
+	[[nodiscard]]
+	auto get_samples() const -> const float*
+	{
+		return (const float*)(memory_ + wav_->dataChunkDataPos);
+	}
+
+	// The data chunk might claim to be bigger than the source is
+	[[nodiscard]]
+	auto get_num_frames_in_memory() const -> std::uint64_t
+	{
+		const auto frame_bytes{std::uint64_t(wav_->channels) * sizeof(float)};
+
+		return std::min<std::uint64_t>(wav_->totalPCMFrameCount, (memory_size_ - wav_->dataChunkDataPos) / frame_bytes);
+	}
+
 	[[nodiscard]] static
 	auto file(std::string_view utf8_path) -> expected<WAV>
 	{
@@ -58,7 +102,12 @@ struct WAV
 			return tl::make_unexpected("Failed to open WAV decoder for memory");
 		}
 
-		return WAV{std::move(wav)};
+		WAV out{std::move(wav)};
+
+		out.memory_ = (const std::byte*)(data);
+		out.memory_size_ = data_size;
+
+		return out;
 	}
 
 	[[nodiscard]] static
@@ -94,28 +143,85 @@ private:
 
 	std::unique_ptr<drwav> wav_;
 	AudioDataFormat header_{};
+	const std::byte* memory_{};
+	std::size_t memory_size_{0};
 };
 
 [[nodiscard]] static
-auto read_frame_data(drwav* wav, AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> expected<void>
+auto make_format_reader(drwav* wav, OutputFormat output_format) -> FormatReader
 {
-	const auto read_func = [wav](float* buffer, uint32_t read_size)
+	FormatReader::NativeReaders native_readers;
+
+	native_readers.f32 = [wav](void* buffer, uint32_t read_size)
+	{
+		return uint32_t(drwav_read_pcm_frames_f32(wav, read_size, (float*)(buffer)));
+	};
+
+	native_readers.s16 = [wav](void* buffer, uint32_t read_size)
 	{
-		return uint32_t(drwav_read_pcm_frames_f32(wav, read_size, buffer));
+		return uint32_t(drwav_read_pcm_frames_s16(wav, read_size, (drwav_int16*)(buffer)));
 	};
 
-	return dr_libs::generic_frame_reader_loop(callbacks, read_func, chunk_size, format.num_channels, format.num_frames);
+	native_readers.s32 = [wav](void* buffer, uint32_t read_size)
+	{
+		return uint32_t(drwav_read_pcm_frames_s32(wav, read_size, (drwav_int32*)(buffer)));
+	};
+
+	// dr_wav converts integers to float one sample at a time. 8 bit is
+	// left to it because it scales unsigned samples differently.
+	const auto bits{wav->bitsPerSample};
+
+	if (wav->translatedFormatTag == DR_WAVE_FORMAT_PCM && (bits == 16 || bits == 24 || bits == 32))
+	{
+		native_readers.integer_bits = bits;
+
+		// Packed samples straight from the file
+		if (bits == 24 && wav->fmt.blockAlign == 3 * wav->channels)
+		{
+			native_readers.s24 = [wav](void* buffer, uint32_t read_size)
+			{
+				return uint32_t(drwav_read_pcm_frames_le(wav, read_size, buffer));
+			};
+		}
+	}
+
+	return FormatReader{native_readers, wav->channels, output_format};
 }
 
-static
-auto read_stream_data(drwav* wav, AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> void
+[[nodiscard]] static
+auto read_frame_data(drwav* wav, AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size, OutputFormat output_format) -> expected<void>
 {
-	const auto read_func = [wav](float* buffer, uint32_t read_size)
+	auto reader{make_format_reader(wav, output_format)};
+
+	return dr_libs::generic_frame_reader_loop(callbacks, &reader, chunk_size, format.num_frames);
+}
+
+// Hands out pointers into the source. The decoder isn't used at all.
+[[nodiscard]] static
+auto read_frame_data_zero_copy(const WAV& wav, AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> expected<void>
+{
+	const auto samples{wav.get_samples()};
+	const auto num_frames_in_memory{wav.get_num_frames_in_memory()};
+
+	uint64_t frame{0};
+
+	while (frame < num_frames_in_memory)
 	{
-		return uint32_t(drwav_read_pcm_frames_f32(wav, read_size, buffer));
-	};
+		if (callbacks.should_abort()) return {};
+
+		const auto read_size{uint32_t(std::min<uint64_t>(chunk_size, num_frames_in_memory - frame))};
+
+		callbacks.return_chunk((const void*)(samples + (frame * format.num_channels)), frame, read_size);
+
+		frame += read_size;
+	}
+
+	if (num_frames_in_memory < format.num_frames)
+	{
+		return tl::make_unexpected("Read error");
+	}
 
-	dr_libs::generic_stream_reader_loop(callbacks, read_func, chunk_size, format.num_channels);
+	return {};
 }
 
 static
@@ -132,8 +238,11 @@ static
 auto drwav_stream_read(void* user_data, void* buffer, size_t bytes_to_read) -> size_t
 {
 	const auto stream = (AudioReader::Stream*)(user_data);
+	const auto bytes_read = stream->read_bytes(buffer, uint32_t(bytes_to_read));
 
-	return stream->read_bytes(buffer, uint32_t(bytes_to_read));
+	stats::add(stats::Counter::bytes, bytes_read);
+
+	return bytes_read;
 }
 
 static drwav_bool32 drwav_stream_seek(void* user_data, int offset, drwav_seek_origin origin)
@@ -147,28 +256,52 @@ struct WavHandler
 {
 	using OpenFn = std::function<expected<WAV>()>;
 
-	WavHandler(OpenFn open_fn) : open_fn_{open_fn} {}
+	WavHandler(OpenFn open_fn, bool can_open_cursors) : open_fn_{open_fn}, can_open_cursors_{can_open_cursors} {}
 
 	auto type() const -> AudioType { return AudioType::wav; }
 
-	auto try_read_header() -> expected<AudioDataFormat>
+	auto try_read_header(bool keep_decoder) -> expected<AudioDataFormat>
 	{
-		const auto get_header_info = [=](WAV&& wav) -> expected<AudioDataFormat>
+		if (header_decoder_)
 		{
-			return wav.get_header_info();
+			return header_decoder_->get_header_info();
+		}
+
+		const auto get_header_info = [this, keep_decoder](WAV&& wav) -> expected<AudioDataFormat>
+		{
+			const auto header{wav.get_header_info()};
+
+			zero_copy_ = wav.get_zero_copy();
+
+			if (keep_decoder)
+			{
+				header_decoder_ = std::move(wav);
+			}
+
+			return header;
 		};
 
 		return open_fn_().and_then(get_header_info);
 	}
 
-	auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> expected<void>
+	auto zero_copy() const -> AudioReader::ZeroCopy { return zero_copy_; }
+
+	auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size, typed::ReadOptions options) -> expected<void>
 	{
 		const auto read_frames = [=](WAV&& wav)
 		{
-			return read_frame_data(wav, callbacks, format, chunk_size);
+			const auto& output_format{options.output_format};
+			const auto interleaved_f32{output_format.sample_format == SampleFormat::f32 && !output_format.planar};
+
+			if (options.zero_copy && interleaved_f32 && wav.get_zero_copy() == AudioReader::ZeroCopy::available)
+			{
+				return read_frame_data_zero_copy(wav, callbacks, format, chunk_size);
+			}
+
+			return read_frame_data(wav, callbacks, format, chunk_size, output_format);
 		};
 
-		return open_fn_().and_then(read_frames);
+		return open_decoder().and_then(read_frames);
 	}
 
 	[[nodiscard]]
@@ -179,20 +312,31 @@ struct WavHandler
 			return tl::make_unexpected("Failed to read frames from the WAV stream (The stream is not open)");
 		}
 
-		return uint32_t(drwav_read_pcm_frames_f32(*stream_, uint64_t(frames_to_read), (float*)(buffer)));
+		return stream_reader_->read(buffer, frames_to_read);
 	}
 
 	[[nodiscard]]
-	auto stream_open() -> expected<AudioDataFormat>
+	auto stream_read_planar(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>
+	{
+		if (!stream_)
+		{
+			return tl::make_unexpected("Failed to read frames from the WAV stream (The stream is not open)");
+		}
+
+		return stream_reader_->read_planar(channels, frames_to_read);
+	}
+
+	[[nodiscard]]
+	auto stream_open(OutputFormat output_format) -> expected<AudioDataFormat>
 	{
 		if (stream_)
 		{
 			return tl::make_unexpected("Failed to open WAV stream (It is already open)");
 		}
 
-		const auto open_stream = [=]() -> expected<void>
+		const auto open_stream = [=, this]() -> expected<void>
 		{
-			auto result{open_fn_()};
+			auto result{open_decoder()};
 
 			if (!result)
 			{
@@ -200,6 +344,7 @@ struct WavHandler
 			}
 
 			stream_ = std::move(*result);
+			stream_reader_.emplace(make_format_reader(*stream_, output_format));
 			return {};
 		};
 
@@ -212,21 +357,18 @@ struct WavHandler
 	}
 
 	[[nodiscard]]
-	auto stream_seek(uint64_t target_frame) -> expected<void>
+	auto stream_seek(uint64_t target_frame) -> bool
 	{
-		if (!stream_)
-		{
-			return tl::make_unexpected("Failed to seek the WAV stream (The stream is not open)");
-		}
+		if (!stream_) return false;
 
-		const auto result{drwav_seek_to_pcm_frame(*stream_, target_frame)};
+		return drwav_seek_to_pcm_frame(*stream_, target_frame);
+	}
 
-		if (!result)
-		{
-			return tl::make_unexpected("Failed to seek the WAV stream for some reason");
-		}
+	auto stream_reserve(uint32_t max_frames_per_read) -> void
+	{
+		if (!stream_reader_) return;
 
-		return {};
+		stream_reader_->reserve(max_frames_per_read);
 	}
 
 	[[nodiscard]]
@@ -237,14 +379,73 @@ struct WavHandler
 			return tl::make_unexpected("Failed to close WAV stream (The stream is not open)");
 		}
 
+		stream_reader_ = std::nullopt;
 		stream_ = std::nullopt;
 		return {};
 	}
 
+	[[nodiscard]]
+	auto open_cursor(OutputFormat output_format) -> expected<Cursor>
+	{
+		if (!can_open_cursors_)
+		{
+			return tl::make_unexpected("Failed to open WAV cursor (The source can't be decoded more than once at a time)");
+		}
+
+		const auto make_cursor = [output_format](WAV&& wav) -> expected<Cursor>
+		{
+			const auto decoder{std::make_shared<WAV>(std::move(wav))};
+
+			const auto seek = [decoder = decoder.get()](uint64_t frame)
+			{
+				return bool(drwav_seek_to_pcm_frame(*decoder, frame));
+			};
+
+			return Cursor{decoder, make_format_reader(*decoder, output_format), seek};
+		};
+
+		return open_fn_().and_then(make_cursor);
+	}
+
+	auto build_seek_index() -> void {}
+
+	[[nodiscard]]
+	auto set_seek_index(SeekIndex) -> expected<void>
+	{
+		return tl::make_unexpected("WAV data doesn't use a seek index");
+	}
+
+	[[nodiscard]]
+	auto get_seek_index() const -> expected<SeekIndex>
+	{
+		return tl::make_unexpected("WAV data doesn't use a seek index");
+	}
+
 private:
 
+	// Hands over the decoder which was kept open by try_read_header(), or
+	// opens a new one if there isn't one
+	[[nodiscard]]
+	auto open_decoder() -> expected<WAV>
+	{
+		if (header_decoder_)
+		{
+			auto decoder{std::move(*header_decoder_)};
+
+			header_decoder_ = std::nullopt;
+
+			return decoder;
+		}
+
+		return open_fn_();
+	}
+
 	OpenFn open_fn_;
+	bool can_open_cursors_;
+	std::optional<WAV> header_decoder_;
 	std::optional<WAV> stream_;
+	std::optional<FormatReader> stream_reader_;
+	AudioReader::ZeroCopy zero_copy_{AudioReader::ZeroCopy::unavailable};
 };
 
 auto make_handler(std::string utf8_path) -> typed::Handler
@@ -254,7 +455,7 @@ auto make_handler(std::string utf8_path) -> typed::Handler
 		return WAV::file(utf8_path);
 	};
 
-	return WavHandler{open_fn};
+	return WavHandler{open_fn, true};
 }
 
 auto make_handler(const AudioReader::Stream& stream) -> typed::Handler
@@ -264,7 +465,8 @@ auto make_handler(const AudioReader::Stream& stream) -> typed::Handler
 		return WAV::stream(drwav_stream_read, drwav_stream_seek, (void*)(&stream));
 	};
 
-	return WavHandler{open_fn};
+	// The stream can't be decoded by more than one decoder at once
+	return WavHandler{open_fn, false};
 }
 
 auto make_handler(const void* data, std::size_t data_size) -> typed::Handler
@@ -274,7 +476,7 @@ auto make_handler(const void* data, std::size_t data_size) -> typed::Handler
 		return WAV::memory(data, data_size);
 	};
 
-	return WavHandler{open_fn};
+	return WavHandler{open_fn, true};
 }
 
 auto make_attempt_order(typed::Handlers* handlers) -> std::vector<typed::Handler*>
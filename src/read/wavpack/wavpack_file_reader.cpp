@@ -1,23 +1,122 @@
 #include "wavpack_file_reader.h"
 #include <cassert>
+#include <utf8.h>
 #include <wavpack.h>
+#include "counters.h"
 
 namespace blahdio {
 namespace read {
 namespace wavpack {
 
+static std::FILE* open_file(const std::string& utf8_path)
+{
+#ifdef _WIN32
+	return _wfopen((const wchar_t*)(utf8::utf8to16(utf8_path).c_str()), L"rb");
+#else
+	return std::fopen(utf8_path.c_str(), "rb");
+#endif
+}
+
+static int file_seek(std::FILE* file, std::int64_t offset, int mode)
+{
+#ifdef _WIN32
+	return _fseeki64(file, offset, mode);
+#else
+	return fseeko(file, off_t(offset), mode);
+#endif
+}
+
+static std::int64_t file_tell(std::FILE* file)
+{
+#ifdef _WIN32
+	return _ftelli64(file);
+#else
+	return std::int64_t(ftello(file));
+#endif
+}
+
+static WavpackStreamReader64 make_file_stream_reader()
+{
+	WavpackStreamReader64 out;
+
+	out.read_bytes = [](void* id, void* data, std::int32_t bcount) -> std::int32_t
+	{
+		const auto bytes_read = std::fread(data, 1, std::size_t(bcount), (std::FILE*)(id));
+
+		stats::add(stats::Counter::bytes, bytes_read);
+
+		return std::int32_t(bytes_read);
+	};
+
+	out.get_pos = [](void* id) -> std::int64_t
+	{
+		return file_tell((std::FILE*)(id));
+	};
+
+	out.set_pos_abs = [](void* id, std::int64_t pos) -> int
+	{
+		return file_seek((std::FILE*)(id), pos, SEEK_SET);
+	};
+
+	out.set_pos_rel = [](void* id, std::int64_t delta, int mode) -> int
+	{
+		return file_seek((std::FILE*)(id), delta, mode);
+	};
+
+	out.push_back_byte = [](void* id, int c) -> int
+	{
+		return std::ungetc(c, (std::FILE*)(id));
+	};
+
+	out.get_length = [](void* id) -> std::int64_t
+	{
+		const auto file = (std::FILE*)(id);
+		const auto pos = file_tell(file);
+
+		file_seek(file, 0, SEEK_END);
+
+		const auto length = file_tell(file);
+
+		file_seek(file, pos, SEEK_SET);
+
+		return length;
+	};
+
+	out.can_seek = [](void*) -> int
+	{
+		return 1;
+	};
+
+	out.truncate_here = nullptr;
+	out.write_bytes = nullptr;
+	out.close = nullptr;
+
+	return out;
+}
+
+static WavpackStreamReader64 FILE_STREAM_READER = make_file_stream_reader();
+
 FileReader::FileReader(std::string utf8_path)
 	: utf8_path_(std::move(utf8_path))
 {
 }
 
+FileReader::~FileReader()
+{
+	release_opened();
+
+	if (file_)
+	{
+		std::fclose(file_);
+	}
+}
+
 WavpackContext* FileReader::open()
 {
 	assert (!utf8_path_.empty());
 
 	int flags = 0;
 
-	flags |= OPEN_2CH_MAX;
 	//flags |= OPEN_NORMALIZE;
 
 #ifdef _WIN32
@@ -26,7 +125,62 @@ WavpackContext* FileReader::open()
 
 	char error[80];
 
+	release_opened();
+
 	return WavpackOpenFileInput(utf8_path_.c_str(), error, flags, 0);
 }
 
-}}}
\ No newline at end of file
+WavpackContext* FileReader::open_at(std::int64_t offset)
+{
+	const auto file = open_file(utf8_path_);
+
+	if (!file) return nullptr;
+
+	if (file_seek(file, offset, SEEK_SET) != 0)
+	{
+		std::fclose(file);
+		return nullptr;
+	}
+
+	// Not OPEN_STREAMING, so that the context can still seek
+	int flags = 0;
+
+	char error[80];
+
+	const auto context = WavpackOpenFileInputEx64(&FILE_STREAM_READER, file, nullptr, error, flags, 0);
+
+	if (!context)
+	{
+		std::fclose(file);
+		return nullptr;
+	}
+
+	release_opened();
+
+	opened_file_ = file;
+
+	return context;
+}
+
+void FileReader::adopt_opened()
+{
+	// The previous context has already been closed
+	if (file_)
+	{
+		std::fclose(file_);
+	}
+
+	file_ = opened_file_;
+	opened_file_ = nullptr;
+}
+
+void FileReader::release_opened()
+{
+	if (opened_file_)
+	{
+		std::fclose(opened_file_);
+		opened_file_ = nullptr;
+	}
+}
+
+}}}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdio>
 #include <string>
 #include "wavpack_reader.h"
 
@@ -11,11 +12,21 @@ class FileReader : public Reader
 {
 	std::string utf8_path_;
 
+	// The files read by the current context and by the one just returned
+	// by open_at(), if they were opened by open_at(). WavPack doesn't
+	// close files it didn't open itself.
+	std::FILE* file_ = nullptr;
+	std::FILE* opened_file_ = nullptr;
+
 	WavpackContext* open() override;
+	WavpackContext* open_at(std::int64_t offset) override;
+	void adopt_opened() override;
+	void release_opened() override;
 
 public:
 
 	FileReader(std::string utf8_path);
+	~FileReader();
 };
 
-}}}
\ No newline at end of file
+}}}
@@ -0,0 +1,142 @@
+#include "wavpack_index.h"
+#include <vector>
+
+namespace blahdio {
+namespace read {
+namespace wavpack {
+
+static constexpr std::size_t HEADER_SIZE = 32;
+static constexpr std::size_t RESYNC_CHUNK_SIZE = 1 << 16;
+static constexpr std::uint32_t MIN_VERSION = 0x402;
+static constexpr std::uint32_t MAX_VERSION = 0x410;
+static constexpr std::uint32_t MAX_BLOCK_SIZE = 1 << 24;
+static constexpr std::uint32_t FLAG_INITIAL_BLOCK = 0x800;
+
+struct BlockHeader
+{
+	std::uint32_t block_size{0};
+	std::uint64_t block_index{0};
+	std::uint32_t block_samples{0};
+	std::uint32_t flags{0};
+};
+
+[[nodiscard]] static
+auto byte(const std::byte* data, std::size_t index) -> std::uint32_t
+{
+	return std::to_integer<std::uint32_t>(data[index]);
+}
+
+[[nodiscard]] static
+auto read_u32_le(const std::byte* data) -> std::uint32_t
+{
+	return byte(data, 0) | (byte(data, 1) << 8) | (byte(data, 2) << 16) | (byte(data, 3) << 24);
+}
+
+[[nodiscard]] static
+auto is_magic(const std::byte* data) -> bool
+{
+	return byte(data, 0) == 'w' && byte(data, 1) == 'v' && byte(data, 2) == 'p' && byte(data, 3) == 'k';
+}
+
+[[nodiscard]] static
+auto parse_block_header(const std::byte* data) -> std::optional<BlockHeader>
+{
+	if (!is_magic(data)) return std::nullopt;
+
+	const auto version{byte(data, 8) | (byte(data, 9) << 8)};
+
+	if (version < MIN_VERSION || version > MAX_VERSION) return std::nullopt;
+
+	BlockHeader out;
+
+	// ckSize doesn't include the first 8 bytes
+	out.block_size = read_u32_le(data + 4) + 8;
+	out.block_index = (std::uint64_t(byte(data, 10)) << 32) | read_u32_le(data + 16);
+	out.block_samples = read_u32_le(data + 20);
+	out.flags = read_u32_le(data + 24);
+
+	if (out.block_size < HEADER_SIZE || out.block_size > MAX_BLOCK_SIZE) return std::nullopt;
+
+	return out;
+}
+
+// Searches forward from pos for something which looks like a block
+// header. Only needed if there is junk between blocks.
+[[nodiscard]] static
+auto resync(const RawSource& source, std::uint64_t pos, const std::atomic<bool>& cancel) -> std::optional<std::uint64_t>
+{
+	std::vector<std::byte> chunk(RESYNC_CHUNK_SIZE);
+
+	for (;;)
+	{
+		if (cancel) return std::nullopt;
+
+		const auto chunk_size{source.read_at(pos, chunk.data(), chunk.size())};
+
+		if (chunk_size < HEADER_SIZE) return std::nullopt;
+
+		for (std::size_t i = 0; i + HEADER_SIZE <= chunk_size; i++)
+		{
+			if (parse_block_header(chunk.data() + i)) return pos + i;
+		}
+
+		pos += chunk_size - HEADER_SIZE + 1;
+	}
+}
+
+auto build_seek_index(const RawSource& source, const std::atomic<bool>& cancel) -> std::optional<SeekIndex>
+{
+	std::vector<SeekPoint> points;
+	std::uint64_t pos{0};
+
+	for (;;)
+	{
+		if (cancel) return std::nullopt;
+
+		std::byte data[HEADER_SIZE];
+
+		if (source.read_at(pos, data, HEADER_SIZE) != HEADER_SIZE) break;
+
+		const auto header{parse_block_header(data)};
+
+		if (!header)
+		{
+			const auto next_pos{resync(source, pos + 1, cancel)};
+
+			if (!next_pos) break;
+
+			pos = *next_pos;
+			continue;
+		}
+
+		// Multichannel audio is split into several blocks with the same
+		// index. Decoding has to start at the first one.
+		if ((header->flags & FLAG_INITIAL_BLOCK) && header->block_samples > 0)
+		{
+			if (points.empty() || header->block_index > points.back().frame)
+			{
+				SeekPoint point;
+
+				point.frame = header->block_index;
+				point.byte_offset = pos;
+				point.num_frames = header->block_samples;
+
+				points.push_back(point);
+			}
+		}
+
+		pos += header->block_size;
+	}
+
+	if (cancel || points.empty()) return std::nullopt;
+
+	SeekIndex out;
+
+	out.type = AudioType::wavpack;
+	out.source_size = source.size().value_or(0);
+	out.points = std::move(points);
+
+	return out;
+}
+
+}}}
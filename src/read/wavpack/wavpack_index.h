@@ -0,0 +1,16 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include "read/raw_source.h"
+#include "read/seek_index.h"
+
+namespace blahdio {
+namespace read {
+namespace wavpack {
+
+// Finds the start of every WavPack block by walking the block headers.
+// Returns nothing if the source isn't WavPack or the scan was cancelled.
+[[nodiscard]] extern auto build_seek_index(const RawSource& source, const std::atomic<bool>& cancel) -> std::optional<SeekIndex>;
+
+}}}
@@ -1,6 +1,7 @@
 #include "wavpack_memory_reader.h"
 #include <algorithm>
 #include <cstdio>
+#include "counters.h"
 
 namespace blahdio {
 namespace read {
@@ -70,6 +71,8 @@ void MemoryReader::init_stream_reader()
 
 		stream->pos += read_size;
 
+		stats::add(stats::Counter::bytes, std::uint64_t(read_size));
+
 		return read_size;
 	};
 
@@ -124,9 +127,12 @@ MemoryReader::MemoryReader(const void* data, std::size_t data_size)
 
 WavpackContext* MemoryReader::open()
 {
+	// A context opened by open_at() might have moved on
+	stream_.pos = 0;
+	stream_.ungetc_flag = false;
+
 	int flags = 0;
 
-	flags |= OPEN_2CH_MAX;
 	//flags |= OPEN_NORMALIZE;
 
 	char error[80];
@@ -134,4 +140,19 @@ WavpackContext* MemoryReader::open()
 	return WavpackOpenFileInputEx64(&stream_reader_, &stream_, nullptr, error, flags, 0);
 }
 
+WavpackContext* MemoryReader::open_at(std::int64_t offset)
+{
+	if (offset < 0 || std::size_t(offset) >= stream_.data_size) return nullptr;
+
+	stream_.pos = offset;
+	stream_.ungetc_flag = false;
+
+	// Not OPEN_STREAMING, so that the context can still seek
+	int flags = 0;
+
+	char error[80];
+
+	return WavpackOpenFileInputEx64(&stream_reader_, &stream_, nullptr, error, flags, 0);
+}
+
 }}}
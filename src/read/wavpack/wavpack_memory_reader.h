@@ -10,6 +10,7 @@ namespace wavpack {
 class MemoryReader : public Reader
 {
 	WavpackContext* open() override;
+	WavpackContext* open_at(std::int64_t offset) override;
 
 	struct Stream
 	{
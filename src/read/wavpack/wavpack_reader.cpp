@@ -2,14 +2,22 @@
 #include "wavpack_file_reader.h"
 #include "wavpack_stream_reader.h"
 #include "wavpack_memory_reader.h"
+#include "wavpack_index.h"
+#include "convert/int_to_float.h"
+#include "convert/sample_format.h"
+#include <algorithm>
 #include <fstream>
 #include <vector>
+#include <utility>
 #include <wavpack.h>
 
 namespace blahdio {
 namespace read {
 namespace wavpack {
 
+// Frames decoded at a time when skipping forward to a seek target
+static constexpr uint32_t SKIP_CHUNK_SIZE = 4096;
+
 Reader::~Reader()
 {
 	if (context_)
@@ -20,6 +28,8 @@ Reader::~Reader()
 
 bool Reader::try_read_header()
 {
+	if (context_) return true;
+
 	context_ = open();
 
 	if (!context_) return false;
@@ -30,31 +40,37 @@ bool Reader::try_read_header()
 	sample_rate_ = WavpackGetSampleRate(context_);
 	bit_depth_ = WavpackGetBitsPerSample(context_);
 
+	bytes_per_sample_ = WavpackGetBytesPerSample(context_);
+
 	const auto mode = WavpackGetMode(context_);
 
-	if ((mode & MODE_FLOAT) == MODE_FLOAT)
+	float_mode_ = (mode & MODE_FLOAT) == MODE_FLOAT;
+
+	if (float_mode_)
 	{
-		chunk_reader_ = [this](float* buffer, uint32_t read_size)
+		chunk_reader_ = [this](void* buffer, uint32_t read_size)
 		{
 			return WavpackUnpackSamples(context_, reinterpret_cast<int32_t*>(buffer), read_size);
 		};
 	}
 	else
 	{
-		chunk_reader_ = [this](float* buffer, uint32_t read_size)
+		chunk_reader_ = [this](void* out, uint32_t read_size)
 		{
-			const auto divisor = (1 << (bit_depth_ - 1)) - 1;
+			// Matches the scale the writer uses
+			const auto scale = 1.0f / float((std::int64_t(1) << (bit_depth_ - 1)) - 1);
+			const auto num_samples = size_t(num_channels_) * read_size;
 
-			unpacked_samples_buffer_.resize(size_t(num_channels_) * read_size);
+			// Only ever grows, so reads after reserve() don't touch the
+			// allocator
+			if (unpacked_samples_buffer_.size() < num_samples)
+			{
+				unpacked_samples_buffer_.resize(num_samples);
+			}
 
 			const auto frames_read = WavpackUnpackSamples(context_, unpacked_samples_buffer_.data(), read_size);
 
-			unpacked_samples_buffer_.resize(frames_read * num_channels_);
-
-			for (uint32_t i = 0; i < frames_read * num_channels_; i++)
-			{
-				buffer[i] = float(unpacked_samples_buffer_[i]) / divisor;
-			}
+			convert::s32_to_f32(unpacked_samples_buffer_.data(), (float*)(out), size_t(frames_read) * num_channels_, scale);
 
 			return frames_read;
 		};
@@ -63,7 +79,7 @@ bool Reader::try_read_header()
 	return true;
 }
 
-auto Reader::read_all_frames(Callbacks callbacks, uint32_t chunk_size) -> expected<void>
+auto Reader::read_all_frames(Callbacks callbacks, uint32_t chunk_size, OutputFormat output_format) -> expected<void>
 {
 	if (!context_)
 	{
@@ -75,7 +91,9 @@ auto Reader::read_all_frames(Callbacks callbacks, uint32_t chunk_size) -> expect
 		return tl::make_unexpected("Failed to read WavPack frames");
 	}
 
-	return do_read_all_frames(callbacks, chunk_size, chunk_reader_);
+	auto reader = make_format_reader(output_format);
+
+	return do_read_all_frames(callbacks, chunk_size, &reader);
 }
 
 uint32_t Reader::read_frames(uint32_t frames_to_read, float* buffer)
@@ -83,7 +101,56 @@ uint32_t Reader::read_frames(uint32_t frames_to_read, float* buffer)
 	return chunk_reader_(buffer, frames_to_read);
 }
 
-auto Reader::do_read_all_frames(Callbacks callbacks, uint32_t chunk_size, ChunkReader chunk_reader) -> expected<void>
+uint32_t Reader::read_frames_s32(uint32_t frames_to_read, int32_t* buffer)
+{
+	const auto frames_read = WavpackUnpackSamples(context_, buffer, frames_to_read);
+	const auto num_samples = size_t(frames_read) * num_channels_;
+
+	if (float_mode_)
+	{
+		convert::convert_samples(buffer, SampleFormat::f32, buffer, SampleFormat::s32, num_samples);
+
+		return frames_read;
+	}
+
+	// WavPack returns integers right justified in the number of bytes
+	// per sample of the original file
+	const auto shift = 32 - (bytes_per_sample_ * 8);
+
+	if (shift > 0)
+	{
+		for (size_t i = 0; i < num_samples; i++)
+		{
+			buffer[i] = int32_t(uint32_t(buffer[i]) << shift);
+		}
+	}
+
+	return frames_read;
+}
+
+void Reader::reserve(uint32_t max_frames_per_read)
+{
+	unpacked_samples_buffer_.reserve(size_t(num_channels_) * std::max(max_frames_per_read, SKIP_CHUNK_SIZE));
+}
+
+FormatReader Reader::make_format_reader(OutputFormat output_format)
+{
+	FormatReader::NativeReaders native_readers;
+
+	native_readers.f32 = [this](void* buffer, uint32_t read_size)
+	{
+		return read_frames(read_size, (float*)(buffer));
+	};
+
+	native_readers.s32 = [this](void* buffer, uint32_t read_size)
+	{
+		return read_frames_s32(read_size, (int32_t*)(buffer));
+	};
+
+	return FormatReader{native_readers, num_channels_, output_format};
+}
+
+auto Reader::do_read_all_frames(Callbacks callbacks, uint32_t chunk_size, FormatReader* reader) -> expected<void>
 {
 	uint64_t frame = 0;
 
@@ -91,8 +158,6 @@ auto Reader::do_read_all_frames(Callbacks callbacks, uint32_t chunk_size, ChunkR
 	{
 		if (callbacks.should_abort()) break;
 
-		std::vector<float> interleaved_frames;
-
 		auto read_size = chunk_size;
 
 		if (frame + read_size >= num_frames_)
@@ -100,11 +165,9 @@ auto Reader::do_read_all_frames(Callbacks callbacks, uint32_t chunk_size, ChunkR
 			read_size = uint32_t(num_frames_ - frame);
 		}
 
-		interleaved_frames.resize(size_t(read_size) * num_channels_);
-
-		const auto frames_read = chunk_reader(interleaved_frames.data(), read_size);
+		const auto frames_read = reader->read_chunk(read_size);
 
-		callbacks.return_chunk((const void*)(interleaved_frames.data()), frame, frames_read);
+		reader->return_chunk(callbacks, frame, frames_read);
 
 		if (frames_read < read_size)
 		{
@@ -119,57 +182,155 @@ auto Reader::do_read_all_frames(Callbacks callbacks, uint32_t chunk_size, ChunkR
 
 bool Reader::seek(uint64_t target_frame)
 {
+	if (seek_index_ && seek_using_index(target_frame)) return true;
+
+	// WavPack can't seek to frames before the start of a context opened
+	// part way through, so go back to one which covers the whole source
+	if (context_start_frame_ > 0)
+	{
+		const auto context = open();
+
+		if (!context) return false;
+
+		replace_context(context, 0);
+	}
+
 	return WavpackSeekSample64(context_, target_frame);
 }
 
+void Reader::replace_context(WavpackContext* context, uint64_t start_frame)
+{
+	WavpackCloseFile(context_);
+	context_ = context;
+	context_start_frame_ = start_frame;
+	adopt_opened();
+}
+
+void Reader::discard_context(WavpackContext* context)
+{
+	WavpackCloseFile(context);
+	release_opened();
+}
+
+void Reader::set_seek_index(std::shared_ptr<const SeekIndex> index)
+{
+	seek_index_ = std::move(index);
+}
+
+bool Reader::seek_using_index(uint64_t target_frame)
+{
+	const auto& points = seek_index_->points;
+
+	const auto is_before = [](uint64_t frame, const SeekPoint& point)
+	{
+		return frame < point.frame;
+	};
+
+	const auto next = std::upper_bound(points.begin(), points.end(), target_frame, is_before);
+
+	if (next == points.begin()) return false;
+
+	const auto& point = *std::prev(next);
+
+	if (target_frame >= point.frame + point.num_frames && next == points.end()) return false;
+
+	const auto context = open_at(std::int64_t(point.byte_offset));
+
+	if (!context) return false;
+
+	// The current context is kept if this fails, so that the caller can
+	// still fall back to seeking with it
+	if (!skip_frames(context, target_frame - point.frame))
+	{
+		discard_context(context);
+		return false;
+	}
+
+	replace_context(context, point.frame);
+
+	return true;
+}
+
+bool Reader::skip_frames(WavpackContext* context, uint64_t num_frames)
+{
+	if (unpacked_samples_buffer_.size() < size_t(num_channels_) * SKIP_CHUNK_SIZE)
+	{
+		unpacked_samples_buffer_.resize(size_t(num_channels_) * SKIP_CHUNK_SIZE);
+	}
+
+	while (num_frames > 0)
+	{
+		const auto read_size = uint32_t(std::min<uint64_t>(num_frames, SKIP_CHUNK_SIZE));
+		const auto frames_read = WavpackUnpackSamples(context, unpacked_samples_buffer_.data(), read_size);
+
+		if (frames_read < read_size) return false;
+
+		num_frames -= frames_read;
+	}
+
+	return true;
+}
+
 struct WavPackHandler
 {
 	using OpenFn = std::function<expected<std::shared_ptr<Reader>>()>;
 
-	WavPackHandler(OpenFn open_fn) : open_fn_{open_fn} {}
+	WavPackHandler(OpenFn open_fn, RawSource raw_source) : open_fn_{open_fn}, raw_source_{raw_source} {}
 
 	auto type() const -> AudioType { return AudioType::wavpack; }
+	auto zero_copy() const -> AudioReader::ZeroCopy { return AudioReader::ZeroCopy::unavailable; }
 
-	auto try_read_header() -> expected<AudioDataFormat>
+	auto try_read_header(bool keep_decoder) -> expected<AudioDataFormat>
 	{
-		const auto get_header_info = [=](std::shared_ptr<Reader> reader) -> expected<AudioDataFormat>
+		if (header_decoder_)
+		{
+			return header_decoder_->get_header_info();
+		}
+
+		const auto get_header_info = [this, keep_decoder](std::shared_ptr<Reader> reader) -> expected<AudioDataFormat>
 		{
 			if (!reader->try_read_header())
 			{
 				return tl::make_unexpected("Failed to read WavPack header");
 			}
 
+			if (keep_decoder)
+			{
+				header_decoder_ = reader;
+			}
+
 			return reader->get_header_info();
 		};
 
 		return open_fn_().and_then(get_header_info);
 	}
 
-	auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size) -> expected<void>
+	auto read_frames(AudioReader::Callbacks callbacks, const AudioDataFormat& format, uint32_t chunk_size, typed::ReadOptions options) -> expected<void>
 	{
 		const auto read_frames = [=](std::shared_ptr<Reader> reader)
 		{
 			wavpack::Reader::Callbacks reader_callbacks;
 
 			reader_callbacks.return_chunk = callbacks.return_chunk;
+			reader_callbacks.return_planar_chunk = callbacks.return_planar_chunk;
 			reader_callbacks.should_abort = callbacks.should_abort;
 
-			return reader->read_all_frames(reader_callbacks, chunk_size);
+			return reader->read_all_frames(reader_callbacks, chunk_size, options.output_format);
 		};
 
-		return open_fn_().and_then(read_frames);
+		return open_decoder().and_then(read_frames);
 	}
 
-	auto stream_open() -> expected<AudioDataFormat>
+	auto stream_open(OutputFormat output_format) -> expected<AudioDataFormat>
 	{
 		if (stream_)
 		{
 			return tl::make_unexpected("Failed to open WavPack stream (It is already open)");
 		}
 
-		const auto open_stream = [=]() -> expected<void>
+		const auto open_stream = [=, this]() -> expected<void>
 		{
-			auto result{open_fn_()};
+			auto result{open_decoder()};
 
 			if (!result)
 			{
@@ -180,13 +341,15 @@ struct WavPackHandler
 			return {};
 		};
 
-		const auto get_header_info = [=]() -> expected<AudioDataFormat>
+		const auto get_header_info = [=, this]() -> expected<AudioDataFormat>
 		{
 			if (!stream_->try_read_header())
 			{
 				return tl::make_unexpected("Failed to read WavPack header");
 			}
 
+			stream_reader_.emplace(stream_->make_format_reader(output_format));
+
 			return stream_->get_header_info();
 		};
 
@@ -200,23 +363,40 @@ struct WavPackHandler
 			return tl::make_unexpected("Failed to read frames from the WavPack stream (The stream is not open)");
 		}
 
-		return stream_->read_frames(frames_to_read, (float*)(buffer));
+		return stream_reader_->read(buffer, frames_to_read);
 	}
 
-	[[nodiscard]]
-	auto stream_seek(uint64_t target_frame) -> expected<void>
+	auto stream_read_planar(void* const* channels, uint32_t frames_to_read) -> expected<uint32_t>
 	{
 		if (!stream_)
 		{
-			return tl::make_unexpected("Failed to seek the WavPack stream (The stream is not open)");
+			return tl::make_unexpected("Failed to read frames from the WavPack stream (The stream is not open)");
 		}
 
-		if (!stream_->seek(target_frame))
+		return stream_reader_->read_planar(channels, frames_to_read);
+	}
+
+	[[nodiscard]]
+	auto stream_seek(uint64_t target_frame) -> bool
+	{
+		if (!stream_) return false;
+
+		if (!reserved_)
 		{
-			return tl::make_unexpected("Failed to seek the WavPack stream for some reason");
+			set_seek_index_if_ready();
 		}
 
-		return {};
+		return stream_->seek(target_frame);
+	}
+
+	auto stream_reserve(uint32_t max_frames_per_read) -> void
+	{
+		if (!stream_) return;
+
+		set_seek_index_if_ready();
+		stream_->reserve(max_frames_per_read);
+		stream_reader_->reserve(max_frames_per_read);
+		reserved_ = true;
 	}
 
 	[[nodiscard]]
@@ -227,24 +407,115 @@ struct WavPackHandler
 			return tl::make_unexpected("Failed to close WavPack stream (The stream is not open)");
 		}
 
+		stream_reader_.reset();
 		stream_.reset();
+		reserved_ = false;
+		return {};
+	}
+
+	[[nodiscard]]
+	auto open_cursor(OutputFormat output_format) -> expected<Cursor>
+	{
+		// Sources which can be scanned for a seek index (files and memory)
+		// can also be decoded by more than one decoder at once
+		if (!raw_source_)
+		{
+			return tl::make_unexpected("Failed to open WavPack cursor (The source can't be decoded more than once at a time)");
+		}
+
+		const auto make_cursor = [this, output_format](std::shared_ptr<Reader> reader) -> expected<Cursor>
+		{
+			if (!reader->try_read_header())
+			{
+				return tl::make_unexpected("Failed to read WavPack header");
+			}
+
+			if (const auto index{seek_index_.try_get()})
+			{
+				reader->set_seek_index(index);
+			}
+
+			const auto seek = [reader = reader.get()](uint64_t frame)
+			{
+				return reader->seek(frame);
+			};
+
+			return Cursor{reader, reader->make_format_reader(output_format), seek};
+		};
+
+		return open_fn_().and_then(make_cursor);
+	}
+
+	auto build_seek_index() -> void
+	{
+		if (!raw_source_) return;
+
+		seek_index_.start([raw_source = raw_source_](const std::atomic<bool>& cancel)
+		{
+			return wavpack::build_seek_index(raw_source, cancel);
+		});
+	}
+
+	[[nodiscard]]
+	auto set_seek_index(SeekIndex index) -> expected<void>
+	{
+		seek_index_.set(std::move(index));
 		return {};
 	}
 
+	[[nodiscard]]
+	auto get_seek_index() const -> expected<SeekIndex>
+	{
+		const auto index{seek_index_.wait()};
+
+		if (!index)
+		{
+			return tl::make_unexpected("Failed to get WavPack seek index (It hasn't been built)");
+		}
+
+		return *index;
+	}
+
 private:
 
+	// Hands over the reader which was kept open by try_read_header(), or
+	// opens a new one if there isn't one
+	[[nodiscard]]
+	auto open_decoder() -> expected<std::shared_ptr<Reader>>
+	{
+		if (header_decoder_)
+		{
+			return std::exchange(header_decoder_, nullptr);
+		}
+
+		return open_fn_();
+	}
+
+	auto set_seek_index_if_ready() -> void
+	{
+		if (const auto index{seek_index_.try_get()})
+		{
+			stream_->set_seek_index(index);
+		}
+	}
+
 	OpenFn open_fn_;
+	RawSource raw_source_;
+	std::shared_ptr<Reader> header_decoder_;
 	std::shared_ptr<Reader> stream_;
+	std::optional<FormatReader> stream_reader_;
+	mutable BackgroundSeekIndex seek_index_;
+	bool reserved_{false};
 };
 
-auto make_handler(std::string utf8_path) -> typed::Handler
+auto make_handler(std::string utf8_path, RawSource raw_source) -> typed::Handler
 {
 	auto open_fn = [utf8_path = std::move(utf8_path)]
 	{
 		return std::make_shared<wavpack::FileReader>(utf8_path);
 	};
 
-	return WavPackHandler{open_fn};
+	return WavPackHandler{open_fn, raw_source};
 }
 
 auto make_handler(const AudioReader::Stream& stream) -> typed::Handler
@@ -254,17 +525,18 @@ auto make_handler(const AudioReader::Stream& stream) -> typed::Handler
 		return std::make_shared<wavpack::StreamReader>(stream);
 	};
 
-	return WavPackHandler{open_fn};
+	// The stream can't be scanned while it is being decoded
+	return WavPackHandler{open_fn, {}};
 }
 
-auto make_handler(const void* data, std::size_t data_size) -> typed::Handler
+auto make_handler(const void* data, std::size_t data_size, RawSource raw_source) -> typed::Handler
 {
 	auto open_fn = [data, data_size]
 	{
 		return std::make_shared<wavpack::MemoryReader>(data, data_size);
 	};
 
-	return WavPackHandler{open_fn};
+	return WavPackHandler{open_fn, raw_source};
 }
 
 auto make_attempt_order(typed::Handlers* handlers) -> std::vector<typed::Handler*>
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+#include "read/format_reader.h"
 #include "read/generic_reader.h"
 #include "read/typed_read_handler.h"
 
@@ -16,29 +18,65 @@ public:
 	~Reader();
 
 	bool try_read_header();
-	auto read_all_frames(Callbacks callbacks, uint32_t chunk_size) -> expected<void> override;
+	auto read_all_frames(Callbacks callbacks, uint32_t chunk_size, OutputFormat output_format) -> expected<void> override;
 	std::uint32_t read_frames(std::uint32_t frames_to_read, float* buffer);
+
+	// Full scale 32 bit integers, whatever the bit depth of the source
+	std::uint32_t read_frames_s32(std::uint32_t frames_to_read, std::int32_t* buffer);
+
+	FormatReader make_format_reader(OutputFormat output_format);
+
+	// Makes room for reads of up to this many frames, and for skipping
+	// frames while seeking, so that neither allocates our own buffers.
+	// WavPack itself still allocates when it moves on to a new block.
+	void reserve(std::uint32_t max_frames_per_read);
 	bool seek(std::uint64_t target_frame);
 
+	// If there is an index, seeking reopens the decoder at the nearest
+	// block instead of letting WavPack search for it
+	void set_seek_index(std::shared_ptr<const SeekIndex> index);
+
 protected:
 
-	using ChunkReader = std::function<std::uint32_t(float* buffer, uint32_t read_size)>;
+	using ChunkReader = std::function<std::uint32_t(void* buffer, uint32_t read_size)>;
+
+	virtual auto do_read_all_frames(Callbacks callbacks, uint32_t chunk_size, FormatReader* reader) -> expected<void>;
 
 private:
 
 	WavpackContext* context_ = nullptr;
 	ChunkReader chunk_reader_;
+	bool float_mode_ = false;
+	int bytes_per_sample_ = 0;
 	std::vector<std::int32_t> unpacked_samples_buffer_;
+	std::shared_ptr<const SeekIndex> seek_index_;
+
+	// WavPack counts the frames of a context opened by open_at() from
+	// the block it was opened at
+	std::uint64_t context_start_frame_ = 0;
 
 	virtual WavpackContext* open() = 0;
 
-	virtual auto do_read_all_frames(Callbacks callbacks, uint32_t chunk_size, ChunkReader chunk_reader) -> expected<void>;
+	// Opens a new context which starts decoding from the block at
+	// the given byte offset. Returns null if the source can't do that.
+	virtual WavpackContext* open_at(std::int64_t) { return nullptr; }
+
+	// Called when the context returned by the last open() or open_at()
+	// replaces the current one, or is closed instead, for sources which
+	// keep something open for each context
+	virtual void adopt_opened() {}
+	virtual void release_opened() {}
+
+	void replace_context(WavpackContext* context, std::uint64_t start_frame);
+	void discard_context(WavpackContext* context);
+	bool seek_using_index(std::uint64_t target_frame);
+	bool skip_frames(WavpackContext* context, std::uint64_t num_frames);
 
 };
 
-extern auto make_handler(std::string utf8_path) -> typed::Handler;
+extern auto make_handler(std::string utf8_path, RawSource raw_source) -> typed::Handler;
 extern auto make_handler(const AudioReader::Stream& stream) -> typed::Handler;
-extern auto make_handler(const void* data, std::size_t data_size) -> typed::Handler;
+extern auto make_handler(const void* data, std::size_t data_size, RawSource raw_source) -> typed::Handler;
 extern auto make_attempt_order(typed::Handlers* handlers) -> std::vector<typed::Handler*>;
 
 }}}
\ No newline at end of file
@@ -1,14 +1,28 @@
 #include "wavpack_stream_reader.h"
+#include "counters.h"
 
 namespace blahdio {
 namespace read {
 namespace wavpack {
 
+int StreamReader::seek_abs(Stream* stream, std::int64_t pos)
+{
+	if (!stream->client_stream.seek || pos < 0) return -1;
+	if (!stream->client_stream.seek(AudioReader::Stream::SeekOrigin::Start, pos)) return -1;
+
+	stream->pos = pos;
+	stream->ungetc_flag = false;
+
+	return 0;
+}
+
 void StreamReader::init_stream_reader()
 {
 	stream_reader_.can_seek = [](void* id) -> int
 	{
-		return 0;
+		const auto stream = (Stream*)(id);
+
+		return stream->client_stream.seek && stream->client_stream.get_size;
 	};
 
 	stream_reader_.close = [](void* id) -> int
@@ -18,18 +32,26 @@ void StreamReader::init_stream_reader()
 
 	stream_reader_.get_length = [](void* id) -> std::int64_t
 	{
-		return 0;
+		const auto stream = (Stream*)(id);
+
+		if (!stream->client_stream.get_size) return 0;
+
+		return std::int64_t(stream->client_stream.get_size());
 	};
 
 	stream_reader_.get_pos = [](void* id) -> std::int64_t
 	{
-		return 0;
+		const auto stream = (Stream*)(id);
+
+		return stream->pos;
 	};
 
 	stream_reader_.push_back_byte = [](void* id, int c) -> int
 	{
 		const auto stream = (Stream*)(id);
 
+		stream->ungetc_char = (unsigned char)(c);
+		stream->ungetc_flag = true;
 		stream->pos--;
 
 		return c;
@@ -41,26 +63,51 @@ void StreamReader::init_stream_reader()
 
 		if (bcount < 1) return 0;
 
+		auto out = (unsigned char*)(data);
+		std::int32_t bytes_read = 0;
+
 		if (stream->ungetc_flag)
 		{
-			*((char*)(data)) = stream->ungetc_char;
+			*out++ = stream->ungetc_char;
 			stream->ungetc_flag = false;
+			bytes_read++;
 			bcount--;
 		}
 
-		if (bcount < 1) return 0;
+		if (bcount > 0)
+		{
+			bytes_read += std::int32_t(stream->client_stream.read_bytes(out, bcount));
+		}
+
+		stream->pos += bytes_read;
+
+		stats::add(stats::Counter::bytes, std::uint64_t(bytes_read));
 
-		return std::int32_t(stream->client_stream.read_bytes(data, bcount));
+		return bytes_read;
 	};
 
 	stream_reader_.set_pos_abs = [](void* id, std::int64_t pos) -> int
 	{
-		return 0;
+		return seek_abs((Stream*)(id), pos);
 	};
 
 	stream_reader_.set_pos_rel = [](void* id, std::int64_t delta, int mode) -> int
 	{
-		return 0;
+		const auto stream = (Stream*)(id);
+
+		switch (mode)
+		{
+			case SEEK_SET: return seek_abs(stream, delta);
+			case SEEK_CUR: return seek_abs(stream, stream->pos + delta);
+			case SEEK_END:
+			{
+				if (!stream->client_stream.get_size) return -1;
+
+				return seek_abs(stream, std::int64_t(stream->client_stream.get_size()) + delta);
+			}
+		}
+
+		return -1;
 	};
 
 	stream_reader_.truncate_here = nullptr;
@@ -74,34 +121,67 @@ StreamReader::StreamReader(const AudioReader::Stream& stream)
 	stream_.client_stream = stream;
 }
 
+bool StreamReader::is_seekable() const
+{
+	return stream_.client_stream.seek && stream_.client_stream.get_size;
+}
+
 WavpackContext* StreamReader::open()
 {
 	int flags = 0;
 
-	flags |= OPEN_2CH_MAX;
 	//flags |= OPEN_NORMALIZE;
-	flags |= OPEN_STREAMING;
+
+	if (stream_.client_stream.seek)
+	{
+		// Another reader might have already read from the stream
+		if (seek_abs(&stream_, 0) != 0) return nullptr;
+	}
+
+	if (!is_seekable())
+	{
+		flags |= OPEN_STREAMING;
+	}
+
+	char error[80];
+
+	return WavpackOpenFileInputEx64(&stream_reader_, &stream_, nullptr, error, flags, 0);
+}
+
+WavpackContext* StreamReader::open_at(std::int64_t offset)
+{
+	if (!is_seekable()) return nullptr;
+	if (seek_abs(&stream_, offset) != 0) return nullptr;
+
+	// Not OPEN_STREAMING, so that the context can still seek
+	int flags = 0;
 
 	char error[80];
 
 	return WavpackOpenFileInputEx64(&stream_reader_, &stream_, nullptr, error, flags, 0);
 }
 
-auto StreamReader::do_read_all_frames(Callbacks callbacks, std::uint32_t chunk_size, ChunkReader chunk_reader) -> expected<void>
+auto StreamReader::do_read_all_frames(Callbacks callbacks, std::uint32_t chunk_size, FormatReader* reader) -> expected<void>
 {
+	// The number of frames is known if WavPack could look at the end of
+	// the stream
+	if (is_seekable())
+	{
+		return Reader::do_read_all_frames(callbacks, chunk_size, reader);
+	}
+
 	std::uint64_t frame = 0;
 
 	for (;;)
 	{
 		if (callbacks.should_abort()) break;
 
-		std::vector<float> interleaved_frames;
-
-		interleaved_frames.resize(size_t(chunk_size) * num_channels_);
+		const auto frames_read = reader->read_chunk(chunk_size);
 
-		const auto frames_read = chunk_reader(interleaved_frames.data(), chunk_size);
-
-		callbacks.return_chunk((const void*)(interleaved_frames.data()), frame, chunk_size);
+		if (frames_read > 0)
+		{
+			reader->return_chunk(callbacks, frame, frames_read);
+		}
 
 		if (frames_read < chunk_size) break;
 
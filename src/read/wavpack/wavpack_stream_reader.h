@@ -10,10 +10,14 @@ namespace wavpack {
 class StreamReader : public Reader
 {
 	WavpackContext* open() override;
+	WavpackContext* open_at(std::int64_t offset) override;
 
 	struct Stream
 	{
 		AudioReader::Stream client_stream;
+
+		// Position as seen by WavPack, which is one byte behind the client
+		// stream while there is a pushed back byte
 		std::int64_t pos = 0;
 		unsigned char ungetc_char;
 		bool ungetc_flag = false;
@@ -22,8 +26,12 @@ class StreamReader : public Reader
 	WavpackStreamReader64 stream_reader_;
 
 	void init_stream_reader();
+	bool is_seekable() const;
+
+	// Returns 0 on success, like fseek()
+	static int seek_abs(Stream* stream, std::int64_t pos);
 
-	auto do_read_all_frames(Callbacks callbacks, uint32_t chunk_size, ChunkReader chunk_reader) -> expected<void> override; 
+	auto do_read_all_frames(Callbacks callbacks, uint32_t chunk_size, FormatReader* reader) -> expected<void> override;
 
 public:
 
@@ -0,0 +1,132 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace blahdio {
+
+ThreadPool::ThreadPool(int num_threads)
+{
+	if (num_threads <= 0)
+	{
+		num_threads = std::max(1, int(std::thread::hardware_concurrency()));
+	}
+
+	for (int i = 0; i < num_threads; i++)
+	{
+		queues_.push_back(std::make_unique<Queue>());
+	}
+
+	for (int i = 0; i < num_threads; i++)
+	{
+		threads_.emplace_back([this, i]() { run(std::size_t(i)); });
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock{mutex_};
+		stop_ = true;
+	}
+
+	cv_.notify_all();
+
+	for (auto& thread : threads_)
+	{
+		thread.join();
+	}
+}
+
+// Counted before it is queued so the count never falls below the number
+// of tasks in the queues
+auto ThreadPool::push(std::size_t index, Task task) -> void
+{
+	{
+		std::lock_guard lock{mutex_};
+		num_queued_++;
+	}
+
+	std::lock_guard lock{queues_[index]->mutex};
+	queues_[index]->tasks.push_back(std::move(task));
+}
+
+auto ThreadPool::submit(Task task) -> void
+{
+	push(next_queue_++ % queues_.size(), std::move(task));
+
+	cv_.notify_one();
+}
+
+auto ThreadPool::submit(std::vector<Task> tasks) -> void
+{
+	for (auto& task : tasks)
+	{
+		push(next_queue_++ % queues_.size(), std::move(task));
+	}
+
+	cv_.notify_all();
+}
+
+auto ThreadPool::try_pop(std::size_t index) -> std::optional<Task>
+{
+	const auto take = [this](Queue* queue, bool from_back) -> std::optional<Task>
+	{
+		std::lock_guard lock{queue->mutex};
+
+		if (queue->tasks.empty()) return std::nullopt;
+
+		Task task;
+
+		if (from_back)
+		{
+			task = std::move(queue->tasks.back());
+			queue->tasks.pop_back();
+		}
+		else
+		{
+			task = std::move(queue->tasks.front());
+			queue->tasks.pop_front();
+		}
+
+		return task;
+	};
+
+	if (auto task{take(queues_[index].get(), true)})
+	{
+		return task;
+	}
+
+	for (std::size_t i = 1; i < queues_.size(); i++)
+	{
+		if (auto task{take(queues_[(index + i) % queues_.size()].get(), false)})
+		{
+			return task;
+		}
+	}
+
+	return std::nullopt;
+}
+
+auto ThreadPool::run(std::size_t index) -> void
+{
+	for (;;)
+	{
+		if (auto task{try_pop(index)})
+		{
+			{
+				std::lock_guard lock{mutex_};
+				num_queued_--;
+			}
+
+			(*task)();
+			continue;
+		}
+
+		std::unique_lock lock{mutex_};
+
+		cv_.wait(lock, [this]() { return stop_ || num_queued_ > 0; });
+
+		if (stop_ && num_queued_ == 0) return;
+	}
+}
+
+}
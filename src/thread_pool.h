@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace blahdio {
+
+// Each thread has its own queue and takes work from the back of it.
+// When that runs out it steals from the front of the others, so a few
+// long tasks don't hold up the short ones queued behind them.
+class ThreadPool
+{
+public:
+
+	using Task = std::function<void()>;
+
+	// 0 means one thread per hardware thread
+	explicit ThreadPool(int num_threads);
+
+	// Tasks already submitted are finished first
+	~ThreadPool();
+
+	auto submit(Task task) -> void;
+
+	// Spreads the tasks across all of the queues
+	auto submit(std::vector<Task> tasks) -> void;
+
+	auto get_num_threads() const -> int { return int(threads_.size()); }
+
+private:
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	auto run(std::size_t index) -> void;
+	auto try_pop(std::size_t index) -> std::optional<Task>;
+	auto push(std::size_t index, Task task) -> void;
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> threads_;
+	std::atomic<std::size_t> next_queue_{0};
+
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::size_t num_queued_{0};
+	bool stop_{false};
+};
+
+}
@@ -0,0 +1,29 @@
+#include "trace.h"
+#include "blahdio/tracing.h"
+
+namespace blahdio {
+
+#if BLAHDIO_ENABLE_TRACING
+
+namespace trace {
+
+std::atomic<const TracingCallbacks*> callbacks{};
+
+} // trace
+
+auto set_tracing_callbacks(const TracingCallbacks* callbacks) -> bool
+{
+	trace::callbacks.store(callbacks, std::memory_order_release);
+	return true;
+}
+
+#else
+
+auto set_tracing_callbacks(const TracingCallbacks*) -> bool
+{
+	return false;
+}
+
+#endif
+
+} // blahdio
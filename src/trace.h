@@ -0,0 +1,62 @@
+#pragma once
+
+// BLAHDIO_TRACE_ZONE("blahdio::name") reports the rest of the enclosing
+// scope as a zone. BLAHDIO_TRACE_ZONE_AT(zone) does the same for a
+// TraceZone defined elsewhere. Both expand to nothing, and their
+// arguments aren't evaluated, unless BLAHDIO_ENABLE_TRACING is set.
+
+#if BLAHDIO_ENABLE_TRACING
+
+#include <atomic>
+#include "blahdio/tracing.h"
+
+namespace blahdio {
+namespace trace {
+
+extern std::atomic<const TracingCallbacks*> callbacks;
+
+class Zone
+{
+public:
+
+	explicit Zone(const TraceZone& zone)
+		: callbacks_{callbacks.load(std::memory_order_acquire)}
+		, zone_{zone}
+	{
+		if (callbacks_) token_ = callbacks_->begin(zone_, callbacks_->user_data);
+	}
+
+	~Zone()
+	{
+		if (callbacks_) callbacks_->end(zone_, token_, callbacks_->user_data);
+	}
+
+	Zone(const Zone&) = delete;
+	auto operator=(const Zone&) -> Zone& = delete;
+
+private:
+
+	// The ones the zone began with, even if they have been replaced since
+	const TracingCallbacks* callbacks_;
+	const TraceZone& zone_;
+	std::uint64_t token_{};
+};
+
+}}
+
+#define BLAHDIO_TRACE_CONCAT_(a, b) a##b
+#define BLAHDIO_TRACE_CONCAT(a, b) BLAHDIO_TRACE_CONCAT_(a, b)
+
+#define BLAHDIO_TRACE_ZONE_AT(zone) \
+	const ::blahdio::trace::Zone BLAHDIO_TRACE_CONCAT(blahdio_trace_zone_, __LINE__){zone}
+
+#define BLAHDIO_TRACE_ZONE(name) \
+	static constexpr ::blahdio::TraceZone BLAHDIO_TRACE_CONCAT(blahdio_trace_location_, __LINE__){name, __FILE__, __LINE__}; \
+	BLAHDIO_TRACE_ZONE_AT(BLAHDIO_TRACE_CONCAT(blahdio_trace_location_, __LINE__))
+
+#else
+
+#define BLAHDIO_TRACE_ZONE_AT(zone)
+#define BLAHDIO_TRACE_ZONE(name)
+
+#endif
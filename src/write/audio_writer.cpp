@@ -1,4 +1,5 @@
 #include "blahdio/audio_writer.h"
+#include "counters.h"
 #include "typed_write_handler.h"
 
 namespace blahdio {
@@ -12,16 +13,44 @@ public:
 	AudioWriter(const std::string& utf8_path, AudioType type, const AudioDataFormat& format);
 	AudioWriter(const blahdio::AudioWriter::Stream& stream, AudioType type, const AudioDataFormat& format);
 
+	void set_dither(Dither dither) { options_.dither = dither; }
 	void write_frames(blahdio::AudioWriter::Callbacks callbacks, std::uint32_t chunk_size);
 
+	Stats get_stats() const { return counters_.get(); }
+
 private:
 
 	write::typed::Handler typed_handler_;
+	write::typed::Options options_;
+	stats::Counters counters_{stats::Kind::writing};
 };
 
-void AudioWriter::write_frames(blahdio::AudioWriter::Callbacks callbacks, std::uint32_t chunk_size)
+void AudioWriter::write_frames(blahdio::AudioWriter::Callbacks client_callbacks, std::uint32_t chunk_size)
 {
-	typed_handler_.write_frames(callbacks, chunk_size);
+	stats::Scope stats_scope{&counters_};
+
+	// Times the caller's callbacks and counts the frames taken from them
+	auto callbacks{client_callbacks};
+
+	if (client_callbacks.should_abort)
+	{
+		callbacks.should_abort = [&client_callbacks]()
+		{
+			stats::Timer timer{stats::Counter::callback_ns};
+
+			return client_callbacks.should_abort();
+		};
+	}
+
+	callbacks.get_next_chunk = [&client_callbacks](float* buffer, std::uint64_t frame, std::uint32_t num_frames)
+	{
+		stats::add(stats::Counter::frames, num_frames);
+		stats::Timer timer{stats::Counter::callback_ns};
+
+		client_callbacks.get_next_chunk(buffer, frame, num_frames);
+	};
+
+	typed_handler_.write_frames(callbacks, chunk_size, options_);
 }
 
 AudioWriter::AudioWriter(const std::string& utf8_path, AudioType type, const AudioDataFormat& format)
@@ -51,10 +80,20 @@ AudioWriter::~AudioWriter()
 	delete impl_;
 }
 
+void AudioWriter::set_dither(Dither dither)
+{
+	impl_->set_dither(dither);
+}
+
 void AudioWriter::write_frames(Callbacks callbacks, std::uint32_t chunk_size)
 {
 	impl_->write_frames(callbacks, chunk_size);
 }
 
+Stats AudioWriter::get_stats() const
+{
+	return impl_->get_stats();
+}
+
 
 }
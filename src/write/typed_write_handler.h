@@ -6,9 +6,15 @@ namespace blahdio {
 namespace write {
 namespace typed {
 
+// Settings which apply to every type of writer
+struct Options
+{
+	Dither dither{Dither::triangular};
+};
+
 struct Handler
 {
-	using WriteFramesFunc = std::function<void(AudioWriter::Callbacks, std::uint32_t)>;
+	using WriteFramesFunc = std::function<void(AudioWriter::Callbacks, std::uint32_t, const Options&)>;
 
 	WriteFramesFunc write_frames;
 };
@@ -1,6 +1,10 @@
 #include "wav_writer.h"
 #include "mackron/blahdio_dr_libs.h"
-#include <miniaudio.h>
+#include "convert/quantize.h"
+#include "counters.h"
+#include "trace.h"
+#include <cstddef>
+#include <optional>
 #include <stdexcept>
 #include <vector>
 
@@ -60,52 +64,23 @@ static drwav_bool32 drwav_stream_seek(void* user_data, int offset, drwav_seek_or
 	return stream->seek(convert(origin), offset);
 }
 
-static ma_format get_miniaudio_pcm_format(int bit_depth)
+static void drwav_write_frames(drwav* wav, AudioWriter::Callbacks callbacks, const AudioDataFormat& format, std::uint32_t chunk_size, const typed::Options& options)
 {
-	switch (bit_depth)
-	{
-		case 8: return ma_format_u8;
-		case 16: return ma_format_s16;
-		case 24: return ma_format_s24;
-		case 32: default: return ma_format_s32;
-	}
-}
-
-template <AudioDataFormat::StorageType TYPE>
-drwav_uint64 drwav_write_f32_pcm_frames(drwav* wav, size_t write_size, int num_channels, const float* frames, int bit_depth)
-{
-	return drwav_write_pcm_frames(wav, write_size, frames);
-}
-
-template <>
-drwav_uint64 drwav_write_f32_pcm_frames<AudioDataFormat::StorageType::Int>(drwav* wav, size_t write_size, int num_channels, const float* frames, int bit_depth)
-{
-	std::vector<char> buffer(size_t(bit_depth / 8) * num_channels * write_size);
+	std::uint64_t frame = 0;
 
-	ma_convert_pcm_frames_format(buffer.data(), get_miniaudio_pcm_format(bit_depth), frames, ma_format_f32, write_size, num_channels, ma_dither_mode_triangle);
+	// Allocated once for the whole session. Chunks are never bigger than
+	// chunk_size so they don't grow after this.
+	std::vector<float> interleaved_frames;
+	std::vector<std::byte> pcm_frames;
+	std::optional<convert::Quantizer> quantizer;
 
-	return drwav_write_pcm_frames(wav, write_size, buffer.data());
-}
+	stats::resize(&interleaved_frames, size_t(chunk_size) * format.num_channels);
 
-static drwav_uint64 drwav_write_f32_pcm_frames(drwav* wav, size_t write_size, const AudioDataFormat& format, const float* frames)
-{
-	switch (format.storage_type)
+	if (format.storage_type == AudioDataFormat::StorageType::Int)
 	{
-		case AudioDataFormat::StorageType::Int:
-		{
-			return drwav_write_f32_pcm_frames<AudioDataFormat::StorageType::Int>(wav, write_size, format.num_channels, frames, format.bit_depth);
-		}
-
-		default:
-		{
-			return drwav_write_f32_pcm_frames<AudioDataFormat::StorageType::Default>(wav, write_size, format.num_channels, frames, format.bit_depth);
-		}
+		stats::resize(&pcm_frames, size_t(format.bit_depth / 8) * interleaved_frames.size());
+		quantizer.emplace(format.bit_depth, float(std::int64_t(1) << (format.bit_depth - 1)), options.dither);
 	}
-}
-
-static void drwav_write_frames(drwav* wav, AudioWriter::Callbacks callbacks, const AudioDataFormat& format, std::uint32_t chunk_size)
-{
-	std::uint64_t frame = 0;
 
 	while (frame < format.num_frames)
 	{
@@ -118,22 +93,39 @@ static void drwav_write_frames(drwav* wav, AudioWriter::Callbacks callbacks, con
 			write_size = std::uint32_t(format.num_frames - frame);
 		}
 
-		std::vector<float> interleaved_frames(size_t(write_size) * format.num_channels);
-
 		callbacks.get_next_chunk(interleaved_frames.data(), frame, write_size);
 
-		if (drwav_write_f32_pcm_frames(wav, write_size, format, interleaved_frames.data()) != write_size)
+		const void* data = interleaved_frames.data();
+
+		if (quantizer)
 		{
-			throw std::runtime_error("Write error");
+			BLAHDIO_TRACE_ZONE("blahdio::convert");
+			stats::Timer timer{stats::Counter::convert_ns};
+
+			quantizer->quantize_pcm(interleaved_frames.data(), pcm_frames.data(), size_t(write_size) * format.num_channels);
+
+			data = pcm_frames.data();
 		}
 
+		{
+			BLAHDIO_TRACE_ZONE("blahdio::write block");
+			stats::Timer timer{stats::Counter::codec_ns};
+
+			if (drwav_write_pcm_frames(wav, write_size, data) != write_size)
+			{
+				throw std::runtime_error("Write error");
+			}
+		}
+
+		stats::add(stats::Counter::bytes, std::uint64_t(write_size) * format.num_channels * (format.bit_depth / 8));
+
 		frame += write_size;
 	}
 }
 
 typed::Handler make_handler(const AudioWriter::Stream& stream, const AudioDataFormat& format)
 {
-	const auto write_func = [stream, format](AudioWriter::Callbacks callbacks, std::uint32_t chunk_size)
+	const auto write_func = [stream, format](AudioWriter::Callbacks callbacks, std::uint32_t chunk_size, const typed::Options& options)
 	{
 		drwav wav;
 
@@ -146,7 +138,7 @@ typed::Handler make_handler(const AudioWriter::Stream& stream, const AudioDataFo
 
 		try
 		{
-			drwav_write_frames(&wav, callbacks, format, chunk_size);
+			drwav_write_frames(&wav, callbacks, format, chunk_size, options);
 		}
 		catch (const std::exception& err)
 		{
@@ -162,7 +154,7 @@ typed::Handler make_handler(const AudioWriter::Stream& stream, const AudioDataFo
 
 typed::Handler make_handler(const std::string& utf8_path, const AudioDataFormat& format)
 {
-	const auto write_func = [utf8_path, format](AudioWriter::Callbacks callbacks, std::uint32_t chunk_size)
+	const auto write_func = [utf8_path, format](AudioWriter::Callbacks callbacks, std::uint32_t chunk_size, const typed::Options& options)
 	{
 		drwav wav;
 
@@ -175,7 +167,7 @@ typed::Handler make_handler(const std::string& utf8_path, const AudioDataFormat&
 
 		try
 		{
-			drwav_write_frames(&wav, callbacks, format, chunk_size);
+			drwav_write_frames(&wav, callbacks, format, chunk_size, options);
 		}
 		catch (const std::exception& err)
 		{
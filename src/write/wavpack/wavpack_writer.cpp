@@ -1,5 +1,9 @@
 #include "wavpack_writer.h"
+#include "convert/quantize.h"
+#include "counters.h"
+#include "trace.h"
 #include <fstream>
+#include <optional>
 #include <vector>
 #include <utf8.h>
 #include <wavpack.h>
@@ -8,7 +12,7 @@ namespace blahdio {
 namespace write {
 namespace wavpack {
 
-static void wavpack_write_file(WavpackBlockOutput blockout, void* id, const AudioDataFormat& format, AudioWriter::Callbacks callbacks, std::uint32_t chunk_size)
+static void wavpack_write_file(WavpackBlockOutput blockout, void* id, const AudioDataFormat& format, AudioWriter::Callbacks callbacks, std::uint32_t chunk_size, const typed::Options& options)
 {
 	const auto context = WavpackOpenFileOutput(blockout, id, nullptr);
 
@@ -51,10 +55,25 @@ static void wavpack_write_file(WavpackBlockOutput blockout, void* id, const Audi
 		throw std::runtime_error(WavpackGetErrorMessage(context));
 	}
 
-	const auto int_scale = (1 << (format.bit_depth - 1)) - 1;
-
 	std::uint64_t frame = 0;
 
+	// Allocated once for the whole session. Chunks are never bigger than
+	// chunk_size so they don't grow after this.
+	std::vector<float> interleaved_frames;
+	std::vector<std::int32_t> samples;
+	std::optional<convert::Quantizer> quantizer;
+
+	stats::resize(&interleaved_frames, size_t(chunk_size) * format.num_channels);
+
+	if (format.storage_type == AudioDataFormat::StorageType::Int)
+	{
+		// The reader divides by the same scale
+		const auto int_scale = float((std::int64_t(1) << (format.bit_depth - 1)) - 1);
+
+		stats::resize(&samples, interleaved_frames.size());
+		quantizer.emplace(format.bit_depth, int_scale, options.dither);
+	}
+
 	while (frame < format.num_frames)
 	{
 		if (callbacks.should_abort && callbacks.should_abort()) break;
@@ -66,8 +85,6 @@ static void wavpack_write_file(WavpackBlockOutput blockout, void* id, const Audi
 			write_size = std::uint32_t(format.num_frames - frame);
 		}
 
-		std::vector<float> interleaved_frames(size_t(write_size) * format.num_channels);
-
 		callbacks.get_next_chunk(interleaved_frames.data(), frame, write_size);
 
 		switch (format.storage_type)
@@ -75,6 +92,8 @@ static void wavpack_write_file(WavpackBlockOutput blockout, void* id, const Audi
 			case AudioDataFormat::StorageType::Float:
 			case AudioDataFormat::StorageType::NormalizedFloat:
 			{
+				stats::Timer timer{stats::Counter::codec_ns};
+
 				if (!WavpackPackSamples(context, reinterpret_cast<std::int32_t*>(interleaved_frames.data()), write_size))
 				{
 					throw std::runtime_error("Write error");
@@ -85,13 +104,15 @@ static void wavpack_write_file(WavpackBlockOutput blockout, void* id, const Audi
 
 			case AudioDataFormat::StorageType::Int:
 			{
-				std::vector<std::int32_t> samples(size_t(write_size) * format.num_channels);
-
-				for (int i = 0; i < samples.size(); i++)
 				{
-					samples[i] = std::int32_t(double(interleaved_frames[i]) * int_scale);
+					BLAHDIO_TRACE_ZONE("blahdio::convert");
+					stats::Timer timer{stats::Counter::convert_ns};
+
+					quantizer->quantize(interleaved_frames.data(), samples.data(), size_t(write_size) * format.num_channels);
 				}
 
+				stats::Timer timer{stats::Counter::codec_ns};
+
 				if (!WavpackPackSamples(context, samples.data(), write_size))
 				{
 					throw std::runtime_error("Write error");
@@ -105,6 +126,8 @@ static void wavpack_write_file(WavpackBlockOutput blockout, void* id, const Audi
 		frame += write_size;
 	}
 
+	stats::Timer timer{stats::Counter::codec_ns};
+
 	if (!WavpackFlushSamples(context))
 	{
 		throw std::runtime_error("Write error");
@@ -124,16 +147,20 @@ static void open_file(std::ofstream* file, const std::string& utf8_path)
 
 typed::Handler make_handler(const std::string& utf8_path, const AudioDataFormat& format)
 {
-	const auto write_func = [utf8_path, format](AudioWriter::Callbacks callbacks, std::uint32_t chunk_size)
+	const auto write_func = [utf8_path, format](AudioWriter::Callbacks callbacks, std::uint32_t chunk_size, const typed::Options& options)
 	{
 		const auto blockout = [](void* id, void* data, int32_t bcount) -> int
 		{
+			BLAHDIO_TRACE_ZONE("blahdio::write block");
+
 			auto file = (std::ofstream*)(id);
 
 			file->write((const char*)(data), bcount);
 
 			if (file->fail()) return 0;
 
+			stats::add(stats::Counter::bytes, std::uint64_t(bcount));
+
 			return 1;
 		};
 
@@ -141,7 +168,7 @@ typed::Handler make_handler(const std::string& utf8_path, const AudioDataFormat&
 
 		open_file(&file, utf8_path);
 
-		wavpack_write_file(blockout, &file, format, callbacks, chunk_size);
+		wavpack_write_file(blockout, &file, format, callbacks, chunk_size, options);
 	};
 
 	return { write_func };
@@ -149,18 +176,22 @@ typed::Handler make_handler(const std::string& utf8_path, const AudioDataFormat&
 
 typed::Handler make_handler(const AudioWriter::Stream& stream, const AudioDataFormat& format)
 {
-	const auto write_func = [stream, format](AudioWriter::Callbacks callbacks, std::uint32_t chunk_size)
+	const auto write_func = [stream, format](AudioWriter::Callbacks callbacks, std::uint32_t chunk_size, const typed::Options& options)
 	{
 		const auto blockout = [](void* id, void* data, int32_t bcount) -> int
 		{
+			BLAHDIO_TRACE_ZONE("blahdio::write block");
+
 			auto stream = (AudioWriter::Stream*)(id);
 
 			if (stream->write_bytes(data, bcount) != bcount) return 0;
 
+			stats::add(stats::Counter::bytes, std::uint64_t(bcount));
+
 			return 1;
 		};
 
-		wavpack_write_file(blockout, (void*)(&stream), format, callbacks, chunk_size);
+		wavpack_write_file(blockout, (void*)(&stream), format, callbacks, chunk_size, options);
 	};
 
 	return { write_func };
@@ -0,0 +1,193 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <blahdio/audio_writer.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "util.h"
+
+// Counts every (unaligned) allocation made through operator new in the
+// test executable. The C libraries allocate with malloc, so this only
+// covers our own buffers.
+static std::atomic<std::size_t> num_allocations{0};
+
+// Allocations made on this thread while trapping is turned on are
+// counted separately, so a test can check that a real-time section made
+// none no matter what other threads were doing
+static thread_local bool trap_allocations{false};
+static std::atomic<std::size_t> num_trapped_allocations{0};
+
+struct AllocationTrap
+{
+	AllocationTrap() { trap_allocations = true; }
+	~AllocationTrap() { trap_allocations = false; }
+};
+
+void* operator new(std::size_t size)
+{
+	num_allocations++;
+
+	if (trap_allocations)
+	{
+		num_trapped_allocations++;
+	}
+
+	if (const auto ptr{std::malloc(size > 0 ? size : 1)})
+	{
+		return ptr;
+	}
+
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+SCENARIO("Reading and writing don't allocate after the first chunk", "[allocations]")
+{
+	static constexpr auto NUM_FRAMES = 4410;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr auto CHUNK_SIZE = 64;
+
+	const auto data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, 256.0f)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 16)};
+
+	const auto test_file_path = (std::filesystem::path(DIR_TEST_FILES) / "allocations").replace_extension(util::get_ext(blahdio::AudioType::wav));
+
+	if (!std::filesystem::exists(test_file_path.parent_path()))
+	{
+		std::filesystem::create_directory(test_file_path.parent_path());
+	}
+
+	GIVEN("A 16 bit WAV file being written")
+	{
+		std::size_t allocations_after_first_chunk{0};
+		std::size_t allocations_at_last_chunk{0};
+
+		blahdio::AudioWriter writer(test_file_path.string(), blahdio::AudioType::wav, format);
+
+		blahdio::AudioWriter::Callbacks callbacks;
+
+		callbacks.should_abort = []() { return false; };
+		callbacks.get_next_chunk = [&](float* buffer, std::uint64_t frame, std::uint32_t num_frames)
+		{
+			if (frame == CHUNK_SIZE) allocations_after_first_chunk = num_allocations;
+
+			allocations_at_last_chunk = num_allocations;
+
+			std::copy(data.data() + (frame * NUM_CHANNELS), data.data() + ((frame + num_frames) * NUM_CHANNELS), buffer);
+		};
+
+		writer.write_frames(callbacks, CHUNK_SIZE);
+
+		THEN("No chunk after the first one allocated")
+		{
+			REQUIRE(allocations_at_last_chunk == allocations_after_first_chunk);
+		}
+
+		AND_WHEN("It is read back")
+		{
+			const auto sample_format = GENERATE(blahdio::SampleFormat::f32, blahdio::SampleFormat::s16, blahdio::SampleFormat::s24);
+
+			blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_only);
+
+			allocations_after_first_chunk = 0;
+			allocations_at_last_chunk = 0;
+
+			blahdio::AudioReader::Callbacks read_callbacks;
+
+			read_callbacks.should_abort = []() { return false; };
+			read_callbacks.return_chunk = [&](const void*, std::uint64_t frame, std::uint32_t)
+			{
+				if (frame == 0) allocations_after_first_chunk = num_allocations;
+
+				allocations_at_last_chunk = num_allocations;
+			};
+
+			REQUIRE(reader.read_frames(read_callbacks, CHUNK_SIZE, {sample_format}));
+
+			THEN("No chunk after the first one allocated")
+			{
+				REQUIRE(allocations_at_last_chunk == allocations_after_first_chunk);
+			}
+		}
+	}
+}
+
+SCENARIO("Real-time streaming doesn't allocate", "[allocations]")
+{
+	static constexpr auto NUM_FRAMES = 4410;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr auto MAX_FRAMES_PER_READ = 256;
+
+	const auto data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, 256.0f)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 16)};
+
+	const auto test_file_path{util::write_test_file("realtime_allocations", blahdio::AudioType::wav, data, format)};
+
+	const auto file_data{util::read_file(test_file_path)};
+
+	GIVEN("A reserved streamer over a 16 bit WAV file in memory")
+	{
+		const auto output_format = GENERATE(blahdio::OutputFormat{blahdio::SampleFormat::f32}, blahdio::OutputFormat{blahdio::SampleFormat::s16});
+
+		blahdio::AudioReader reader(file_data.data(), file_data.size(), blahdio::AudioTypeHint::try_wav_only);
+
+		auto streamer{reader.streamer(output_format)};
+
+		REQUIRE(streamer.reserve(MAX_FRAMES_PER_READ));
+
+		std::vector<float> buffer(MAX_FRAMES_PER_READ * NUM_CHANNELS);
+		std::vector<float> left(MAX_FRAMES_PER_READ);
+		std::vector<float> right(MAX_FRAMES_PER_READ);
+		void* const channels[] = { left.data(), right.data() };
+
+		WHEN("It is read to the end, seeked and read again")
+		{
+			num_trapped_allocations = 0;
+
+			std::uint64_t total_frames_read{0};
+			blahdio::AudioStreamer::Error too_many_frames_error;
+			blahdio::AudioStreamer::Error seek_error;
+			blahdio::AudioStreamer::RealtimeResult planar_result;
+
+			{
+				AllocationTrap trap;
+
+				for (;;)
+				{
+					const auto result{streamer.read_frames_realtime(buffer.data(), MAX_FRAMES_PER_READ)};
+
+					total_frames_read += result.frames_read;
+
+					if (result.error != blahdio::AudioStreamer::Error::none || result.frames_read < MAX_FRAMES_PER_READ) break;
+				}
+
+				too_many_frames_error = streamer.read_frames_realtime(buffer.data(), MAX_FRAMES_PER_READ + 1).error;
+				seek_error = streamer.seek_realtime(NUM_FRAMES / 2);
+				planar_result = streamer.read_planar_frames_realtime(channels, MAX_FRAMES_PER_READ);
+			}
+
+			THEN("Nothing was allocated and the errors are codes")
+			{
+				REQUIRE(num_trapped_allocations == 0);
+				REQUIRE(total_frames_read == NUM_FRAMES);
+				REQUIRE(too_many_frames_error == blahdio::AudioStreamer::Error::too_many_frames);
+				REQUIRE(seek_error == blahdio::AudioStreamer::Error::none);
+				REQUIRE(planar_result.error == blahdio::AudioStreamer::Error::none);
+				REQUIRE(planar_result.frames_read == MAX_FRAMES_PER_READ);
+			}
+		}
+	}
+}
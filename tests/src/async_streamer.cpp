@@ -0,0 +1,112 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <chrono>
+#include <thread>
+#include "util.h"
+
+// Keeps reading until the streamer reaches the end, waiting out any
+// underruns
+static auto read_to_end(blahdio::AsyncAudioStreamer* streamer, std::vector<float>* out, int num_channels) -> blahdio::AsyncAudioStreamer::Status
+{
+	static constexpr auto BUFFER_SIZE = 512;
+
+	std::vector<float> buffer(BUFFER_SIZE * num_channels);
+
+	for (;;)
+	{
+		const auto result{streamer->read_frames(buffer.data(), BUFFER_SIZE)};
+
+		out->insert(out->end(), buffer.begin(), buffer.begin() + (result.frames_read * num_channels));
+
+		switch (result.status)
+		{
+			case blahdio::AsyncAudioStreamer::Status::ok: break;
+			case blahdio::AsyncAudioStreamer::Status::underrun: std::this_thread::sleep_for(std::chrono::milliseconds(1)); break;
+			default: return result.status;
+		}
+	}
+}
+
+SCENARIO("Frames can be streamed from a background thread", "[async_streamer]")
+{
+	static constexpr auto NUM_FRAMES = 100000;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr auto SEEK_FRAME = 60000;
+
+	const auto data{util::generate_noise_data(NUM_FRAMES, NUM_CHANNELS)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 32)};
+
+	const auto types =
+	{
+		blahdio::AudioType::wav,
+		blahdio::AudioType::wavpack,
+	};
+
+	for (const auto type : types)
+	{
+		const auto test_file_path{util::write_test_file("async_streamer", type, data, format)};
+
+		GIVEN(std::string("A ") + std::string(util::to_string(type)) + " file")
+		{
+			blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_first);
+
+			blahdio::AsyncAudioStreamer::Options options;
+
+			// Smaller than the file so the ring wraps around
+			options.read_ahead = 8192;
+			options.chunk_size = 1000;
+
+			std::vector<float> frames;
+
+			WHEN("It is streamed to the end")
+			{
+				auto streamer{reader.async_streamer(options)};
+
+				const auto status{read_to_end(&streamer, &frames, NUM_CHANNELS)};
+
+				THEN("The frames are the same as the ones written")
+				{
+					REQUIRE(status == blahdio::AsyncAudioStreamer::Status::end);
+					REQUIRE(frames == data);
+				}
+			}
+
+			WHEN("It is streamed after a seek")
+			{
+				auto streamer{reader.async_streamer(options)};
+
+				streamer.seek(SEEK_FRAME);
+
+				const auto status{read_to_end(&streamer, &frames, NUM_CHANNELS)};
+
+				THEN("The frames start at the seek position")
+				{
+					REQUIRE(status == blahdio::AsyncAudioStreamer::Status::end);
+					REQUIRE(frames == std::vector<float>(data.begin() + (SEEK_FRAME * NUM_CHANNELS), data.end()));
+				}
+			}
+
+			WHEN("It is streamed with options of 0")
+			{
+				static constexpr auto END_FRAME = NUM_FRAMES - 10;
+
+				options.read_ahead = 0;
+				options.chunk_size = 0;
+
+				auto streamer{reader.async_streamer(options)};
+
+				streamer.seek(END_FRAME);
+
+				const auto status{read_to_end(&streamer, &frames, NUM_CHANNELS)};
+
+				THEN("The options are raised to something which works")
+				{
+					REQUIRE(status == blahdio::AsyncAudioStreamer::Status::end);
+					REQUIRE(frames == std::vector<float>(data.begin() + (END_FRAME * NUM_CHANNELS), data.end()));
+				}
+			}
+		}
+	}
+}
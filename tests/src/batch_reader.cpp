@@ -0,0 +1,92 @@
+#include <catch2/catch.hpp>
+#include <blahdio/batch_reader.h>
+#include <mutex>
+#include "util.h"
+
+SCENARIO("Many files can be read at once", "[batch_reader]")
+{
+	static constexpr auto NUM_FILES = 8;
+	static constexpr auto NUM_FRAMES = 100000;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr auto CHUNK_SIZE = 1000;
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 16)};
+
+	std::vector<std::vector<float>> expected_frames;
+	std::vector<blahdio::BatchReader::Item> items;
+
+	for (int i = 0; i < NUM_FILES; i++)
+	{
+		const auto type{i % 2 == 0 ? blahdio::AudioType::wav : blahdio::AudioType::wavpack};
+		const auto data{util::generate_noise_data(NUM_FRAMES, NUM_CHANNELS)};
+		const auto test_file_path{util::write_test_file("batch_read_" + std::to_string(i), type, data, format)};
+
+		// Read the file back normally to get the frames the batch should
+		// return, since 16-bit storage is lossy
+		blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_first);
+
+		std::vector<float> frames(data.size());
+
+		blahdio::AudioReader::Callbacks callbacks;
+
+		callbacks.should_abort = []() { return false; };
+		callbacks.return_chunk = [&](const void* chunk, std::uint64_t first_frame, std::uint32_t num_frames)
+		{
+			std::copy((const float*)(chunk), (const float*)(chunk) + (num_frames * NUM_CHANNELS), frames.data() + (first_frame * NUM_CHANNELS));
+		};
+
+		REQUIRE(reader.read_frames(callbacks, CHUNK_SIZE));
+
+		expected_frames.push_back(std::move(frames));
+		items.push_back({test_file_path.string()});
+	}
+
+	GIVEN("A list of files and one missing file")
+	{
+		items.push_back({(std::filesystem::path(DIR_TEST_FILES) / "batch_read_missing.wav").string()});
+
+		std::mutex mutex;
+		std::vector<std::vector<float>> frames(items.size(), std::vector<float>(NUM_FRAMES * NUM_CHANNELS));
+		std::vector<int> num_headers(items.size(), 0);
+
+		blahdio::BatchReader::Callbacks callbacks;
+
+		callbacks.header = [&](std::size_t index, const blahdio::AudioDataFormat&)
+		{
+			std::lock_guard lock{mutex};
+
+			num_headers[index]++;
+		};
+
+		callbacks.return_chunk = [&](std::size_t index, const void* chunk, std::uint64_t first_frame, std::uint32_t num_frames)
+		{
+			std::copy((const float*)(chunk), (const float*)(chunk) + (num_frames * NUM_CHANNELS), frames[index].data() + (first_frame * NUM_CHANNELS));
+		};
+
+		WHEN("They are read on four threads")
+		{
+			blahdio::BatchReader batch_reader{4};
+
+			const auto results{batch_reader.read(items, callbacks, CHUNK_SIZE)};
+
+			THEN("Each file's frames are the same as when it is read on its own")
+			{
+				REQUIRE(results.size() == items.size());
+
+				for (int i = 0; i < NUM_FILES; i++)
+				{
+					REQUIRE(results[i]);
+					REQUIRE(results[i]->num_frames == NUM_FRAMES);
+					REQUIRE(num_headers[i] == 1);
+					REQUIRE(frames[i] == expected_frames[i]);
+				}
+			}
+
+			THEN("Only the missing file fails")
+			{
+				REQUIRE(!results.back());
+				REQUIRE(num_headers.back() == 0);
+			}
+		}
+	}
+}
@@ -0,0 +1,177 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <blahdio/block_cache.h>
+#include "util.h"
+
+SCENARIO("Streamers read cached blocks after seeking back", "[block_cache]")
+{
+	static constexpr auto NUM_FRAMES = 100000;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr auto FRAMES_TO_READ = 20000;
+	static constexpr auto START_FRAME = 12345;
+
+	const auto data{util::generate_noise_data(NUM_FRAMES, NUM_CHANNELS)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 32)};
+
+	const auto types =
+	{
+		blahdio::AudioType::wav,
+		blahdio::AudioType::wavpack,
+	};
+
+	blahdio::set_block_cache_budget(std::size_t(64) << 20);
+
+	for (const auto type : types)
+	{
+		const auto test_file_path{util::write_test_file("block_cache", type, data, format)};
+
+		blahdio::clear_block_cache();
+
+		GIVEN(std::string("A ") + std::string(util::to_string(type)) + " file")
+		{
+			blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_first);
+
+			REQUIRE(reader.read_header());
+
+			const auto expected_frames{std::vector<float>(data.begin() + (START_FRAME * NUM_CHANNELS), data.begin() + ((START_FRAME + FRAMES_TO_READ) * NUM_CHANNELS))};
+
+			WHEN("The same frames are streamed twice")
+			{
+				auto streamer{reader.streamer()};
+
+				std::vector<float> first(FRAMES_TO_READ * NUM_CHANNELS);
+				std::vector<float> second(FRAMES_TO_READ * NUM_CHANNELS);
+
+				REQUIRE(streamer.seek(START_FRAME));
+
+				const auto first_read{streamer.read_frames(first.data(), FRAMES_TO_READ)};
+				const auto stats_before{blahdio::get_block_cache_stats()};
+
+				REQUIRE(streamer.seek(START_FRAME));
+
+				const auto second_read{streamer.read_frames(second.data(), FRAMES_TO_READ)};
+				const auto stats_after{blahdio::get_block_cache_stats()};
+
+				THEN("The second read comes from the cache and returns the same frames")
+				{
+					REQUIRE(first_read);
+					REQUIRE(second_read);
+					REQUIRE(*first_read == FRAMES_TO_READ);
+					REQUIRE(*second_read == FRAMES_TO_READ);
+					REQUIRE(first == expected_frames);
+					REQUIRE(second == expected_frames);
+					REQUIRE(stats_before.bytes_used > 0);
+					REQUIRE(stats_after.hits > stats_before.hits);
+					REQUIRE(stats_after.misses == stats_before.misses);
+				}
+			}
+
+			WHEN("A cursor reads frames a streamer has already read")
+			{
+				auto streamer{reader.streamer()};
+
+				std::vector<float> streamed(FRAMES_TO_READ * NUM_CHANNELS);
+				std::vector<float> planar_left(FRAMES_TO_READ);
+				std::vector<float> planar_right(FRAMES_TO_READ);
+
+				REQUIRE(streamer.seek(START_FRAME));
+				REQUIRE(streamer.read_frames(streamed.data(), FRAMES_TO_READ));
+
+				auto cursor{reader.cursor()};
+				auto cursor_read{blahdio::expected<std::uint32_t>{0}};
+
+				const auto stats_before{blahdio::get_block_cache_stats()};
+
+				if (cursor && cursor->seek(START_FRAME))
+				{
+					void* const channels[] = { planar_left.data(), planar_right.data() };
+
+					cursor_read = cursor->read_planar_frames(channels, FRAMES_TO_READ);
+				}
+
+				const auto stats_after{blahdio::get_block_cache_stats()};
+
+				THEN("The cursor's frames come from the cache")
+				{
+					REQUIRE(cursor);
+					REQUIRE(cursor_read);
+					REQUIRE(*cursor_read == FRAMES_TO_READ);
+					REQUIRE(stats_after.hits > stats_before.hits);
+
+					for (int i = 0; i < FRAMES_TO_READ; i++)
+					{
+						REQUIRE(planar_left[i] == expected_frames[(i * NUM_CHANNELS) + 0]);
+						REQUIRE(planar_right[i] == expected_frames[(i * NUM_CHANNELS) + 1]);
+					}
+				}
+			}
+		}
+	}
+
+	blahdio::set_block_cache_budget(0);
+
+	REQUIRE(blahdio::get_block_cache_stats().bytes_used == 0);
+}
+
+SCENARIO("Sources in memory don't share cached blocks when the memory is reused", "[block_cache]")
+{
+	static constexpr auto NUM_FRAMES = 20000;
+	static constexpr auto NUM_CHANNELS = 2;
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 32)};
+
+	const auto first_data{util::generate_noise_data(NUM_FRAMES, NUM_CHANNELS)};
+	const auto second_data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, 440.0f)};
+
+	const auto write_and_read = [&format](const std::vector<float>& data)
+	{
+		return util::read_file(util::write_test_file("block_cache_memory", blahdio::AudioType::wav, data, format));
+	};
+
+	const auto stream_all = [](blahdio::AudioReader* reader)
+	{
+		auto streamer{reader->streamer()};
+
+		std::vector<float> out(NUM_FRAMES * NUM_CHANNELS);
+
+		REQUIRE(*streamer.read_frames(out.data(), NUM_FRAMES) == NUM_FRAMES);
+
+		return out;
+	};
+
+	blahdio::set_block_cache_budget(std::size_t(64) << 20);
+	blahdio::clear_block_cache();
+
+	GIVEN("Two files of the same size read one after the other from the same memory")
+	{
+		auto memory{write_and_read(first_data)};
+
+		std::vector<float> first_frames;
+
+		{
+			blahdio::AudioReader reader(memory.data(), memory.size(), blahdio::AudioTypeHint::try_wav_only);
+
+			first_frames = stream_all(&reader);
+		}
+
+		const auto second_file{write_and_read(second_data)};
+
+		REQUIRE(second_file.size() == memory.size());
+
+		std::copy(second_file.begin(), second_file.end(), memory.begin());
+
+		blahdio::AudioReader reader(memory.data(), memory.size(), blahdio::AudioTypeHint::try_wav_only);
+
+		const auto second_frames{stream_all(&reader)};
+
+		THEN("The second reader gets its own frames, not the first one's")
+		{
+			REQUIRE(first_frames == first_data);
+			REQUIRE(second_frames == second_data);
+		}
+	}
+
+	blahdio::set_block_cache_budget(0);
+}
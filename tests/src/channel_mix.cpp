@@ -0,0 +1,135 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "util.h"
+
+static auto read_all(blahdio::AudioReader* reader, blahdio::OutputFormat output_format, int num_channels) -> std::vector<float>
+{
+	std::vector<float> out;
+
+	blahdio::AudioReader::Callbacks callbacks;
+
+	callbacks.should_abort = []() { return false; };
+	callbacks.return_chunk = [&](const void* chunk, std::uint64_t, std::uint32_t num_frames)
+	{
+		out.insert(out.end(), (const float*)(chunk), (const float*)(chunk) + (num_frames * num_channels));
+	};
+
+	REQUIRE(reader->read_frames(callbacks, 512, output_format));
+
+	return out;
+}
+
+SCENARIO("Channels can be mixed while they are read", "[channel_mix]")
+{
+	static constexpr auto NUM_FRAMES = 10000;
+	static constexpr auto NUM_CHANNELS = 6;
+	static constexpr auto MINUS_3DB = 0.70710678f;
+
+	enum { FL, FR, FC, LFE, BL, BR };
+
+	const auto data{util::generate_noise_data(NUM_FRAMES, NUM_CHANNELS)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 32)};
+
+	const auto types =
+	{
+		blahdio::AudioType::wav,
+		blahdio::AudioType::wavpack,
+	};
+
+	for (const auto type : types)
+	{
+		const auto test_file_path{util::write_test_file("channel_mix", type, data, format)};
+
+		GIVEN(std::string("A 5.1 ") + std::string(util::to_string(type)) + " file")
+		{
+			blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_first);
+
+			WHEN("It is read without mixing")
+			{
+				const auto frames{read_all(&reader, {}, NUM_CHANNELS)};
+
+				THEN("Every channel is there")
+				{
+					REQUIRE(frames == data);
+				}
+			}
+
+			WHEN("It is read as stereo")
+			{
+				blahdio::OutputFormat output_format;
+
+				output_format.num_channels = 2;
+
+				const auto frames{read_all(&reader, output_format, 2)};
+
+				THEN("The centre and surrounds are mixed in at -3dB")
+				{
+					REQUIRE(frames.size() == NUM_FRAMES * 2);
+
+					for (int i = 0; i < NUM_FRAMES; i++)
+					{
+						const auto in{data.data() + (i * NUM_CHANNELS)};
+						const auto left{in[FL] + (MINUS_3DB * in[FC]) + (MINUS_3DB * in[BL])};
+						const auto right{in[FR] + (MINUS_3DB * in[FC]) + (MINUS_3DB * in[BR])};
+
+						REQUIRE(frames[(i * 2) + 0] == Approx(left).margin(0.00001));
+						REQUIRE(frames[(i * 2) + 1] == Approx(right).margin(0.00001));
+					}
+				}
+			}
+
+			WHEN("A streamer picks out the LFE with a mix of its own")
+			{
+				blahdio::OutputFormat output_format;
+
+				output_format.sample_format = blahdio::SampleFormat::s16;
+				output_format.num_channels = 1;
+				output_format.channel_mix = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+
+				auto streamer{reader.streamer(output_format)};
+
+				std::vector<std::int16_t> frames(NUM_FRAMES);
+
+				REQUIRE(streamer.seek(100));
+
+				const auto frames_read{streamer.read_frames(frames.data(), NUM_FRAMES)};
+
+				THEN("It reads the LFE channel")
+				{
+					REQUIRE(frames_read);
+					REQUIRE(*frames_read == NUM_FRAMES - 100);
+
+					for (int i = 0; i < NUM_FRAMES - 100; i++)
+					{
+						const auto expected{std::clamp(std::nearbyint(data[((i + 100) * NUM_CHANNELS) + LFE] * 32768.0f), -32768.0f, 32767.0f)};
+
+						REQUIRE(float(frames[i]) == expected);
+					}
+				}
+			}
+
+			WHEN("The mix doesn't have a gain for each channel")
+			{
+				blahdio::OutputFormat output_format;
+
+				output_format.num_channels = 2;
+				output_format.channel_mix = { 1.0f, 0.0f };
+
+				blahdio::AudioReader::Callbacks callbacks;
+
+				callbacks.should_abort = []() { return false; };
+				callbacks.return_chunk = [](const void*, std::uint64_t, std::uint32_t) {};
+
+				THEN("Reading fails")
+				{
+					REQUIRE_FALSE(reader.read_frames(callbacks, 512, output_format));
+				}
+			}
+		}
+	}
+}
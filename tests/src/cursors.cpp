@@ -0,0 +1,93 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <thread>
+#include "util.h"
+
+SCENARIO("Several cursors can read one source at once", "[cursors]")
+{
+	static constexpr auto NUM_FRAMES = 100000;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr auto NUM_CURSORS = 4;
+	static constexpr auto FRAMES_TO_READ = 10000;
+
+	const auto data{util::generate_noise_data(NUM_FRAMES, NUM_CHANNELS)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 32)};
+
+	const auto types =
+	{
+		blahdio::AudioType::wav,
+		blahdio::AudioType::wavpack,
+	};
+
+	for (const auto type : types)
+	{
+		const auto test_file_path{util::write_test_file("cursors", type, data, format)};
+
+		GIVEN(std::string("A ") + std::string(util::to_string(type)) + " file with a streamer open")
+		{
+			blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_first);
+
+			REQUIRE(reader.read_header());
+
+			auto streamer{reader.streamer()};
+
+			WHEN("Each cursor seeks somewhere different and reads on its own thread")
+			{
+				std::vector<blahdio::AudioCursor> cursors;
+
+				for (int i = 0; i < NUM_CURSORS; i++)
+				{
+					auto cursor{reader.cursor()};
+
+					REQUIRE(cursor);
+
+					cursors.push_back(std::move(*cursor));
+				}
+
+				std::vector<std::vector<float>> frames(NUM_CURSORS, std::vector<float>(FRAMES_TO_READ * NUM_CHANNELS));
+				std::vector<int> succeeded(NUM_CURSORS, 0);
+				std::vector<std::thread> threads;
+
+				const auto get_start_frame = [](int cursor) { return std::uint64_t(cursor) * (NUM_FRAMES / NUM_CURSORS) + 123; };
+
+				for (int i = 0; i < NUM_CURSORS; i++)
+				{
+					threads.emplace_back([&, i]()
+					{
+						if (!cursors[i].seek(get_start_frame(i))) return;
+
+						const auto frames_read{cursors[i].read_frames(frames[i].data(), FRAMES_TO_READ)};
+
+						succeeded[i] = frames_read && *frames_read == FRAMES_TO_READ ? 1 : 0;
+					});
+				}
+
+				std::vector<float> streamed(FRAMES_TO_READ * NUM_CHANNELS);
+
+				const auto streamed_frames{streamer.read_frames(streamed.data(), FRAMES_TO_READ)};
+
+				for (auto& thread : threads)
+				{
+					thread.join();
+				}
+
+				THEN("Each cursor reads its own frames and the streamer is unaffected")
+				{
+					for (int i = 0; i < NUM_CURSORS; i++)
+					{
+						const auto start{data.begin() + (get_start_frame(i) * NUM_CHANNELS)};
+
+						REQUIRE(succeeded[i]);
+						REQUIRE(frames[i] == std::vector<float>(start, start + (FRAMES_TO_READ * NUM_CHANNELS)));
+					}
+
+					REQUIRE(streamed_frames);
+					REQUIRE(*streamed_frames == FRAMES_TO_READ);
+					REQUIRE(streamed == std::vector<float>(data.begin(), data.begin() + (FRAMES_TO_READ * NUM_CHANNELS)));
+				}
+			}
+		}
+	}
+}
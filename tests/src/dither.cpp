@@ -0,0 +1,115 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "util.h"
+
+template <typename T>
+static auto read_all(const std::filesystem::path& path, blahdio::SampleFormat sample_format, int num_channels) -> std::vector<T>
+{
+	blahdio::AudioReader reader(path.string(), blahdio::AudioTypeHint::try_wav_first);
+
+	std::vector<T> out;
+
+	blahdio::AudioReader::Callbacks callbacks;
+
+	callbacks.should_abort = []() { return false; };
+	callbacks.return_chunk = [&](const void* chunk, std::uint64_t, std::uint32_t num_frames)
+	{
+		out.insert(out.end(), (const T*)(chunk), (const T*)(chunk) + (num_frames * num_channels));
+	};
+
+	REQUIRE(reader.read_frames(callbacks, 512, {sample_format}));
+
+	return out;
+}
+
+SCENARIO("Integer samples are clipped and optionally dithered when they are written", "[dither][wav][wavpack]")
+{
+	// Odd so the vectorized quantization leaves a few samples over
+	static constexpr auto NUM_FRAMES = 4411;
+	static constexpr auto NUM_CHANNELS = 2;
+
+	// Goes past full scale so some of it has to be clipped
+	auto data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, 256.0f)};
+
+	for (auto& value : data) value *= 1.5f;
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 16)};
+
+	struct Type
+	{
+		blahdio::AudioType type;
+
+		// WavPack is scaled by one less, to match its reader
+		double scale;
+	};
+
+	const Type types[] =
+	{
+		{ blahdio::AudioType::wav, 32768.0 },
+		{ blahdio::AudioType::wavpack, 32767.0 },
+	};
+
+	for (const auto& type : types)
+	{
+		const auto dir{std::filesystem::path(DIR_TEST_FILES)};
+		const auto ext{util::get_ext(type.type)};
+		const auto plain_path{(dir / "dither_none").replace_extension(ext)};
+		const auto dither_path{(dir / "dither_triangular").replace_extension(ext)};
+
+		GIVEN(std::string("A 16 bit ") + std::string(util::to_string(type.type)) + " file written without dither")
+		{
+			util::write_frames(plain_path, data.data(), type.type, format, 512, blahdio::Dither::none);
+
+			const auto plain{read_all<std::int16_t>(plain_path, blahdio::SampleFormat::s16, NUM_CHANNELS)};
+
+			REQUIRE(plain.size() == data.size());
+
+			THEN("Each sample is rounded to the nearest integer and clipped")
+			{
+				for (size_t i = 0; i < plain.size(); i++)
+				{
+					const auto expected{std::clamp(std::nearbyint(double(data[i]) * type.scale), -32768.0, 32767.0)};
+
+					REQUIRE(std::abs(double(plain[i]) - expected) <= 1.0);
+				}
+
+				REQUIRE(*std::max_element(plain.begin(), plain.end()) == 32767);
+			}
+
+			AND_WHEN("The same data is written with triangular dither")
+			{
+				util::write_frames(dither_path, data.data(), type.type, format, 512, blahdio::Dither::triangular);
+
+				const auto dithered{read_all<std::int16_t>(dither_path, blahdio::SampleFormat::s16, NUM_CHANNELS)};
+
+				REQUIRE(dithered.size() == plain.size());
+
+				THEN("It is never more than one step away, but isn't the same")
+				{
+					bool any_different{false};
+
+					for (size_t i = 0; i < dithered.size(); i++)
+					{
+						REQUIRE(std::abs(int(dithered[i]) - int(plain[i])) <= 1);
+
+						any_different = any_different || dithered[i] != plain[i];
+					}
+
+					REQUIRE(any_different);
+				}
+
+				THEN("Writing it again gives the same file, whatever the chunk size")
+				{
+					const auto again_path{(dir / "dither_triangular_again").replace_extension(ext)};
+
+					util::write_frames(again_path, data.data(), type.type, format, 333, blahdio::Dither::triangular);
+
+					REQUIRE(util::read_file(again_path) == util::read_file(dither_path));
+				}
+			}
+		}
+	}
+}
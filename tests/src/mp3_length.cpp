@@ -0,0 +1,104 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// MPEG-1 layer III, 128 kbps, 44.1 kHz, stereo
+static constexpr unsigned char FRAME_HEADER[] = { 0xFF, 0xFB, 0x90, 0x00 };
+static constexpr std::size_t FRAME_SIZE = 417;
+static constexpr std::uint32_t FRAME_LENGTH = 1152;
+
+// Offset of the Xing tag, after the header and the stereo side info
+static constexpr std::size_t XING_OFFSET = 4 + 32;
+
+// Silent frames, behind an Info frame with the frames flag set and a
+// LAME tag giving the delay and padding
+auto make_tagged_mp3(std::uint32_t num_frames, std::uint32_t delay, std::uint32_t padding) -> std::vector<unsigned char>
+{
+	std::vector<unsigned char> out((num_frames + 1) * FRAME_SIZE);
+
+	for (std::uint32_t i = 0; i < num_frames + 1; i++)
+	{
+		std::memcpy(out.data() + (i * FRAME_SIZE), FRAME_HEADER, sizeof(FRAME_HEADER));
+	}
+
+	const auto xing{out.data() + XING_OFFSET};
+
+	std::memcpy(xing, "Info", 4);
+
+	xing[7] = 0x01;
+	xing[8] = (unsigned char)(num_frames >> 24);
+	xing[9] = (unsigned char)(num_frames >> 16);
+	xing[10] = (unsigned char)(num_frames >> 8);
+	xing[11] = (unsigned char)(num_frames);
+
+	const auto lame{xing + 12};
+
+	std::memcpy(lame, "LAME3.100", 9);
+
+	lame[21] = (unsigned char)(delay >> 4);
+	lame[22] = (unsigned char)(((delay & 0xF) << 4) | (padding >> 8));
+	lame[23] = (unsigned char)(padding & 0xFF);
+
+	return out;
+}
+
+}
+
+SCENARIO("MP3 lengths are read from the Xing and LAME tags", "[mp3]")
+{
+	static constexpr std::uint32_t NUM_FRAMES = 10;
+	static constexpr std::uint32_t DELAY = 576;
+	static constexpr std::uint32_t PADDING = 1000;
+
+	static constexpr std::uint64_t EXPECTED_FRAMES = (NUM_FRAMES * FRAME_LENGTH) - DELAY - PADDING;
+
+	GIVEN("An MP3 stream with an Info frame and a LAME tag")
+	{
+		const auto data{make_tagged_mp3(NUM_FRAMES, DELAY, PADDING)};
+
+		blahdio::AudioReader reader(data.data(), data.size(), blahdio::AudioTypeHint::try_mp3_only);
+
+		WHEN("The header is read")
+		{
+			const auto format{reader.read_header()};
+
+			REQUIRE(format);
+
+			THEN("The length leaves out the delay and padding, and is exact")
+			{
+				REQUIRE(format->num_frames == EXPECTED_FRAMES);
+				REQUIRE(format->num_frames_exact);
+				REQUIRE(format->encoder_delay == DELAY);
+				REQUIRE(format->encoder_padding == PADDING);
+			}
+
+			AND_WHEN("The stream is decoded to the end")
+			{
+				auto streamer{reader.streamer()};
+
+				std::vector<float> buffer(FRAME_LENGTH * format->num_channels);
+				std::uint64_t frames_read{0};
+
+				for (;;)
+				{
+					const auto result{streamer.read_frames(buffer.data(), FRAME_LENGTH)};
+
+					REQUIRE(result);
+
+					if (*result == 0) break;
+
+					frames_read += *result;
+				}
+
+				THEN("The decoder produced the number of frames the header reported")
+				{
+					REQUIRE(frames_read == EXPECTED_FRAMES);
+				}
+			}
+		}
+	}
+}
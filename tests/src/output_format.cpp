@@ -0,0 +1,238 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <cmath>
+#include <cstdint>
+#include "util.h"
+
+template <typename T>
+static auto read_all(blahdio::AudioReader* reader, blahdio::SampleFormat sample_format, int num_channels) -> std::vector<T>
+{
+	std::vector<T> out;
+
+	blahdio::AudioReader::Callbacks callbacks;
+
+	callbacks.should_abort = []() { return false; };
+	callbacks.return_chunk = [&](const void* chunk, std::uint64_t, std::uint32_t num_frames)
+	{
+		out.insert(out.end(), (const T*)(chunk), (const T*)(chunk) + (num_frames * num_channels));
+	};
+
+	REQUIRE(reader->read_frames(callbacks, 512, {sample_format}));
+
+	return out;
+}
+
+SCENARIO("Frames can be read in formats other than float32", "[output_format]")
+{
+	static constexpr auto NUM_FRAMES = 4410;
+	static constexpr auto NUM_CHANNELS = 2;
+
+	const auto data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, 256.0f)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 16)};
+
+	const auto types =
+	{
+		blahdio::AudioType::wav,
+		blahdio::AudioType::wavpack,
+	};
+
+	for (const auto type : types)
+	{
+		const auto test_file_path{util::write_test_file("output_format", type, data, format)};
+
+		GIVEN(std::string("A 16 bit ") + std::string(util::to_string(type)) + " file")
+		{
+			blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_first);
+
+			const auto f32_frames{read_all<float>(&reader, blahdio::SampleFormat::f32, NUM_CHANNELS)};
+
+			REQUIRE(f32_frames.size() == data.size());
+
+			THEN("The s16 frames are the float frames at full scale")
+			{
+				const auto s16_frames{read_all<std::int16_t>(&reader, blahdio::SampleFormat::s16, NUM_CHANNELS)};
+
+				REQUIRE(s16_frames.size() == f32_frames.size());
+
+				for (size_t i = 0; i < s16_frames.size(); i++)
+				{
+					REQUIRE(float(s16_frames[i]) == std::nearbyint(f32_frames[i] * 32768.0f));
+				}
+			}
+
+			THEN("The s32 frames are the float frames at full scale")
+			{
+				const auto s32_frames{read_all<std::int32_t>(&reader, blahdio::SampleFormat::s32, NUM_CHANNELS)};
+
+				REQUIRE(s32_frames.size() == f32_frames.size());
+
+				for (size_t i = 0; i < s32_frames.size(); i++)
+				{
+					REQUIRE(double(s32_frames[i]) == std::nearbyint(double(f32_frames[i]) * 2147483648.0));
+				}
+			}
+
+			THEN("The f64 frames from a streamer are the float frames")
+			{
+				auto streamer{reader.streamer({blahdio::SampleFormat::f64})};
+
+				std::vector<double> f64_frames(data.size());
+
+				const auto frames_read{streamer.read_frames(f64_frames.data(), NUM_FRAMES)};
+
+				REQUIRE(frames_read);
+				REQUIRE(*frames_read == NUM_FRAMES);
+
+				for (size_t i = 0; i < f64_frames.size(); i++)
+				{
+					REQUIRE(float(f64_frames[i]) == f32_frames[i]);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Frames can be read into one buffer per channel", "[output_format][planar]")
+{
+	static constexpr auto NUM_FRAMES = 4410;
+	static constexpr auto NUM_CHANNELS = 2;
+
+	const auto data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, 256.0f)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 16)};
+
+	const auto test_file_path{util::write_test_file("output_format_planar", blahdio::AudioType::wav, data, format)};
+
+	GIVEN("A 16 bit WAV file")
+	{
+		blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_only);
+
+		const auto interleaved{read_all<float>(&reader, blahdio::SampleFormat::f32, NUM_CHANNELS)};
+
+		REQUIRE(interleaved.size() == data.size());
+
+		THEN("Planar chunks are aligned and hold the same frames")
+		{
+			std::vector<float> frames(data.size());
+			bool all_aligned{true};
+
+			blahdio::AudioReader::Callbacks callbacks;
+
+			callbacks.should_abort = []() { return false; };
+			callbacks.return_planar_chunk = [&](const void* const* channels, std::uint64_t first_frame, std::uint32_t num_frames)
+			{
+				for (int c = 0; c < NUM_CHANNELS; c++)
+				{
+					if (std::uintptr_t(channels[c]) % 64 != 0) all_aligned = false;
+
+					for (std::uint32_t i = 0; i < num_frames; i++)
+					{
+						frames[((first_frame + i) * NUM_CHANNELS) + c] = ((const float*)(channels[c]))[i];
+					}
+				}
+			};
+
+			blahdio::OutputFormat output_format;
+
+			output_format.planar = true;
+
+			REQUIRE(reader.read_frames(callbacks, 512, output_format));
+			REQUIRE(all_aligned);
+			REQUIRE(frames == interleaved);
+		}
+
+		THEN("A streamer can read s16 frames into the caller's channel buffers")
+		{
+			const auto s16_frames{read_all<std::int16_t>(&reader, blahdio::SampleFormat::s16, NUM_CHANNELS)};
+
+			auto streamer{reader.streamer({blahdio::SampleFormat::s16})};
+
+			std::vector<std::int16_t> left(NUM_FRAMES);
+			std::vector<std::int16_t> right(NUM_FRAMES);
+
+			void* const channels[NUM_CHANNELS] = { left.data(), right.data() };
+
+			const auto frames_read{streamer.read_planar_frames(channels, NUM_FRAMES)};
+
+			REQUIRE(frames_read);
+			REQUIRE(*frames_read == NUM_FRAMES);
+
+			for (size_t i = 0; i < NUM_FRAMES; i++)
+			{
+				REQUIRE(left[i] == s16_frames[i * 2]);
+				REQUIRE(right[i] == s16_frames[(i * 2) + 1]);
+			}
+		}
+	}
+}
+
+SCENARIO("Integer frames are converted to float exactly", "[output_format]")
+{
+	// Odd sizes so the vectorized conversions leave a few samples over
+	static constexpr auto NUM_FRAMES = 4411;
+
+	for (const auto bit_depth : {24, 32})
+	{
+		for (const auto num_channels : {1, 2, 3})
+		{
+			const auto data{util::generate_sine_data(NUM_FRAMES, num_channels, 256.0f)};
+
+			auto format{util::make_format(NUM_FRAMES, num_channels, bit_depth)};
+
+			format.storage_type = blahdio::AudioDataFormat::StorageType::Int;
+
+			const auto test_file_path{util::write_test_file("output_format_int", blahdio::AudioType::wav, data, format)};
+
+			GIVEN("A " + std::to_string(bit_depth) + " bit WAV file with " + std::to_string(num_channels) + " channels")
+			{
+				blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_only);
+
+				const auto s32_frames{read_all<std::int32_t>(&reader, blahdio::SampleFormat::s32, num_channels)};
+
+				REQUIRE(s32_frames.size() == data.size());
+
+				THEN("The float frames are the s32 frames scaled by 2^31")
+				{
+					const auto f32_frames{read_all<float>(&reader, blahdio::SampleFormat::f32, num_channels)};
+
+					REQUIRE(f32_frames.size() == s32_frames.size());
+
+					for (size_t i = 0; i < f32_frames.size(); i++)
+					{
+						REQUIRE(f32_frames[i] == float(double(s32_frames[i]) / 2147483648.0));
+					}
+				}
+
+				THEN("The planar float frames are the same")
+				{
+					const auto f32_frames{read_all<float>(&reader, blahdio::SampleFormat::f32, num_channels)};
+
+					auto streamer{reader.streamer()};
+
+					std::vector<std::vector<float>> channels(num_channels, std::vector<float>(NUM_FRAMES));
+					std::vector<void*> channel_ptrs;
+
+					for (auto& channel : channels)
+					{
+						channel_ptrs.push_back(channel.data());
+					}
+
+					const auto frames_read{streamer.read_planar_frames(channel_ptrs.data(), NUM_FRAMES)};
+
+					REQUIRE(frames_read);
+					REQUIRE(*frames_read == NUM_FRAMES);
+
+					for (size_t i = 0; i < NUM_FRAMES; i++)
+					{
+						for (int c = 0; c < num_channels; c++)
+						{
+							REQUIRE(channels[c][i] == f32_frames[(i * num_channels) + c]);
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <algorithm>
+#include "util.h"
+
+SCENARIO("Frames can be decoded on several threads", "[parallel_read]")
+{
+	// Long enough to be split into segments for at least four threads
+	static constexpr auto NUM_FRAMES = 1 << 21;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr auto CHUNK_SIZE = 1000;
+
+	const auto data{util::generate_noise_data(NUM_FRAMES, NUM_CHANNELS)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 16)};
+
+	const auto types =
+	{
+		blahdio::AudioType::wav,
+		blahdio::AudioType::wavpack,
+	};
+
+	for (const auto type : types)
+	{
+		const auto test_file_path{util::write_test_file("parallel_read", type, data, format)};
+
+		GIVEN(std::string("A ") + std::string(util::to_string(type)) + " file")
+		{
+			const auto read = [&](int num_threads, bool in_order)
+			{
+				blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_first);
+
+				reader.set_decode_threads(num_threads, in_order);
+
+				std::vector<float> frames(data.size());
+				std::vector<std::uint64_t> chunk_starts;
+
+				blahdio::AudioReader::Callbacks callbacks;
+
+				callbacks.should_abort = []() { return false; };
+				callbacks.return_chunk = [&](const void* chunk, std::uint64_t first_frame, std::uint32_t num_frames)
+				{
+					chunk_starts.push_back(first_frame);
+
+					std::copy((const float*)(chunk), (const float*)(chunk) + (num_frames * NUM_CHANNELS), frames.data() + (first_frame * NUM_CHANNELS));
+				};
+
+				REQUIRE(reader.read_frames(callbacks, CHUNK_SIZE));
+
+				return std::make_pair(frames, chunk_starts);
+			};
+
+			const auto [sequential_frames, sequential_chunks] = read(1, true);
+
+			THEN("Reading in order gives the same chunks as reading on one thread")
+			{
+				const auto [frames, chunks] = read(4, true);
+
+				REQUIRE(chunks == sequential_chunks);
+				REQUIRE(frames == sequential_frames);
+			}
+
+			THEN("Reading out of order gives the same frames")
+			{
+				auto [frames, chunks] = read(4, false);
+
+				std::sort(chunks.begin(), chunks.end());
+
+				REQUIRE(chunks == sequential_chunks);
+				REQUIRE(frames == sequential_frames);
+			}
+		}
+	}
+}
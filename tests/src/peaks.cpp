@@ -0,0 +1,113 @@
+#include <catch2/catch.hpp>
+#include <blahdio/peaks.h>
+#include <algorithm>
+#include <cmath>
+#include "util.h"
+
+SCENARIO("Peaks can be built and saved to a sidecar file", "[peaks]")
+{
+	static constexpr auto NUM_FRAMES = 100000;
+	static constexpr auto NUM_CHANNELS = 2;
+
+	const auto data{util::generate_noise_data(NUM_FRAMES, NUM_CHANNELS)};
+
+	auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 32)};
+
+	const auto test_file_path{util::write_test_file("peaks", blahdio::AudioType::wav, data, format)};
+	const auto sidecar_path = std::filesystem::path(DIR_TEST_FILES) / "peaks.wav.peaks";
+
+	GIVEN("The peaks of a WAV file")
+	{
+		blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_only);
+
+		const auto peaks{blahdio::build_peaks(&reader)};
+
+		REQUIRE(peaks);
+		REQUIRE(peaks->num_frames == NUM_FRAMES);
+		REQUIRE(peaks->levels.size() == 4);
+
+		THEN("Each bin of every level summarizes its frames")
+		{
+			for (const auto& level : peaks->levels)
+			{
+				const auto num_bins{(NUM_FRAMES + level.frames_per_bin - 1) / level.frames_per_bin};
+
+				REQUIRE(level.bins.size() == num_bins * NUM_CHANNELS);
+
+				for (std::size_t bin = 0; bin < num_bins; bin++)
+				{
+					const auto first_frame{bin * level.frames_per_bin};
+					const auto last_frame{std::min<std::size_t>(first_frame + level.frames_per_bin, NUM_FRAMES)};
+
+					for (int c = 0; c < NUM_CHANNELS; c++)
+					{
+						float min{data[(first_frame * NUM_CHANNELS) + c]};
+						float max{min};
+						double sum_of_squares{0.0};
+
+						for (auto frame = first_frame; frame < last_frame; frame++)
+						{
+							const auto value{data[(frame * NUM_CHANNELS) + c]};
+
+							min = std::min(min, value);
+							max = std::max(max, value);
+							sum_of_squares += double(value) * value;
+						}
+
+						const auto& peak{level.bins[(bin * NUM_CHANNELS) + c]};
+
+						REQUIRE(peak.min == min);
+						REQUIRE(peak.max == max);
+						REQUIRE(peak.rms == Approx(std::sqrt(sum_of_squares / double(last_frame - first_frame))).epsilon(0.0001));
+					}
+				}
+			}
+		}
+
+		THEN("The level for a zoom is the coarsest one which isn't too coarse")
+		{
+			REQUIRE(peaks->find_level(10.0)->frames_per_bin == 64);
+			REQUIRE(peaks->find_level(300.0)->frames_per_bin == 256);
+			REQUIRE(peaks->find_level(100000.0)->frames_per_bin == 4096);
+		}
+
+		WHEN("They are saved to a sidecar")
+		{
+			REQUIRE(blahdio::save_peaks(*peaks, test_file_path.string(), sidecar_path.string()));
+
+			THEN("They load back the same")
+			{
+				const auto loaded{blahdio::load_peaks(test_file_path.string(), sidecar_path.string())};
+
+				REQUIRE(loaded);
+				REQUIRE(loaded->num_channels == peaks->num_channels);
+				REQUIRE(loaded->num_frames == peaks->num_frames);
+				REQUIRE(loaded->levels.size() == peaks->levels.size());
+
+				for (std::size_t i = 0; i < peaks->levels.size(); i++)
+				{
+					REQUIRE(loaded->levels[i].frames_per_bin == peaks->levels[i].frames_per_bin);
+
+					for (std::size_t bin = 0; bin < peaks->levels[i].bins.size(); bin++)
+					{
+						REQUIRE(loaded->levels[i].bins[bin].min == peaks->levels[i].bins[bin].min);
+						REQUIRE(loaded->levels[i].bins[bin].max == peaks->levels[i].bins[bin].max);
+						REQUIRE(loaded->levels[i].bins[bin].rms == peaks->levels[i].bins[bin].rms);
+					}
+				}
+			}
+
+			AND_WHEN("The source file changes")
+			{
+				format.num_frames = NUM_FRAMES / 2;
+
+				util::write_frames(test_file_path, data.data(), blahdio::AudioType::wav, format);
+
+				THEN("The sidecar is out of date")
+				{
+					REQUIRE(!blahdio::load_peaks(test_file_path.string(), sidecar_path.string()));
+				}
+			}
+		}
+	}
+}
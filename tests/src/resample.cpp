@@ -0,0 +1,127 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "util.h"
+
+SCENARIO("Frames can be resampled while they are read", "[resample]")
+{
+	static constexpr auto NUM_FRAMES = 44100;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr auto FREQUENCY = 1000.0f;
+	static constexpr auto SOURCE_RATE = 44100;
+	static constexpr auto TARGET_RATE = 48000;
+	static constexpr auto EXPECTED_FRAMES = ((std::uint64_t(NUM_FRAMES) * TARGET_RATE) + SOURCE_RATE - 1) / SOURCE_RATE;
+
+	const auto data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, FREQUENCY, SOURCE_RATE)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 32, SOURCE_RATE)};
+
+	const auto test_file_path{util::write_test_file("resample", blahdio::AudioType::wav, data, format)};
+
+	const auto quality = GENERATE(blahdio::ResampleQuality::linear, blahdio::ResampleQuality::sinc);
+
+	blahdio::OutputFormat output_format;
+
+	output_format.sample_rate = TARGET_RATE;
+	output_format.resample_quality = quality;
+
+	GIVEN(std::string("A 44.1kHz sine wave, resampled to 48kHz with the ") + (quality == blahdio::ResampleQuality::sinc ? "sinc" : "linear") + " resampler")
+	{
+		blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_first);
+
+		WHEN("All of the frames are read")
+		{
+			std::vector<float> frames;
+			std::uint64_t next_frame{0};
+			bool in_order{true};
+
+			blahdio::AudioReader::Callbacks callbacks;
+
+			callbacks.should_abort = []() { return false; };
+			callbacks.return_chunk = [&](const void* chunk, std::uint64_t first_frame_index, std::uint32_t num_frames)
+			{
+				in_order = in_order && first_frame_index == next_frame;
+				next_frame += num_frames;
+				frames.insert(frames.end(), (const float*)(chunk), (const float*)(chunk) + (num_frames * NUM_CHANNELS));
+			};
+
+			const auto result{reader.read_frames(callbacks, 512, output_format)};
+
+			THEN("There are as many frames as the new rate needs and they follow the sine wave")
+			{
+				REQUIRE(result);
+				REQUIRE(in_order);
+				REQUIRE(frames.size() == EXPECTED_FRAMES * NUM_CHANNELS);
+
+				// The edges are filtered against the silence either side. The
+				// linear resampler's low-pass filter delays the signal a little,
+				// so only its level is checked.
+				float peak{0.0f};
+
+				for (std::uint64_t i = 1000; i < EXPECTED_FRAMES - 1000; i++)
+				{
+					const auto source_frame{double(i) * SOURCE_RATE / TARGET_RATE};
+					const auto expected{std::sin(3.14159 * 2 * FREQUENCY * source_frame / SOURCE_RATE)};
+
+					peak = std::max(peak, std::abs(frames[i * NUM_CHANNELS]));
+
+					if (quality == blahdio::ResampleQuality::sinc)
+					{
+						REQUIRE(std::abs(frames[i * NUM_CHANNELS] - expected) < 0.001);
+					}
+				}
+
+				REQUIRE(std::abs(peak - 1.0f) < 0.05f);
+			}
+		}
+
+		WHEN("A streamer seeks into the middle")
+		{
+			static constexpr auto SEEK_FRAME = 20000;
+			static constexpr auto FRAMES_TO_READ = 10000;
+
+			auto streamer{reader.streamer(output_format)};
+
+			std::vector<float> from_start((SEEK_FRAME + FRAMES_TO_READ) * NUM_CHANNELS);
+			std::vector<float> from_seek(FRAMES_TO_READ * NUM_CHANNELS);
+
+			const auto start_read{streamer.read_frames(from_start.data(), SEEK_FRAME + FRAMES_TO_READ)};
+
+			REQUIRE(streamer.seek(SEEK_FRAME));
+
+			const auto seek_read{streamer.read_frames(from_seek.data(), FRAMES_TO_READ)};
+
+			THEN("It reads what it would have read without seeking")
+			{
+				REQUIRE(start_read);
+				REQUIRE(seek_read);
+				REQUIRE(*start_read == SEEK_FRAME + FRAMES_TO_READ);
+				REQUIRE(*seek_read == FRAMES_TO_READ);
+
+				// The linear resampler's filter starts over after a seek
+				const auto tolerance{quality == blahdio::ResampleQuality::sinc ? 0.0f : 0.001f};
+
+				for (int i = 0; i < FRAMES_TO_READ * NUM_CHANNELS; i++)
+				{
+					REQUIRE(std::abs(from_seek[i] - from_start[(SEEK_FRAME * NUM_CHANNELS) + i]) <= tolerance);
+				}
+			}
+
+			AND_WHEN("It reads to the end")
+			{
+				std::vector<float> rest(EXPECTED_FRAMES * NUM_CHANNELS);
+
+				const auto rest_read{streamer.read_frames(rest.data(), std::uint32_t(EXPECTED_FRAMES))};
+
+				THEN("It stops at the same frame read_frames() does")
+				{
+					REQUIRE(rest_read);
+					REQUIRE(*rest_read == EXPECTED_FRAMES - SEEK_FRAME - FRAMES_TO_READ);
+				}
+			}
+		}
+	}
+}
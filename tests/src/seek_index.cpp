@@ -0,0 +1,171 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <algorithm>
+#include "util.h"
+
+SCENARIO("A WavPack seek index can be built, saved and used for seeking", "[wavpack][seek_index]")
+{
+	static constexpr auto NUM_FRAMES = 44100 * 4;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr std::uint64_t SEEK_FRAMES[] = { 0, 1, 30000, 100000, NUM_FRAMES - 100 };
+	static constexpr std::uint32_t READ_SIZE = 64;
+
+	const auto data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, 256.0f)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 32)};
+
+	const auto test_file_path{util::write_test_file("seek_index", blahdio::AudioType::wavpack, data, format)};
+
+	GIVEN("A reader which builds a seek index")
+	{
+		blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wavpack_only);
+
+		reader.set_build_seek_index(true);
+
+		REQUIRE(reader.read_header());
+
+		auto streamer{reader.streamer()};
+		const auto index{reader.get_seek_index()};
+
+		REQUIRE(index);
+
+		THEN("Seeking a streamer gives the same frames as reading from the start")
+		{
+			std::vector<float> buffer(READ_SIZE * NUM_CHANNELS);
+
+			for (auto frame : SEEK_FRAMES)
+			{
+				REQUIRE(streamer.seek(frame));
+
+				const auto frames_read{streamer.read_frames(buffer.data(), READ_SIZE)};
+
+				REQUIRE(frames_read);
+				REQUIRE(*frames_read == READ_SIZE);
+
+				util::compare_frames(buffer.data(), data.data() + (frame * NUM_CHANNELS), READ_SIZE, NUM_CHANNELS);
+			}
+		}
+
+		THEN("The index can be given to another reader of the same file")
+		{
+			blahdio::AudioReader other_reader(test_file_path.string(), blahdio::AudioTypeHint::try_wavpack_only);
+
+			REQUIRE(other_reader.set_seek_index(*index));
+			REQUIRE(other_reader.read_header());
+			REQUIRE(other_reader.get_seek_index());
+		}
+
+		THEN("A reader given only the start of the index can still seek anywhere")
+		{
+			// Keep the first two points. The point count is the last field
+			// of the header, stored little endian.
+			static constexpr std::size_t HEADER_SIZE = 28;
+			static constexpr std::size_t POINT_SIZE = 24;
+			static constexpr std::size_t NUM_POINTS = 2;
+
+			auto partial_index{*index};
+
+			REQUIRE(partial_index.size() > HEADER_SIZE + (NUM_POINTS * POINT_SIZE));
+
+			std::fill(partial_index.begin() + HEADER_SIZE - 8, partial_index.begin() + HEADER_SIZE, std::byte(0));
+			partial_index[HEADER_SIZE - 8] = std::byte(NUM_POINTS);
+			partial_index.resize(HEADER_SIZE + (NUM_POINTS * POINT_SIZE));
+
+			blahdio::AudioReader other_reader(test_file_path.string(), blahdio::AudioTypeHint::try_wavpack_only);
+
+			REQUIRE(other_reader.set_seek_index(partial_index));
+			REQUIRE(other_reader.read_header());
+
+			auto other_streamer{other_reader.streamer()};
+
+			std::vector<float> buffer(READ_SIZE * NUM_CHANNELS);
+
+			// Past the end of the index, then within it, then past it again
+			// from a decoder reopened part way through the file
+			for (std::uint64_t frame : { std::uint64_t(NUM_FRAMES - 100), std::uint64_t(30000), std::uint64_t(100000), std::uint64_t(1) })
+			{
+				REQUIRE(other_streamer.seek(frame));
+
+				const auto frames_read{other_streamer.read_frames(buffer.data(), READ_SIZE)};
+
+				REQUIRE(frames_read);
+				REQUIRE(*frames_read == READ_SIZE);
+
+				util::compare_frames(buffer.data(), data.data() + (frame * NUM_CHANNELS), READ_SIZE, NUM_CHANNELS);
+			}
+		}
+	}
+}
+
+SCENARIO("A stream-backed WavPack source can be seeked", "[wavpack][stream]")
+{
+	static constexpr auto NUM_FRAMES = 44100 * 4;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr std::uint64_t SEEK_FRAMES[] = { 100000, 1, 30000, NUM_FRAMES - 100, 0 };
+	static constexpr std::uint32_t READ_SIZE = 64;
+
+	const auto data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, 256.0f)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 32)};
+
+	const auto test_file_path{util::write_test_file("stream_seek", blahdio::AudioType::wavpack, data, format)};
+	const auto file_data{util::read_file(test_file_path)};
+
+	GIVEN("A stream with a size")
+	{
+		std::int64_t pos{0};
+
+		blahdio::AudioReader::Stream stream;
+
+		stream.read_bytes = [&](void* buffer, std::uint32_t bytes_to_read)
+		{
+			const auto size{std::uint32_t(std::min<std::int64_t>(bytes_to_read, std::int64_t(file_data.size()) - pos))};
+
+			std::copy(file_data.data() + pos, file_data.data() + pos + size, (char*)(buffer));
+
+			pos += size;
+
+			return size;
+		};
+
+		stream.seek = [&](blahdio::AudioReader::Stream::SeekOrigin origin, std::int64_t offset)
+		{
+			const auto new_pos{origin == blahdio::AudioReader::Stream::SeekOrigin::Start ? offset : pos + offset};
+
+			if (new_pos < 0 || new_pos > std::int64_t(file_data.size())) return false;
+
+			pos = new_pos;
+
+			return true;
+		};
+
+		stream.get_size = [&]()
+		{
+			return std::uint64_t(file_data.size());
+		};
+
+		blahdio::AudioReader reader(stream, blahdio::AudioTypeHint::try_wavpack_only);
+
+		REQUIRE(reader.read_header());
+
+		auto streamer{reader.streamer()};
+
+		THEN("Seeking a streamer gives the same frames as reading from the start")
+		{
+			std::vector<float> buffer(READ_SIZE * NUM_CHANNELS);
+
+			for (auto frame : SEEK_FRAMES)
+			{
+				REQUIRE(streamer.seek(frame));
+
+				const auto frames_read{streamer.read_frames(buffer.data(), READ_SIZE)};
+
+				REQUIRE(frames_read);
+				REQUIRE(*frames_read == READ_SIZE);
+
+				util::compare_frames(buffer.data(), data.data() + (frame * NUM_CHANNELS), READ_SIZE, NUM_CHANNELS);
+			}
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+#include <blahdio/library_info.h>
+#include <vector>
+#include "util.h"
+
+SCENARIO("The audio type can be deduced from the file contents", "[sniff]")
+{
+	static constexpr auto NUM_FRAMES = 4410;
+	static constexpr auto NUM_CHANNELS = 2;
+
+	static constexpr blahdio::AudioType AUDIO_TYPES[] =
+	{
+		blahdio::AudioType::wav,
+		blahdio::AudioType::wavpack,
+	};
+
+	const auto data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, 256.0f)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 16)};
+
+	for (auto audio_type : AUDIO_TYPES)
+	{
+		GIVEN("A " << util::to_string(audio_type) << " file with the wrong file extension")
+		{
+			const auto test_file_path = std::filesystem::path(DIR_TEST_FILES) / (std::string("sniff_") + std::string(util::get_ext(audio_type)) + ".bin");
+
+			util::write_frames(test_file_path, data.data(), audio_type, format);
+
+			THEN("The sniffed type is correct")
+			{
+				const auto type{blahdio::sniff_type(test_file_path.string())};
+
+				REQUIRE(type);
+				REQUIRE(*type == audio_type);
+			}
+		}
+	}
+
+	GIVEN("Some data which isn't audio")
+	{
+		const char junk[] = "This is not an audio file";
+
+		THEN("No type is sniffed")
+		{
+			REQUIRE(!blahdio::sniff_type(junk, sizeof(junk)));
+		}
+	}
+
+	GIVEN("Junk with a chance MPEG frame sync near the end of the sniffed window")
+	{
+		// MPEG-1 layer III, 128 kbps, 44.1 kHz, so the next frame would
+		// start 417 bytes later, past the first 4 KB
+		const unsigned char sync[] = { 0xFF, 0xFB, 0x90, 0x00 };
+
+		std::vector<unsigned char> junk(8192);
+
+		std::copy(std::begin(sync), std::end(sync), junk.begin() + 3800);
+
+		THEN("No type is sniffed")
+		{
+			REQUIRE(!blahdio::sniff_type(junk.data(), junk.size()));
+		}
+
+		AND_GIVEN("The same data truncated a little after the frame header")
+		{
+			junk.resize(3900);
+
+			THEN("The sniffed type is MP3, since the frame runs up to the end of the data")
+			{
+				const auto type{blahdio::sniff_type(junk.data(), junk.size())};
+
+				REQUIRE(type);
+				REQUIRE(*type == blahdio::AudioType::mp3);
+			}
+		}
+	}
+
+	GIVEN("The start of a FLAC file with an ID3 tag in front of it")
+	{
+		const unsigned char flac[] = { 'I', 'D', '3', 4, 0, 0, 0, 0, 0, 2, 0, 0, 'f', 'L', 'a', 'C' };
+
+		THEN("The sniffed type is FLAC")
+		{
+			const auto type{blahdio::sniff_type(flac, sizeof(flac))};
+
+			REQUIRE(type);
+			REQUIRE(*type == blahdio::AudioType::flac);
+		}
+	}
+}
@@ -0,0 +1,124 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <blahdio/audio_streamer.h>
+#include <blahdio/audio_writer.h>
+#include <blahdio/stats.h>
+#include "util.h"
+
+SCENARIO("Readers, streamers and writers count their work", "[stats]")
+{
+	static constexpr auto NUM_FRAMES = 20000;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr auto CHUNK_SIZE = 512;
+
+	const auto data{util::generate_noise_data(NUM_FRAMES, NUM_CHANNELS)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 16)};
+
+	const auto test_file_path = (std::filesystem::path(DIR_TEST_FILES) / "stats").replace_extension(util::get_ext(blahdio::AudioType::wavpack));
+
+	GIVEN("A WavPack file written by a writer")
+	{
+		const auto process_before{blahdio::get_process_stats()};
+
+		blahdio::AudioWriter writer(test_file_path.string(), blahdio::AudioType::wavpack, format);
+
+		blahdio::AudioWriter::Callbacks write_callbacks;
+
+		write_callbacks.should_abort = []() { return false; };
+		write_callbacks.get_next_chunk = [&](float* buffer, std::uint64_t frame, std::uint32_t num_frames)
+		{
+			std::copy(data.data() + (frame * NUM_CHANNELS), data.data() + ((frame + num_frames) * NUM_CHANNELS), buffer);
+		};
+
+		writer.write_frames(write_callbacks, CHUNK_SIZE);
+
+		const auto written{writer.get_stats()};
+
+		THEN("The writer counted every frame and the encoded bytes")
+		{
+			REQUIRE(written.frames == NUM_FRAMES);
+			REQUIRE(written.bytes == std::filesystem::file_size(test_file_path));
+			REQUIRE(written.seeks == 0);
+			REQUIRE(written.underruns == 0);
+		}
+
+		WHEN("It is read with read_frames()")
+		{
+			blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wavpack_first);
+
+			blahdio::AudioReader::Callbacks callbacks;
+
+			callbacks.should_abort = []() { return false; };
+			callbacks.return_chunk = [](const void*, std::uint64_t, std::uint32_t) {};
+
+			REQUIRE(reader.read_frames(callbacks, CHUNK_SIZE));
+
+			const auto read{reader.get_stats()};
+
+			THEN("The reader counted every frame and read the whole file")
+			{
+				REQUIRE(read.frames == NUM_FRAMES);
+				REQUIRE(read.bytes >= std::filesystem::file_size(test_file_path));
+				REQUIRE(read.codec_ns > 0);
+				REQUIRE(read.seeks == 0);
+			}
+
+			THEN("The process totals include both")
+			{
+				const auto process{blahdio::get_process_stats()};
+
+				REQUIRE(process.writing.frames - process_before.writing.frames >= NUM_FRAMES);
+				REQUIRE(process.reading.frames - process_before.reading.frames >= NUM_FRAMES);
+			}
+		}
+
+		WHEN("It is streamed with a seek")
+		{
+			blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wavpack_first);
+
+			const auto reader_before{reader.get_stats()};
+
+			auto streamer{reader.streamer()};
+
+			std::vector<float> buffer(CHUNK_SIZE * NUM_CHANNELS);
+
+			REQUIRE(*streamer.read_frames(buffer.data(), CHUNK_SIZE) == CHUNK_SIZE);
+			REQUIRE(streamer.seek(NUM_FRAMES / 2));
+			REQUIRE(*streamer.read_frames(buffer.data(), CHUNK_SIZE) == CHUNK_SIZE);
+
+			const auto streamed{streamer.get_stats()};
+
+			THEN("The streamer counted its own reads and seek")
+			{
+				REQUIRE(streamed.frames == CHUNK_SIZE * 2);
+				REQUIRE(streamed.seeks == 1);
+				REQUIRE(streamed.bytes > 0);
+			}
+
+			THEN("None of it was charged to the reader")
+			{
+				REQUIRE(reader.get_stats().frames == reader_before.frames);
+				REQUIRE(reader.get_stats().seeks == 0);
+			}
+
+			AND_WHEN("A streamer has reserved room for its reads")
+			{
+				REQUIRE(streamer.reserve(CHUNK_SIZE));
+
+				const auto reserved{streamer.get_stats()};
+
+				for (int i = 0; i < 8; i++)
+				{
+					REQUIRE(streamer.read_frames_realtime(buffer.data(), CHUNK_SIZE).error == blahdio::AudioStreamer::Error::none);
+				}
+
+				THEN("Reading doesn't grow its buffers")
+				{
+					REQUIRE(streamer.get_stats().allocations == reserved.allocations);
+					REQUIRE(streamer.get_stats().frames == reserved.frames + (CHUNK_SIZE * 8));
+				}
+			}
+		}
+	}
+}
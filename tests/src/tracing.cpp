@@ -0,0 +1,95 @@
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <blahdio/audio_reader.h>
+#include <blahdio/tracing.h>
+#include <string>
+#include <vector>
+#include "util.h"
+
+namespace {
+
+struct Recorder
+{
+	std::vector<const blahdio::TraceZone*> open;
+	std::vector<std::string> names;
+	std::uint64_t next_token{1};
+	bool balanced{true};
+};
+
+}
+
+SCENARIO("Zones are reported to the tracing callbacks", "[tracing]")
+{
+	static constexpr auto NUM_FRAMES = 10000;
+	static constexpr auto NUM_CHANNELS = 2;
+
+	const auto data{util::generate_noise_data(NUM_FRAMES, NUM_CHANNELS)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 16)};
+
+	const auto test_file_path{util::write_test_file("tracing", blahdio::AudioType::wav, data, format)};
+
+	GIVEN("Callbacks which record the zones")
+	{
+		Recorder recorder;
+
+		blahdio::TracingCallbacks callbacks;
+
+		callbacks.user_data = &recorder;
+
+		callbacks.begin = [](const blahdio::TraceZone& zone, void* user_data) -> std::uint64_t
+		{
+			const auto recorder{static_cast<Recorder*>(user_data)};
+
+			recorder->open.push_back(&zone);
+			recorder->names.push_back(zone.name);
+
+			return recorder->next_token++;
+		};
+
+		callbacks.end = [](const blahdio::TraceZone& zone, std::uint64_t, void* user_data)
+		{
+			const auto recorder{static_cast<Recorder*>(user_data)};
+
+			if (recorder->open.empty() || recorder->open.back() != &zone)
+			{
+				recorder->balanced = false;
+				return;
+			}
+
+			recorder->open.pop_back();
+		};
+
+		// Nothing to check if the library was built without tracing
+		if (!blahdio::set_tracing_callbacks(&callbacks)) return;
+
+		WHEN("A file is read")
+		{
+			blahdio::AudioReader reader(test_file_path.string(), blahdio::AudioTypeHint::try_wav_first);
+
+			blahdio::AudioReader::Callbacks read_callbacks;
+
+			read_callbacks.should_abort = []() { return false; };
+			read_callbacks.return_chunk = [](const void*, std::uint64_t, std::uint32_t) {};
+
+			REQUIRE(reader.read_frames(read_callbacks, 512));
+
+			blahdio::set_tracing_callbacks(nullptr);
+
+			const auto count = [&recorder](const std::string& name)
+			{
+				return std::count(recorder.names.begin(), recorder.names.end(), name);
+			};
+
+			THEN("The header was probed and every chunk decoded in a zone, and they all ended")
+			{
+				REQUIRE(count("blahdio::probe WAV") == 1);
+				REQUIRE(count("blahdio::decode") >= NUM_FRAMES / 512);
+				REQUIRE(recorder.balanced);
+				REQUIRE(recorder.open.empty());
+			}
+		}
+
+		blahdio::set_tracing_callbacks(nullptr);
+	}
+}
@@ -1,5 +1,7 @@
 #include "util.h"
 #include <cmath>
+#include <fstream>
+#include <iterator>
 #include <catch2/catch.hpp>
 #include <blahdio/audio_reader.h>
 #include <blahdio/audio_writer.h>
@@ -32,7 +34,8 @@ void write_frames(
 		const float* write_buffer,
 		AudioType audio_type,
 		AudioDataFormat write_format,
-		int chunk_size)
+		int chunk_size,
+		Dither dither)
 {
 	const auto dir = file_path.parent_path();
 
@@ -43,6 +46,8 @@ void write_frames(
 
 	AudioWriter writer(file_path.string(), audio_type, write_format);
 
+	writer.set_dither(dither);
+
 	AudioWriter::Callbacks writer_callbacks;
 
 	writer_callbacks.should_abort = []() { return false; };
@@ -220,4 +225,33 @@ std::vector<float> generate_noise_data(int num_frames, int num_channels)
 	return out;
 }
 
+auto make_format(int num_frames, int num_channels, int bit_depth, int sample_rate) -> AudioDataFormat
+{
+	AudioDataFormat out;
+
+	out.num_frames = num_frames;
+	out.num_channels = num_channels;
+	out.sample_rate = sample_rate;
+	out.bit_depth = bit_depth;
+	out.storage_type = bit_depth == 32 ? AudioDataFormat::StorageType::Float : AudioDataFormat::StorageType::Int;
+
+	return out;
+}
+
+auto write_test_file(std::string_view name, AudioType audio_type, const std::vector<float>& data, AudioDataFormat format) -> std::filesystem::path
+{
+	const auto file_path = (std::filesystem::path(DIR_TEST_FILES) / name).replace_extension(get_ext(audio_type));
+
+	write_frames(file_path, data.data(), audio_type, format);
+
+	return file_path;
+}
+
+auto read_file(const std::filesystem::path& file_path) -> std::vector<char>
+{
+	std::ifstream file(file_path, std::ios::binary);
+
+	return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
 } // util
@@ -2,9 +2,11 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <string_view>
 #include <vector>
 #include <blahdio/audio_data_format.h>
 #include <blahdio/audio_type.h>
+#include <blahdio/audio_writer.h>
 
 namespace util {
 
@@ -15,7 +17,8 @@ extern void write_frames(
 		const float* buffer,
 		blahdio::AudioType audio_type,
 		blahdio::AudioDataFormat format,
-		int chunk_size = 512);
+		int chunk_size = 512,
+		blahdio::Dither dither = blahdio::Dither::triangular);
 
 extern void read_frames(
 		const std::filesystem::path& file_path,
@@ -37,4 +40,14 @@ extern auto get_ext(blahdio::AudioType audio_type) -> std::string_view;
 extern std::vector<float> generate_sine_data(int num_frames, int num_channels, float frequency, int sample_rate = 44100);
 extern std::vector<float> generate_noise_data(int num_frames, int num_channels);
 
+// Samples are stored as float if the bit depth is 32, otherwise as
+// integers
+extern auto make_format(int num_frames, int num_channels, int bit_depth, int sample_rate = 44100) -> blahdio::AudioDataFormat;
+
+// Writes the frames to a file called name in the test files directory,
+// with the extension for the type, and returns its path
+extern auto write_test_file(std::string_view name, blahdio::AudioType audio_type, const std::vector<float>& data, blahdio::AudioDataFormat format) -> std::filesystem::path;
+
+extern auto read_file(const std::filesystem::path& file_path) -> std::vector<char>;
+
 } // util
@@ -0,0 +1,62 @@
+#include <catch2/catch.hpp>
+#include <blahdio/audio_reader.h>
+#include <algorithm>
+#include "util.h"
+
+SCENARIO("Float WAV data in memory can be read without copying", "[wav][zero_copy]")
+{
+	static constexpr auto NUM_FRAMES = 4410;
+	static constexpr auto NUM_CHANNELS = 2;
+	static constexpr auto CHUNK_SIZE = 512;
+
+	const auto data{util::generate_sine_data(NUM_FRAMES, NUM_CHANNELS, 256.0f)};
+
+	const auto format{util::make_format(NUM_FRAMES, NUM_CHANNELS, 32)};
+
+	const auto test_file_path{util::write_test_file("zero_copy", blahdio::AudioType::wav, data, format)};
+	const auto file_data{util::read_file(test_file_path)};
+
+	GIVEN("A reader with zero copy enabled")
+	{
+		blahdio::AudioReader reader(file_data.data(), file_data.size(), blahdio::AudioTypeHint::try_wav_only);
+
+		reader.set_zero_copy(true);
+
+		REQUIRE(reader.read_header());
+
+		const auto zero_copy{reader.get_zero_copy()};
+
+		REQUIRE(zero_copy);
+		REQUIRE(*zero_copy != blahdio::AudioReader::ZeroCopy::unavailable);
+
+		THEN("The frames are the same as the ones written")
+		{
+			std::vector<float> frames(data.size());
+			bool all_chunks_in_source{true};
+
+			blahdio::AudioReader::Callbacks callbacks;
+
+			callbacks.should_abort = []() { return false; };
+			callbacks.return_chunk = [&](const void* chunk, std::uint64_t first_frame, std::uint32_t num_frames)
+			{
+				const auto chunk_bytes{(const char*)(chunk)};
+
+				if (chunk_bytes < file_data.data() || chunk_bytes >= file_data.data() + file_data.size())
+				{
+					all_chunks_in_source = false;
+				}
+
+				std::copy((const float*)(chunk), (const float*)(chunk) + (num_frames * NUM_CHANNELS), frames.data() + (first_frame * NUM_CHANNELS));
+			};
+
+			REQUIRE(reader.read_frames(callbacks, CHUNK_SIZE));
+
+			util::compare_frames(frames.data(), data.data(), NUM_FRAMES, NUM_CHANNELS);
+
+			if (*zero_copy == blahdio::AudioReader::ZeroCopy::available)
+			{
+				REQUIRE(all_chunks_in_source);
+			}
+		}
+	}
+}